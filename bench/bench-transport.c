@@ -0,0 +1,382 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include <stdbool.h>
+#include <time.h>
+
+#include "ytstenut/yts-contact-impl.h"
+#include "bench-transport.h"
+
+/*
+ * Synthetic transport for the discovery simulator. It has no network
+ * behind it, the simulator announces services and status changes through
+ * the yts_transport_emit_*() functions. Contact resolution completes after
+ * a configurable delay, one contact per main loop iteration, like replies
+ * trickling in from a connection manager.
+ */
+
+static void
+_transport_interface_init (YtsTransportInterface *interface);
+
+G_DEFINE_TYPE_WITH_CODE (BenchTransport,
+                         bench_transport,
+                         G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (YTS_TYPE_TRANSPORT,
+                                                _transport_interface_init))
+
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BENCH_TYPE_TRANSPORT, BenchTransportPrivate))
+
+typedef struct {
+  GSimpleAsyncResult  *result;
+  int64_t              due_time;
+} Resolve;
+
+typedef struct {
+  char      *contact_id;
+  unsigned   resolve_delay_ms;
+  GQueue     resolves;
+  unsigned   resolve_id;
+  bool       resolve_idle;
+  BenchCost  resolve_cost;
+} BenchTransportPrivate;
+
+/*
+ * BenchCost
+ */
+
+int64_t
+bench_cost_begin (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts);
+
+  return ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+}
+
+void
+bench_cost_end (BenchCost *self,
+                int64_t    begin)
+{
+  uint64_t ns = bench_cost_begin () - begin;
+
+  self->count++;
+  self->total_ns += ns;
+  self->max_ns = MAX (self->max_ns, ns);
+}
+
+/*
+ * Contact resolution
+ */
+
+static bool
+_resolve_dispatch (BenchTransport *self);
+
+static void
+resolve_schedule (BenchTransport *self)
+{
+  BenchTransportPrivate *priv = GET_PRIVATE (self);
+  Resolve *resolve;
+  int64_t  wait_ms;
+
+  resolve = g_queue_peek_head (&priv->resolves);
+  if (NULL == resolve) {
+    return;
+  }
+
+  wait_ms = (resolve->due_time - g_get_monotonic_time ()) / 1000;
+  if (wait_ms <= 0) {
+    priv->resolve_idle = true;
+    priv->resolve_id = g_idle_add ((GSourceFunc) _resolve_dispatch, self);
+  } else {
+    priv->resolve_idle = false;
+    priv->resolve_id = g_timeout_add (wait_ms,
+                                      (GSourceFunc) _resolve_dispatch,
+                                      self);
+  }
+}
+
+static bool
+_resolve_dispatch (BenchTransport *self)
+{
+  BenchTransportPrivate *priv = GET_PRIVATE (self);
+  Resolve *resolve;
+  int64_t  begin;
+
+  resolve = g_queue_peek_head (&priv->resolves);
+  if (resolve && resolve->due_time <= g_get_monotonic_time ()) {
+
+    g_queue_pop_head (&priv->resolves);
+
+    /* The roster's callback runs from in here. */
+    begin = bench_cost_begin ();
+    g_simple_async_result_complete (resolve->result);
+    bench_cost_end (&priv->resolve_cost, begin);
+
+    g_object_unref (resolve->result);
+    g_slice_free (Resolve, resolve);
+
+    resolve = g_queue_peek_head (&priv->resolves);
+  }
+
+  if (resolve && priv->resolve_idle &&
+      resolve->due_time <= g_get_monotonic_time ()) {
+    /* Keep going, one per iteration. */
+    return true;
+  }
+
+  priv->resolve_id = 0;
+  resolve_schedule (self);
+
+  return false;
+}
+
+/*
+ * YtsTransport implementation
+ */
+
+static char const *
+_get_contact_id (YtsTransport *self)
+{
+  BenchTransportPrivate *priv = GET_PRIVATE (self);
+
+  return priv->contact_id;
+}
+
+static bool
+_connect_idle (YtsTransport *self)
+{
+  yts_transport_emit_ready (self);
+
+  return false;
+}
+
+static void
+_connect (YtsTransport *self)
+{
+  g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                   (GSourceFunc) _connect_idle,
+                   g_object_ref (self),
+                   g_object_unref);
+}
+
+static void
+_disconnect (YtsTransport *self)
+{
+  yts_transport_emit_disconnected (self);
+}
+
+static void
+_add_capability (YtsTransport *self,
+                 char const   *fqc_id)
+{
+}
+
+static void
+_add_interest (YtsTransport *self,
+               char const   *fqc_id)
+{
+}
+
+static void
+_advertise_status (YtsTransport *self,
+                   char const   *fqc_id,
+                   char const   *status_xml)
+{
+}
+
+static void
+_refresh (YtsTransport *self)
+{
+}
+
+static YtsError
+_send_message (YtsTransport *self,
+               YtsContact   *contact,
+               char const   *service_id,
+               YtsMetadata  *message)
+{
+  return yts_error_new (YTS_ERROR_NO_ROUTE);
+}
+
+static void
+_resolve_contact_async (YtsTransport        *self,
+                        char const          *contact_id,
+                        GCancellable        *cancellable,
+                        GAsyncReadyCallback  callback,
+                        void                *user_data)
+{
+  BenchTransportPrivate *priv = GET_PRIVATE (self);
+  Resolve *resolve;
+
+  resolve = g_slice_new (Resolve);
+  resolve->result = g_simple_async_result_new (G_OBJECT (self),
+                                               callback,
+                                               user_data,
+                                               _resolve_contact_async);
+  g_simple_async_result_set_op_res_gpointer (
+                                      resolve->result,
+                                      yts_contact_impl_new_for_id (contact_id),
+                                      g_object_unref);
+  resolve->due_time = g_get_monotonic_time () +
+                      priv->resolve_delay_ms * 1000;
+  g_queue_push_tail (&priv->resolves, resolve);
+
+  if (0 == priv->resolve_id) {
+    resolve_schedule (BENCH_TRANSPORT (self));
+  }
+}
+
+static YtsContact *
+_resolve_contact_finish (YtsTransport  *self,
+                         GAsyncResult  *result,
+                         GError       **error)
+{
+  GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  g_return_val_if_fail (g_simple_async_result_is_valid (result,
+                                                        G_OBJECT (self),
+                                                        _resolve_contact_async),
+                        NULL);
+
+  return g_object_ref (g_simple_async_result_get_op_res_gpointer (simple));
+}
+
+static YtsOutgoingFile *
+_send_file (YtsTransport  *self,
+            YtsContact    *contact,
+            char const    *service_id,
+            GFile         *file,
+            char const    *description,
+            GError       **error)
+{
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                       "File transfer is not supported by the simulator");
+  return NULL;
+}
+
+static YtsOutgoingFile *
+_send_stream (YtsTransport  *self,
+              YtsContact    *contact,
+              char const    *service_id,
+              GInputStream  *stream,
+              uint64_t       size,
+              char const    *name,
+              char const    *content_type,
+              char const    *description,
+              GError       **error)
+{
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                       "File transfer is not supported by the simulator");
+  return NULL;
+}
+
+static void
+_transport_interface_init (YtsTransportInterface *interface)
+{
+  interface->get_contact_id = _get_contact_id;
+  interface->connect = _connect;
+  interface->disconnect = _disconnect;
+  interface->add_capability = _add_capability;
+  interface->add_interest = _add_interest;
+  interface->advertise_status = _advertise_status;
+  interface->refresh = _refresh;
+  interface->send_message = _send_message;
+  interface->resolve_contact_async = _resolve_contact_async;
+  interface->resolve_contact_finish = _resolve_contact_finish;
+  interface->send_file = _send_file;
+  interface->send_stream = _send_stream;
+}
+
+/*
+ * BenchTransport
+ */
+
+static void
+_dispose (GObject *object)
+{
+  BenchTransportPrivate *priv = GET_PRIVATE (object);
+  Resolve *resolve;
+
+  if (priv->resolve_id) {
+    g_source_remove (priv->resolve_id);
+    priv->resolve_id = 0;
+  }
+
+  while (NULL != (resolve = g_queue_pop_head (&priv->resolves))) {
+    g_object_unref (resolve->result);
+    g_slice_free (Resolve, resolve);
+  }
+
+  G_OBJECT_CLASS (bench_transport_parent_class)->dispose (object);
+}
+
+static void
+_finalize (GObject *object)
+{
+  BenchTransportPrivate *priv = GET_PRIVATE (object);
+
+  g_free (priv->contact_id);
+
+  G_OBJECT_CLASS (bench_transport_parent_class)->finalize (object);
+}
+
+static void
+bench_transport_class_init (BenchTransportClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  g_type_class_add_private (klass, sizeof (BenchTransportPrivate));
+
+  object_class->dispose = _dispose;
+  object_class->finalize = _finalize;
+}
+
+static void
+bench_transport_init (BenchTransport *self)
+{
+  BenchTransportPrivate *priv = GET_PRIVATE (self);
+
+  g_queue_init (&priv->resolves);
+}
+
+BenchTransport *
+bench_transport_new (char const *contact_id,
+                     unsigned    resolve_delay_ms)
+{
+  BenchTransport        *self;
+  BenchTransportPrivate *priv;
+
+  self = g_object_new (BENCH_TYPE_TRANSPORT, NULL);
+  priv = GET_PRIVATE (self);
+  priv->contact_id = g_strdup (contact_id);
+  priv->resolve_delay_ms = resolve_delay_ms;
+
+  return self;
+}
+
+BenchCost const *
+bench_transport_get_resolve_cost (BenchTransport *self)
+{
+  BenchTransportPrivate *priv = GET_PRIVATE (self);
+
+  return &priv->resolve_cost;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef BENCH_TRANSPORT_H
+#define BENCH_TRANSPORT_H
+
+#include <stdint.h>
+#include <glib-object.h>
+#include "ytstenut/yts-transport.h"
+
+G_BEGIN_DECLS
+
+#define BENCH_TYPE_TRANSPORT bench_transport_get_type()
+
+#define BENCH_TRANSPORT(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), BENCH_TYPE_TRANSPORT, BenchTransport))
+
+#define BENCH_TRANSPORT_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), BENCH_TYPE_TRANSPORT, BenchTransportClass))
+
+#define BENCH_IS_TRANSPORT(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), BENCH_TYPE_TRANSPORT))
+
+#define BENCH_IS_TRANSPORT_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), BENCH_TYPE_TRANSPORT))
+
+#define BENCH_TRANSPORT_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), BENCH_TYPE_TRANSPORT, BenchTransportClass))
+
+typedef struct {
+  GObject parent;
+} BenchTransport;
+
+typedef struct {
+  GObjectClass parent;
+} BenchTransportClass;
+
+/*
+ * CPU time spent handling one kind of event, in nanoseconds.
+ */
+typedef struct {
+  uint64_t  count;
+  uint64_t  total_ns;
+  uint64_t  max_ns;
+} BenchCost;
+
+int64_t
+bench_cost_begin (void);
+
+void
+bench_cost_end (BenchCost *self,
+                int64_t    begin);
+
+GType
+bench_transport_get_type (void) G_GNUC_CONST;
+
+BenchTransport *
+bench_transport_new (char const *contact_id,
+                     unsigned    resolve_delay_ms);
+
+BenchCost const *
+bench_transport_get_resolve_cost (BenchTransport *self);
+
+G_END_DECLS
+
+#endif /* BENCH_TRANSPORT_H */
@@ -0,0 +1,621 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+/*
+ * Micro-benchmarks for the message codec, no transport involved.
+ *
+ *   create-message
+ *       yts_message_new_for_payload(), what yts_service_send_text() and
+ *       friends build: the payload is printed and escaped right away.
+ *   invocation-message
+ *       yts_invocation_message_new(), including serialisation of the
+ *       deferred arguments.
+ *   metadata-extract
+ *       yts_metadata_extract() on a ready message, as the Telepathy
+ *       transport does before sending.
+ *   dispatch-parse
+ *       the decoding steps of the client's dispatch_to_service(): parsing
+ *       the XML, looking up the routing attributes, unescaping the payload.
+ *   unescape
+ *       yts_metadata_unescape_payload() alone.
+ *
+ * Each benchmark runs over a corpus of text, list, dictionary and
+ * invocation argument payloads of increasing size. Allocations are
+ * counted through a GMemVTable, with GSlice routed through malloc, so
+ * "allocs/op" includes the GObject, GVariant and RestXmlNode overhead.
+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <rest/rest-xml-parser.h>
+
+#include <ytstenut/ytstenut.h>
+#include "ytstenut/yts-invocation-message.h"
+#include "ytstenut/yts-message.h"
+#include "ytstenut/yts-metadata-internal.h"
+
+#define PLAYER_FQC_ID "org.freedesktop.ytstenut.VideoProfile.Player"
+
+/*
+ * Allocation accounting.
+ */
+
+static uint64_t _n_allocs = 0;
+static uint64_t _n_bytes = 0;
+
+static gpointer
+_counting_malloc (gsize n_bytes)
+{
+  _n_allocs++;
+  _n_bytes += n_bytes;
+  return malloc (n_bytes);
+}
+
+static gpointer
+_counting_realloc (gpointer mem,
+                   gsize    n_bytes)
+{
+  _n_allocs++;
+  _n_bytes += n_bytes;
+  return realloc (mem, n_bytes);
+}
+
+static gpointer
+_counting_calloc (gsize n_blocks,
+                  gsize n_block_bytes)
+{
+  _n_allocs++;
+  _n_bytes += n_blocks * n_block_bytes;
+  return calloc (n_blocks, n_block_bytes);
+}
+
+static GMemVTable _counting_vtable = {
+  _counting_malloc,
+  _counting_realloc,
+  free,
+  _counting_calloc,
+  _counting_malloc,
+  _counting_realloc
+};
+
+/*
+ * Corpus.
+ */
+
+typedef enum {
+  PAYLOAD_TEXT,
+  PAYLOAD_LIST,
+  PAYLOAD_DICTIONARY,
+  PAYLOAD_ARGUMENTS
+} PayloadKind;
+
+static char const *const _payload_types[] = {
+  "text",
+  "list",
+  "dictionary",
+  "invocation"
+};
+
+typedef struct {
+  char        *name;
+  PayloadKind  kind;
+  char const  *aspect;
+  GVariant    *payload;
+  /* Derived */
+  char        *escaped;
+  char        *xml;
+  YtsMetadata *message;
+} Sample;
+
+/* Titles, people's names and URIs are what passes through, so there is a
+ * fair share of characters that need escaping and non-ASCII. */
+static char const *const _phrases[] = {
+  "Now playing: \"Hüsker Dü – Don't Want to Know If You Are Lonely\"",
+  " <live at First Avenue> & encore;",
+  " Björk, Sigur Rós & Mùm — 12\" remixes",
+  " file:///media/Music/Various%20Artists/Compilation (Disc 2)/",
+  " 100% € & ¥ [bonus]"
+};
+
+static char *
+make_text (size_t size)
+{
+  GString     *str;
+  unsigned     i;
+  char const  *end;
+
+  str = g_string_sized_new (size + 128);
+  for (i = 0; str->len < size; i++) {
+    g_string_append (str, _phrases[i % G_N_ELEMENTS (_phrases)]);
+  }
+
+  /* Cut at a character boundary. */
+  end = str->str + size;
+  if (!g_utf8_validate (str->str, size, NULL)) {
+    end = g_utf8_find_prev_char (str->str, end);
+  }
+  g_string_truncate (str, end - str->str);
+
+  return g_string_free (str, false);
+}
+
+static GVariant *
+make_list (unsigned length)
+{
+  GVariantBuilder  builder;
+  unsigned         i;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("as"));
+  for (i = 0; i < length; i++) {
+    char *uri = g_strdup_printf ("file:///media/Music/Artist %u/"
+                                 "Album (%u)/%02u - Track #%u.ogg",
+                                 i % 7, i % 3, i, i);
+    g_variant_builder_add (&builder, "s", uri);
+    g_free (uri);
+  }
+
+  return g_variant_builder_end (&builder);
+}
+
+static GVariant *
+make_dictionary (unsigned length)
+{
+  static char const *const keys[] = {
+    "title", "artist", "album", "genre", "uri", "comment", "date", "mime"
+  };
+  GVariantBuilder  builder;
+  unsigned         i;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{ss}"));
+  for (i = 0; i < length; i++) {
+    char *key = g_strdup_printf ("%s-%u", keys[i % G_N_ELEMENTS (keys)], i);
+    char *value = make_text (16 + (i % 4) * 16);
+    g_variant_builder_add (&builder, "{ss}", key, value);
+    g_free (value);
+    g_free (key);
+  }
+
+  return g_variant_builder_end (&builder);
+}
+
+static GVariant *
+make_metadata_arguments (unsigned length)
+{
+  GVariantBuilder  builder;
+  unsigned         i;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+  for (i = 0; i < length; i++) {
+    char *key = g_strdup_printf ("xesam:field-%u", i);
+    GVariant *value;
+    switch (i % 3) {
+      case 0: {
+        char *text = make_text (32);
+        value = g_variant_new_string (text);
+        g_free (text);
+      } break;
+      case 1:
+        /* Integers other than int32 don't survive the untyped print. */
+        value = g_variant_new_boolean (i % 2);
+        break;
+      default:
+        value = g_variant_new_double (i / 7.0);
+    }
+    g_variant_builder_add (&builder, "{sv}", key, value);
+    g_free (key);
+  }
+
+  return g_variant_builder_end (&builder);
+}
+
+static Sample *
+sample_new (PayloadKind  kind,
+            char const  *aspect,
+            GVariant    *payload,
+            char const  *name_format,
+            ...)
+{
+  Sample  *self;
+  va_list  args;
+
+  self = g_new0 (Sample, 1);
+  va_start (args, name_format);
+  self->name = g_strdup_vprintf (name_format, args);
+  va_end (args);
+  self->kind = kind;
+  self->aspect = aspect;
+  self->payload = g_variant_ref_sink (payload);
+
+  self->escaped = yts_metadata_escape_payload (self->payload);
+
+  if (kind == PAYLOAD_ARGUMENTS) {
+    self->message = yts_invocation_message_new ("42",
+                                                PLAYER_FQC_ID,
+                                                aspect,
+                                                self->payload);
+  } else {
+    self->message = yts_message_new_for_payload (_payload_types[kind],
+                                                 SERVICE_FQC_ID,
+                                                 self->payload);
+  }
+  /* What the connection manager adds on the way. */
+  yts_metadata_add_attribute (self->message,
+                              "from-service",
+                              "org.freedesktop.ytstenut.CodecBench");
+  self->xml = yts_metadata_to_string (self->message);
+
+  return self;
+}
+
+static void
+sample_destroy (Sample *self)
+{
+  g_object_unref (self->message);
+  g_free (self->xml);
+  g_free (self->escaped);
+  g_variant_unref (self->payload);
+  g_free (self->name);
+  g_free (self);
+}
+
+static GPtrArray *
+corpus_new (void)
+{
+  static unsigned const text_sizes[] = { 16, 256, 4096 };
+  static unsigned const lengths[] = { 8, 64 };
+  GPtrArray *corpus;
+  unsigned   i;
+
+  corpus = g_ptr_array_new_with_free_func ((GDestroyNotify) sample_destroy);
+
+  for (i = 0; i < G_N_ELEMENTS (text_sizes); i++) {
+    char *text = make_text (text_sizes[i]);
+    g_ptr_array_add (corpus,
+                     sample_new (PAYLOAD_TEXT, NULL,
+                                 g_variant_new_string (text),
+                                 "text-%u", text_sizes[i]));
+    g_free (text);
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (lengths); i++) {
+    g_ptr_array_add (corpus,
+                     sample_new (PAYLOAD_LIST, NULL,
+                                 make_list (lengths[i]),
+                                 "list-%u", lengths[i]));
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (lengths); i++) {
+    g_ptr_array_add (corpus,
+                     sample_new (PAYLOAD_DICTIONARY, NULL,
+                                 make_dictionary (lengths[i]),
+                                 "dictionary-%u", lengths[i]));
+  }
+
+  /* Typical player invocations, and a metadata update. */
+  g_ptr_array_add (corpus,
+                   sample_new (PAYLOAD_ARGUMENTS, "volume",
+                               g_variant_new_double (0.75),
+                               "arguments-volume"));
+  {
+    char *uri = make_text (128);
+    g_ptr_array_add (corpus,
+                     sample_new (PAYLOAD_ARGUMENTS, "playable-uri",
+                                 g_variant_new_string (uri),
+                                 "arguments-playable-uri"));
+    g_free (uri);
+  }
+  g_ptr_array_add (corpus,
+                   sample_new (PAYLOAD_ARGUMENTS, "metadata",
+                               make_metadata_arguments (24),
+                               "arguments-metadata-24"));
+
+  return corpus;
+}
+
+/*
+ * Benchmarks, one operation each, freeing everything it allocates.
+ */
+
+typedef bool (*BenchFunc) (Sample const *sample);
+
+static bool
+bench_create_message (Sample const *sample)
+{
+  YtsMetadata *message;
+
+  if (sample->kind == PAYLOAD_ARGUMENTS)
+    return false;
+
+  message = yts_message_new_for_payload (_payload_types[sample->kind],
+                                         SERVICE_FQC_ID,
+                                         sample->payload);
+  g_object_unref (message);
+
+  return true;
+}
+
+static bool
+bench_invocation_message (Sample const *sample)
+{
+  YtsMetadata *message;
+
+  if (sample->kind != PAYLOAD_ARGUMENTS)
+    return false;
+
+  message = yts_invocation_message_new ("42",
+                                        PLAYER_FQC_ID,
+                                        sample->aspect,
+                                        sample->payload);
+  /* Forces the arguments to be serialised. */
+  yts_metadata_get_root_node (message);
+  g_object_unref (message);
+
+  return true;
+}
+
+static bool
+bench_metadata_extract (Sample const *sample)
+{
+  GHashTable  *attrs;
+  char        *body = NULL;
+
+  attrs = yts_metadata_extract (sample->message, &body);
+  g_hash_table_unref (attrs);
+  g_free (body);
+
+  return true;
+}
+
+static bool
+bench_dispatch_parse (Sample const *sample)
+{
+  RestXmlParser *parser;
+  RestXmlNode   *node;
+  char const    *escaped;
+  GVariant      *payload;
+
+  parser = rest_xml_parser_new ();
+  node = rest_xml_parser_parse_from_data (parser,
+                                          sample->xml,
+                                          strlen (sample->xml));
+  g_assert (node);
+
+  g_assert (rest_xml_node_get_attr (node, "from-service"));
+  g_assert (rest_xml_node_get_attr (node, "capability"));
+  g_assert (rest_xml_node_get_attr (node, "type"));
+
+  if (sample->kind == PAYLOAD_ARGUMENTS) {
+    rest_xml_node_get_attr (node, "invocation");
+    rest_xml_node_get_attr (node, "aspect");
+    escaped = rest_xml_node_get_attr (node, "arguments");
+  } else {
+    escaped = rest_xml_node_get_attr (node, "payload");
+  }
+
+  payload = yts_metadata_unescape_payload (escaped);
+  g_variant_unref (payload);
+
+  rest_xml_node_unref (node);
+  g_object_unref (parser);
+
+  return true;
+}
+
+static bool
+bench_unescape (Sample const *sample)
+{
+  GVariant *payload;
+
+  payload = yts_metadata_unescape_payload (sample->escaped);
+  g_variant_unref (payload);
+
+  return true;
+}
+
+typedef struct {
+  char const  *name;
+  BenchFunc    func;
+} Benchmark;
+
+static Benchmark const _benchmarks[] = {
+  { "create-message", bench_create_message },
+  { "invocation-message", bench_invocation_message },
+  { "metadata-extract", bench_metadata_extract },
+  { "dispatch-parse", bench_dispatch_parse },
+  { "unescape", bench_unescape }
+};
+
+static void
+run_benchmark (Benchmark const  *benchmark,
+               Sample const     *sample,
+               unsigned          iterations,
+               GString          *json)
+{
+  unsigned  warmup;
+  unsigned  i;
+  int64_t   start_time;
+  int64_t   elapsed;
+  uint64_t  n_allocs;
+  uint64_t  n_bytes;
+  double    ns_per_op;
+  double    allocs_per_op;
+  double    bytes_per_op;
+
+  /* Benchmark doesn't apply to this kind of payload. */
+  if (!benchmark->func (sample))
+    return;
+
+  /* Fill caches, intern type strings and the like. */
+  warmup = MAX (iterations / 10, 1);
+  for (i = 0; i < warmup; i++) {
+    benchmark->func (sample);
+  }
+
+  n_allocs = _n_allocs;
+  n_bytes = _n_bytes;
+  start_time = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++) {
+    benchmark->func (sample);
+  }
+  elapsed = g_get_monotonic_time () - start_time;
+  n_allocs = _n_allocs - n_allocs;
+  n_bytes = _n_bytes - n_bytes;
+
+  ns_per_op = elapsed * 1000.0 / iterations;
+  allocs_per_op = (double) n_allocs / iterations;
+  bytes_per_op = (double) n_bytes / iterations;
+
+  g_printerr ("  %-20s %-24s %10.0f ns/op %8.1f allocs/op %10.0f B/op\n",
+              benchmark->name,
+              sample->name,
+              ns_per_op,
+              allocs_per_op,
+              bytes_per_op);
+
+  if (json->len) {
+    g_string_append (json, ",\n");
+  }
+  g_string_append_printf (json,
+    "    {\n"
+    "      \"name\": \"%s\",\n"
+    "      \"payload\": \"%s\",\n"
+    "      \"xml_size\": %u,\n"
+    "      \"iterations\": %u,\n"
+    "      \"ns_per_op\": %.1f,\n"
+    "      \"allocs_per_op\": %.2f,\n"
+    "      \"bytes_per_op\": %.1f\n"
+    "    }",
+    benchmark->name,
+    sample->name,
+    (unsigned) strlen (sample->xml),
+    iterations,
+    ns_per_op,
+    allocs_per_op,
+    bytes_per_op);
+}
+
+int
+main (int     argc,
+      char  **argv)
+{
+  int        iterations = 10000;
+  char      *filter = NULL;
+  char      *output = NULL;
+  GOptionEntry entries[] = {
+    { "iterations", 'n', 0, G_OPTION_ARG_INT, &iterations,
+      "Operations per benchmark and payload", "<count>" },
+    { "filter", 'f', 0, G_OPTION_ARG_STRING, &filter,
+      "Only run benchmarks whose name contains this string", "<name>" },
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+      "Write JSON results to file instead of stdout", "<file>" },
+    { NULL, }
+  };
+  GOptionContext  *context;
+  GPtrArray       *corpus;
+  GString         *results;
+  GString         *json;
+  GError          *error = NULL;
+  unsigned         i;
+  unsigned         j;
+  int              ret = EXIT_SUCCESS;
+
+  /* Must come before anything is allocated. */
+  g_mem_set_vtable (&_counting_vtable);
+  g_setenv ("G_SLICE", "always-malloc", true);
+
+  g_type_init ();
+
+  context = g_option_context_new ("- message codec benchmarks");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_parse (context, &argc, &argv, &error);
+  g_option_context_free (context);
+  if (error) {
+    g_warning ("%s : %s", G_STRLOC, error->message);
+    g_clear_error (&error);
+    return EXIT_FAILURE;
+  }
+
+  if (iterations <= 0) {
+    g_warning ("%s : Invalid number of iterations %i", G_STRLOC, iterations);
+    return EXIT_FAILURE;
+  }
+
+  corpus = corpus_new ();
+
+  /* Sanity check, the codec has to round-trip what we measure. */
+  for (j = 0; j < corpus->len; j++) {
+    Sample const *sample = g_ptr_array_index (corpus, j);
+    GVariant *payload = yts_metadata_unescape_payload (sample->escaped);
+    if (!g_variant_equal (sample->payload, payload)) {
+      g_warning ("%s : Payload '%s' doesn't survive the codec",
+                 G_STRLOC,
+                 sample->name);
+      ret = EXIT_FAILURE;
+    }
+    g_variant_unref (payload);
+  }
+
+  results = g_string_new ("");
+  for (i = 0; i < G_N_ELEMENTS (_benchmarks); i++) {
+    if (filter && !strstr (_benchmarks[i].name, filter))
+      continue;
+    for (j = 0; j < corpus->len; j++) {
+      run_benchmark (&_benchmarks[i],
+                     g_ptr_array_index (corpus, j),
+                     iterations,
+                     results);
+    }
+  }
+
+  json = g_string_new ("");
+  g_string_append_printf (json,
+                          "{\n"
+                          "  \"benchmark\": \"codec-bench\",\n"
+                          "  \"version\": \"%s\",\n"
+                          "  \"results\": [\n"
+                          "%s\n"
+                          "  ]\n"
+                          "}\n",
+                          YTS_VERSION_S,
+                          results->str);
+
+  if (output) {
+    if (!g_file_set_contents (output, json->str, json->len, &error)) {
+      g_warning ("%s : %s", G_STRLOC, error->message);
+      g_clear_error (&error);
+      ret = EXIT_FAILURE;
+    }
+  } else {
+    fputs (json->str, stdout);
+  }
+
+  g_string_free (json, true);
+  g_string_free (results, true);
+  g_ptr_array_free (corpus, true);
+  g_free (filter);
+  g_free (output);
+
+  return ret;
+}
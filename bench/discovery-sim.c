@@ -0,0 +1,734 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+/*
+ * Mesh-scale discovery simulator.
+ *
+ * One YtsClient runs over a synthetic transport, see bench-transport.c,
+ * and the simulator plays the mesh: thousands of contacts announcing their
+ * services, status updates, services going away and coming back. Nothing
+ * leaves the process, so storms far larger than a development network
+ * can produce are cheap to reproduce.
+ *
+ * The run has two phases. During join, every contact's services are
+ * announced at --join-rate (all at once when 0), the client is ready once
+ * the roster holds every contact and service. Churn then goes on for
+ * --duration seconds, with status changes at --status-rate and services
+ * being removed or re-added at --churn-rate.
+ *
+ * Reported are time-to-ready, peak RSS, main loop stalls as seen by a
+ * heartbeat timer, and the CPU time spent handling each kind of event.
+ * Handling is synchronous all the way through YtsRoster, YtsContact and
+ * YtsService, so the cost of an event is the cost of emitting it; contact
+ * resolution is timed by the transport.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <glib.h>
+
+#include <ytstenut/ytstenut.h>
+#include "bench-transport.h"
+
+#define CLIENT_CONTACT_ID "simulator@ytstenut"
+#define CLIENT_SERVICE_ID "org.freedesktop.ytstenut.DiscoverySimulator"
+#define SERVICE_TYPE "application"
+
+/* Driver granularity, events are spread over ticks at the given rates. */
+#define TICK_MS 10
+
+/* Heartbeat used to detect main loop stalls. */
+#define HEARTBEAT_MS 5
+
+typedef enum {
+  SERVICE_ABSENT,
+  SERVICE_PENDING,  /* announced, not in the roster yet */
+  SERVICE_VISIBLE
+} ServiceState;
+
+typedef struct {
+  char          *contact_id;
+  char          *service_id;
+  char const    *fqc_id;
+  ServiceState   state;
+  unsigned       status_seq;
+} SimService;
+
+typedef enum {
+  EVENT_SERVICE_ADDED,
+  EVENT_SERVICE_REMOVED,
+  EVENT_STATUS_CHANGED,
+
+  N_EVENTS
+} EventKind;
+
+static char const *const _event_names[] = {
+  "service-added",
+  "service-removed",
+  "status-changed"
+};
+
+typedef struct {
+  /* Configuration */
+  unsigned         n_contacts;
+  unsigned         n_services;
+  double           join_rate;
+  double           status_rate;
+  double           churn_rate;
+  unsigned         duration_s;
+  /* Data */
+  GMainLoop       *mainloop;
+  GRand           *rand;
+  BenchTransport  *transport;
+  YtsClient       *client;
+  GPtrArray       *services;        /* SimService */
+  GHashTable      *services_by_id;  /* unowned SimService */
+  GPtrArray       *visible;         /* unowned SimService, for picking */
+  unsigned         join_cursor;
+  double           join_budget;
+  double           status_budget;
+  double           churn_budget;
+  unsigned         n_contacts_visible;
+  /* Timing */
+  int64_t          connect_time;
+  int64_t          ready_time;
+  int64_t          churn_end_time;
+  int64_t          tick_time;
+  int64_t          heartbeat_time;
+  GArray          *stalls;          /* int64_t, microseconds */
+  BenchCost        costs[N_EVENTS];
+  long             ready_rss_kb;
+  /* Watches */
+  unsigned         tick_id;
+  unsigned         heartbeat_id;
+  int              ret;
+} Sim;
+
+static char const *const _fqc_ids[] = {
+  "org.freedesktop.ytstenut.VideoProfile.Player",
+  "org.freedesktop.ytstenut.VideoProfile.Content",
+  "org.freedesktop.ytstenut.VideoProfile.Transcript"
+};
+
+static void
+sim_service_free (SimService *self)
+{
+  g_free (self->contact_id);
+  g_free (self->service_id);
+  g_slice_free (SimService, self);
+}
+
+static long
+peak_rss_kb (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  /* Kilobytes on Linux. */
+  return usage.ru_maxrss;
+}
+
+static int
+_compare_int64 (int64_t const *a,
+                int64_t const *b)
+{
+  return *a < *b ? -1 : *a > *b ? 1 : 0;
+}
+
+/*
+ * Visible set, for picking random services to churn.
+ */
+
+static void
+visible_remove (Sim         *self,
+                SimService  *service)
+{
+  unsigned i;
+
+  for (i = 0; i < self->visible->len; i++) {
+    if (service == g_ptr_array_index (self->visible, i)) {
+      g_ptr_array_remove_index_fast (self->visible, i);
+      return;
+    }
+  }
+}
+
+static SimService *
+visible_pick (Sim *self)
+{
+  if (0 == self->visible->len) {
+    return NULL;
+  }
+
+  return g_ptr_array_index (self->visible,
+                            g_rand_int_range (self->rand,
+                                              0, self->visible->len));
+}
+
+/*
+ * Events, as the mesh would deliver them.
+ */
+
+static void
+emit_service_added (Sim         *self,
+                    SimService  *service)
+{
+  char const  *caps[2] = { service->fqc_id, NULL };
+  GHashTable  *names;
+  GHashTable  *statuses;
+  char        *name;
+  char        *status;
+  int64_t      begin;
+
+  names = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+  name = g_strdup_printf ("Simulated %s", service->service_id);
+  g_hash_table_insert (names, "en_GB", name);
+
+  statuses = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+  status = g_strdup_printf ("<status xmlns='%s' from-service='%s' "
+                                    "seq='%u' activity='idle'/>",
+                            service->fqc_id,
+                            service->service_id,
+                            service->status_seq);
+  g_hash_table_insert (statuses, (char *) service->fqc_id, status);
+
+  service->state = SERVICE_PENDING;
+
+  begin = bench_cost_begin ();
+  yts_transport_emit_service_added (YTS_TRANSPORT (self->transport),
+                                    service->contact_id,
+                                    service->service_id,
+                                    SERVICE_TYPE,
+                                    caps,
+                                    names,
+                                    statuses);
+  bench_cost_end (&self->costs[EVENT_SERVICE_ADDED], begin);
+
+  g_hash_table_unref (statuses);
+  g_hash_table_unref (names);
+}
+
+static void
+emit_service_removed (Sim         *self,
+                      SimService  *service)
+{
+  int64_t begin;
+
+  begin = bench_cost_begin ();
+  yts_transport_emit_service_removed (YTS_TRANSPORT (self->transport),
+                                      service->contact_id,
+                                      service->service_id);
+  bench_cost_end (&self->costs[EVENT_SERVICE_REMOVED], begin);
+}
+
+static void
+emit_status_changed (Sim        *self,
+                     SimService *service)
+{
+  char    *status;
+  int64_t  begin;
+
+  service->status_seq++;
+  status = g_strdup_printf ("<status xmlns='%s' from-service='%s' "
+                                    "seq='%u' activity='%s'/>",
+                            service->fqc_id,
+                            service->service_id,
+                            service->status_seq,
+                            service->status_seq % 2 ? "playing" : "paused");
+
+  begin = bench_cost_begin ();
+  yts_transport_emit_status_changed (YTS_TRANSPORT (self->transport),
+                                     service->contact_id,
+                                     service->fqc_id,
+                                     service->service_id,
+                                     status);
+  bench_cost_end (&self->costs[EVENT_STATUS_CHANGED], begin);
+
+  g_free (status);
+}
+
+/*
+ * Roster, to find out what the client has seen.
+ */
+
+static void
+check_ready (Sim *self)
+{
+  if (self->ready_time ||
+      self->join_cursor < self->services->len ||
+      self->visible->len < self->services->len ||
+      self->n_contacts_visible < self->n_contacts) {
+    return;
+  }
+
+  self->ready_time = g_get_monotonic_time ();
+  self->ready_rss_kb = peak_rss_kb ();
+  self->churn_end_time = self->ready_time +
+                         self->duration_s * G_USEC_PER_SEC;
+}
+
+static void
+_roster_contact_added (YtsRoster  *roster,
+                       YtsContact *contact,
+                       Sim        *self)
+{
+  self->n_contacts_visible++;
+  check_ready (self);
+}
+
+static void
+_roster_contact_removed (YtsRoster  *roster,
+                         YtsContact *contact,
+                         Sim        *self)
+{
+  self->n_contacts_visible--;
+}
+
+static void
+_roster_service_added (YtsRoster  *roster,
+                       YtsService *service,
+                       Sim        *self)
+{
+  SimService *sim_service;
+
+  sim_service = g_hash_table_lookup (self->services_by_id,
+                                     yts_service_get_id (service));
+  g_return_if_fail (sim_service);
+
+  if (SERVICE_VISIBLE != sim_service->state) {
+    sim_service->state = SERVICE_VISIBLE;
+    g_ptr_array_add (self->visible, sim_service);
+  }
+
+  check_ready (self);
+}
+
+static void
+_roster_service_removed (YtsRoster  *roster,
+                         YtsService *service,
+                         Sim        *self)
+{
+  SimService *sim_service;
+
+  sim_service = g_hash_table_lookup (self->services_by_id,
+                                     yts_service_get_id (service));
+  g_return_if_fail (sim_service);
+
+  if (SERVICE_VISIBLE == sim_service->state) {
+    visible_remove (self, sim_service);
+  }
+  sim_service->state = SERVICE_ABSENT;
+}
+
+/*
+ * Driver
+ */
+
+static unsigned
+take_budget (double   *budget,
+             double    rate,
+             int64_t   elapsed_us)
+{
+  unsigned n;
+
+  *budget += rate * elapsed_us / G_USEC_PER_SEC;
+  n = (unsigned) *budget;
+  *budget -= n;
+
+  return n;
+}
+
+static void
+sim_join (Sim     *self,
+          int64_t  elapsed_us)
+{
+  unsigned n;
+
+  if (self->join_rate > 0) {
+    n = take_budget (&self->join_budget, self->join_rate, elapsed_us);
+  } else {
+    /* Storm, everybody at once. */
+    n = self->services->len;
+  }
+
+  for (; n && self->join_cursor < self->services->len; n--) {
+    emit_service_added (self, g_ptr_array_index (self->services,
+                                                 self->join_cursor++));
+  }
+}
+
+static void
+sim_churn (Sim      *self,
+           int64_t   elapsed_us)
+{
+  unsigned n;
+  unsigned i;
+
+  n = take_budget (&self->status_budget, self->status_rate, elapsed_us);
+  for (i = 0; i < n; i++) {
+    SimService *service = visible_pick (self);
+    if (service) {
+      emit_status_changed (self, service);
+    }
+  }
+
+  /* Half the churn takes services away, the other half brings back
+   * what is gone. */
+  n = take_budget (&self->churn_budget, self->churn_rate, elapsed_us);
+  for (i = 0; i < n; i++) {
+    SimService *service;
+    if (g_rand_boolean (self->rand)) {
+      service = visible_pick (self);
+      if (service) {
+        emit_service_removed (self, service);
+      }
+    } else {
+      service = g_ptr_array_index (self->services,
+                                   g_rand_int_range (self->rand,
+                                                     0, self->services->len));
+      if (SERVICE_ABSENT == service->state) {
+        emit_service_added (self, service);
+      }
+    }
+  }
+}
+
+static bool
+_tick (Sim *self)
+{
+  int64_t now = g_get_monotonic_time ();
+  int64_t elapsed = now - self->tick_time;
+
+  self->tick_time = now;
+
+  if (0 == self->ready_time) {
+    sim_join (self, elapsed);
+  } else if (now < self->churn_end_time) {
+    sim_churn (self, elapsed);
+  } else {
+    g_main_loop_quit (self->mainloop);
+    self->tick_id = 0;
+    return false;
+  }
+
+  return true;
+}
+
+static bool
+_heartbeat (Sim *self)
+{
+  int64_t now = g_get_monotonic_time ();
+  int64_t stall = now - self->heartbeat_time - HEARTBEAT_MS * 1000;
+
+  self->heartbeat_time = now;
+  g_array_append_val (self->stalls, stall);
+
+  return true;
+}
+
+static void
+_client_ready (YtsClient  *client,
+               Sim        *self)
+{
+  self->tick_time = g_get_monotonic_time ();
+  self->tick_id = g_timeout_add (TICK_MS, (GSourceFunc) _tick, self);
+}
+
+static bool
+_watchdog (Sim *self)
+{
+  if (0 == self->ready_time) {
+    g_warning ("%s : Roster incomplete, %u of %u services, %u of %u contacts",
+               G_STRLOC,
+               self->visible->len, self->services->len,
+               self->n_contacts_visible, self->n_contacts);
+    self->ret = EXIT_FAILURE;
+    g_main_loop_quit (self->mainloop);
+  }
+
+  return false;
+}
+
+/*
+ * Report
+ */
+
+static void
+append_cost_json (GString         *json,
+                  char const      *name,
+                  BenchCost const *cost,
+                  bool             last)
+{
+  g_string_append_printf (json,
+    "    \"%s\": {\n"
+    "      \"count\": %" G_GUINT64_FORMAT ",\n"
+    "      \"mean_ns\": %" G_GUINT64_FORMAT ",\n"
+    "      \"max_ns\": %" G_GUINT64_FORMAT "\n"
+    "    }%s\n",
+    name,
+    cost->count,
+    cost->count ? cost->total_ns / cost->count : 0,
+    cost->max_ns,
+    last ? "" : ",");
+}
+
+static GString *
+sim_report (Sim *self)
+{
+  GString   *json;
+  int64_t    p99 = 0;
+  int64_t    max = 0;
+  unsigned   over_16ms = 0;
+  unsigned   over_100ms = 0;
+  unsigned   i;
+
+  if (self->stalls->len) {
+    g_array_sort (self->stalls, (GCompareFunc) _compare_int64);
+    p99 = g_array_index (self->stalls, int64_t,
+                         (self->stalls->len - 1) * 99 / 100);
+    max = g_array_index (self->stalls, int64_t, self->stalls->len - 1);
+    for (i = 0; i < self->stalls->len; i++) {
+      int64_t stall = g_array_index (self->stalls, int64_t, i);
+      if (stall > 16000)
+        over_16ms++;
+      if (stall > 100000)
+        over_100ms++;
+    }
+  }
+
+  json = g_string_new ("");
+  g_string_append_printf (json,
+    "{\n"
+    "  \"benchmark\": \"discovery-sim\",\n"
+    "  \"version\": \"%s\",\n"
+    "  \"contacts\": %u,\n"
+    "  \"services_per_contact\": %u,\n"
+    "  \"join_rate\": %.1f,\n"
+    "  \"status_rate\": %.1f,\n"
+    "  \"churn_rate\": %.1f,\n"
+    "  \"duration_s\": %u,\n"
+    "  \"time_to_ready_us\": %" G_GINT64_FORMAT ",\n"
+    "  \"peak_rss_kb\": {\n"
+    "    \"ready\": %ld,\n"
+    "    \"end\": %ld\n"
+    "  },\n"
+    "  \"stalls_us\": {\n"
+    "    \"samples\": %u,\n"
+    "    \"p99\": %" G_GINT64_FORMAT ",\n"
+    "    \"max\": %" G_GINT64_FORMAT ",\n"
+    "    \"over_16ms\": %u,\n"
+    "    \"over_100ms\": %u\n"
+    "  },\n"
+    "  \"cpu\": {\n",
+    YTS_VERSION_S,
+    self->n_contacts,
+    self->n_services,
+    self->join_rate,
+    self->status_rate,
+    self->churn_rate,
+    self->duration_s,
+    self->ready_time - self->connect_time,
+    self->ready_rss_kb,
+    peak_rss_kb (),
+    self->stalls->len,
+    p99,
+    max,
+    over_16ms,
+    over_100ms);
+
+  for (i = 0; i < N_EVENTS; i++) {
+    append_cost_json (json, _event_names[i], &self->costs[i], false);
+  }
+  append_cost_json (json,
+                    "contact-resolved",
+                    bench_transport_get_resolve_cost (self->transport),
+                    true);
+
+  g_string_append (json, "  }\n}\n");
+
+  return json;
+}
+
+int
+main (int     argc,
+      char  **argv)
+{
+  int        n_contacts = 1000;
+  int        n_services = 2;
+  double     join_rate = 0;
+  double     status_rate = 100;
+  double     churn_rate = 10;
+  int        duration_s = 10;
+  int        resolve_delay_ms = 0;
+  int        timeout_s = 120;
+  char      *output = NULL;
+  GOptionEntry entries[] = {
+    { "contacts", 'c', 0, G_OPTION_ARG_INT, &n_contacts,
+      "Number of simulated contacts", "<count>" },
+    { "services", 's', 0, G_OPTION_ARG_INT, &n_services,
+      "Services per contact", "<count>" },
+    { "join-rate", 'j', 0, G_OPTION_ARG_DOUBLE, &join_rate,
+      "Services announced per second while joining, 0 for all at once",
+      "<rate>" },
+    { "status-rate", 0, 0, G_OPTION_ARG_DOUBLE, &status_rate,
+      "Status changes per second during churn", "<rate>" },
+    { "churn-rate", 0, 0, G_OPTION_ARG_DOUBLE, &churn_rate,
+      "Services removed or re-added per second during churn", "<rate>" },
+    { "duration", 'd', 0, G_OPTION_ARG_INT, &duration_s,
+      "Seconds of churn after the roster is complete", "<seconds>" },
+    { "resolve-delay", 0, 0, G_OPTION_ARG_INT, &resolve_delay_ms,
+      "Milliseconds contact resolution takes", "<ms>" },
+    { "timeout", 0, 0, G_OPTION_ARG_INT, &timeout_s,
+      "Seconds to wait for the roster to complete", "<seconds>" },
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+      "Write JSON results to file instead of stdout", "<file>" },
+    { NULL, }
+  };
+  GOptionContext  *context;
+  YtsRoster       *roster;
+  GString         *json;
+  GError          *error = NULL;
+  Sim              sim;
+  unsigned         i;
+  unsigned         j;
+
+  g_type_init ();
+
+  context = g_option_context_new ("- mesh-scale discovery simulator");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_parse (context, &argc, &argv, &error);
+  g_option_context_free (context);
+  if (error) {
+    g_warning ("%s : %s", G_STRLOC, error->message);
+    g_clear_error (&error);
+    return EXIT_FAILURE;
+  }
+
+  if (n_contacts <= 0 || n_services <= 0 || duration_s < 0 ||
+      resolve_delay_ms < 0 || timeout_s <= 0 ||
+      join_rate < 0 || status_rate < 0 || churn_rate < 0) {
+    g_warning ("%s : Invalid arguments, see --help", G_STRLOC);
+    return EXIT_FAILURE;
+  }
+
+  memset (&sim, 0, sizeof (sim));
+  sim.n_contacts = n_contacts;
+  sim.n_services = n_services;
+  sim.join_rate = join_rate;
+  sim.status_rate = status_rate;
+  sim.churn_rate = churn_rate;
+  sim.duration_s = duration_s;
+  sim.ret = EXIT_SUCCESS;
+
+  /* Same mesh every run. */
+  sim.rand = g_rand_new_with_seed (0x5eed);
+
+  sim.services = g_ptr_array_new_with_free_func (
+                                        (GDestroyNotify) sim_service_free);
+  sim.services_by_id = g_hash_table_new (g_str_hash, g_str_equal);
+  sim.visible = g_ptr_array_new ();
+  for (i = 0; i < sim.n_contacts; i++) {
+    char *contact_id = g_strdup_printf ("device%05u@ytstenut", i);
+    for (j = 0; j < sim.n_services; j++) {
+      SimService *service = g_slice_new0 (SimService);
+      service->contact_id = g_strdup (contact_id);
+      service->service_id = g_strdup_printf (
+                                  "org.freedesktop.ytstenut.Sim.Device%05u."
+                                  "Service%u", i, j);
+      service->fqc_id = _fqc_ids[(i + j) % G_N_ELEMENTS (_fqc_ids)];
+      g_ptr_array_add (sim.services, service);
+      g_hash_table_insert (sim.services_by_id, service->service_id, service);
+    }
+    g_free (contact_id);
+  }
+
+  /* Interleave contacts, like announcements arrive off the network. */
+  for (i = sim.services->len - 1; i > 0; i--) {
+    unsigned k = g_rand_int_range (sim.rand, 0, i + 1);
+    void *tmp = sim.services->pdata[i];
+    sim.services->pdata[i] = sim.services->pdata[k];
+    sim.services->pdata[k] = tmp;
+  }
+
+  sim.stalls = g_array_new (false, false, sizeof (int64_t));
+
+  sim.transport = bench_transport_new (CLIENT_CONTACT_ID, resolve_delay_ms);
+  sim.client = g_object_new (YTS_TYPE_CLIENT,
+                             "service-id",  CLIENT_SERVICE_ID,
+                             "transport",   sim.transport,
+                             NULL);
+  g_signal_connect (sim.client, "ready",
+                    G_CALLBACK (_client_ready), &sim);
+
+  roster = yts_client_get_roster (sim.client);
+  g_signal_connect (roster, "contact-added",
+                    G_CALLBACK (_roster_contact_added), &sim);
+  g_signal_connect (roster, "contact-removed",
+                    G_CALLBACK (_roster_contact_removed), &sim);
+  g_signal_connect (roster, "service-added",
+                    G_CALLBACK (_roster_service_added), &sim);
+  g_signal_connect (roster, "service-removed",
+                    G_CALLBACK (_roster_service_removed), &sim);
+
+  sim.heartbeat_time = g_get_monotonic_time ();
+  sim.heartbeat_id = g_timeout_add (HEARTBEAT_MS,
+                                    (GSourceFunc) _heartbeat, &sim);
+  g_timeout_add_seconds (timeout_s, (GSourceFunc) _watchdog, &sim);
+
+  sim.connect_time = g_get_monotonic_time ();
+  yts_client_connect (sim.client);
+
+  sim.mainloop = g_main_loop_new (NULL, false);
+  g_main_loop_run (sim.mainloop);
+  g_main_loop_unref (sim.mainloop);
+
+  if (sim.tick_id) {
+    g_source_remove (sim.tick_id);
+  }
+  g_source_remove (sim.heartbeat_id);
+
+  json = sim_report (&sim);
+  if (output) {
+    if (!g_file_set_contents (output, json->str, json->len, &error)) {
+      g_warning ("%s : %s", G_STRLOC, error->message);
+      g_clear_error (&error);
+      sim.ret = EXIT_FAILURE;
+    }
+  } else {
+    fputs (json->str, stdout);
+  }
+  g_string_free (json, true);
+
+  g_object_unref (sim.client);
+  g_object_unref (sim.transport);
+  g_array_free (sim.stalls, true);
+  g_ptr_array_free (sim.visible, true);
+  g_hash_table_destroy (sim.services_by_id);
+  g_ptr_array_free (sim.services, true);
+  g_rand_free (sim.rand);
+  g_free (output);
+
+  return sim.ret;
+}
@@ -0,0 +1,901 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+/*
+ * Messaging throughput and latency benchmarks.
+ *
+ * A receiver client publishes a player service, a sender client talks to
+ * it, and for the fan-out runs additional subscriber clients each hold a
+ * player proxy. Every message carries the index of the run, a sequence
+ * number and the time it was sent, so the receiving side can compute the
+ * latency; all clients live in this process and share the monotonic clock.
+ *
+ *   text, list, dictionary
+ *       yts_service_send_text() and friends, sender to receiver.
+ *   invoke
+ *       proxy invocation, setting the player's "playable-uri" remotely.
+ *   round-trip
+ *       proxy invocation with response, yts_vp_player_next().
+ *   fan-out
+ *       the player changes "playable-uri", the event goes to every proxy.
+ *
+ * Payload size is the number of padding bytes added to each message.
+ * Concurrency is the number of messages in flight at any time. Results are
+ * written as JSON, see --help for the sweeps.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include <ytstenut/ytstenut.h>
+#include "tests/test-player.h"
+
+#define MESH_ID "bench"
+#define RECEIVER_SERVICE_ID "org.freedesktop.ytstenut.BenchReceiver"
+#define SENDER_SERVICE_ID "org.freedesktop.ytstenut.BenchSender"
+#define SUBSCRIBER_SERVICE_ID "org.freedesktop.ytstenut.BenchSubscriber"
+
+typedef enum {
+  BENCH_TEXT,
+  BENCH_LIST,
+  BENCH_DICTIONARY,
+  BENCH_INVOKE,
+  BENCH_ROUND_TRIP,
+  BENCH_FAN_OUT
+} BenchKind;
+
+static char const *const _kind_names[] = {
+  "text",
+  "list",
+  "dictionary",
+  "invoke",
+  "round-trip",
+  "fan-out"
+};
+
+typedef struct Bench Bench;
+
+typedef struct {
+  Bench       *bench;
+  unsigned     index;
+  YtsClient   *client;
+  YtsVPPlayer *player;
+} Peer;
+
+typedef struct {
+  /* Configuration */
+  BenchKind  kind;
+  unsigned   payload_size;
+  unsigned   concurrency;
+  unsigned   n_proxies;
+  unsigned   n_messages;
+  /* Data */
+  char      *padding;
+  unsigned   sent;
+  unsigned   completed;
+  unsigned  *deliveries;  /* per message, fan-out only */
+  int64_t    start_time;
+  int64_t    end_time;
+  GArray    *latencies;   /* int64_t, microseconds */
+  bool       timed_out;
+} Run;
+
+struct Bench {
+  /* Configuration */
+  char const  *transport;
+  unsigned     timeout_s;
+  /* Data */
+  GMainLoop   *mainloop;
+  YtsClient   *receiver;
+  TestPlayer  *player;
+  GPtrArray   *peers;
+  unsigned     n_ready_peers;
+  YtsService  *service;   /* the receiver, as seen by the sender */
+  GPtrArray   *runs;
+  unsigned     current;
+  bool         running;
+  int64_t      last_progress;
+  GString     *results;
+  int          ret;
+};
+
+/*
+ * Run
+ */
+
+static Run *
+run_new (BenchKind  kind,
+         unsigned   payload_size,
+         unsigned   concurrency,
+         unsigned   n_proxies,
+         unsigned   n_messages)
+{
+  Run *self;
+
+  self = g_slice_new0 (Run);
+  self->kind = kind;
+  self->payload_size = payload_size;
+  self->concurrency = MAX (concurrency, 1);
+  self->n_proxies = MAX (n_proxies, 1);
+  self->n_messages = n_messages;
+
+  self->padding = g_malloc (payload_size + 1);
+  memset (self->padding, 'x', payload_size);
+  self->padding[payload_size] = '\0';
+
+  if (BENCH_FAN_OUT == kind) {
+    self->deliveries = g_new0 (unsigned, n_messages);
+  }
+
+  self->latencies = g_array_sized_new (false, false, sizeof (int64_t),
+                                       n_messages * self->n_proxies);
+
+  return self;
+}
+
+static void
+run_free (Run *self)
+{
+  g_free (self->padding);
+  g_free (self->deliveries);
+  g_array_free (self->latencies, true);
+  g_slice_free (Run, self);
+}
+
+static int
+_compare_int64 (void const *a,
+                void const *b)
+{
+  int64_t const *lhs = a;
+  int64_t const *rhs = b;
+
+  return *lhs < *rhs ? -1 : *lhs > *rhs ? 1 : 0;
+}
+
+/* Nearest-rank percentile over sorted latencies. */
+static int64_t
+run_get_percentile (Run const  *self,
+                    double      percentile)
+{
+  unsigned rank;
+
+  if (0 == self->latencies->len) {
+    return 0;
+  }
+
+  rank = (unsigned) (percentile * self->latencies->len + 0.5);
+  rank = CLAMP (rank, 1, self->latencies->len);
+
+  return g_array_index (self->latencies, int64_t, rank - 1);
+}
+
+static void
+run_append_json (Run      *self,
+                 GString  *json)
+{
+  int64_t elapsed;
+  double  per_second;
+
+  g_array_sort (self->latencies, _compare_int64);
+
+  elapsed = MAX (self->end_time - self->start_time, 1);
+  per_second = self->completed * (double) G_USEC_PER_SEC / elapsed;
+
+  g_string_append_printf (json,
+    "    {\n"
+    "      \"name\": \"%s\",\n"
+    "      \"payload_size\": %u,\n"
+    "      \"concurrency\": %u,\n"
+    "      \"proxies\": %u,\n"
+    "      \"messages\": %u,\n"
+    "      \"completed\": %u,\n"
+    "      \"timed_out\": %s,\n"
+    "      \"deliveries\": %u,\n"
+    "      \"elapsed_us\": %" G_GINT64_FORMAT ",\n"
+    "      \"messages_per_second\": %.1f,\n"
+    "      \"latency_us\": {\n"
+    "        \"min\": %" G_GINT64_FORMAT ",\n"
+    "        \"p50\": %" G_GINT64_FORMAT ",\n"
+    "        \"p99\": %" G_GINT64_FORMAT ",\n"
+    "        \"p999\": %" G_GINT64_FORMAT ",\n"
+    "        \"max\": %" G_GINT64_FORMAT "\n"
+    "      }\n"
+    "    }",
+    _kind_names[self->kind],
+    self->payload_size,
+    self->concurrency,
+    self->n_proxies,
+    self->n_messages,
+    self->completed,
+    self->timed_out ? "true" : "false",
+    self->latencies->len,
+    (gint64) elapsed,
+    per_second,
+    (gint64) run_get_percentile (self, 0.0),
+    (gint64) run_get_percentile (self, 0.5),
+    (gint64) run_get_percentile (self, 0.99),
+    (gint64) run_get_percentile (self, 0.999),
+    (gint64) run_get_percentile (self, 1.0));
+}
+
+/*
+ * Messages
+ */
+
+static char *
+format_tag (unsigned  run_index,
+            unsigned  seq,
+            int64_t   time,
+            char      separator)
+{
+  return g_strdup_printf ("%u%c%u%c%" G_GINT64_FORMAT,
+                          run_index, separator,
+                          seq, separator,
+                          (gint64) time);
+}
+
+static bool
+parse_tag (char const *tag,
+           char        separator,
+           unsigned   *run_index,
+           unsigned   *seq,
+           int64_t    *time)
+{
+  char *end;
+
+  *run_index = g_ascii_strtoull (tag, &end, 10);
+  if (end == tag || *end != separator) {
+    return false;
+  }
+
+  tag = end + 1;
+  *seq = g_ascii_strtoull (tag, &end, 10);
+  if (end == tag || *end != separator) {
+    return false;
+  }
+
+  tag = end + 1;
+  *time = g_ascii_strtoll (tag, &end, 10);
+  return end != tag;
+}
+
+static void
+run_finish (Bench *bench,
+            Run   *run);
+
+static void
+send_one (Bench     *bench,
+          Run       *run,
+          unsigned   seq)
+{
+  Peer    *sender = g_ptr_array_index (bench->peers, 0);
+  char    *tag;
+  char    *text;
+
+  tag = format_tag (bench->current, seq, g_get_monotonic_time (), ' ');
+
+  switch (run->kind) {
+
+    case BENCH_TEXT:
+      text = g_strdup_printf ("%s %s", tag, run->padding);
+      yts_service_send_text (bench->service, text);
+      g_free (text);
+      break;
+
+    case BENCH_LIST: {
+      char const *list[] = { tag, run->padding, NULL };
+      yts_service_send_list (bench->service, list, -1);
+    } break;
+
+    case BENCH_DICTIONARY: {
+      char const *dictionary[] = {
+        "tag", tag,
+        "padding", run->padding,
+        NULL
+      };
+      yts_service_send_dictionary (bench->service, dictionary, -1);
+    } break;
+
+    case BENCH_INVOKE:
+      text = g_strdup_printf ("%s %s", tag, run->padding);
+      yts_vp_player_set_playable_uri (sender->player, text);
+      g_free (text);
+      break;
+
+    case BENCH_ROUND_TRIP:
+      /* The tag doubles as invocation ID, and comes back with the response. */
+      g_free (tag);
+      tag = format_tag (bench->current, seq, g_get_monotonic_time (), '-');
+      yts_vp_player_next (sender->player, tag);
+      break;
+
+    case BENCH_FAN_OUT:
+      text = g_strdup_printf ("%s %s", tag, run->padding);
+      yts_vp_player_set_playable_uri (YTS_VP_PLAYER (bench->player), text);
+      g_free (text);
+      break;
+  }
+
+  g_free (tag);
+}
+
+static void
+send_more (Bench *bench,
+           Run   *run)
+{
+  while (bench->running &&
+         run->sent < run->n_messages &&
+         run->sent - run->completed < run->concurrency) {
+    send_one (bench, run, run->sent++);
+  }
+}
+
+static void
+deliver (Bench      *bench,
+         BenchKind   kind,
+         char const *tag,
+         char        separator)
+{
+  Run     *run;
+  unsigned run_index;
+  unsigned seq;
+  int64_t  time;
+  int64_t  now;
+  int64_t  latency;
+
+  if (!bench->running ||
+      !parse_tag (tag, separator, &run_index, &seq, &time) ||
+      run_index != bench->current) {
+    /* Late arrival from an earlier run. */
+    return;
+  }
+
+  run = g_ptr_array_index (bench->runs, bench->current);
+  if (run->kind != kind ||
+      seq >= run->sent) {
+    return;
+  }
+
+  now = g_get_monotonic_time ();
+  latency = now - time;
+  g_array_append_val (run->latencies, latency);
+  bench->last_progress = now;
+
+  if (BENCH_FAN_OUT == kind &&
+      ++run->deliveries[seq] < run->n_proxies) {
+    return;
+  }
+
+  run->completed++;
+  if (run->completed == run->n_messages) {
+    run_finish (bench, run);
+  } else {
+    send_more (bench, run);
+  }
+}
+
+/*
+ * Receiver
+ */
+
+static void
+_receiver_text_message (YtsClient  *client,
+                        char const *text,
+                        Bench      *bench)
+{
+  deliver (bench, BENCH_TEXT, text, ' ');
+}
+
+static void
+_receiver_list_message (YtsClient         *client,
+                        char const *const *list,
+                        Bench             *bench)
+{
+  if (list && list[0]) {
+    deliver (bench, BENCH_LIST, list[0], ' ');
+  }
+}
+
+static void
+_receiver_dictionary_message (YtsClient         *client,
+                              char const *const *dictionary,
+                              Bench             *bench)
+{
+  unsigned i;
+
+  for (i = 0; dictionary && dictionary[i] && dictionary[i + 1]; i += 2) {
+    if (0 == g_strcmp0 ("tag", dictionary[i])) {
+      deliver (bench, BENCH_DICTIONARY, dictionary[i + 1], ' ');
+      break;
+    }
+  }
+}
+
+static void
+_player_notify_playable_uri (YtsVPPlayer *player,
+                             GParamSpec  *pspec,
+                             Bench       *bench)
+{
+  char *playable_uri;
+
+  playable_uri = yts_vp_player_get_playable_uri (player);
+  if (playable_uri) {
+    deliver (bench, BENCH_INVOKE, playable_uri, ' ');
+  }
+  g_free (playable_uri);
+}
+
+/*
+ * Peers, the sender and subscribers
+ */
+
+static YtsClient *
+client_new (Bench      *bench,
+            char const *name,
+            char const *service_id)
+{
+  YtsClient *client;
+
+  if (0 == g_strcmp0 ("loopback", bench->transport)) {
+    char *contact_id = g_strdup_printf ("%s@%s", name, MESH_ID);
+    client = yts_client_new_loopback (MESH_ID, contact_id, service_id);
+    g_free (contact_id);
+  } else {
+    client = yts_client_new_p2p (service_id);
+  }
+
+  return client;
+}
+
+static void
+_peer_notify_playable_uri (YtsVPPlayer *player,
+                           GParamSpec  *pspec,
+                           Peer        *peer)
+{
+  char *playable_uri;
+
+  playable_uri = yts_vp_player_get_playable_uri (player);
+  if (playable_uri) {
+    deliver (peer->bench, BENCH_FAN_OUT, playable_uri, ' ');
+  }
+  g_free (playable_uri);
+}
+
+static void
+_peer_next_response (YtsVPPlayer *player,
+                     char const  *invocation_id,
+                     bool         return_value,
+                     Peer        *peer)
+{
+  deliver (peer->bench, BENCH_ROUND_TRIP, invocation_id, '-');
+}
+
+static bool
+_run_next (Bench *bench);
+
+static void
+_peer_proxy_created (YtsProxyService *service,
+                     YtsProxy        *proxy,
+                     Peer            *peer)
+{
+  Bench *bench = peer->bench;
+
+  if (!YTS_VP_IS_PLAYER (proxy) ||
+      peer->player) {
+    return;
+  }
+
+  peer->player = g_object_ref (proxy);
+  g_signal_connect (peer->player, "notify::playable-uri",
+                    G_CALLBACK (_peer_notify_playable_uri), peer);
+  if (0 == peer->index) {
+    g_signal_connect (peer->player, "next-response",
+                      G_CALLBACK (_peer_next_response), peer);
+  }
+
+  bench->last_progress = g_get_monotonic_time ();
+  bench->n_ready_peers++;
+  if (bench->n_ready_peers == bench->peers->len) {
+    g_idle_add ((GSourceFunc) _run_next, bench);
+  }
+}
+
+static void
+_peer_service_added (YtsRoster  *roster,
+                     YtsService *service,
+                     Peer       *peer)
+{
+  Bench *bench = peer->bench;
+
+  if (0 != g_strcmp0 (RECEIVER_SERVICE_ID, yts_service_get_id (service)) ||
+      peer->player) {
+    return;
+  }
+
+  if (0 == peer->index &&
+      NULL == bench->service) {
+    bench->service = g_object_ref (service);
+  }
+
+  g_signal_connect (service, "proxy-created",
+                    G_CALLBACK (_peer_proxy_created), peer);
+  if (!yts_proxy_service_create_proxy (YTS_PROXY_SERVICE (service),
+                                       YTS_VP_PLAYER_FQC_ID)) {
+    g_critical ("%s : Failed to create player proxy", G_STRLOC);
+  }
+}
+
+static void
+peer_add (Bench *bench)
+{
+  Peer  *peer;
+  char  *name;
+  char  *service_id;
+
+  peer = g_slice_new0 (Peer);
+  peer->bench = bench;
+  peer->index = bench->peers->len;
+
+  if (0 == peer->index) {
+    name = g_strdup ("sender");
+    service_id = g_strdup (SENDER_SERVICE_ID);
+  } else {
+    name = g_strdup_printf ("subscriber%u", peer->index);
+    service_id = g_strdup_printf ("%s%u", SUBSCRIBER_SERVICE_ID, peer->index);
+  }
+
+  peer->client = client_new (bench, name, service_id);
+  g_signal_connect (yts_client_get_roster (peer->client), "service-added",
+                    G_CALLBACK (_peer_service_added), peer);
+  g_ptr_array_add (bench->peers, peer);
+
+  yts_client_connect (peer->client);
+
+  g_free (service_id);
+  g_free (name);
+}
+
+static void
+peer_free (Peer *self)
+{
+  if (self->player) {
+    g_object_unref (self->player);
+  }
+  g_object_unref (self->client);
+  g_slice_free (Peer, self);
+}
+
+/*
+ * Driver
+ */
+
+static void
+bench_finish (Bench *bench)
+{
+  g_main_loop_quit (bench->mainloop);
+}
+
+static void
+run_start (Bench *bench,
+           Run   *run)
+{
+  g_message ("Running %s, payload %u, concurrency %u, proxies %u",
+             _kind_names[run->kind],
+             run->payload_size,
+             run->concurrency,
+             run->n_proxies);
+
+  bench->running = true;
+  run->start_time = g_get_monotonic_time ();
+  bench->last_progress = run->start_time;
+
+  send_more (bench, run);
+}
+
+static void
+run_finish (Bench *bench,
+            Run   *run)
+{
+  run->end_time = g_get_monotonic_time ();
+  bench->running = false;
+
+  if (bench->results->len > 0) {
+    g_string_append (bench->results, ",\n");
+  }
+  run_append_json (run, bench->results);
+
+  bench->current++;
+  g_idle_add ((GSourceFunc) _run_next, bench);
+}
+
+static bool
+_run_next (Bench *bench)
+{
+  Run *run;
+
+  if (bench->current >= bench->runs->len) {
+    bench_finish (bench);
+    return false;
+  }
+
+  run = g_ptr_array_index (bench->runs, bench->current);
+
+  /* Fan-out runs are sorted by proxy count, so peers only ever get added. */
+  if (run->n_proxies > bench->peers->len) {
+    bench->last_progress = g_get_monotonic_time ();
+    while (bench->peers->len < run->n_proxies) {
+      peer_add (bench);
+    }
+    return false;
+  }
+
+  run_start (bench, run);
+
+  return false;
+}
+
+static bool
+_watchdog (Bench *bench)
+{
+  int64_t idle;
+
+  idle = g_get_monotonic_time () - bench->last_progress;
+  if (idle < bench->timeout_s * G_USEC_PER_SEC) {
+    return true;
+  }
+
+  if (bench->running) {
+    Run *run = g_ptr_array_index (bench->runs, bench->current);
+    g_warning ("Run %s timed out after %u of %u messages",
+               _kind_names[run->kind], run->completed, run->n_messages);
+    run->timed_out = true;
+    run_finish (bench, run);
+    bench->last_progress = g_get_monotonic_time ();
+    return true;
+  }
+
+  g_critical ("Timed out waiting for %u of %u clients",
+              bench->peers->len - bench->n_ready_peers,
+              bench->peers->len);
+  bench->ret = EXIT_FAILURE;
+  bench_finish (bench);
+  return false;
+}
+
+/*
+ * Main
+ */
+
+static GArray *
+parse_uint_list (char const *list)
+{
+  GArray   *values;
+  char    **tokens;
+  unsigned  i;
+
+  values = g_array_new (false, false, sizeof (unsigned));
+  tokens = g_strsplit (list, ",", -1);
+  for (i = 0; tokens[i]; i++) {
+    unsigned value = g_ascii_strtoull (tokens[i], NULL, 10);
+    g_array_append_val (values, value);
+  }
+  g_strfreev (tokens);
+
+  return values;
+}
+
+static int
+_compare_uint (void const *a,
+               void const *b)
+{
+  unsigned const *lhs = a;
+  unsigned const *rhs = b;
+
+  return *lhs < *rhs ? -1 : *lhs > *rhs ? 1 : 0;
+}
+
+static GPtrArray *
+plan_runs (unsigned  n_messages,
+           GArray   *payload_sizes,
+           GArray   *concurrency,
+           GArray   *proxies)
+{
+  GPtrArray *runs;
+  BenchKind  kind;
+  unsigned   i, j;
+
+  runs = g_ptr_array_new_with_free_func ((GDestroyNotify) run_free);
+
+  for (kind = BENCH_TEXT; kind <= BENCH_INVOKE; kind++) {
+    for (i = 0; i < payload_sizes->len; i++) {
+      for (j = 0; j < concurrency->len; j++) {
+        g_ptr_array_add (runs,
+                         run_new (kind,
+                                  g_array_index (payload_sizes, unsigned, i),
+                                  g_array_index (concurrency, unsigned, j),
+                                  1,
+                                  n_messages));
+      }
+    }
+  }
+
+  /* Responses carry no payload. */
+  for (j = 0; j < concurrency->len; j++) {
+    g_ptr_array_add (runs,
+                     run_new (BENCH_ROUND_TRIP,
+                              0,
+                              g_array_index (concurrency, unsigned, j),
+                              1,
+                              n_messages));
+  }
+
+  /* One event at a time, so latency is per event and not queueing. */
+  g_array_sort (proxies, _compare_uint);
+  for (i = 0; i < proxies->len; i++) {
+    for (j = 0; j < payload_sizes->len; j++) {
+      g_ptr_array_add (runs,
+                       run_new (BENCH_FAN_OUT,
+                                g_array_index (payload_sizes, unsigned, j),
+                                1,
+                                g_array_index (proxies, unsigned, i),
+                                n_messages));
+    }
+  }
+
+  return runs;
+}
+
+int
+main (int     argc,
+      char  **argv)
+{
+  char const  *transport = "loopback";
+  int          n_messages = 1000;
+  char const  *payload_sizes = "16,1024,16384";
+  char const  *concurrency = "1,16,64";
+  char const  *proxies = "1,4,16";
+  int          timeout_s = 10;
+  char const  *output = NULL;
+  GOptionEntry entries[] = {
+    { "transport", 't', 0, G_OPTION_ARG_STRING, &transport,
+      "Transport to run over, 'loopback' or 'salut'", "<transport>" },
+    { "messages", 'n', 0, G_OPTION_ARG_INT, &n_messages,
+      "Messages per run", "<count>" },
+    { "payload-sizes", 's', 0, G_OPTION_ARG_STRING, &payload_sizes,
+      "Comma-separated payload sizes in bytes", "<sizes>" },
+    { "concurrency", 'c', 0, G_OPTION_ARG_STRING, &concurrency,
+      "Comma-separated numbers of messages in flight", "<counts>" },
+    { "proxies", 'p', 0, G_OPTION_ARG_STRING, &proxies,
+      "Comma-separated numbers of proxies for fan-out", "<counts>" },
+    { "timeout", 0, 0, G_OPTION_ARG_INT, &timeout_s,
+      "Seconds without progress before a run is abandoned", "<seconds>" },
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+      "Write JSON results to file instead of stdout", "<file>" },
+    { NULL, }
+  };
+  GOptionContext  *context;
+  GArray          *payload_size_list;
+  GArray          *concurrency_list;
+  GArray          *proxies_list;
+  GString         *json;
+  GError          *error = NULL;
+  Bench            bench;
+
+  g_type_init ();
+
+  context = g_option_context_new ("- messaging benchmarks");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_parse (context, &argc, &argv, &error);
+  g_option_context_free (context);
+  if (error) {
+    g_warning ("%s : %s", G_STRLOC, error->message);
+    g_clear_error (&error);
+    return EXIT_FAILURE;
+  }
+
+  if (0 != g_strcmp0 ("loopback", transport) &&
+      0 != g_strcmp0 ("salut", transport)) {
+    g_warning ("%s : Unknown transport '%s'", G_STRLOC, transport);
+    return EXIT_FAILURE;
+  }
+
+  memset (&bench, 0, sizeof (bench));
+  bench.transport = transport;
+  bench.timeout_s = MAX (timeout_s, 1);
+  bench.peers = g_ptr_array_new_with_free_func ((GDestroyNotify) peer_free);
+  bench.results = g_string_new ("");
+  bench.ret = EXIT_SUCCESS;
+
+  payload_size_list = parse_uint_list (payload_sizes);
+  concurrency_list = parse_uint_list (concurrency);
+  proxies_list = parse_uint_list (proxies);
+  bench.runs = plan_runs (MAX (n_messages, 1),
+                          payload_size_list,
+                          concurrency_list,
+                          proxies_list);
+  g_array_free (payload_size_list, true);
+  g_array_free (concurrency_list, true);
+  g_array_free (proxies_list, true);
+
+  /* Capabilities are published before connecting, so peers see the
+   * receiver's service only once. */
+  bench.receiver = client_new (&bench, "receiver", RECEIVER_SERVICE_ID);
+  g_signal_connect (bench.receiver, "text-message",
+                    G_CALLBACK (_receiver_text_message), &bench);
+  g_signal_connect (bench.receiver, "list-message",
+                    G_CALLBACK (_receiver_list_message), &bench);
+  g_signal_connect (bench.receiver, "dictionary-message",
+                    G_CALLBACK (_receiver_dictionary_message), &bench);
+
+  bench.player = test_player_new ();
+  g_signal_connect (bench.player, "notify::playable-uri",
+                    G_CALLBACK (_player_notify_playable_uri), &bench);
+  yts_client_publish_service (bench.receiver, YTS_CAPABILITY (bench.player));
+
+  yts_client_connect (bench.receiver);
+  peer_add (&bench);
+
+  bench.last_progress = g_get_monotonic_time ();
+  g_timeout_add_seconds (1, (GSourceFunc) _watchdog, &bench);
+
+  bench.mainloop = g_main_loop_new (NULL, false);
+  g_main_loop_run (bench.mainloop);
+  g_main_loop_unref (bench.mainloop);
+
+  json = g_string_new ("");
+  g_string_append_printf (json,
+                          "{\n"
+                          "  \"benchmark\": \"message-bench\",\n"
+                          "  \"version\": \"%s\",\n"
+                          "  \"transport\": \"%s\",\n"
+                          "  \"results\": [\n"
+                          "%s\n"
+                          "  ]\n"
+                          "}\n",
+                          YTS_VERSION_S,
+                          bench.transport,
+                          bench.results->str);
+
+  if (output) {
+    if (!g_file_set_contents (output, json->str, json->len, &error)) {
+      g_warning ("%s : %s", G_STRLOC, error->message);
+      g_clear_error (&error);
+      bench.ret = EXIT_FAILURE;
+    }
+  } else {
+    fputs (json->str, stdout);
+  }
+
+  g_string_free (json, true);
+  g_string_free (bench.results, true);
+  g_ptr_array_free (bench.runs, true);
+  g_ptr_array_free (bench.peers, true);
+  if (bench.service) {
+    g_object_unref (bench.service);
+  }
+  g_object_unref (bench.receiver);
+  g_object_unref (bench.player);
+
+  return bench.ret;
+}
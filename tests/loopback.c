@@ -0,0 +1,209 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include <string.h>
+#include <ytstenut/ytstenut.h>
+#include "test-player.h"
+
+/*
+ * Two loopback clients on one mesh: they have to discover each other,
+ * see each other's status, and exchange text and an invocation with its
+ * response. No connection manager is involved, so this runs in "make
+ * check".
+ */
+
+#define TEST_LENGTH 10
+
+#define MESH_ID "loopback-test"
+#define SERVICE_ID_1 "org.freedesktop.ytstenut.LoopbackTest1"
+#define SERVICE_ID_2 "org.freedesktop.ytstenut.LoopbackTest2"
+#define TEXT "Hello loopback"
+#define INVOCATION_ID "loopback-next"
+
+static int          retval = 1;
+static YtsClient   *client1 = NULL;
+static YtsClient   *client2 = NULL;
+static YtsService  *service1 = NULL;  /* SERVICE_ID_1 as seen by client2 */
+static YtsService  *service2 = NULL;  /* SERVICE_ID_2 as seen by client1 */
+static GMainLoop   *loop = NULL;
+
+static gboolean
+timeout_test_cb (gpointer data)
+{
+  g_message ("TIMEOUT: quiting loopback test");
+
+  retval = 1;
+
+  g_main_loop_quit (loop);
+
+  return FALSE;
+}
+
+static void
+_next_response (YtsVPPlayer *player,
+                char const  *invocation_id,
+                bool         return_value,
+                gpointer     data)
+{
+  g_debug ("%s() %s", __FUNCTION__, invocation_id);
+
+  g_assert_cmpstr (invocation_id, ==, INVOCATION_ID);
+  g_assert (return_value);
+
+  retval = 0;
+
+  g_main_loop_quit (loop);
+}
+
+static void
+_proxy_created (YtsProxyService *service,
+                YtsProxy        *proxy,
+                gpointer         data)
+{
+  g_assert (YTS_VP_IS_PLAYER (proxy));
+
+  /* The proxy is owned by the service. */
+  g_signal_connect (proxy, "next-response",
+                    G_CALLBACK (_next_response), NULL);
+  yts_vp_player_next (YTS_VP_PLAYER (proxy), INVOCATION_ID);
+}
+
+static void
+_text_message (YtsClient  *client,
+               char const *text,
+               gpointer    data)
+{
+  g_debug ("%s() %s", __FUNCTION__, text);
+
+  g_assert (client == client2);
+  g_assert_cmpstr (text, ==, TEXT);
+
+  /* Last step, invoke the player published by client1. */
+  g_signal_connect (service1, "proxy-created",
+                    G_CALLBACK (_proxy_created), NULL);
+  g_assert (yts_proxy_service_create_proxy (YTS_PROXY_SERVICE (service1),
+                                            YTS_VP_PLAYER_FQC_ID));
+}
+
+static void
+_status_changed (YtsService *service,
+                 char const *fqc_id,
+                 char const *status,
+                 gpointer    data)
+{
+  static gboolean seen = FALSE;
+
+  g_debug ("%s() %s %s", __FUNCTION__, fqc_id, status);
+
+  g_assert (service == service1);
+  g_assert (strstr (fqc_id, "yts-caps-video"));
+  g_assert (strstr (status, "yts-activity-playing"));
+
+  if (seen)
+    return;
+
+  seen = TRUE;
+
+  yts_service_send_text (service2, TEXT);
+}
+
+static void
+service_added_cb (YtsRoster   *roster,
+                  YtsService  *service,
+                  YtsClient   *client)
+{
+  const char  *sid = yts_service_get_id (service);
+
+  g_debug ("Service: %s", sid);
+
+  if (client == client1 && 0 == g_strcmp0 (sid, SERVICE_ID_2))
+    {
+      service2 = service;
+    }
+
+  if (client == client2 && 0 == g_strcmp0 (sid, SERVICE_ID_1))
+    {
+      service1 = service;
+
+      g_signal_connect (service, "status-changed",
+                        G_CALLBACK (_status_changed), NULL);
+    }
+
+  /*
+   * Waiting for both clients to see each other ...
+   */
+  if (service1 && service2 && (service == service1 || service == service2))
+    {
+      yts_client_set_status_by_capability (client1,
+                                           "yts-caps-video",
+                                           "yts-activity-playing",
+                                           "");
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  TestPlayer  *player;
+  YtsRoster   *roster1;
+  YtsRoster   *roster2;
+
+  g_type_init ();
+
+  /* Contacts without a TpContact must not raise criticals. */
+  g_log_set_always_fatal (G_LOG_LEVEL_CRITICAL);
+
+  loop = g_main_loop_new (NULL, FALSE);
+
+  client1 = yts_client_new_loopback (MESH_ID, "contact1", SERVICE_ID_1);
+  yts_client_add_capability (client1, "yts-caps-video",
+      YTS_CAPABILITY_MODE_PROVIDED);
+  player = test_player_new ();
+  yts_client_publish_service (client1, YTS_CAPABILITY (player));
+  roster1 = yts_client_get_roster (client1);
+  g_signal_connect (roster1, "service-added",
+                    G_CALLBACK (service_added_cb), client1);
+  yts_client_connect (client1);
+
+  client2 = yts_client_new_loopback (MESH_ID, "contact2", SERVICE_ID_2);
+  yts_client_add_capability (client2, "yts-caps-video",
+      YTS_CAPABILITY_MODE_CONSUMED);
+  g_signal_connect (client2, "text-message",
+                    G_CALLBACK (_text_message), NULL);
+  roster2 = yts_client_get_roster (client2);
+  g_signal_connect (roster2, "service-added",
+                    G_CALLBACK (service_added_cb), client2);
+  yts_client_connect (client2);
+
+  g_timeout_add_seconds (TEST_LENGTH, timeout_test_cb, loop);
+
+  /*
+   * Run the main loop.
+   */
+  g_main_loop_run (loop);
+
+  g_object_unref (client1);
+  g_object_unref (client2);
+  g_object_unref (player);
+
+  g_main_loop_unref (loop);
+
+  return retval;
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include <ytstenut/ytstenut.h>
+#include "ytstenut/yts-client-internal.h"
+#include "ytstenut/yts-loopback-transport.h"
+#include "ytstenut/yts-message.h"
+
+/*
+ * Client1's connection to the mesh is dropped every time it comes back,
+ * N_DROPS times. None of them lasts long enough to reset the backoff, so
+ * each reconnect has to take longer than the minimum of the one before.
+ * Messages client1 sends to client2 while the last reconnect is pending
+ * have to arrive once it is back, in the order they have been sent.
+ */
+
+#define TEST_LENGTH 10
+
+#define MESH_ID "org.freedesktop.ytstenut.ReconnectTest"
+#define SERVICE_ID_1 "org.freedesktop.ytstenut.ReconnectTest1"
+#define SERVICE_ID_2 "org.freedesktop.ytstenut.ReconnectTest2"
+
+/* See yts-client.c, half of each delay is randomised. */
+#define RECONNECT_DELAY_MIN 250
+#define N_DROPS 3
+#define N_MESSAGES 5
+
+static int                    retval = 1;
+static GMainLoop             *loop = NULL;
+static YtsLoopbackTransport  *transport1 = NULL;
+static YtsClient             *client1 = NULL;
+static YtsClient             *client2 = NULL;
+static YtsContact            *contact2 = NULL;
+static unsigned               n_drops = 0;
+static unsigned               n_received = 0;
+static int64_t                drop_time;
+
+static gboolean
+timeout_test_cb (gpointer data)
+{
+  g_message ("TIMEOUT: quiting reconnect test");
+
+  retval = 1;
+
+  g_main_loop_quit (loop);
+
+  return FALSE;
+}
+
+static void
+drop (void)
+{
+  n_drops++;
+  drop_time = g_get_monotonic_time ();
+  yts_loopback_transport_drop (transport1);
+}
+
+static void
+_client1_ready (YtsClient *client,
+                void      *data)
+{
+  int64_t elapsed_ms;
+
+  if (NULL == contact2) {
+    /* First connect, wait for client2 to show up. */
+    return;
+  }
+
+  elapsed_ms = (g_get_monotonic_time () - drop_time) / 1000;
+  g_debug ("%s() reconnected after %" G_GINT64_FORMAT " ms",
+           __FUNCTION__, elapsed_ms);
+
+  /* At least half of RECONNECT_DELAY_MIN, doubled for every attempt. */
+  g_assert_cmpint (elapsed_ms,
+                   >=,
+                   (RECONNECT_DELAY_MIN << (n_drops - 1)) / 2);
+
+  if (n_drops < N_DROPS) {
+    drop ();
+  }
+}
+
+static void
+_client1_disconnected (YtsClient *client,
+                       void      *data)
+{
+  YtsMetadata *message;
+  YtsError     e;
+  char        *text;
+  unsigned     i;
+
+  g_debug ("%s() %u", __FUNCTION__, n_drops);
+
+  if (n_drops < N_DROPS) {
+    return;
+  }
+
+  /* Kept for after reconnecting. */
+  for (i = 0; i < N_MESSAGES; i++) {
+    text = g_strdup_printf ("%u", i);
+    message = yts_message_new_for_payload ("text",
+                                           SERVICE_FQC_ID,
+                                           g_variant_new_string (text));
+    e = yts_client_send_message (client1, contact2, SERVICE_ID_2, message);
+    g_assert_cmpuint (yts_error_get_code (e), ==, YTS_ERROR_PENDING);
+    g_object_unref (message);
+    g_free (text);
+  }
+}
+
+static void
+_client2_text_message (YtsClient  *client,
+                       char const *text,
+                       void       *data)
+{
+  char *expected;
+
+  g_debug ("%s() %s", __FUNCTION__, text);
+
+  /* Only sent after the last drop. */
+  g_assert_cmpuint (n_drops, ==, N_DROPS);
+
+  expected = g_strdup_printf ("%u", n_received);
+  g_assert_cmpstr (text, ==, expected);
+  g_free (expected);
+
+  if (++n_received == N_MESSAGES) {
+    retval = 0;
+    g_main_loop_quit (loop);
+  }
+}
+
+static void
+_roster1_service_added (YtsRoster   *roster,
+                        YtsService  *service,
+                        void        *data)
+{
+  if (contact2 ||
+      0 != g_strcmp0 (SERVICE_ID_2, yts_service_get_id (service))) {
+    return;
+  }
+
+  /* Kept across the roster being cleared on disconnect. */
+  contact2 = yts_roster_find_contact_by_id (roster, "contact2");
+  g_assert (contact2);
+  g_object_ref (contact2);
+
+  drop ();
+}
+
+int
+main (int argc, char **argv)
+{
+  g_type_init ();
+
+  loop = g_main_loop_new (NULL, FALSE);
+
+  /* Set up like yts_client_new_loopback(), but keeping the transport. */
+  transport1 = yts_loopback_transport_new (MESH_ID, "contact1", SERVICE_ID_1);
+  client1 = g_object_new (YTS_TYPE_CLIENT,
+                          "service-id", SERVICE_ID_1,
+                          "transport",  transport1,
+                          NULL);
+  g_signal_connect (client1, "ready",
+                    G_CALLBACK (_client1_ready), NULL);
+  g_signal_connect (client1, "disconnected",
+                    G_CALLBACK (_client1_disconnected), NULL);
+  g_signal_connect (yts_client_get_roster (client1), "service-added",
+                    G_CALLBACK (_roster1_service_added), NULL);
+  yts_client_connect (client1);
+
+  client2 = yts_client_new_loopback (MESH_ID, "contact2", SERVICE_ID_2);
+  g_signal_connect (client2, "text-message",
+                    G_CALLBACK (_client2_text_message), NULL);
+  yts_client_connect (client2);
+
+  g_timeout_add_seconds (TEST_LENGTH, timeout_test_cb, loop);
+
+  /*
+   * Run the main loop.
+   */
+  g_main_loop_run (loop);
+
+  if (contact2) {
+    g_object_unref (contact2);
+  }
+  g_object_unref (client1);
+  g_object_unref (client2);
+  g_object_unref (transport1);
+
+  g_main_loop_unref (loop);
+
+  return retval;
+}
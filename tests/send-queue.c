@@ -0,0 +1,264 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include <ytstenut/ytstenut.h>
+#include "ytstenut/yts-contact-impl.h"
+#include "ytstenut/yts-message.h"
+#include "ytstenut/yts-telepathy-transport.h"
+
+/*
+ * Contacts created from an ID only never get a TpContact, so everything
+ * sent to them waits in the transport's send queue; no account is needed.
+ *
+ * Contact "b" is filled up to high water right away. With REJECT_NEW the
+ * next message is refused, with DROP_OLDEST the head of the queue fails
+ * instead. Contact "a" gets half of its messages now and the other half
+ * 1.5 s later, so when the first half expires it is still above low water
+ * and stays congested until the rest expire too. Expired messages have to
+ * fail oldest first.
+ */
+
+#define TEST_LENGTH 10
+
+#define HIGH_WATER 4
+#define LOW_WATER 1
+#define EXPIRY_S 2
+#define STAGGER_MS 1500
+
+static int             retval = 1;
+static GMainLoop      *loop = NULL;
+static YtsTransport   *transport = NULL;
+static YtsContact     *contact_a = NULL;
+static YtsContact     *contact_b = NULL;
+
+/* Atoms of the queued messages, in the order they are expected to expire. */
+static GQueue          expected_a = G_QUEUE_INIT;
+static GQueue          expected_b = G_QUEUE_INIT;
+static unsigned        dropped_atom = 0;
+static unsigned        n_dropped = 0;
+static unsigned        n_congested_a = 0;
+static unsigned        n_congested_b = 0;
+static unsigned        n_cleared = 0;
+
+static YtsSendQueueLimits limits = {
+  HIGH_WATER,
+  LOW_WATER,
+  EXPIRY_S,
+  YTS_SEND_QUEUE_POLICY_REJECT_NEW
+};
+
+static gboolean
+timeout_test_cb (gpointer data)
+{
+  g_message ("TIMEOUT: quiting send queue test");
+
+  retval = 1;
+
+  g_main_loop_quit (loop);
+
+  return FALSE;
+}
+
+static YtsError
+send_message (YtsContact  *contact,
+              GQueue      *expected)
+{
+  char const  *attrs[] = { "a1", "v1", NULL };
+  YtsMessage  *message;
+  YtsError     e;
+
+  message = yts_message_new (attrs);
+  e = yts_transport_send_message (transport,
+                                  contact,
+                                  "org.freedesktop.ytstenut.SendQueue",
+                                  YTS_METADATA (message));
+  g_object_unref (message);
+
+  if (YTS_ERROR_PENDING == yts_error_get_code (e) && expected) {
+    g_queue_push_tail (expected, GUINT_TO_POINTER (yts_error_get_atom (e)));
+  }
+
+  return e;
+}
+
+static void
+assert_waiting (unsigned n_waiting)
+{
+  YtsTransportStatistics statistics;
+
+  yts_transport_get_statistics (transport, &statistics);
+  g_assert_cmpuint (statistics.messages_waiting, ==, n_waiting);
+}
+
+static void
+_transport_error (YtsTransport  *transport,
+                  unsigned       error,
+                  void          *data)
+{
+  unsigned atom = yts_error_get_atom (error);
+
+  if (YTS_ERROR_QUEUE_FULL == yts_error_get_code (error)) {
+
+    /* Only DROP_OLDEST fails a queued message for being full. */
+    g_assert_cmpuint (atom, ==, dropped_atom);
+    n_dropped++;
+
+  } else {
+
+    g_assert_cmpuint (yts_error_get_code (error), ==, YTS_ERROR_EXPIRED);
+
+    if (atom == GPOINTER_TO_UINT (g_queue_peek_head (&expected_a))) {
+      g_queue_pop_head (&expected_a);
+    } else {
+      g_assert_cmpuint (atom,
+                        ==,
+                        GPOINTER_TO_UINT (g_queue_peek_head (&expected_b)));
+      g_queue_pop_head (&expected_b);
+    }
+  }
+}
+
+static gboolean
+_done (gpointer data)
+{
+  assert_waiting (0);
+  g_assert_cmpuint (n_dropped, ==, 1);
+
+  retval = 0;
+
+  g_main_loop_quit (loop);
+
+  return FALSE;
+}
+
+static void
+_transport_send_queue_congested (YtsTransport *transport,
+                                 char const   *contact_id,
+                                 gboolean      congested,
+                                 void         *data)
+{
+  g_debug ("%s() %s %s", __FUNCTION__, contact_id,
+           congested ? "congested" : "cleared");
+
+  if (0 == g_strcmp0 ("a", contact_id)) {
+
+    n_congested_a += congested;
+    if (!congested) {
+      /* Half of the messages expiring is not enough to drop to low water. */
+      g_assert (g_queue_is_empty (&expected_a));
+    }
+
+  } else {
+
+    g_assert_cmpstr ("b", ==, contact_id);
+    n_congested_b += congested;
+    if (!congested) {
+      g_assert (g_queue_is_empty (&expected_b));
+    }
+  }
+
+  if (!congested &&
+      2 == ++n_cleared) {
+    /* Let the transport finish the sweep first. */
+    g_idle_add (_done, NULL);
+  }
+}
+
+static gboolean
+_send_second_half (gpointer data)
+{
+  unsigned i;
+
+  g_assert_cmpuint (n_congested_a, ==, 0);
+
+  for (i = 0; i < HIGH_WATER / 2; i++) {
+    send_message (contact_a, &expected_a);
+  }
+
+  g_assert_cmpuint (n_congested_a, ==, 1);
+  assert_waiting (2 * HIGH_WATER);
+
+  return FALSE;
+}
+
+int
+main (int argc, char **argv)
+{
+  YtsError  e;
+  unsigned  i;
+
+  g_type_init ();
+
+  loop = g_main_loop_new (NULL, FALSE);
+
+  /* Never connected, messages can only be queued. */
+  transport = g_object_new (YTS_TYPE_TELEPATHY_TRANSPORT, NULL);
+  g_signal_connect (transport, "error",
+                    G_CALLBACK (_transport_error), NULL);
+  g_signal_connect (transport, "send-queue-congested",
+                    G_CALLBACK (_transport_send_queue_congested), NULL);
+  yts_transport_set_send_queue_limits (transport, &limits);
+
+  contact_a = YTS_CONTACT (yts_contact_impl_new_for_id ("a"));
+  contact_b = YTS_CONTACT (yts_contact_impl_new_for_id ("b"));
+
+  for (i = 0; i < HIGH_WATER / 2; i++) {
+    send_message (contact_a, &expected_a);
+  }
+
+  for (i = 0; i < HIGH_WATER; i++) {
+    e = send_message (contact_b, &expected_b);
+    g_assert_cmpuint (yts_error_get_code (e), ==, YTS_ERROR_PENDING);
+  }
+  g_assert_cmpuint (n_congested_b, ==, 1);
+
+  /* Refused right away, nothing queued fails. */
+  e = send_message (contact_b, &expected_b);
+  g_assert_cmpuint (yts_error_get_code (e), ==, YTS_ERROR_QUEUE_FULL);
+  g_assert_cmpuint (n_dropped, ==, 0);
+  assert_waiting (HIGH_WATER / 2 + HIGH_WATER);
+
+  /* Accepted at the expense of the oldest one. */
+  limits.policy = YTS_SEND_QUEUE_POLICY_DROP_OLDEST;
+  yts_transport_set_send_queue_limits (transport, &limits);
+
+  dropped_atom = GPOINTER_TO_UINT (g_queue_pop_head (&expected_b));
+  e = send_message (contact_b, &expected_b);
+  g_assert_cmpuint (yts_error_get_code (e), ==, YTS_ERROR_PENDING);
+  g_assert_cmpuint (n_dropped, ==, 1);
+  g_assert_cmpuint (n_congested_b, ==, 1);
+  assert_waiting (HIGH_WATER / 2 + HIGH_WATER);
+
+  g_timeout_add (STAGGER_MS, _send_second_half, NULL);
+  g_timeout_add_seconds (TEST_LENGTH, timeout_test_cb, loop);
+
+  /*
+   * Run the main loop.
+   */
+  g_main_loop_run (loop);
+
+  g_object_unref (contact_a);
+  g_object_unref (contact_b);
+  g_object_unref (transport);
+
+  g_main_loop_unref (loop);
+
+  return retval;
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include <ytstenut/ytstenut.h>
+#include "test-player.h"
+
+/*
+ * Minimal YtsVPPlayer service for the tests and benchmarks. Unlike the
+ * example's mock player it does no logging and no timers, so it does not
+ * skew measurements. next() and prev() respond right away.
+ */
+
+static void
+_capability_interface_init (YtsCapability *interface);
+
+static void
+_player_interface_init (YtsVPPlayerInterface *interface);
+
+G_DEFINE_TYPE_WITH_CODE (TestPlayer,
+                         test_player,
+                         G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (YTS_TYPE_CAPABILITY,
+                                                _capability_interface_init)
+                         G_IMPLEMENT_INTERFACE (YTS_VP_TYPE_PLAYER,
+                                                _player_interface_init))
+
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), TEST_TYPE_PLAYER, TestPlayerPrivate))
+
+enum {
+  PROP_0,
+
+  /* YtsCapability */
+  PROP_CAPABILITY_FQC_IDS,
+
+  /* YtsVPPlayer */
+  PROP_PLAYER_PLAYABLE,
+  PROP_PLAYER_PLAYING,
+  PROP_PLAYER_VOLUME,
+  PROP_PLAYER_PLAYABLE_URI
+};
+
+typedef struct {
+  bool     playing;
+  double   volume;
+  char    *playable_uri;
+} TestPlayerPrivate;
+
+/*
+ * YtsCapability implementation
+ */
+
+static void
+_capability_interface_init (YtsCapability *interface)
+{
+  /* Nothing to do, it's just about overriding the "fqc-id" property */
+}
+
+/*
+ * YtsVPPlayer
+ */
+
+static void
+_player_play (YtsVPPlayer *self)
+{
+  yts_vp_player_set_playing (self, true);
+}
+
+static void
+_player_pause (YtsVPPlayer *self)
+{
+  yts_vp_player_set_playing (self, false);
+}
+
+static void
+_player_next (YtsVPPlayer  *self,
+              char const   *invocation_id)
+{
+  yts_vp_player_next_return (self, invocation_id, true);
+}
+
+static void
+_player_prev (YtsVPPlayer  *self,
+              char const   *invocation_id)
+{
+  yts_vp_player_prev_return (self, invocation_id, true);
+}
+
+static void
+_player_interface_init (YtsVPPlayerInterface *interface)
+{
+  interface->play = _player_play;
+  interface->pause = _player_pause;
+  interface->next = _player_next;
+  interface->prev = _player_prev;
+}
+
+/*
+ * TestPlayer
+ */
+
+static void
+_get_property (GObject    *object,
+               unsigned    property_id,
+               GValue     *value,
+               GParamSpec *pspec)
+{
+  TestPlayerPrivate *priv = GET_PRIVATE (object);
+
+  switch (property_id) {
+    case PROP_CAPABILITY_FQC_IDS: {
+      char const *fcq_ids[] = {
+        YTS_VP_PLAYER_FQC_ID,
+        NULL };
+      g_value_set_boxed (value, fcq_ids);
+    } break;
+    case PROP_PLAYER_PLAYABLE:
+      g_value_set_object (value, NULL);
+      break;
+    case PROP_PLAYER_PLAYING:
+      g_value_set_boolean (value, priv->playing);
+      break;
+    case PROP_PLAYER_VOLUME:
+      g_value_set_double (value, priv->volume);
+      break;
+    case PROP_PLAYER_PLAYABLE_URI:
+      g_value_set_string (value, priv->playable_uri);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+_set_property (GObject      *object,
+               unsigned      property_id,
+               const GValue *value,
+               GParamSpec   *pspec)
+{
+  TestPlayerPrivate *priv = GET_PRIVATE (object);
+
+  switch (property_id) {
+    case PROP_PLAYER_PLAYABLE:
+      /* Not supported. */
+      break;
+    case PROP_PLAYER_PLAYING: {
+      bool playing = g_value_get_boolean (value);
+      if (playing != priv->playing) {
+        priv->playing = playing;
+        g_object_notify (object, "playing");
+      }
+    } break;
+    case PROP_PLAYER_VOLUME: {
+      /* Every set is reported, the benchmarks count them. */
+      priv->volume = g_value_get_double (value);
+      g_object_notify (object, "volume");
+    } break;
+    case PROP_PLAYER_PLAYABLE_URI: {
+      g_free (priv->playable_uri);
+      priv->playable_uri = g_value_dup_string (value);
+      g_object_notify (object, "playable-uri");
+    } break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+_finalize (GObject *object)
+{
+  TestPlayerPrivate *priv = GET_PRIVATE (object);
+
+  g_free (priv->playable_uri);
+
+  G_OBJECT_CLASS (test_player_parent_class)->finalize (object);
+}
+
+static void
+test_player_class_init (TestPlayerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  g_type_class_add_private (klass, sizeof (TestPlayerPrivate));
+
+  object_class->get_property = _get_property;
+  object_class->set_property = _set_property;
+  object_class->finalize = _finalize;
+
+  /* YtsCapability */
+
+  g_object_class_override_property (object_class,
+                                    PROP_CAPABILITY_FQC_IDS,
+                                    "fqc-ids");
+
+  /* YtsVPPlayer */
+
+  g_object_class_override_property (object_class,
+                                    PROP_PLAYER_PLAYABLE,
+                                    "playable");
+
+  g_object_class_override_property (object_class,
+                                    PROP_PLAYER_PLAYING,
+                                    "playing");
+
+  g_object_class_override_property (object_class,
+                                    PROP_PLAYER_VOLUME,
+                                    "volume");
+
+  g_object_class_override_property (object_class,
+                                    PROP_PLAYER_PLAYABLE_URI,
+                                    "playable-uri");
+}
+
+static void
+test_player_init (TestPlayer *self)
+{
+}
+
+TestPlayer *
+test_player_new (void)
+{
+  return g_object_new (TEST_TYPE_PLAYER, NULL);
+}
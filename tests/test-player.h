@@ -0,0 +1,61 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef TEST_PLAYER_H
+#define TEST_PLAYER_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define TEST_TYPE_PLAYER test_player_get_type()
+
+#define TEST_PLAYER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), TEST_TYPE_PLAYER, TestPlayer))
+
+#define TEST_PLAYER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), TEST_TYPE_PLAYER, TestPlayerClass))
+
+#define TEST_IS_PLAYER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), TEST_TYPE_PLAYER))
+
+#define TEST_IS_PLAYER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), TEST_TYPE_PLAYER))
+
+#define TEST_PLAYER_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), TEST_TYPE_PLAYER, TestPlayerClass))
+
+typedef struct {
+  GObject parent;
+} TestPlayer;
+
+typedef struct {
+  GObjectClass parent;
+} TestPlayerClass;
+
+GType
+test_player_get_type (void) G_GNUC_CONST;
+
+TestPlayer *
+test_player_new (void);
+
+G_END_DECLS
+
+#endif /* TEST_PLAYER_H */
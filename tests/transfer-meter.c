@@ -0,0 +1,154 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include <ytstenut/ytstenut.h>
+#include "ytstenut/yts-file-transfer-internal.h"
+
+/*
+ * Feed a resumed transfer's meter at a steady 10000 bytes per second: the
+ * progress notifications have to be throttled by both interval and
+ * threshold, the resumed prefix must not count towards throughput, and
+ * the time estimate has to follow from the measured rate.
+ */
+
+#define TEST_LENGTH 10
+
+#define SIZE 20000
+#define OFFSET 4000
+#define CHUNK 100
+#define CHUNK_INTERVAL_MS 10
+#define RATE (CHUNK * 1000 / CHUNK_INTERVAL_MS)
+#define NOTIFY_INTERVAL_MS 100
+#define NOTIFY_THRESHOLD 0.05
+
+static int                   retval = 1;
+static GMainLoop            *loop = NULL;
+static YtsFileTransferMeter  meter;
+static uint64_t              transferred = OFFSET;
+static unsigned              n_updates = 0;
+static unsigned              n_notifications = 0;
+static float                 notified_progress;
+static int64_t               notified_time;
+
+static gboolean
+timeout_test_cb (gpointer data)
+{
+  g_message ("TIMEOUT: quiting transfer meter test");
+
+  retval = 1;
+
+  g_main_loop_quit (loop);
+
+  return FALSE;
+}
+
+static gboolean
+_feed (gpointer data)
+{
+  float progress;
+
+  transferred += CHUNK;
+  n_updates++;
+
+  if (yts_file_transfer_meter_update (&meter, transferred)) {
+
+    progress = yts_file_transfer_meter_get_progress (&meter);
+    n_notifications++;
+
+    /* Throttled, unless complete. */
+    if (progress < 1.0) {
+      g_assert_cmpfloat (progress - notified_progress, >=, NOTIFY_THRESHOLD);
+      g_assert_cmpint (meter.notify_time - notified_time,
+                       >=,
+                       NOTIFY_INTERVAL_MS * 1000);
+    }
+
+    notified_progress = progress;
+    notified_time = meter.notify_time;
+  }
+
+  if (meter.bytes_per_second) {
+
+    int64_t remaining = yts_file_transfer_meter_get_time_remaining (&meter);
+
+    /* The 4000 bytes prefix would push the first sample far beyond. */
+    g_assert_cmpuint (meter.bytes_per_second, <, 2 * RATE);
+    g_assert_cmpint (remaining,
+                     ==,
+                     (SIZE - transferred) / meter.bytes_per_second);
+  }
+
+  if (transferred < SIZE) {
+    return TRUE;
+  }
+
+  g_debug ("%u updates, %u notifications, %" G_GUINT64_FORMAT " bytes/s",
+           n_updates, n_notifications, meter.bytes_per_second);
+
+  /* Completion is always notified. */
+  g_assert_cmpfloat (notified_progress, ==, 1.0);
+  g_assert_cmpint (yts_file_transfer_meter_get_time_remaining (&meter), ==, 0);
+
+  /* 1.6 s worth of updates, no more than one notification per interval. */
+  g_assert_cmpuint (n_notifications,
+                    <=,
+                    n_updates * CHUNK_INTERVAL_MS / NOTIFY_INTERVAL_MS + 1);
+  g_assert_cmpuint (meter.bytes_per_second, >, 0);
+
+  retval = 0;
+
+  g_main_loop_quit (loop);
+
+  return FALSE;
+}
+
+int
+main (int argc, char **argv)
+{
+  g_type_init ();
+
+  loop = g_main_loop_new (NULL, FALSE);
+
+  yts_file_transfer_meter_init (&meter);
+  meter.size = SIZE;
+  meter.notify_interval_ms = NOTIFY_INTERVAL_MS;
+  meter.notify_threshold = NOTIFY_THRESHOLD;
+
+  /* Resumed, the prefix is there already. */
+  yts_file_transfer_meter_start (&meter, OFFSET);
+  notified_progress = yts_file_transfer_meter_get_progress (&meter);
+  notified_time = meter.notify_time;
+
+  g_assert_cmpfloat (notified_progress, ==, (float) OFFSET / SIZE);
+  g_assert_cmpuint (meter.bytes_per_second, ==, 0);
+  g_assert_cmpint (yts_file_transfer_meter_get_time_remaining (&meter), ==, -1);
+
+  g_timeout_add (CHUNK_INTERVAL_MS, _feed, NULL);
+  g_timeout_add_seconds (TEST_LENGTH, timeout_test_cb, loop);
+
+  /*
+   * Run the main loop.
+   */
+  g_main_loop_run (loop);
+
+  g_main_loop_unref (loop);
+
+  return retval;
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include <ytstenut/ytstenut.h>
+#include "ytstenut/yts-outgoing-file-internal.h"
+#include "ytstenut/yts-transfer-scheduler-internal.h"
+
+/*
+ * Queue transfers to three contacts at both priorities, with at most two
+ * running overall and one per contact. Transfers are not really started,
+ * the scheduler's start() is overridden to record the order, and finished
+ * by cancelling them. Every step runs after the scheduler's dispatch.
+ */
+
+#define TEST_LENGTH 10
+
+#define SIZE 100
+
+typedef struct {
+  YtsTransferScheduler parent;
+} TestScheduler;
+
+typedef struct {
+  YtsTransferSchedulerClass parent;
+} TestSchedulerClass;
+
+G_DEFINE_TYPE (TestScheduler, test_scheduler, YTS_TYPE_TRANSFER_SCHEDULER)
+
+static int                    retval = 1;
+static GMainLoop             *loop = NULL;
+static YtsTransferScheduler  *scheduler = NULL;
+static GPtrArray             *started = NULL;
+static unsigned               step = 0;
+
+/* Transfers, by recipient contact and priority. */
+static YtsOutgoingFile *a_background;
+static YtsOutgoingFile *a_interactive;
+static YtsOutgoingFile *b_background;
+static YtsOutgoingFile *b_interactive;
+static YtsOutgoingFile *c_interactive;
+static YtsOutgoingFile *c_cancelled;
+
+static void
+_start (YtsTransferScheduler *self,
+        YtsOutgoingFile      *transfer)
+{
+  g_ptr_array_add (started, transfer);
+}
+
+static void
+test_scheduler_class_init (TestSchedulerClass *klass)
+{
+  YtsTransferSchedulerClass *scheduler_class =
+                                      YTS_TRANSFER_SCHEDULER_CLASS (klass);
+
+  scheduler_class->start = _start;
+}
+
+static void
+test_scheduler_init (TestScheduler *self)
+{
+}
+
+static YtsOutgoingFile *
+create_transfer (char const *contact_id)
+{
+  YtsOutgoingFile *transfer;
+  GInputStream    *stream;
+
+  /* Never started for real, so no account is needed. */
+  stream = g_memory_input_stream_new ();
+  transfer = yts_outgoing_file_new_for_stream (NULL,
+                                               stream,
+                                               SIZE,
+                                               NULL,
+                                               NULL,
+                                               "org.freedesktop.ytstenut.Sender",
+                                               contact_id,
+                                               "org.freedesktop.ytstenut.Recipient",
+                                               NULL);
+  g_object_unref (stream);
+
+  return transfer;
+}
+
+static void
+assert_started (unsigned          n_started,
+                YtsOutgoingFile  *last,
+                unsigned          n_running,
+                unsigned          n_queued)
+{
+  unsigned running;
+  unsigned queued;
+  uint64_t bytes_per_second;
+
+  g_assert_cmpuint (started->len, ==, n_started);
+  if (last) {
+    g_assert (last == g_ptr_array_index (started, started->len - 1));
+  }
+
+  yts_transfer_scheduler_get_statistics (scheduler,
+                                         &running,
+                                         &queued,
+                                         &bytes_per_second);
+  g_assert_cmpuint (running, ==, n_running);
+  g_assert_cmpuint (queued, ==, n_queued);
+}
+
+static gboolean
+timeout_test_cb (gpointer data)
+{
+  g_message ("TIMEOUT: quiting transfer scheduler test");
+
+  retval = 1;
+
+  g_main_loop_quit (loop);
+
+  return FALSE;
+}
+
+/*
+ * Runs after the scheduler's dispatch, which is an idle of higher priority.
+ */
+static gboolean
+_step (gpointer data)
+{
+  g_debug ("%s() %u", __FUNCTION__, step);
+
+  switch (step++) {
+
+    case 0:
+      /* Interactive ones first, in order, up to max-transfers. */
+      g_assert (g_ptr_array_index (started, 0) == a_interactive);
+      assert_started (2, c_interactive, 2, 3);
+      g_assert (!yts_transfer_scheduler_set_priority (
+                                        scheduler,
+                                        a_interactive,
+                                        YTS_TRANSFER_PRIORITY_BACKGROUND));
+      yts_outgoing_file_cancel (a_interactive);
+      break;
+
+    case 1:
+      /* The remaining interactive one beats a's background transfer. */
+      assert_started (3, b_interactive, 2, 2);
+      yts_outgoing_file_cancel (c_interactive);
+      break;
+
+    case 2:
+      assert_started (4, a_background, 2, 1);
+      g_assert_cmpfloat (yts_transfer_scheduler_get_progress (scheduler),
+                         <,
+                         1.0);
+      yts_outgoing_file_cancel (a_background);
+      break;
+
+    case 3:
+      /* A slot is free, but b has its one transfer running already. */
+      assert_started (4, NULL, 1, 1);
+      yts_outgoing_file_cancel (b_interactive);
+      break;
+
+    case 4:
+      assert_started (5, b_background, 1, 0);
+      yts_outgoing_file_cancel (b_background);
+      break;
+
+    case 5:
+      /* Batch done, the cancelled transfer never got started. */
+      assert_started (5, NULL, 0, 0);
+      g_assert_cmpfloat (yts_transfer_scheduler_get_progress (scheduler),
+                         ==,
+                         1.0);
+      retval = 0;
+      g_main_loop_quit (loop);
+      return FALSE;
+  }
+
+  g_idle_add_full (G_PRIORITY_LOW, _step, NULL, NULL);
+
+  return FALSE;
+}
+
+int
+main (int argc, char **argv)
+{
+  g_type_init ();
+
+  loop = g_main_loop_new (NULL, FALSE);
+
+  started = g_ptr_array_new ();
+  scheduler = g_object_new (test_scheduler_get_type (),
+                            "max-transfers", 2,
+                            "max-transfers-per-contact", 1,
+                            NULL);
+
+  a_background = create_transfer ("a");
+  a_interactive = create_transfer ("a");
+  b_background = create_transfer ("b");
+  b_interactive = create_transfer ("b");
+  c_interactive = create_transfer ("c");
+  c_cancelled = create_transfer ("c");
+
+  yts_transfer_scheduler_enqueue (scheduler, a_background,
+                                  YTS_TRANSFER_PRIORITY_BACKGROUND);
+  yts_transfer_scheduler_enqueue (scheduler, a_interactive,
+                                  YTS_TRANSFER_PRIORITY_INTERACTIVE);
+  /* Raised to interactive below, before the first dispatch. */
+  yts_transfer_scheduler_enqueue (scheduler, b_interactive,
+                                  YTS_TRANSFER_PRIORITY_BACKGROUND);
+  yts_transfer_scheduler_enqueue (scheduler, b_background,
+                                  YTS_TRANSFER_PRIORITY_BACKGROUND);
+  yts_transfer_scheduler_enqueue (scheduler, c_interactive,
+                                  YTS_TRANSFER_PRIORITY_INTERACTIVE);
+  yts_transfer_scheduler_enqueue (scheduler, c_cancelled,
+                                  YTS_TRANSFER_PRIORITY_INTERACTIVE);
+
+  g_assert (yts_transfer_scheduler_set_priority (
+                                        scheduler,
+                                        b_interactive,
+                                        YTS_TRANSFER_PRIORITY_INTERACTIVE));
+  g_assert (yts_transfer_scheduler_cancel (scheduler, c_cancelled));
+  g_assert (!yts_transfer_scheduler_cancel (scheduler, c_cancelled));
+
+  g_idle_add_full (G_PRIORITY_LOW, _step, NULL, NULL);
+  g_timeout_add_seconds (TEST_LENGTH, timeout_test_cb, loop);
+
+  /*
+   * Run the main loop.
+   */
+  g_main_loop_run (loop);
+
+  g_object_unref (scheduler);
+  g_ptr_array_free (started, true);
+  g_object_unref (a_background);
+  g_object_unref (a_interactive);
+  g_object_unref (b_background);
+  g_object_unref (b_interactive);
+  g_object_unref (c_interactive);
+  g_object_unref (c_cancelled);
+
+  g_main_loop_unref (loop);
+
+  return retval;
+}
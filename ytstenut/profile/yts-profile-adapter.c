@@ -61,6 +61,16 @@ _service_adapter_invoke (YtsServiceAdapter *self,
                                  invocation_id,
                                  capability);
 
+  } else if (0 == g_strcmp0 ("register-proxies", aspect) &&
+             arguments &&
+             g_variant_is_of_type (arguments, G_VARIANT_TYPE_STRING_ARRAY)) {
+
+    char const **capabilities = g_variant_get_strv (arguments, NULL);
+    yts_profile_register_proxies (priv->profile,
+                                  invocation_id,
+                                  capabilities);
+    g_free (capabilities);
+
   } else if (0 == g_strcmp0 ("unregister-proxy", aspect) &&
              arguments &&
              g_variant_is_of_type (arguments, G_VARIANT_TYPE_STRING)) {
@@ -62,18 +62,19 @@ _capability_interface_init (YtsCapability *interface)
  * YtsProfile
  */
 
-static void
-_register_proxy (YtsProfile  *self,
-                 char const   *invocation_id,
-                 char const   *capability)
+/*
+ * Returns the initial properties for the new proxy, or boolean false.
+ */
+static GVariant *
+register_proxy (YtsProfile  *self,
+                YtsContact  *contact,
+                char const  *proxy_id,
+                char const  *capability)
 {
   YtsProfileImplPrivate *priv = GET_PRIVATE (self);
-  YtsContact   *contact;
-  char const    *proxy_id;
   bool           found;
   unsigned       i;
   GVariant      *return_value = NULL;
-  YtsMetadata  *message;
 
   found = false;
   for (i = 0; i < priv->capabilities->len; i++) {
@@ -85,28 +86,16 @@ _register_proxy (YtsProfile  *self,
 
   if (found) {
 
-    bool have_proxy = yts_client_get_invocation_proxy (priv->client,
-                                                        invocation_id,
-                                                        &contact,
-                                                        &proxy_id);
-    if (have_proxy) {
-
-      return_value = yts_client_register_proxy (priv->client,
-                                                 capability,
-                                                 contact,
-                                                 proxy_id);
-
-      if (NULL == return_value) {
-        g_critical ("%s : Failed to register proxy %s:%s for %s",
-                    G_STRLOC,
-                    yts_contact_get_id (contact),
-                    proxy_id,
-                    capability);
-        return_value = g_variant_new_boolean (false);
-      }
-    } else {
-      g_critical ("%s : Failed to get proxy info for %s",
+    return_value = yts_client_register_proxy (priv->client,
+                                               capability,
+                                               contact,
+                                               proxy_id);
+
+    if (NULL == return_value) {
+      g_critical ("%s : Failed to register proxy %s:%s for %s",
                   G_STRLOC,
+                  yts_contact_get_id (contact),
+                  proxy_id,
                   capability);
       return_value = g_variant_new_boolean (false);
     }
@@ -118,6 +107,37 @@ _register_proxy (YtsProfile  *self,
     return_value = g_variant_new_boolean (false);
   }
 
+  return return_value;
+}
+
+static void
+_register_proxy (YtsProfile  *self,
+                 char const   *invocation_id,
+                 char const   *capability)
+{
+  YtsProfileImplPrivate *priv = GET_PRIVATE (self);
+  YtsContact   *contact;
+  char const    *proxy_id;
+  bool           have_proxy;
+  GVariant      *return_value;
+  YtsMetadata  *message;
+
+  have_proxy = yts_client_get_invocation_proxy (priv->client,
+                                                 invocation_id,
+                                                 &contact,
+                                                 &proxy_id);
+  if (!have_proxy) {
+    g_critical ("%s : Failed to get proxy info for %s",
+                G_STRLOC,
+                capability);
+    return;
+  }
+
+  return_value = g_variant_ref_sink (register_proxy (self,
+                                                    contact,
+                                                    proxy_id,
+                                                    capability));
+
   /* This is one big HACK. The request was made to org.freedesktop.Ytstenut
    * but the response goes to the actual capability that was registered,
    * so it ends up in the right place. */
@@ -129,6 +149,52 @@ _register_proxy (YtsProfile  *self,
   g_variant_unref (return_value);
 }
 
+static void
+_register_proxies (YtsProfile          *self,
+                   char const          *invocation_id,
+                   char const *const   *capabilities)
+{
+  YtsProfileImplPrivate *priv = GET_PRIVATE (self);
+  YtsContact       *contact;
+  char const        *proxy_id;
+  bool               have_proxy;
+  GVariantBuilder    builder;
+  GVariant          *return_value;
+  YtsMetadata       *message;
+  unsigned           i;
+
+  have_proxy = yts_client_get_invocation_proxy (priv->client,
+                                                 invocation_id,
+                                                 &contact,
+                                                 &proxy_id);
+  if (!have_proxy) {
+    g_critical ("%s : Failed to get proxy info for %s",
+                G_STRLOC,
+                capabilities[0]);
+    return;
+  }
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+  for (i = 0; capabilities[i]; i++) {
+    g_variant_builder_add (&builder, "{sv}",
+                           capabilities[i],
+                           register_proxy (self,
+                                           contact,
+                                           proxy_id,
+                                           capabilities[i]));
+  }
+  return_value = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  /* Same hack as in _register_proxy(), the response needs to be addressed
+   * to a capability the remote service proxy knows about. */
+  message = yts_response_message_new (capabilities[0],
+                                       invocation_id,
+                                       return_value);
+  yts_client_send_message (priv->client, contact, proxy_id, message);
+  g_object_unref (message);
+  g_variant_unref (return_value);
+}
+
 static void
 _unregister_proxy (YtsProfile  *self,
                    char const   *invocation_id,
@@ -189,6 +255,7 @@ static void
 _profile_interface_init (YtsProfileInterface *interface)
 {
   interface->register_proxy = _register_proxy;
+  interface->register_proxies = _register_proxies;
   interface->unregister_proxy = _unregister_proxy;
 }
 
@@ -41,9 +41,6 @@ typedef struct {
   // FIXME hook this property up
   GPtrArray *capabilities;
 
-  /* Data */
-  GHashTable  *invocations;
-
 } YtsProfileProxyPrivate;
 
 /*
@@ -55,45 +52,84 @@ _register_proxy (YtsProfile  *self,
                  char const   *invocation_id_,
                  char const   *capability)
 {
-  YtsProfileProxyPrivate *priv = GET_PRIVATE (self);
   char *invocation_id;
 
   invocation_id = invocation_id_ ?
                     g_strdup (invocation_id_) :
                     yts_proxy_create_invocation_id (YTS_PROXY (self));
-  /* Hash takes invocation_id. */
-  g_hash_table_insert (priv->invocations,
-                       invocation_id, _register_proxy);
-  // TODO set timeout, well, probably in yts-proxy-service.c
 
+  /* Not invoked asynchronously, the response is addressed to
+   * the registered capability and picked up by YtsProxyService through
+   * the invocation ID, which also takes care of the timeout. */
   yts_proxy_invoke (YTS_PROXY (self), invocation_id, "register-proxy",
                      g_variant_new_string (capability));
+  g_free (invocation_id);
 }
 
 static void
-_unregister_proxy (YtsProfile  *self,
-                   char const   *invocation_id_,
-                   char const   *capability)
+_register_proxies (YtsProfile          *self,
+                   char const          *invocation_id_,
+                   char const *const   *capabilities)
 {
-  YtsProfileProxyPrivate *priv = GET_PRIVATE (self);
   char *invocation_id;
 
   invocation_id = invocation_id_ ?
                     g_strdup (invocation_id_) :
                     yts_proxy_create_invocation_id (YTS_PROXY (self));
-  /* Hash takes invocation_id. */
-  g_hash_table_insert (priv->invocations,
-                       invocation_id, _unregister_proxy);
-  // TODO set timeout, well, probably in yts-proxy-service.c
 
-  yts_proxy_invoke (YTS_PROXY (self), invocation_id, "unregister-proxy",
-                     g_variant_new_string (capability));
+  /* Not tracked either, see _register_proxy(). */
+  yts_proxy_invoke (YTS_PROXY (self), invocation_id, "register-proxies",
+                     g_variant_new_strv (capabilities, -1));
+  g_free (invocation_id);
+}
+
+static void
+_unregister_proxy_ready (YtsProxy     *self,
+                         GAsyncResult *result,
+                         char         *invocation_id)
+{
+  GVariant  *response;
+  GError    *error = NULL;
+  bool       ret = false;
+
+  response = yts_proxy_invoke_finish (self, result, &error);
+  if (error) {
+    g_warning ("%s : %s", G_STRLOC, error->message);
+    g_clear_error (&error);
+  } else if (response &&
+             g_variant_is_of_type (response, G_VARIANT_TYPE_BOOLEAN)) {
+    ret = g_variant_get_boolean (response);
+  }
+
+  yts_profile_unregister_proxy_return (YTS_PROFILE (self),
+                                        invocation_id,
+                                        ret);
+
+  if (response) {
+    g_variant_unref (response);
+  }
+  g_free (invocation_id);
+}
+
+static void
+_unregister_proxy (YtsProfile  *self,
+                   char const   *invocation_id,
+                   char const   *capability)
+{
+  yts_proxy_invoke_async (YTS_PROXY (self), "unregister-proxy",
+                          g_variant_new_string (capability),
+                          -1, NULL,
+                          (GAsyncReadyCallback) _unregister_proxy_ready,
+                          invocation_id ?
+                            g_strdup (invocation_id) :
+                            yts_proxy_create_invocation_id (YTS_PROXY (self)));
 }
 
 static void
 _profile_interface_init (YtsProfileInterface *interface)
 {
   interface->register_proxy = _register_proxy;
+  interface->register_proxies = _register_proxies;
   interface->unregister_proxy = _unregister_proxy;
 }
 
@@ -113,49 +149,6 @@ _proxy_service_event (YtsProxy   *self,
              aspect);
 }
 
-static void
-_proxy_service_response (YtsProxy  *self,
-                         char const *invocation_id,
-                         GVariant   *response)
-{
-  YtsProfileProxyPrivate *priv = GET_PRIVATE (self);
-  void *call;
-
-  call = g_hash_table_lookup (priv->invocations, invocation_id);
-  // TODO clear timeout, well, probably in yts-proxy-service.c
-
-  if (call == _register_proxy) {
-
-    yts_profile_register_proxy_return (YTS_PROFILE (self),
-                                        invocation_id,
-                                        response);
-
-  } else if (call == _unregister_proxy) {
-
-    yts_profile_unregister_proxy_return (YTS_PROFILE (self),
-                                          invocation_id,
-                                          g_variant_get_boolean (response));
-
-  } else if (call == NULL) {
-
-    // TODO emit general response
-    g_critical ("%s : Response not found for invocation %s",
-                G_STRLOC,
-                invocation_id);
-
-  } else {
-
-    g_critical ("%s : Unknown call %p for invocation %s",
-                G_STRLOC,
-                call,
-                invocation_id);
-  }
-
-  if (call) {
-    g_hash_table_remove (priv->invocations, invocation_id);
-  }
-}
-
 /*
  * YtsProfileProxy
  */
@@ -206,12 +199,7 @@ _set_property (GObject      *object,
 static void
 _dispose (GObject *object)
 {
-  YtsProfileProxyPrivate *priv = GET_PRIVATE (object);
-
-  if (priv->invocations) {
-    g_hash_table_destroy (priv->invocations);
-    priv->invocations = NULL;
-  }
+  // YtsProfileProxyPrivate *priv = GET_PRIVATE (object);
 
   G_OBJECT_CLASS (yts_profile_proxy_parent_class)->dispose (object);
 }
@@ -229,7 +217,6 @@ yts_profile_proxy_class_init (YtsProfileProxyClass *klass)
   object_class->dispose = _dispose;
 
   proxy_class->service_event = _proxy_service_event;
-  proxy_class->service_response = _proxy_service_response;
 
   /* YtsCapability */
 
@@ -247,11 +234,5 @@ yts_profile_proxy_class_init (YtsProfileProxyClass *klass)
 static void
 yts_profile_proxy_init (YtsProfileProxy *self)
 {
-  YtsProfileProxyPrivate *priv = GET_PRIVATE (self);
-
-  priv->invocations = g_hash_table_new_full (g_str_hash,
-                                             g_str_equal,
-                                             g_free,
-                                             NULL);
 }
 
@@ -47,6 +47,16 @@ _register_proxy (YtsProfile  *self,
               G_OBJECT_TYPE_NAME (self));
 }
 
+static void
+_register_proxies (YtsProfile          *self,
+                   char const          *invocation_id,
+                   char const *const   *capabilities)
+{
+  g_critical ("%s : Method YtsProfile.register_proxies() not implemented by %s",
+              G_STRLOC,
+              G_OBJECT_TYPE_NAME (self));
+}
+
 static void
 _unregister_proxy (YtsProfile  *self,
                    char const   *invocation_id,
@@ -63,6 +73,7 @@ yts_profile_default_init (YtsProfileInterface *interface)
   GParamSpec *pspec;
 
   interface->register_proxy = _register_proxy;
+  interface->register_proxies = _register_proxies;
   interface->unregister_proxy = _unregister_proxy;
 
   pspec = g_param_spec_boxed ("capabilities", "", "",
@@ -117,6 +128,24 @@ yts_profile_register_proxy (YtsProfile  *self,
                                                      capability);
 }
 
+/*
+ * Register proxies for several capabilities at once. The response is a
+ * dictionary mapping each capability to its initial properties, or to
+ * boolean false if registering that one failed.
+ */
+void
+yts_profile_register_proxies (YtsProfile          *self,
+                              char const          *invocation_id,
+                              char const *const   *capabilities)
+{
+  g_return_if_fail (YTS_IS_PROFILE (self));
+  g_return_if_fail (capabilities && capabilities[0]);
+
+  YTS_PROFILE_GET_INTERFACE (self)->register_proxies (self,
+                                                       invocation_id,
+                                                       capabilities);
+}
+
 void
 yts_profile_unregister_proxy (YtsProfile  *self,
                                char const   *invocation_id,
@@ -55,6 +55,11 @@ struct YtsProfileInterface {
                      char const   *invocation_id,
                      char const   *capability);
 
+  void
+  (*register_proxies) (YtsProfile          *self,
+                       char const          *invocation_id,
+                       char const *const   *capabilities);
+
   void
   (*unregister_proxy) (YtsProfile  *self,
                        char const   *invocation_id,
@@ -72,6 +77,11 @@ yts_profile_register_proxy (YtsProfile  *self,
                              char const   *invocation_id,
                              char const   *capability);
 
+void
+yts_profile_register_proxies (YtsProfile          *self,
+                              char const          *invocation_id,
+                              char const *const   *capabilities);
+
 void
 yts_profile_unregister_proxy (YtsProfile  *self,
                                char const   *invocation_id,
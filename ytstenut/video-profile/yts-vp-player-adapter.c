@@ -25,6 +25,7 @@
 #include "yts-service-adapter.h"
 #include "yts-vp-player.h"
 #include "yts-vp-player-adapter.h"
+#include "video-profile/yts-vp-player-glue.h"
 
 G_DEFINE_TYPE (YtsVPPlayerAdapter,
                yts_vp_player_adapter,
@@ -47,30 +48,8 @@ static GVariant *
 _service_adapter_collect_properties (YtsServiceAdapter *self)
 {
   YtsVPPlayerAdapterPrivate *priv = GET_PRIVATE (self);
-  GVariantBuilder  builder;
-  bool             playing;
-  double           volume;
-  char            *playable_uri;
-
-  g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
-
-  playing = yts_vp_player_get_playing (priv->player);
-  g_variant_builder_add (&builder, "{sv}", "playing",
-                                           g_variant_new_boolean (playing));
-
-  volume = yts_vp_player_get_volume (priv->player);
-  g_variant_builder_add (&builder, "{sv}", "volume",
-                                           g_variant_new_double (volume));
-
-  /* PONDERING should NULL properties be synched or assumed default? */
-  playable_uri = yts_vp_player_get_playable_uri (priv->player);
-  if (playable_uri) {
-    g_variant_builder_add (&builder, "{sv}", "playable-uri",
-                                             g_variant_new_string (playable_uri));
-    g_free (playable_uri);
-  }
 
-  return g_variant_builder_end (&builder);
+  return yts_vp_player_glue_collect_properties (priv->player);
 }
 
 static bool
@@ -82,64 +61,16 @@ _service_adapter_invoke (YtsServiceAdapter *self,
   YtsVPPlayerAdapterPrivate *priv = GET_PRIVATE (self);
   bool keep_sae = false;
 
-  /* Properties */
-
   if (0 == g_strcmp0 ("playable", aspect)) {
 
     /* TODO */
     g_debug ("%s : 'playable' property not implemented yet", G_STRLOC);
 
-  } else if (0 == g_strcmp0 ("playing", aspect) &&
-             arguments &&
-             g_variant_is_of_type (arguments, G_VARIANT_TYPE_BOOLEAN)) {
-
-    /* PONDERING at some point we can maybe optimize out sending back the notification */
-    yts_vp_player_set_playing (priv->player,
-                                g_variant_get_boolean (arguments));
-
-  } else if (0 == g_strcmp0 ("volume", aspect) &&
-             arguments &&
-             g_variant_is_of_type (arguments, G_VARIANT_TYPE_DOUBLE)) {
-
-    /* PONDERING at some point we can maybe optimize out sending back the notification */
-    yts_vp_player_set_volume (priv->player,
-                               g_variant_get_double (arguments));
-
-  } else if (0 == g_strcmp0 ("playable-uri", aspect) &&
-             arguments &&
-             g_variant_is_of_type (arguments, G_VARIANT_TYPE_STRING)) {
-
-    /* PONDERING at some point we can maybe optimize out sending back the notification */
-    yts_vp_player_set_playable_uri (priv->player,
-                                     g_variant_get_string (arguments, NULL));
-
-  } else
-
-  /* Methods */
-
-  if (0 == g_strcmp0 ("play", aspect)) {
-
-    yts_vp_player_play (priv->player);
-
-  } else if (0 == g_strcmp0 ("pause", aspect)) {
-
-    yts_vp_player_pause (priv->player);
-
-  } else if (0 == g_strcmp0 ("next", aspect)) {
-
-    yts_vp_player_next (priv->player, invocation_id);
-    /* This method responds whether it could skip to next,
-     * so keep the return envelope. */
-    keep_sae = true;
-
-  } else if (0 == g_strcmp0 ("prev", aspect)) {
-
-    yts_vp_player_prev (priv->player, invocation_id);
-    /* This method responds whether it could skip to next,
-     * so keep the return envelope. */
-    keep_sae = true;
-
-  } else {
+  } else if (!yts_vp_player_glue_invoke (priv->player,
+                                         invocation_id,
+                                         aspect,
+                                         arguments,
+                                         &keep_sae)) {
 
     char *arg_string = arguments ?
                           g_variant_print (arguments, false) :
@@ -165,77 +96,6 @@ enum {
   PROP_SERVICE_ADAPTER_SERVICE
 };
 
-static void
-_player_notify_playable (YtsVPPlayer         *player,
-                         GParamSpec           *pspec,
-                         YtsVPPlayerAdapter  *self)
-{
-  /* TODO */
-  g_debug ("%s : %s() not implemented yet", G_STRLOC, __FUNCTION__);
-}
-
-static void
-_player_notify_playing (YtsVPPlayer         *player,
-                        GParamSpec           *pspec,
-                        YtsVPPlayerAdapter  *self)
-{
-  bool playing;
-
-  playing = yts_vp_player_get_playing (player);
-  yts_service_adapter_send_event (YTS_SERVICE_ADAPTER (self),
-                                   "playing",
-                                   g_variant_new_boolean (playing));
-}
-
-static void
-_player_notify_volume (YtsVPPlayer         *player,
-                       GParamSpec           *pspec,
-                       YtsVPPlayerAdapter  *self)
-{
-  double volume;
-
-  volume = yts_vp_player_get_volume (player);
-  yts_service_adapter_send_event (YTS_SERVICE_ADAPTER (self),
-                                   "volume",
-                                   g_variant_new_double (volume));
-}
-
-static void
-_player_notify_playable_uri (YtsVPPlayer         *player,
-                             GParamSpec           *pspec,
-                             YtsVPPlayerAdapter  *self)
-{
-  char *playable_uri;
-
-  playable_uri = yts_vp_player_get_playable_uri (player);
-  yts_service_adapter_send_event (YTS_SERVICE_ADAPTER (self),
-                                   "playable-uri",
-                                   g_variant_new_string (playable_uri));
-  g_free (playable_uri);
-}
-
-static void
-_player_next_response (YtsVPPlayer         *player,
-                       char const           *invocation_id,
-                       bool                  return_value,
-                       YtsVPPlayerAdapter  *self)
-{
-  yts_service_adapter_send_response (YTS_SERVICE_ADAPTER (self),
-                                      invocation_id,
-                                      g_variant_new_boolean (return_value));
-}
-
-static void
-_player_prev_response (YtsVPPlayer         *player,
-                       char const           *invocation_id,
-                       bool                  return_value,
-                       YtsVPPlayerAdapter  *self)
-{
-  yts_service_adapter_send_response (YTS_SERVICE_ADAPTER (self),
-                                      invocation_id,
-                                      g_variant_new_boolean (return_value));
-}
-
 static void
 _player_destroyed (YtsVPPlayerAdapter  *self,
                    void                 *stale_player_ptr)
@@ -288,19 +148,8 @@ _set_property (GObject      *object,
                          (GWeakNotify) _player_destroyed,
                          object);
 
-      g_signal_connect (priv->player, "notify::playable",
-                        G_CALLBACK (_player_notify_playable), object);
-      g_signal_connect (priv->player, "notify::playing",
-                        G_CALLBACK (_player_notify_playing), object);
-      g_signal_connect (priv->player, "notify::volume",
-                        G_CALLBACK (_player_notify_volume), object);
-      g_signal_connect (priv->player, "notify::playable-uri",
-                        G_CALLBACK (_player_notify_playable_uri), object);
-
-      g_signal_connect (priv->player, "next-response",
-                        G_CALLBACK (_player_next_response), object);
-      g_signal_connect (priv->player, "prev-response",
-                        G_CALLBACK (_player_prev_response), object);
+      yts_vp_player_glue_connect_adapter (priv->player,
+                                          YTS_SERVICE_ADAPTER (object));
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
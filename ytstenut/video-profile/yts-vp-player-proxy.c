@@ -27,6 +27,7 @@
 #include "yts-vp-playable-proxy.h"
 #include "yts-vp-player.h"
 #include "yts-vp-player-proxy.h"
+#include "video-profile/yts-vp-player-glue.h"
 
 static void
 _player_interface_init (YtsVPPlayerInterface *interface);
@@ -48,9 +49,6 @@ typedef struct {
   double               volume;
   char                *playable_uri;
 
-  /* Data */
-  GHashTable  *invocations;
-
 } YtsVPPlayerProxyPrivate;
 
 static void
@@ -87,39 +85,75 @@ _player_pause (YtsVPPlayer *self)
   g_free (invocation_id);
 }
 
+/*
+ * Returns the boolean response, false if the invocation failed.
+ */
+static bool
+finish_boolean_invocation (YtsProxy     *self,
+                           GAsyncResult *result)
+{
+  GVariant  *response;
+  GError    *error = NULL;
+  bool       ret = false;
+
+  response = yts_proxy_invoke_finish (self, result, &error);
+  if (error) {
+    g_warning ("%s : %s", G_STRLOC, error->message);
+    g_clear_error (&error);
+  } else if (response &&
+             g_variant_is_of_type (response, G_VARIANT_TYPE_BOOLEAN)) {
+    ret = g_variant_get_boolean (response);
+  }
+
+  if (response) {
+    g_variant_unref (response);
+  }
+
+  return ret;
+}
+
 static void
-_player_next (YtsVPPlayer  *self,
-              char const    *invocation_id_)
+_player_next_ready (YtsProxy     *self,
+                    GAsyncResult *result,
+                    char         *invocation_id)
 {
-  YtsVPPlayerProxyPrivate *priv = GET_PRIVATE (self);
-  char *invocation_id;
+  bool ret = finish_boolean_invocation (self, result);
 
-  invocation_id = invocation_id_ ?
-                    g_strdup (invocation_id_) :
-                    yts_proxy_create_invocation_id (YTS_PROXY (self));
-  /* Hash takes invocation_id. */
-  g_hash_table_insert (priv->invocations,
-                       invocation_id, _player_next);
-  // TODO set timeout, well, probably in yts-proxy-service.c
+  yts_vp_player_next_return (YTS_VP_PLAYER (self), invocation_id, ret);
+  g_free (invocation_id);
+}
 
-  yts_proxy_invoke (YTS_PROXY (self), invocation_id, "next", NULL);
+static void
+_player_next (YtsVPPlayer  *self,
+              char const    *invocation_id)
+{
+  yts_proxy_invoke_async (YTS_PROXY (self), "next", NULL, -1, NULL,
+                          (GAsyncReadyCallback) _player_next_ready,
+                          invocation_id ?
+                            g_strdup (invocation_id) :
+                            yts_proxy_create_invocation_id (YTS_PROXY (self)));
 }
 
 static void
-_player_prev (YtsVPPlayer  *self,
-              char const    *invocation_id_)
+_player_prev_ready (YtsProxy     *self,
+                    GAsyncResult *result,
+                    char         *invocation_id)
 {
-  YtsVPPlayerProxyPrivate *priv = GET_PRIVATE (self);
-  char *invocation_id;
+  bool ret = finish_boolean_invocation (self, result);
 
-  invocation_id = invocation_id_ ?
-                    g_strdup (invocation_id_) :
-                    yts_proxy_create_invocation_id (YTS_PROXY (self));
-  /* Hash takes invocation_id. */
-  g_hash_table_insert (priv->invocations, invocation_id, _player_prev);
-  // TODO set timeout, well, probably in yts-proxy-service.c
+  yts_vp_player_prev_return (YTS_VP_PLAYER (self), invocation_id, ret);
+  g_free (invocation_id);
+}
 
-  yts_proxy_invoke (YTS_PROXY (self), invocation_id, "prev", NULL);
+static void
+_player_prev (YtsVPPlayer  *self,
+              char const    *invocation_id)
+{
+  yts_proxy_invoke_async (YTS_PROXY (self), "prev", NULL, -1, NULL,
+                          (GAsyncReadyCallback) _player_prev_ready,
+                          invocation_id ?
+                            g_strdup (invocation_id) :
+                            yts_proxy_create_invocation_id (YTS_PROXY (self)));
 }
 
 static void
@@ -142,30 +176,21 @@ _proxy_service_event (YtsProxy   *self,
 {
 //  YtsVPPlayerProxyPrivate *priv = GET_PRIVATE (self);
 
+  static YtsVPPlayerProxyGlue const glue = {
+    player_proxy_set_playing,
+    player_proxy_set_volume,
+    player_proxy_set_playable_uri
+  };
+
   if (0 == g_strcmp0 ("playable", aspect)) {
 
     /* TODO */
     g_debug ("%s : 'playable' property not implemented yet", G_STRLOC);
 
-  } else if (0 == g_strcmp0 ("playing", aspect) &&
-             g_variant_is_of_type (arguments, G_VARIANT_TYPE_BOOLEAN)) {
-
-    bool playing = g_variant_get_boolean (arguments);
-    player_proxy_set_playing (YTS_VP_PLAYER_PROXY (self), playing);
-
-  } else if (0 == g_strcmp0 ("volume", aspect) &&
-             g_variant_is_of_type (arguments, G_VARIANT_TYPE_DOUBLE)) {
-
-    double volume = g_variant_get_double (arguments);
-    player_proxy_set_volume (YTS_VP_PLAYER_PROXY (self), volume);
-
-  } else if (0 == g_strcmp0 ("playable-uri", aspect) &&
-             g_variant_is_of_type (arguments, G_VARIANT_TYPE_STRING)) {
-
-    char const *playable_uri = g_variant_get_string (arguments, NULL);
-    player_proxy_set_playable_uri (YTS_VP_PLAYER_PROXY (self), playable_uri);
-
-  } else {
+  } else if (!yts_vp_player_glue_dispatch_event (YTS_VP_PLAYER_PROXY (self),
+                                                 &glue,
+                                                 aspect,
+                                                 arguments)) {
 
     g_critical ("%s : Unhandled event '%s' of type '%s'",
                 G_STRLOC,
@@ -176,49 +201,6 @@ _proxy_service_event (YtsProxy   *self,
   }
 }
 
-static void
-_proxy_service_response (YtsProxy  *self,
-                         char const *invocation_id,
-                         GVariant   *response)
-{
-  YtsVPPlayerProxyPrivate *priv = GET_PRIVATE (self);
-  void *call;
-
-  call = g_hash_table_lookup (priv->invocations, invocation_id);
-  // TODO clear timeout, well, probably in yts-proxy-service.c
-
-  if (call == _player_next) {
-
-    yts_vp_player_next_return (YTS_VP_PLAYER (self),
-                                invocation_id,
-                                g_variant_get_boolean (response));
-
-  } else if (call == _player_prev) {
-
-    yts_vp_player_prev_return (YTS_VP_PLAYER (self),
-                                invocation_id,
-                                g_variant_get_boolean (response));
-
-  } else if (call == NULL) {
-
-    // TODO emit general response
-    g_critical ("%s : Response not found for invocation %s",
-                G_STRLOC,
-                invocation_id);
-
-  } else {
-
-    g_critical ("%s : Unknown call %p for invocation %s",
-                G_STRLOC,
-                call,
-                invocation_id);
-  }
-
-  if (call) {
-    g_hash_table_remove (priv->invocations, invocation_id);
-  }
-}
-
 /*
  * YtsVPPlayerProxy
  */
@@ -327,11 +309,6 @@ _dispose (GObject *object)
     priv->playable = NULL;
   }
 
-  if (priv->invocations) {
-    g_hash_table_destroy (priv->invocations);
-    priv->invocations = NULL;
-  }
-
   G_OBJECT_CLASS (yts_vp_player_proxy_parent_class)->dispose (object);
 }
 
@@ -348,7 +325,6 @@ yts_vp_player_proxy_class_init (YtsVPPlayerProxyClass *klass)
   object_class->dispose = _dispose;
 
   proxy_class->service_event = _proxy_service_event;
-  proxy_class->service_response = _proxy_service_response;
 
   /* YtsCapability */
 
@@ -378,12 +354,6 @@ yts_vp_player_proxy_class_init (YtsVPPlayerProxyClass *klass)
 static void
 yts_vp_player_proxy_init (YtsVPPlayerProxy *self)
 {
-  YtsVPPlayerProxyPrivate *priv = GET_PRIVATE (self);
-
-  priv->invocations = g_hash_table_new_full (g_str_hash,
-                                             g_str_equal,
-                                             g_free,
-                                             NULL);
 }
 
 static void
@@ -22,6 +22,7 @@
 #include "yts-service-adapter.h"
 #include "yts-vp-transcript.h"
 #include "yts-vp-transcript-adapter.h"
+#include "video-profile/yts-vp-transcript-glue.h"
 
 G_DEFINE_TYPE (YtsVPTranscriptAdapter,
                yts_vp_transcript_adapter,
@@ -44,36 +45,8 @@ static GVariant *
 _service_adapter_collect_properties (YtsServiceAdapter *self)
 {
   YtsVPTranscriptAdapterPrivate *priv = GET_PRIVATE (self);
-  GVariantBuilder   builder;
-  char            **locales;
-  char             *current_text;
-  char             *locale;
-
-  g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
-
-  locales = yts_vp_transcript_get_available_locales (priv->transcript);
-  if (locales) {
-    GVariant *v = g_variant_new_strv ((char const *const *) locales, -1);
-    g_variant_builder_add (&builder, "{sv}",
-                           "available-locales", v);
-    g_strfreev (locales);
-  }
-
-  current_text = yts_vp_transcript_get_current_text (priv->transcript);
-  if (current_text) {
-    g_variant_builder_add (&builder, "{sv}",
-                           "current-text", g_variant_new_string (current_text));
-    g_free (current_text);
-  }
 
-  locale = yts_vp_transcript_get_locale (priv->transcript);
-  if (locale) {
-    g_variant_builder_add (&builder, "{sv}",
-                           "locale", g_variant_new_string (locale));
-    g_free (locale);
-  }
-
-  return g_variant_builder_end (&builder);
+  return yts_vp_transcript_glue_collect_properties (priv->transcript);
 }
 
 static bool
@@ -85,16 +58,11 @@ _service_adapter_invoke (YtsServiceAdapter *self,
   YtsVPTranscriptAdapterPrivate *priv = GET_PRIVATE (self);
   bool keep_sae = false;
 
-  /* Properties */
-
-  if (0 == g_strcmp0 ("locale", aspect) &&
-      arguments &&
-      g_variant_is_of_type (arguments, G_VARIANT_TYPE_STRING)) {
-
-    yts_vp_transcript_set_locale (priv->transcript,
-                                   g_variant_get_string (arguments, NULL));
-
-  } else {
+  if (!yts_vp_transcript_glue_invoke (priv->transcript,
+                                      invocation_id,
+                                      aspect,
+                                      arguments,
+                                      &keep_sae)) {
 
     char *arg_string = arguments ?
                           g_variant_print (arguments, false) :
@@ -120,50 +88,6 @@ enum {
   PROP_SERVICE_ADAPTER_SERVICE
 };
 
-static void
-_transcript_notify_available_locales (YtsVPTranscript        *transcript,
-                                      GParamSpec              *pspec,
-                                      YtsVPTranscriptAdapter *self)
-{
-  char **locales;
-  GVariant *v;
-
-  locales = yts_vp_transcript_get_available_locales (transcript);
-  v = g_variant_new_strv ((char const *const *) locales, -1);
-  yts_service_adapter_send_event (YTS_SERVICE_ADAPTER (self),
-                                   "available-locales",
-                                   v);
-  g_strfreev (locales);
-}
-
-static void
-_transcript_notify_current_text (YtsVPTranscript         *transcript,
-                                 GParamSpec               *pspec,
-                                 YtsVPTranscriptAdapter  *self)
-{
-  char *current_text;
-
-  current_text = yts_vp_transcript_get_current_text (transcript);
-  yts_service_adapter_send_event (YTS_SERVICE_ADAPTER (self),
-                                   "current-text",
-                                   g_variant_new_string (current_text));
-  g_free (current_text);
-}
-
-static void
-_transcript_notify_locale (YtsVPTranscript         *transcript,
-                           GParamSpec               *pspec,
-                           YtsVPTranscriptAdapter  *self)
-{
-  char *locale;
-
-  locale = yts_vp_transcript_get_locale (transcript);
-  yts_service_adapter_send_event (YTS_SERVICE_ADAPTER (self),
-                                   "locale",
-                                   g_variant_new_string (locale));
-  g_free (locale);
-}
-
 static void
 _transcript_destroyed (YtsVPTranscriptAdapter  *self,
                        void                     *stale_transcript_ptr)
@@ -216,13 +140,8 @@ _set_property (GObject      *object,
                          (GWeakNotify) _transcript_destroyed,
                          object);
 
-      g_signal_connect (priv->transcript, "notify::available-locales",
-                        G_CALLBACK (_transcript_notify_available_locales),
-                        object);
-      g_signal_connect (priv->transcript, "notify::current-text",
-                        G_CALLBACK (_transcript_notify_current_text), object);
-      g_signal_connect (priv->transcript, "notify::locale",
-                        G_CALLBACK (_transcript_notify_locale), object);
+      yts_vp_transcript_glue_connect_adapter (priv->transcript,
+                                              YTS_SERVICE_ADAPTER (object));
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
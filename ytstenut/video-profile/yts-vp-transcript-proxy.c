@@ -23,6 +23,7 @@
 
 #include "yts-vp-transcript.h"
 #include "yts-vp-transcript-proxy.h"
+#include "video-profile/yts-vp-transcript-glue.h"
 
 static void
 _transcript_interface_init (YtsVPTranscriptInterface *interface);
@@ -43,9 +44,6 @@ typedef struct {
   char     *current_text;
   char     *locale;
 
-  /* Data */
-  GHashTable  *invocations;
-
 } YtsVPTranscriptProxyPrivate;
 
 static void
@@ -79,30 +77,17 @@ _proxy_service_event (YtsProxy   *self,
 {
 //  YtsVPTranscriptProxyPrivate *priv = GET_PRIVATE (self);
 
-  if (0 == g_strcmp0 ("available-locales", aspect) &&
-      g_variant_is_of_type (arguments, G_VARIANT_TYPE_STRING_ARRAY)) {
-
-    /* Read-only property, sync behind the scenes. */
-    char const **locales = g_variant_get_strv (arguments, NULL);
-    transcript_proxy_set_available_locales (YTS_VP_TRANSCRIPT_PROXY (self),
-                                            locales);
-    g_free (locales); /* See g_variant_get_strv(). */
-
-  } else if (0 == g_strcmp0 ("current-text", aspect) &&
-             g_variant_is_of_type (arguments, G_VARIANT_TYPE_STRING)) {
-
-    /* Read-only property, sync behind the scenes. */
-    char const *current_text = g_variant_get_string (arguments, NULL);
-    transcript_proxy_set_current_text (YTS_VP_TRANSCRIPT_PROXY (self),
-                                       current_text);
-
-  } else if (0 == g_strcmp0 ("locale", aspect) &&
-             g_variant_is_of_type (arguments, G_VARIANT_TYPE_STRING)) {
-
-    char const *locale = g_variant_get_string (arguments, NULL);
-    transcript_proxy_set_locale (YTS_VP_TRANSCRIPT_PROXY (self), locale);
+  static YtsVPTranscriptProxyGlue const glue = {
+    transcript_proxy_set_available_locales,
+    transcript_proxy_set_current_text,
+    transcript_proxy_set_locale
+  };
 
-  } else {
+  /* Read-only properties are synced behind the scenes too. */
+  if (!yts_vp_transcript_glue_dispatch_event (YTS_VP_TRANSCRIPT_PROXY (self),
+                                              &glue,
+                                              aspect,
+                                              arguments)) {
 
     g_critical ("%s : Unhandled event '%s' of type '%s'",
                 G_STRLOC,
@@ -197,12 +182,7 @@ _set_property (GObject      *object,
 static void
 _dispose (GObject *object)
 {
-  YtsVPTranscriptProxyPrivate *priv = GET_PRIVATE (object);
-
-  if (priv->invocations) {
-    g_hash_table_destroy (priv->invocations);
-    priv->invocations = NULL;
-  }
+  // YtsVPTranscriptProxyPrivate *priv = GET_PRIVATE (object);
 
   G_OBJECT_CLASS (yts_vp_transcript_proxy_parent_class)->dispose (object);
 }
@@ -246,12 +226,6 @@ yts_vp_transcript_proxy_class_init (YtsVPTranscriptProxyClass *klass)
 static void
 yts_vp_transcript_proxy_init (YtsVPTranscriptProxy *self)
 {
-  YtsVPTranscriptProxyPrivate *priv = GET_PRIVATE (self);
-
-  priv->invocations = g_hash_table_new_full (g_str_hash,
-                                             g_str_equal,
-                                             g_free,
-                                             NULL);
 }
 
 static void
@@ -0,0 +1,184 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "yts-bundle-input-stream.h"
+#include "yts-file-transfer-internal.h"
+
+G_DEFINE_TYPE (YtsBundleInputStream,
+               yts_bundle_input_stream,
+               G_TYPE_INPUT_STREAM)
+
+/*
+ * Reads the files of an outgoing bundle back to back. Each file is read up
+ * to the size announced in the manifest, if it has been truncated meanwhile
+ * the stream fails rather than corrupting the following entries.
+ */
+
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), YTS_TYPE_BUNDLE_INPUT_STREAM, YtsBundleInputStreamPrivate))
+
+typedef struct {
+  GPtrArray     *files;
+  GPtrArray     *entries;
+  unsigned       current;
+  GInputStream  *stream;
+  uint64_t       remaining;
+} YtsBundleInputStreamPrivate;
+
+static gssize
+_read (GInputStream  *stream,
+       void          *buffer,
+       gsize          count,
+       GCancellable  *cancellable,
+       GError       **error)
+{
+  YtsBundleInputStreamPrivate *priv = GET_PRIVATE (stream);
+
+  while (priv->current < priv->files->len) {
+
+    gssize n_read;
+
+    if (NULL == priv->stream) {
+      YtsBundleEntry const *entry = g_ptr_array_index (priv->entries,
+                                                       priv->current);
+      GFile *file = g_ptr_array_index (priv->files, priv->current);
+
+      priv->stream = (GInputStream *) g_file_read (file, cancellable, error);
+      if (NULL == priv->stream) {
+        return -1;
+      }
+      priv->remaining = entry->size;
+    }
+
+    if (priv->remaining > 0) {
+      n_read = g_input_stream_read (priv->stream,
+                                    buffer,
+                                    MIN (count, priv->remaining),
+                                    cancellable,
+                                    error);
+      if (n_read < 0) {
+        return -1;
+      }
+      if (0 == n_read) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+                     "Bundle entry %u is shorter than announced",
+                     priv->current);
+        return -1;
+      }
+      priv->remaining -= n_read;
+      return n_read;
+    }
+
+    /* Entry done, move on. */
+    g_input_stream_close (priv->stream, cancellable, NULL);
+    g_object_unref (priv->stream);
+    priv->stream = NULL;
+    priv->current++;
+  }
+
+  return 0;
+}
+
+static gboolean
+_close (GInputStream  *stream,
+        GCancellable  *cancellable,
+        GError       **error)
+{
+  YtsBundleInputStreamPrivate *priv = GET_PRIVATE (stream);
+  bool ret = true;
+
+  if (priv->stream) {
+    ret = g_input_stream_close (priv->stream, cancellable, error);
+    g_object_unref (priv->stream);
+    priv->stream = NULL;
+  }
+
+  return ret;
+}
+
+static void
+_finalize (GObject *object)
+{
+  YtsBundleInputStreamPrivate *priv = GET_PRIVATE (object);
+
+  if (priv->stream) {
+    g_object_unref (priv->stream);
+    priv->stream = NULL;
+  }
+
+  if (priv->files) {
+    g_ptr_array_unref (priv->files);
+    priv->files = NULL;
+  }
+
+  if (priv->entries) {
+    g_ptr_array_unref (priv->entries);
+    priv->entries = NULL;
+  }
+
+  G_OBJECT_CLASS (yts_bundle_input_stream_parent_class)->finalize (object);
+}
+
+static void
+yts_bundle_input_stream_class_init (YtsBundleInputStreamClass *klass)
+{
+  GObjectClass      *object_class = G_OBJECT_CLASS (klass);
+  GInputStreamClass *stream_class = G_INPUT_STREAM_CLASS (klass);
+
+  g_type_class_add_private (klass, sizeof (YtsBundleInputStreamPrivate));
+
+  object_class->finalize = _finalize;
+
+  stream_class->read_fn = _read;
+  stream_class->close_fn = _close;
+}
+
+static void
+yts_bundle_input_stream_init (YtsBundleInputStream *self)
+{
+}
+
+/*
+ * @files: array of #GFile.
+ * @entries: array of #YtsBundleEntry, one per file.
+ */
+GInputStream *
+yts_bundle_input_stream_new (GPtrArray *files,
+                             GPtrArray *entries)
+{
+  GInputStream                *self;
+  YtsBundleInputStreamPrivate *priv;
+
+  g_return_val_if_fail (files, NULL);
+  g_return_val_if_fail (entries, NULL);
+  g_return_val_if_fail (files->len == entries->len, NULL);
+
+  self = g_object_new (YTS_TYPE_BUNDLE_INPUT_STREAM, NULL);
+  priv = GET_PRIVATE (self);
+  priv->files = g_ptr_array_ref (files);
+  priv->entries = g_ptr_array_ref (entries);
+
+  return self;
+}
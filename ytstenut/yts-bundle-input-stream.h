@@ -0,0 +1,53 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_BUNDLE_INPUT_STREAM_H
+#define YTS_BUNDLE_INPUT_STREAM_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define YTS_TYPE_BUNDLE_INPUT_STREAM yts_bundle_input_stream_get_type()
+
+#define YTS_BUNDLE_INPUT_STREAM(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), YTS_TYPE_BUNDLE_INPUT_STREAM, YtsBundleInputStream))
+
+#define YTS_IS_BUNDLE_INPUT_STREAM(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), YTS_TYPE_BUNDLE_INPUT_STREAM))
+
+typedef struct {
+  GInputStream parent;
+} YtsBundleInputStream;
+
+typedef struct {
+  GInputStreamClass parent;
+} YtsBundleInputStreamClass;
+
+GType
+yts_bundle_input_stream_get_type (void) G_GNUC_CONST;
+
+GInputStream *
+yts_bundle_input_stream_new (GPtrArray *files,
+                             GPtrArray *entries);
+
+G_END_DECLS
+
+#endif /* YTS_BUNDLE_INPUT_STREAM_H */
@@ -0,0 +1,257 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "yts-bundle-output-stream.h"
+#include "yts-file-transfer-internal.h"
+
+G_DEFINE_TYPE (YtsBundleOutputStream,
+               yts_bundle_output_stream,
+               G_TYPE_OUTPUT_STREAM)
+
+/*
+ * Splits the content of an incoming bundle into one file per entry, as
+ * listed in the manifest. Entries without a target file are skipped.
+ *
+ * Writing happens in splice's worker thread, so progress is only recorded
+ * in a counter that the main thread polls.
+ */
+
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), YTS_TYPE_BUNDLE_OUTPUT_STREAM, YtsBundleOutputStreamPrivate))
+
+typedef struct {
+  GPtrArray     *entries;
+  GPtrArray     *targets;
+  unsigned       current;
+  GOutputStream *stream;
+  uint64_t       remaining;
+  bool           opened;
+  volatile int   n_completed;
+} YtsBundleOutputStreamPrivate;
+
+/*
+ * Open the current entry's target, if any, and skip past empty entries.
+ */
+static bool
+open_entry (YtsBundleOutputStream  *self,
+            GCancellable           *cancellable,
+            GError                **error)
+{
+  YtsBundleOutputStreamPrivate *priv = GET_PRIVATE (self);
+
+  while (priv->current < priv->entries->len && !priv->opened) {
+
+    YtsBundleEntry const *entry = g_ptr_array_index (priv->entries,
+                                                     priv->current);
+    GFile *target = g_ptr_array_index (priv->targets, priv->current);
+
+    if (target) {
+      priv->stream = (GOutputStream *) g_file_replace (target,
+                                                       NULL,
+                                                       false,
+                                                       G_FILE_CREATE_NONE,
+                                                       cancellable,
+                                                       error);
+      if (NULL == priv->stream) {
+        return false;
+      }
+    }
+
+    priv->remaining = entry->size;
+    priv->opened = true;
+
+    if (0 == priv->remaining) {
+      if (priv->stream) {
+        g_output_stream_close (priv->stream, cancellable, NULL);
+        g_object_unref (priv->stream);
+        priv->stream = NULL;
+      }
+      priv->opened = false;
+      priv->current++;
+      g_atomic_int_inc (&priv->n_completed);
+    }
+  }
+
+  return true;
+}
+
+static gssize
+_write (GOutputStream  *stream,
+        void const     *buffer,
+        gsize           count,
+        GCancellable   *cancellable,
+        GError        **error)
+{
+  YtsBundleOutputStream         *self = YTS_BUNDLE_OUTPUT_STREAM (stream);
+  YtsBundleOutputStreamPrivate  *priv = GET_PRIVATE (self);
+  gssize                         n_written;
+
+  if (!open_entry (self, cancellable, error)) {
+    return -1;
+  }
+
+  if (priv->current >= priv->entries->len) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                 "Bundle is larger than announced");
+    return -1;
+  }
+
+  if (priv->stream) {
+    n_written = g_output_stream_write (priv->stream,
+                                       buffer,
+                                       MIN (count, priv->remaining),
+                                       cancellable,
+                                       error);
+    if (n_written < 0) {
+      return -1;
+    }
+  } else {
+    /* Not selected, discard. */
+    n_written = MIN (count, priv->remaining);
+  }
+
+  priv->remaining -= n_written;
+  if (0 == priv->remaining) {
+    if (priv->stream) {
+      bool closed = g_output_stream_close (priv->stream, cancellable, error);
+      g_object_unref (priv->stream);
+      priv->stream = NULL;
+      if (!closed) {
+        return -1;
+      }
+    }
+    priv->opened = false;
+    priv->current++;
+    g_atomic_int_inc (&priv->n_completed);
+  }
+
+  return n_written;
+}
+
+static gboolean
+_close (GOutputStream  *stream,
+        GCancellable   *cancellable,
+        GError        **error)
+{
+  YtsBundleOutputStream         *self = YTS_BUNDLE_OUTPUT_STREAM (stream);
+  YtsBundleOutputStreamPrivate  *priv = GET_PRIVATE (self);
+
+  /* Trailing empty entries. */
+  if (!open_entry (self, cancellable, error)) {
+    return false;
+  }
+
+  if (priv->current < priv->entries->len) {
+    if (priv->stream) {
+      g_output_stream_close (priv->stream, cancellable, NULL);
+      g_object_unref (priv->stream);
+      priv->stream = NULL;
+    }
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+                 "Bundle is shorter than announced");
+    return false;
+  }
+
+  return true;
+}
+
+static void
+_finalize (GObject *object)
+{
+  YtsBundleOutputStreamPrivate *priv = GET_PRIVATE (object);
+
+  if (priv->stream) {
+    g_object_unref (priv->stream);
+    priv->stream = NULL;
+  }
+
+  if (priv->entries) {
+    g_ptr_array_unref (priv->entries);
+    priv->entries = NULL;
+  }
+
+  if (priv->targets) {
+    g_ptr_array_unref (priv->targets);
+    priv->targets = NULL;
+  }
+
+  G_OBJECT_CLASS (yts_bundle_output_stream_parent_class)->finalize (object);
+}
+
+static void
+yts_bundle_output_stream_class_init (YtsBundleOutputStreamClass *klass)
+{
+  GObjectClass        *object_class = G_OBJECT_CLASS (klass);
+  GOutputStreamClass  *stream_class = G_OUTPUT_STREAM_CLASS (klass);
+
+  g_type_class_add_private (klass, sizeof (YtsBundleOutputStreamPrivate));
+
+  object_class->finalize = _finalize;
+
+  stream_class->write_fn = _write;
+  stream_class->close_fn = _close;
+}
+
+static void
+yts_bundle_output_stream_init (YtsBundleOutputStream *self)
+{
+}
+
+/*
+ * @entries: array of #YtsBundleEntry.
+ * @targets: array of #GFile, or %NULL for entries to skip.
+ */
+GOutputStream *
+yts_bundle_output_stream_new (GPtrArray *entries,
+                              GPtrArray *targets)
+{
+  GOutputStream                 *self;
+  YtsBundleOutputStreamPrivate  *priv;
+
+  g_return_val_if_fail (entries, NULL);
+  g_return_val_if_fail (targets, NULL);
+  g_return_val_if_fail (entries->len == targets->len, NULL);
+
+  self = g_object_new (YTS_TYPE_BUNDLE_OUTPUT_STREAM, NULL);
+  priv = GET_PRIVATE (self);
+  priv->entries = g_ptr_array_ref (entries);
+  priv->targets = g_ptr_array_ref (targets);
+
+  return self;
+}
+
+/*
+ * Number of leading entries that have been fully written. Safe to call
+ * while the stream is being written to from another thread.
+ */
+unsigned
+yts_bundle_output_stream_get_n_completed (YtsBundleOutputStream *self)
+{
+  YtsBundleOutputStreamPrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_BUNDLE_OUTPUT_STREAM (self), 0);
+
+  return g_atomic_int_get (&priv->n_completed);
+}
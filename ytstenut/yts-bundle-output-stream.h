@@ -0,0 +1,56 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_BUNDLE_OUTPUT_STREAM_H
+#define YTS_BUNDLE_OUTPUT_STREAM_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define YTS_TYPE_BUNDLE_OUTPUT_STREAM yts_bundle_output_stream_get_type()
+
+#define YTS_BUNDLE_OUTPUT_STREAM(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), YTS_TYPE_BUNDLE_OUTPUT_STREAM, YtsBundleOutputStream))
+
+#define YTS_IS_BUNDLE_OUTPUT_STREAM(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), YTS_TYPE_BUNDLE_OUTPUT_STREAM))
+
+typedef struct {
+  GOutputStream parent;
+} YtsBundleOutputStream;
+
+typedef struct {
+  GOutputStreamClass parent;
+} YtsBundleOutputStreamClass;
+
+GType
+yts_bundle_output_stream_get_type (void) G_GNUC_CONST;
+
+GOutputStream *
+yts_bundle_output_stream_new (GPtrArray *entries,
+                              GPtrArray *targets);
+
+unsigned
+yts_bundle_output_stream_get_n_completed (YtsBundleOutputStream *self);
+
+G_END_DECLS
+
+#endif /* YTS_BUNDLE_OUTPUT_STREAM_H */
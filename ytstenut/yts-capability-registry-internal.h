@@ -0,0 +1,34 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_CAPABILITY_REGISTRY_INTERNAL_H
+#define YTS_CAPABILITY_REGISTRY_INTERNAL_H
+
+#include <ytstenut/yts-capability-registry.h>
+
+G_BEGIN_DECLS
+
+/* Whether a proxy type is registered for @fqc_id, without loading it. */
+bool
+yts_capability_registry_has_proxy (char const *fqc_id);
+
+G_END_DECLS
+
+#endif /* YTS_CAPABILITY_REGISTRY_INTERNAL_H */
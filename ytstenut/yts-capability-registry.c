@@ -0,0 +1,392 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include "config.h"
+
+#include "yts-capability-registry-internal.h"
+#include "ytstenut-internal.h"
+
+#include "video-profile/yts-vp-player-adapter.h"
+#include "video-profile/yts-vp-player-proxy.h"
+#include "video-profile/yts-vp-transcript-adapter.h"
+#include "video-profile/yts-vp-transcript-proxy.h"
+
+/**
+ * SECTION: yts-capability-registry
+ * @short_description: Adapter and proxy types per capability.
+ *
+ * The capability registry maps a capability's fully qualified ID to the
+ * #YtsServiceAdapter subclass publishing a local implementation of it,
+ * and to the #YtsProxy subclass talking to remote ones. Services
+ * advertising a registered capability are discovered as
+ * #YtsProxyService, and yts_client_publish_service() can publish local
+ * services implementing one.
+ *
+ * Applications can register their own capabilities, or override built-in
+ * ones, at any time. Types do not need to exist at registration time:
+ * yts_capability_registry_register_lazy() takes their
+ * <function>get_type()</function> functions, and
+ * yts_capability_registry_register_module() names types provided by a
+ * #GTypeModule, which is only loaded when the first adapter or proxy for
+ * the capability is created. Merely checking for a capability, as done
+ * for every discovered service, never loads anything.
+ */
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN PACKAGE"\0factory\0"G_STRLOC
+
+typedef struct {
+  /* Resolved types. */
+  GType            adapter_gtype;
+  GType            proxy_gtype;
+  /* Deferred types, cleared once resolved. */
+  YtsGetTypeFunc   adapter_get_type;
+  YtsGetTypeFunc   proxy_get_type;
+  GTypeModule     *module;
+  char            *adapter_type_name;
+  char            *proxy_type_name;
+  bool             module_in_use;
+} Entry;
+
+/* Keyed by the fqc-id's quark. Looking up a string that has never been
+ * interned as a quark is known to miss without hashing it into the table,
+ * which is the common case for capabilities advertised by remote services
+ * that we have no proxy for. */
+static GHashTable *_registry = NULL;
+
+static void
+entry_free (Entry *entry)
+{
+  if (entry->module) {
+    if (entry->module_in_use) {
+      g_type_module_unuse (entry->module);
+    }
+    g_object_unref (entry->module);
+  }
+  g_free (entry->adapter_type_name);
+  g_free (entry->proxy_type_name);
+  g_slice_free (Entry, entry);
+}
+
+static GHashTable *
+ensure_registry (void)
+{
+  if (NULL == _registry) {
+
+    _registry = g_hash_table_new_full (g_direct_hash,
+                                       g_direct_equal,
+                                       NULL,
+                                       (GDestroyNotify) entry_free);
+
+    /* Built-in profiles. */
+    yts_capability_registry_register_lazy (
+                      "org.freedesktop.ytstenut.VideoProfile.Player",
+                      yts_vp_player_adapter_get_type,
+                      yts_vp_player_proxy_get_type);
+    yts_capability_registry_register_lazy (
+                      "org.freedesktop.ytstenut.VideoProfile.Transcript",
+                      yts_vp_transcript_adapter_get_type,
+                      yts_vp_transcript_proxy_get_type);
+  }
+
+  return _registry;
+}
+
+static Entry *
+lookup (char const *fqc_id)
+{
+  GHashTable  *registry;
+  GQuark       quark;
+
+  g_return_val_if_fail (fqc_id, NULL);
+
+  /* Registers the built-ins, interning their ids. */
+  registry = ensure_registry ();
+
+  quark = g_quark_try_string (fqc_id);
+  if (0 == quark) {
+    return NULL;
+  }
+
+  return g_hash_table_lookup (registry, GUINT_TO_POINTER (quark));
+}
+
+static void
+insert (char const  *fqc_id,
+        Entry       *entry)
+{
+  GQuark quark = g_quark_from_string (fqc_id);
+
+  if (g_hash_table_lookup (ensure_registry (), GUINT_TO_POINTER (quark))) {
+    DEBUG ("Replacing types for %s", fqc_id);
+  }
+
+  g_hash_table_insert (ensure_registry (), GUINT_TO_POINTER (quark), entry);
+}
+
+static GType
+resolve_type_name (Entry       *entry,
+                   char const  *type_name)
+{
+  GType gtype;
+
+  if (!entry->module_in_use) {
+    if (!g_type_module_use (entry->module)) {
+      g_warning ("%s : Failed to load module %s",
+                 G_STRLOC,
+                 entry->module->name);
+      return G_TYPE_INVALID;
+    }
+    /* Keep the module loaded for as long as it is registered,
+     * instances of its types may be around. */
+    entry->module_in_use = true;
+  }
+
+  gtype = g_type_from_name (type_name);
+  if (G_TYPE_INVALID == gtype) {
+    g_warning ("%s : Module %s does not provide type %s",
+               G_STRLOC,
+               entry->module->name,
+               type_name);
+  }
+
+  return gtype;
+}
+
+static void
+resolve (Entry *entry)
+{
+  if (entry->adapter_get_type) {
+    entry->adapter_gtype = entry->adapter_get_type ();
+    entry->adapter_get_type = NULL;
+  }
+
+  if (entry->proxy_get_type) {
+    entry->proxy_gtype = entry->proxy_get_type ();
+    entry->proxy_get_type = NULL;
+  }
+
+  if (entry->adapter_type_name) {
+    entry->adapter_gtype = resolve_type_name (entry, entry->adapter_type_name);
+    g_free (entry->adapter_type_name);
+    entry->adapter_type_name = NULL;
+  }
+
+  if (entry->proxy_type_name) {
+    entry->proxy_gtype = resolve_type_name (entry, entry->proxy_type_name);
+    g_free (entry->proxy_type_name);
+    entry->proxy_type_name = NULL;
+  }
+}
+
+/**
+ * yts_capability_registry_register:
+ * @fqc_id: fully qualified ID of the capability.
+ * @adapter_gtype: #YtsServiceAdapter subclass, or %G_TYPE_INVALID.
+ * @proxy_gtype: #YtsProxy subclass, or %G_TYPE_INVALID.
+ *
+ * Register the types implementing capability @fqc_id, replacing any
+ * previous registration. Either type may be %G_TYPE_INVALID if only
+ * publishing or only consuming the capability is supported.
+ *
+ * Since: 0.4
+ */
+void
+yts_capability_registry_register (char const  *fqc_id,
+                                  GType        adapter_gtype,
+                                  GType        proxy_gtype)
+{
+  Entry *entry;
+
+  g_return_if_fail (fqc_id);
+  g_return_if_fail (adapter_gtype != G_TYPE_INVALID ||
+                    proxy_gtype != G_TYPE_INVALID);
+
+  entry = g_slice_new0 (Entry);
+  entry->adapter_gtype = adapter_gtype;
+  entry->proxy_gtype = proxy_gtype;
+
+  insert (fqc_id, entry);
+}
+
+/**
+ * yts_capability_registry_register_lazy:
+ * @fqc_id: fully qualified ID of the capability.
+ * @adapter_get_type: (allow-none): function returning the
+ *                    #YtsServiceAdapter subclass.
+ * @proxy_get_type: (allow-none): function returning the #YtsProxy subclass.
+ *
+ * Like yts_capability_registry_register(), but the types are only
+ * registered with the type system once an adapter or proxy for @fqc_id
+ * is first needed.
+ *
+ * Since: 0.4
+ */
+void
+yts_capability_registry_register_lazy (char const     *fqc_id,
+                                       YtsGetTypeFunc  adapter_get_type,
+                                       YtsGetTypeFunc  proxy_get_type)
+{
+  Entry *entry;
+
+  g_return_if_fail (fqc_id);
+  g_return_if_fail (adapter_get_type || proxy_get_type);
+
+  entry = g_slice_new0 (Entry);
+  entry->adapter_get_type = adapter_get_type;
+  entry->proxy_get_type = proxy_get_type;
+
+  insert (fqc_id, entry);
+}
+
+/**
+ * yts_capability_registry_register_module:
+ * @fqc_id: fully qualified ID of the capability.
+ * @module: module providing the types.
+ * @adapter_type_name: (allow-none): name of the #YtsServiceAdapter subclass.
+ * @proxy_type_name: (allow-none): name of the #YtsProxy subclass.
+ *
+ * Like yts_capability_registry_register(), but the types are provided by
+ * @module, which is loaded using g_type_module_use() when an adapter or
+ * proxy for @fqc_id is first needed, and then stays loaded while
+ * registered.
+ *
+ * Since: 0.4
+ */
+void
+yts_capability_registry_register_module (char const  *fqc_id,
+                                         GTypeModule *module,
+                                         char const  *adapter_type_name,
+                                         char const  *proxy_type_name)
+{
+  Entry *entry;
+
+  g_return_if_fail (fqc_id);
+  g_return_if_fail (G_IS_TYPE_MODULE (module));
+  g_return_if_fail (adapter_type_name || proxy_type_name);
+
+  entry = g_slice_new0 (Entry);
+  entry->module = g_object_ref (module);
+  entry->adapter_type_name = g_strdup (adapter_type_name);
+  entry->proxy_type_name = g_strdup (proxy_type_name);
+
+  insert (fqc_id, entry);
+}
+
+/**
+ * yts_capability_registry_unregister:
+ * @fqc_id: fully qualified ID of the capability.
+ *
+ * Remove the registration for @fqc_id, including a built-in one. Existing
+ * adapters and proxies are not affected.
+ *
+ * Returns: %true if @fqc_id had been registered.
+ *
+ * Since: 0.4
+ */
+bool
+yts_capability_registry_unregister (char const *fqc_id)
+{
+  GHashTable  *registry;
+  GQuark       quark;
+
+  g_return_val_if_fail (fqc_id, false);
+
+  registry = ensure_registry ();
+
+  quark = g_quark_try_string (fqc_id);
+  if (0 == quark) {
+    return false;
+  }
+
+  return g_hash_table_remove (registry, GUINT_TO_POINTER (quark));
+}
+
+/**
+ * yts_capability_registry_has_fqc_id:
+ * @fqc_id: fully qualified ID of the capability.
+ *
+ * Check for a registration without resolving its types.
+ *
+ * Returns: %true if types are registered for @fqc_id.
+ *
+ * Since: 0.4
+ */
+bool
+yts_capability_registry_has_fqc_id (char const *fqc_id)
+{
+  return (bool) lookup (fqc_id);
+}
+
+/**
+ * yts_capability_registry_get_adapter_gtype:
+ * @fqc_id: fully qualified ID of the capability.
+ *
+ * Returns: the #YtsServiceAdapter subclass for @fqc_id, or
+ *          %G_TYPE_INVALID.
+ *
+ * Since: 0.4
+ */
+GType
+yts_capability_registry_get_adapter_gtype (char const *fqc_id)
+{
+  Entry *entry = lookup (fqc_id);
+
+  if (NULL == entry) {
+    return G_TYPE_INVALID;
+  }
+
+  resolve (entry);
+
+  return entry->adapter_gtype;
+}
+
+/**
+ * yts_capability_registry_get_proxy_gtype:
+ * @fqc_id: fully qualified ID of the capability.
+ *
+ * Returns: the #YtsProxy subclass for @fqc_id, or %G_TYPE_INVALID.
+ *
+ * Since: 0.4
+ */
+GType
+yts_capability_registry_get_proxy_gtype (char const *fqc_id)
+{
+  Entry *entry = lookup (fqc_id);
+
+  if (NULL == entry) {
+    return G_TYPE_INVALID;
+  }
+
+  resolve (entry);
+
+  return entry->proxy_gtype;
+}
+
+bool
+yts_capability_registry_has_proxy (char const *fqc_id)
+{
+  Entry *entry = lookup (fqc_id);
+
+  return entry &&
+         (entry->proxy_gtype != G_TYPE_INVALID ||
+          entry->proxy_get_type ||
+          entry->proxy_type_name);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_CAPABILITY_REGISTRY_H
+#define YTS_CAPABILITY_REGISTRY_H
+
+#include <stdbool.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/**
+ * YtsGetTypeFunc:
+ *
+ * A type's <function>get_type()</function> function, so registering a
+ * capability does not require registering its types right away.
+ *
+ * Returns: the #GType.
+ *
+ * Since: 0.4
+ */
+typedef GType (*YtsGetTypeFunc) (void);
+
+void
+yts_capability_registry_register (char const  *fqc_id,
+                                  GType        adapter_gtype,
+                                  GType        proxy_gtype);
+
+void
+yts_capability_registry_register_lazy (char const     *fqc_id,
+                                       YtsGetTypeFunc  adapter_get_type,
+                                       YtsGetTypeFunc  proxy_get_type);
+
+void
+yts_capability_registry_register_module (char const  *fqc_id,
+                                         GTypeModule *module,
+                                         char const  *adapter_type_name,
+                                         char const  *proxy_type_name);
+
+bool
+yts_capability_registry_unregister (char const *fqc_id);
+
+bool
+yts_capability_registry_has_fqc_id (char const *fqc_id);
+
+GType
+yts_capability_registry_get_adapter_gtype (char const *fqc_id);
+
+GType
+yts_capability_registry_get_proxy_gtype (char const *fqc_id);
+
+G_END_DECLS
+
+#endif /* YTS_CAPABILITY_REGISTRY_H */
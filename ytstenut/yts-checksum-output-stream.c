@@ -0,0 +1,151 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include "config.h"
+
+#include <stdbool.h>
+
+#include "yts-checksum-output-stream.h"
+
+G_DEFINE_TYPE (YtsChecksumOutputStream,
+               yts_checksum_output_stream,
+               G_TYPE_FILTER_OUTPUT_STREAM)
+
+/*
+ * Passes writes through to the base stream, and feeds what has been
+ * written into a checksum on the way. This verifies the data as it went
+ * out, rather than whatever a file reads back as later on.
+ *
+ * Writing happens in splice's worker thread, only query the checksum
+ * once the stream has been closed.
+ */
+
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), YTS_TYPE_CHECKSUM_OUTPUT_STREAM, YtsChecksumOutputStreamPrivate))
+
+typedef struct {
+  GChecksum *checksum;
+  uint64_t   n_written;
+} YtsChecksumOutputStreamPrivate;
+
+static gssize
+_write (GOutputStream  *stream,
+        void const     *buffer,
+        gsize           count,
+        GCancellable   *cancellable,
+        GError        **error)
+{
+  YtsChecksumOutputStreamPrivate *priv = GET_PRIVATE (stream);
+  GOutputStream *base_stream;
+  gssize         n_written;
+
+  base_stream = g_filter_output_stream_get_base_stream (
+                                            G_FILTER_OUTPUT_STREAM (stream));
+  n_written = g_output_stream_write (base_stream,
+                                     buffer,
+                                     count,
+                                     cancellable,
+                                     error);
+  if (n_written > 0) {
+    g_checksum_update (priv->checksum, (guchar const *) buffer, n_written);
+    priv->n_written += n_written;
+  }
+
+  return n_written;
+}
+
+static void
+_finalize (GObject *object)
+{
+  YtsChecksumOutputStreamPrivate *priv = GET_PRIVATE (object);
+
+  if (priv->checksum) {
+    g_checksum_free (priv->checksum);
+    priv->checksum = NULL;
+  }
+
+  G_OBJECT_CLASS (yts_checksum_output_stream_parent_class)->finalize (object);
+}
+
+static void
+yts_checksum_output_stream_class_init (YtsChecksumOutputStreamClass *klass)
+{
+  GObjectClass        *object_class = G_OBJECT_CLASS (klass);
+  GOutputStreamClass  *stream_class = G_OUTPUT_STREAM_CLASS (klass);
+
+  g_type_class_add_private (klass, sizeof (YtsChecksumOutputStreamPrivate));
+
+  object_class->finalize = _finalize;
+
+  stream_class->write_fn = _write;
+}
+
+static void
+yts_checksum_output_stream_init (YtsChecksumOutputStream *self)
+{
+}
+
+/*
+ * Takes ownership of @checksum, which may have been fed with data
+ * preceding what is written to the stream already, e.g. the partial file
+ * of a resumed transfer.
+ */
+GOutputStream *
+yts_checksum_output_stream_new (GOutputStream *base_stream,
+                                GChecksum     *checksum)
+{
+  GOutputStream                   *self;
+  YtsChecksumOutputStreamPrivate  *priv;
+
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (base_stream), NULL);
+  g_return_val_if_fail (checksum, NULL);
+
+  self = g_object_new (YTS_TYPE_CHECKSUM_OUTPUT_STREAM,
+                       "base-stream", base_stream,
+                       NULL);
+  priv = GET_PRIVATE (self);
+  priv->checksum = checksum;
+
+  return self;
+}
+
+char const *
+yts_checksum_output_stream_get_checksum (YtsChecksumOutputStream *self)
+{
+  YtsChecksumOutputStreamPrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_CHECKSUM_OUTPUT_STREAM (self), NULL);
+
+  return g_checksum_get_string (priv->checksum);
+}
+
+/*
+ * Number of bytes written through the stream, not counting what @checksum
+ * has been fed with beforehand.
+ */
+uint64_t
+yts_checksum_output_stream_get_n_written (YtsChecksumOutputStream *self)
+{
+  YtsChecksumOutputStreamPrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_CHECKSUM_OUTPUT_STREAM (self), 0);
+
+  return priv->n_written;
+}
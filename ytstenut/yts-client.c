@@ -21,6 +21,10 @@
 #include "config.h"
 
 #include <string.h>
+#ifdef G_OS_UNIX
+#include <signal.h>
+#include <glib-unix.h>
+#endif
 #include <rest/rest-xml-parser.h>
 #include <telepathy-glib/telepathy-glib.h>
 #include <telepathy-glib/connection-manager.h>
@@ -42,25 +46,45 @@
 #include "yts-enum-types.h"
 #include "yts-error-message.h"
 #include "yts-event-message.h"
-#include "yts-file-transfer.h"
+#include "yts-file-transfer-internal.h"
+#include "yts-histogram.h"
+#include "yts-incoming-bundle-internal.h"
 #include "yts-incoming-file-internal.h"
+#include "yts-incoming-file-policy-internal.h"
 #include "yts-invocation-message.h"
+#include "yts-local-transport.h"
+#include "yts-loopback-transport.h"
 #include "yts-marshal.h"
 #include "yts-metadata-internal.h"
 #include "yts-outgoing-file-internal.h"
+#include "yts-probes.h"
+#include "yts-proxy-service-internal.h"
 #include "yts-response-message.h"
 #include "yts-roster-impl.h"
 #include "yts-service.h"
 #include "yts-service-adapter.h"
+#include "yts-telepathy-transport.h"
+#include "yts-transfer-scheduler-internal.h"
 #include "yts-xml.h"
 
 #include "profile/yts-profile.h"
 #include "profile/yts-profile-adapter.h"
 #include "profile/yts-profile-impl.h"
 
-#define RECONNECT_DELAY 20 /* in seconds */
+/* Reconnect backoff bounds, in milliseconds */
+#define RECONNECT_DELAY_MIN 250
+#define RECONNECT_DELAY_MAX 30000
+
+/* Seconds a connection has to stay up before backoff starts over */
+#define RECONNECT_STABLE_S 10
+
+/* Messages kept while the connection is down */
+#define REPLAY_QUEUE_LENGTH 1024
 
 static void yts_client_make_connection (YtsClient *client);
+static void attach_transport (YtsClient *self, YtsTransport *transport);
+static void apply_send_queue_limits (YtsClient *self);
+static void drop_local_transport (YtsClient *self, bool replay);
 
 G_DEFINE_TYPE (YtsClient, yts_client, G_TYPE_OBJECT)
 
@@ -80,6 +104,21 @@ G_DEFINE_TYPE (YtsClient, yts_client, G_TYPE_OBJECT)
  * the mesh.
  */
 
+/* Values of the messages' "type" attribute, for statistics. The last one
+ * counts anything else. */
+static char const *const _message_types[] = {
+  "text",
+  "list",
+  "dictionary",
+  "invocation",
+  "event",
+  "response",
+  "error",
+  "other"
+};
+
+#define N_MESSAGE_TYPES G_N_ELEMENTS (_message_types)
+
 typedef struct {
   YtsRoster       *roster;    /* the roster of this client */
   YtsRoster       *unwanted;  /* roster of unwanted items */
@@ -95,10 +134,11 @@ typedef struct {
   TpAccount            *tp_account;
   TpConnection         *tp_conn;
   TpProxy              *tp_debug_proxy;
-  TpYtsStatus          *tp_status;
-  TpYtsClient          *tp_client;
   TpBaseClient         *tp_file_handler;
 
+  /* Discovery and messaging, Telepathy unless passed at construction */
+  YtsTransport *transport;
+
   /* Implemented services */
   GHashTable  *services;
 
@@ -108,8 +148,49 @@ typedef struct {
   /* Registered proxies */
   GHashTable *proxies;
 
+  /* Outgoing file transfers */
+  YtsTransferScheduler *transfer_scheduler;
+
+  /* Incoming file transfers, list of YtsIncomingFilePolicy */
+  GList *incoming_file_policies;
+
+  /* Messages between proxies and services of this client,
+   * queue of LocalMessage */
+  GQueue  *local_messages;
+  unsigned local_messages_id;
+
+  /* Messages to and from clients on the same host */
+  YtsLocalTransport *local_transport;
+
+  /* Statistics, see yts_client_get_statistics() */
+  uint64_t  messages_sent[N_MESSAGE_TYPES];
+  uint64_t  messages_received[N_MESSAGE_TYPES];
+  uint64_t  bytes_received;
+  uint64_t  send_failures;
+  uint64_t  dispatch_failures;
+  uint64_t  invocation_timeouts;
+  unsigned  statistics_interval;
+  unsigned  statistics_id;
+
+  /* Messages held back by the transport until their recipient is
+   * reachable, see the send-queue-* properties */
+  YtsSendQueueLimits send_queue_limits;
+
+  /* Latency of invocations of our services, by capability and aspect */
+  YtsLatencyTable *queueing_latency;
+  YtsLatencyTable *processing_latency;
+  unsigned         latency_dump_id;
+
   /* callback ids */
   guint reconnect_id;
+  unsigned reconnect_attempts;
+  unsigned stable_id;
+
+  /* Messages sent while reconnecting, queue of ReplayMessage, and the
+   * transport's error atoms of replayed ones mapped to the original ones */
+  GQueue      *replay_messages;
+  GHashTable  *replay_atoms;
+  bool         replay_resolving;
 
   bool authenticated;   /* are we authenticated ? */
   bool ready;           /* is TP setup done ? */
@@ -118,6 +199,7 @@ typedef struct {
   bool dialing;         /* are we currently acquiring connection ? */
   bool members_pending; /* requery members when TP set up completed ? */
   bool prepared;        /* are connection features set up ? */
+  bool offline;         /* lost the connection, reconnect pending ? */
   bool disposed;        /* dispose guard */
 
 } YtsClientPrivate;
@@ -133,6 +215,9 @@ enum
   DICTIONARY_MESSAGE,
   ERROR,
   INCOMING_FILE,
+  INCOMING_BUNDLE,
+  STATS_UPDATED,
+  SEND_QUEUE_CONGESTED,
   N_SIGNALS,
 };
 
@@ -145,11 +230,34 @@ enum
   PROP_PROTOCOL,
 
   PROP_TP_ACCOUNT,
-  PROP_TP_STATUS
+  PROP_TP_STATUS,
+
+  PROP_TRANSPORT,
+
+  PROP_STATISTICS_INTERVAL,
+
+  PROP_SEND_QUEUE_HIGH_WATER,
+  PROP_SEND_QUEUE_LOW_WATER,
+  PROP_SEND_QUEUE_EXPIRY,
+  PROP_SEND_QUEUE_POLICY
 };
 
 static guint signals[N_SIGNALS] = {0};
 
+static unsigned
+message_type_index (char const *type)
+{
+  unsigned i;
+
+  for (i = 0; i < N_MESSAGE_TYPES - 1; i++) {
+    if (0 == g_strcmp0 (type, _message_types[i])) {
+      return i;
+    }
+  }
+
+  return N_MESSAGE_TYPES - 1;
+}
+
 /*
  * ServiceData
  */
@@ -197,6 +305,9 @@ typedef struct {
   YtsContact   *contact;           /* free pointer, no ref */
   char          *proxy_id;
   char          *invocation_id;
+  char          *capability;
+  char          *aspect;
+  int64_t        dispatch_time;    /* monotonic, when handed to the adapter */
   unsigned int   timeout_s;
   unsigned int   timeout_id;
 } InvocationData;
@@ -213,6 +324,8 @@ invocation_data_destroy (InvocationData *self)
 
   g_free (self->proxy_id);
   g_free (self->invocation_id);
+  g_free (self->capability);
+  g_free (self->aspect);
   g_free (self);
 }
 
@@ -221,29 +334,48 @@ client_conclude_invocation (YtsClient  *self,
                             char const  *invocation_id)
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
-  bool found;
+  InvocationData *invocation_data;
+  int64_t         processing_time;
 
-  found = g_hash_table_remove (priv->invocations, invocation_id);
-  if (!found) {
+  invocation_data = g_hash_table_lookup (priv->invocations, invocation_id);
+  if (NULL == invocation_data) {
     g_warning ("%s : Pending invocation for ID %s not found",
                G_STRLOC,
                invocation_id);
     return false;
   }
 
+  processing_time = g_get_monotonic_time () - invocation_data->dispatch_time;
+  YTS_PROBE4 (invocation__conclude,
+              invocation_id,
+              invocation_data->capability,
+              invocation_data->aspect,
+              processing_time);
+  yts_latency_table_record (priv->processing_latency,
+                            invocation_data->capability,
+                            invocation_data->aspect,
+                            processing_time);
+
+  g_hash_table_remove (priv->invocations, invocation_id);
+
   return true;
 }
 
 static bool
 _invocation_timeout (InvocationData *self)
 {
+  YtsClientPrivate *priv = GET_PRIVATE (self->client);
+
+  priv->invocation_timeouts++;
+
   g_critical ("%s : Invocation %s timed out after %i seconds",
               G_STRLOC,
               self->invocation_id,
               self->timeout_s);
 
-  /* This destroys self */
-  client_conclude_invocation (self->client, self->invocation_id);
+  /* This destroys self. Not concluded, so it does not skew the
+   * processing latency. */
+  g_hash_table_remove (priv->invocations, self->invocation_id);
 
   // TODO emit timeout / error
 
@@ -256,6 +388,8 @@ invocation_data_create (YtsClient    *client,
                         YtsContact   *contact,
                         char const    *proxy_id,
                         char const    *invocation_id,
+                        char const    *capability,
+                        char const    *aspect,
                         unsigned int   timeout_s)
 {
   InvocationData *self;
@@ -265,6 +399,9 @@ invocation_data_create (YtsClient    *client,
   self->contact = contact;
   self->proxy_id = g_strdup (proxy_id);
   self->invocation_id = g_strdup (invocation_id);
+  self->capability = g_strdup (capability);
+  self->aspect = g_strdup (aspect);
+  self->dispatch_time = g_get_monotonic_time ();
   self->timeout_s = timeout_s;
   self->timeout_id = g_timeout_add_seconds (timeout_s,
                                             (GSourceFunc) _invocation_timeout,
@@ -273,11 +410,18 @@ invocation_data_create (YtsClient    *client,
   return self;
 }
 
+/*
+ * Track an invocation about to be handed to a service adapter. The time
+ * since @received_time, when the message arrived, counts as queueing delay.
+ */
 static bool
 client_establish_invocation (YtsClient   *self,
                              char const   *invocation_id,
                              YtsContact  *contact,
-                             char const   *proxy_id)
+                             char const   *proxy_id,
+                             char const   *capability,
+                             char const   *aspect,
+                             int64_t       received_time)
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
   InvocationData *invocation_data;
@@ -296,7 +440,16 @@ client_establish_invocation (YtsClient   *self,
                                             contact,
                                             proxy_id,
                                             invocation_id,
+                                            capability,
+                                            aspect,
                                             INVOCATION_RESPONSE_TIMEOUT_S);
+  YTS_PROBE4 (invocation__establish,
+              invocation_id, capability, aspect,
+              invocation_data->dispatch_time - received_time);
+  yts_latency_table_record (priv->queueing_latency,
+                            capability,
+                            aspect,
+                            invocation_data->dispatch_time - received_time);
   g_hash_table_insert (priv->invocations,
                        g_strdup (invocation_id),
                        invocation_data);
@@ -467,42 +620,363 @@ proxy_list_destroy (ProxyList *self)
  * YtsClient
  */
 
+/*
+ * LocalMessage
+ *
+ * Proxies for services published by this very client talk to them
+ * directly, without serialising and sending messages around through
+ * Telepathy. Delivery is still deferred to the main loop, so callers see
+ * the same ordering and reentrancy as with remote services.
+ */
+
+typedef struct {
+  YtsContact  *contact;
+  YtsMetadata *message;
+  int64_t      queued_time;
+} LocalMessage;
+
 static void
-_tp_yts_status_advertise_status_cb (GObject       *source_object,
-                                    GAsyncResult  *result,
-                                    gpointer       user_data)
+local_message_free (LocalMessage *self)
 {
-  TpYtsStatus *status = TP_YTS_STATUS (source_object);
-  GError      *error = NULL;
+  g_object_unref (self->contact);
+  g_object_unref (self->message);
+  g_slice_free (LocalMessage, self);
+}
 
-  if (!tp_yts_status_advertise_status_finish (status, result, &error)) {
-      g_critical ("Failed to advertise status: %s", error->message);
-  } else {
-    g_message ("Advertising of status succeeded");
+static bool
+is_local_service (YtsClient  *self,
+                  YtsContact *contact,
+                  char const *service_id)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  char const *contact_id;
+
+  if (0 != g_strcmp0 (service_id, priv->service_id) ||
+      NULL == priv->transport) {
+    return false;
+  }
+
+  contact_id = yts_client_get_contact_id (self);
+
+  return contact_id &&
+         0 == g_strcmp0 (yts_contact_get_id (contact), contact_id);
+}
+
+static void
+dispatch_local_message (YtsClient   *self,
+                        YtsContact  *contact,
+                        YtsMetadata *message,
+                        int64_t      queued_time)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  char const *capability;
+  char const *invocation_id;
+  char const *aspect;
+  GVariant   *payload;
+
+  capability = yts_metadata_get_attribute (message, "capability");
+  invocation_id = yts_metadata_get_attribute (message, "invocation");
+  aspect = yts_metadata_get_attribute (message, "aspect");
+  payload = yts_metadata_get_payload (message);
+
+  priv->messages_received[message_type_index (
+                      yts_metadata_get_attribute (message, "type"))]++;
+
+  if (YTS_IS_INVOCATION_MESSAGE (message)) {
+
+    YtsServiceAdapter *adapter = g_hash_table_lookup (priv->services,
+                                                      capability);
+    if (adapter &&
+        client_establish_invocation (self,
+                                     invocation_id,
+                                     contact,
+                                     priv->service_id,
+                                     capability,
+                                     aspect,
+                                     queued_time)) {
+      bool keep_sae = yts_service_adapter_invoke (adapter,
+                                                  invocation_id,
+                                                  aspect,
+                                                  payload);
+      if (!keep_sae) {
+        client_conclude_invocation (self, invocation_id);
+      }
+    } else {
+      g_warning ("%s : No local service for capability %s",
+                 G_STRLOC,
+                 capability);
+    }
+
+  } else if (YTS_IS_EVENT_MESSAGE (message)) {
+
+    yts_contact_dispatch_event (contact, capability, aspect, payload);
+
+  } else if (YTS_IS_RESPONSE_MESSAGE (message)) {
+
+    yts_contact_dispatch_response (contact, capability, invocation_id, payload);
+  }
+}
+
+static bool
+_local_messages_idle (YtsClient *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  GQueue        *messages;
+  LocalMessage  *local;
+
+  priv->local_messages_id = 0;
+
+  /* Messages queued from within the handlers go out on the next run. */
+  messages = priv->local_messages;
+  priv->local_messages = g_queue_new ();
+
+  while (NULL != (local = g_queue_pop_head (messages))) {
+    dispatch_local_message (self,
+                            local->contact,
+                            local->message,
+                            local->queued_time);
+    local_message_free (local);
   }
 
-  g_clear_error (&error);
+  g_queue_free (messages);
+
+  /* Returning false removes the source. */
+  return false;
 }
 
 static bool
-_client_status_foreach_capability_advertise_status (YtsClientStatus const *client_status,
-                                                    char const            *capability,
-                                                    char const            *status_xml,
-                                                    YtsClient             *self)
+send_local_message (YtsClient   *self,
+                    YtsContact  *contact,
+                    YtsMetadata *message)
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
+  LocalMessage *local;
 
-  tp_yts_status_advertise_status_async (priv->tp_status,
-                                        capability,
-                                        priv->service_id,
-                                        status_xml,
-                                        NULL,
-                                        _tp_yts_status_advertise_status_cb,
-                                        self);
+  if (!YTS_IS_INVOCATION_MESSAGE (message) &&
+      !YTS_IS_EVENT_MESSAGE (message) &&
+      !YTS_IS_RESPONSE_MESSAGE (message)) {
+    /* Low-level messages go the long way round. */
+    return false;
+  }
+
+  local = g_slice_new (LocalMessage);
+  local->contact = g_object_ref (contact);
+  local->message = g_object_ref (message);
+  local->queued_time = g_get_monotonic_time ();
+  g_queue_push_tail (priv->local_messages, local);
+
+  if (0 == priv->local_messages_id) {
+    priv->local_messages_id = g_idle_add ((GSourceFunc) _local_messages_idle,
+                                          self);
+  }
+
+  return true;
+}
+
+static bool
+_client_status_foreach_capability_collect_status (YtsClientStatus const *client_status,
+                                                  char const            *capability,
+                                                  char const            *status_xml,
+                                                  GHashTable            *statuses)
+{
+  g_hash_table_insert (statuses, (void *) capability, (void *) status_xml);
 
   return true;
 }
 
+/*
+ * ReplayMessage
+ *
+ * While the connection is down and a reconnect pending, messages for
+ * remote services are kept and sent once the transport is ready again.
+ * Contacts are looked up again by id then, the roster has been cleared
+ * in the meantime. Callers see completion through #YtsClient::error with
+ * the atom returned at send time, as for any pending message.
+ */
+
+typedef struct {
+  char        *contact_id;
+  char        *service_id;
+  YtsMetadata *message;
+  YtsError     error;
+  int64_t      queued_time;
+} ReplayMessage;
+
+static void
+replay_message_free (ReplayMessage *self)
+{
+  g_free (self->contact_id);
+  g_free (self->service_id);
+  g_object_unref (self->message);
+  g_slice_free (ReplayMessage, self);
+}
+
+static void
+replay_message_fail (YtsClient      *self,
+                     ReplayMessage  *message,
+                     unsigned        code)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+
+  priv->send_failures++;
+  yts_client_emit_error (self,
+                         yts_error_make (yts_error_get_atom (message->error),
+                                         code));
+  replay_message_free (message);
+}
+
+static YtsError
+replay_message_push (YtsClient    *self,
+                     YtsContact   *contact,
+                     char const   *service_id,
+                     YtsMetadata  *message,
+                     YtsError      error)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  ReplayMessage *m;
+
+  m = g_slice_new (ReplayMessage);
+  m->contact_id = g_strdup (yts_contact_get_id (contact));
+  m->service_id = g_strdup (service_id);
+  m->message = g_object_ref (message);
+  m->error = error;
+  m->queued_time = g_get_monotonic_time ();
+
+  g_queue_push_tail (priv->replay_messages, m);
+
+  return m->error;
+}
+
+static YtsError
+replay_queue_push (YtsClient    *self,
+                   YtsContact   *contact,
+                   char const   *service_id,
+                   YtsMetadata  *message)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+
+  if (g_queue_get_length (priv->replay_messages) >= REPLAY_QUEUE_LENGTH) {
+    priv->send_failures++;
+    return yts_error_new (YTS_ERROR_QUEUE_FULL);
+  }
+
+  return replay_message_push (self, contact, service_id, message,
+                              yts_error_new (YTS_ERROR_PENDING));
+}
+
+static void
+replay_message_send (YtsClient      *self,
+                     ReplayMessage  *message,
+                     YtsContact     *contact)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  YtsError  e;
+  unsigned  code;
+
+  e = yts_transport_send_message (priv->transport,
+                                  contact,
+                                  message->service_id,
+                                  message->message);
+  code = yts_error_get_code (e);
+
+  if (YTS_ERROR_PENDING == code) {
+    /* Completion is reported with the transport's atom, see
+     * _transport_error(). */
+    g_hash_table_insert (priv->replay_atoms,
+                         GUINT_TO_POINTER (yts_error_get_atom (e)),
+                         GUINT_TO_POINTER (yts_error_get_atom (message->error)));
+    replay_message_free (message);
+  } else if (YTS_ERROR_SUCCESS == code) {
+    yts_client_emit_error (self,
+                           yts_error_make (yts_error_get_atom (message->error),
+                                           code));
+    replay_message_free (message);
+  } else {
+    replay_message_fail (self, message, code);
+  }
+}
+
+static void replay_messages (YtsClient *self);
+
+static void
+_replay_resolve_contact (YtsTransport *transport,
+                         GAsyncResult *result,
+                         YtsClient    *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  YtsContact    *contact;
+  ReplayMessage *m;
+  GError        *error = NULL;
+
+  priv->replay_resolving = false;
+
+  contact = yts_transport_resolve_contact_finish (transport, result, &error);
+  m = g_queue_peek_head (priv->replay_messages);
+
+  if (contact) {
+    if (m && 0 == g_strcmp0 (m->contact_id, yts_contact_get_id (contact))) {
+      g_queue_pop_head (priv->replay_messages);
+      replay_message_send (self, m, contact);
+    }
+    g_object_unref (contact);
+  } else {
+    g_message ("Failed to resolve contact for replay: %s", error->message);
+    g_clear_error (&error);
+    /* When the connection is gone again, it's kept for the next one. */
+    if (m && !priv->offline) {
+      g_queue_pop_head (priv->replay_messages);
+      replay_message_fail (self, m, YTS_ERROR_NO_ROUTE);
+    }
+  }
+
+  if (!priv->offline && !priv->disposed) {
+    replay_messages (self);
+  }
+
+  g_object_unref (self);
+}
+
+/*
+ * Send messages in the order they have been queued. One whose contact is not
+ * in the roster yet holds the rest back until it is resolved.
+ */
+static void
+replay_messages (YtsClient *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  int64_t        now = g_get_monotonic_time ();
+  int64_t        expiry;
+  ReplayMessage *m;
+  YtsContact    *contact;
+
+  expiry = (int64_t) priv->send_queue_limits.expiry_s * G_USEC_PER_SEC;
+
+  while (!priv->replay_resolving &&
+         (m = g_queue_peek_head (priv->replay_messages))) {
+
+    if (expiry && now - m->queued_time > expiry) {
+      g_queue_pop_head (priv->replay_messages);
+      replay_message_fail (self, m, YTS_ERROR_EXPIRED);
+      continue;
+    }
+
+    contact = yts_roster_find_contact_by_id (priv->roster, m->contact_id);
+    if (NULL == contact) {
+      priv->replay_resolving = true;
+      yts_transport_resolve_contact_async (
+                            priv->transport,
+                            m->contact_id,
+                            NULL,
+                            (GAsyncReadyCallback) _replay_resolve_contact,
+                            g_object_ref (self));
+      return;
+    }
+
+    g_queue_pop_head (priv->replay_messages);
+    replay_message_send (self, m, contact);
+  }
+}
+
 static void
 yts_client_cleanup_connection_resources (YtsClient *self)
 {
@@ -515,6 +989,16 @@ yts_client_cleanup_connection_resources (YtsClient *self)
   priv->ready    = FALSE;
   priv->prepared = FALSE;
 
+  /* Did not last, keep backing off. */
+  if (priv->stable_id)
+    {
+      g_source_remove (priv->stable_id);
+      priv->stable_id = 0;
+    }
+
+  /* Before the roster goes, its contacts are needed for replaying. */
+  drop_local_transport (self, true);
+
   /*
    * Empty roster
    */
@@ -541,19 +1025,153 @@ yts_client_reconnect_cb (YtsClient *self)
   return FALSE;
 }
 
+/*
+ * Exponential backoff, starting at RECONNECT_DELAY_MIN. Half of each delay
+ * is randomised, so clients that lost the connection together don't all
+ * come back at the same time.
+ */
 static void
-yts_client_reconnect_after (YtsClient *self, guint after_seconds)
+yts_client_schedule_reconnect (YtsClient *self)
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
+  unsigned delay;
 
   g_return_if_fail (YTS_IS_CLIENT (self));
 
+  delay = RECONNECT_DELAY_MIN << MIN (priv->reconnect_attempts, 8);
+  delay = MIN (delay, RECONNECT_DELAY_MAX);
+  delay = delay / 2 + g_random_int_range (0, delay / 2 + 1);
+
+  priv->reconnect_attempts++;
   priv->reconnect = TRUE;
+  priv->offline = true;
+
+  YTS_NOTE (CLIENT, "Reconnect attempt %u in %u ms",
+            priv->reconnect_attempts, delay);
+
+  if (priv->reconnect_id) {
+    g_source_remove (priv->reconnect_id);
+  }
+
+  priv->reconnect_id = g_timeout_add (delay,
+                                      (GSourceFunc) yts_client_reconnect_cb,
+                                      self);
+}
+
+static gboolean
+_connection_stable (YtsClient *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+
+  priv->stable_id = 0;
+  priv->reconnect_attempts = 0;
+
+  return false;
+}
+
+/*
+ * A connection that drops right after coming up again must not reset the
+ * backoff, so that only happens once it has lasted for a while.
+ */
+static void
+yts_client_schedule_backoff_reset (YtsClient *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+
+  if (0 == priv->reconnect_attempts ||
+      priv->stable_id) {
+    return;
+  }
+
+  priv->stable_id = g_timeout_add_seconds (RECONNECT_STABLE_S,
+                                           (GSourceFunc) _connection_stable,
+                                           self);
+}
+
+/*
+ * Messages the transport still holds for contacts of the lost connection
+ * are sent after reconnecting like those sent meanwhile, or fail when
+ * there is not going to be a reconnect.
+ */
+static void
+_transport_take_queued (YtsContact  *contact,
+                        char const  *service_id,
+                        YtsMetadata *message,
+                        YtsError     error,
+                        YtsClient   *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+
+  if (!priv->reconnect ||
+      g_queue_get_length (priv->replay_messages) >= REPLAY_QUEUE_LENGTH) {
+    priv->send_failures++;
+    yts_client_emit_error (self,
+                           yts_error_make (yts_error_get_atom (error),
+                                           YTS_ERROR_NO_MSG_CHANNEL));
+    return;
+  }
+
+  replay_message_push (self, contact, service_id, message, error);
+}
+
+static void
+_local_transport_take_queued (char const  *contact_id,
+                              char const  *service_id,
+                              char const  *xml,
+                              YtsClient   *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  YtsContact  *contact = NULL;
+  YtsMetadata *message;
+
+  if (priv->roster) {
+    contact = yts_roster_find_contact_by_id (priv->roster, contact_id);
+  }
+
+  message = yts_metadata_new_from_xml (xml);
+
+  if (NULL == message ||
+      NULL == contact) {
+    priv->send_failures++;
+    yts_client_emit_error (self, yts_error_new (YTS_ERROR_NO_MSG_CHANNEL));
+  } else {
+    /* Reported as sent already, completion goes under a new atom. */
+    _transport_take_queued (contact, service_id, message,
+                            yts_error_new (YTS_ERROR_PENDING), self);
+  }
+
+  if (message) {
+    g_object_unref (message);
+  }
+}
+
+/*
+ * Shut down the local transport without hearing from it any more. Messages
+ * still waiting for peers on this host are replayed through Telepathy
+ * after reconnecting if @replay is set, and dropped otherwise.
+ */
+static void
+drop_local_transport (YtsClient *self,
+                      bool       replay)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+
+  if (NULL == priv->local_transport) {
+    return;
+  }
+
+  g_signal_handlers_disconnect_matched (priv->local_transport,
+                                        G_SIGNAL_MATCH_DATA,
+                                        0, 0, NULL, NULL, self);
+  if (replay) {
+    yts_local_transport_take_queued (
+                    priv->local_transport,
+                    (YtsLocalTransportQueuedFunc) _local_transport_take_queued,
+                    self);
+  }
 
-  priv->reconnect_id =
-    g_timeout_add_seconds (after_seconds,
-                           (GSourceFunc) yts_client_reconnect_cb,
-                           self);
+  g_object_unref (priv->local_transport);
+  priv->local_transport = NULL;
 }
 
 /*
@@ -801,7 +1419,8 @@ extract_remote_service_id (YtsClient   *self,
                                  TP_HASH_TYPE_METADATA);
 
     if (metadata) {
-      char **values = g_hash_table_lookup (metadata, (gpointer) "FromService");
+      char **values = g_hash_table_lookup (metadata,
+                                           YTS_FILE_TRANSFER_METADATA_FROM_SERVICE);
       if (values && values[0]) {
         remote_service_id = values[0];
       }
@@ -810,6 +1429,59 @@ extract_remote_service_id (YtsClient   *self,
   return remote_service_id;
 }
 
+static YtsIncomingFilePolicy *
+find_incoming_file_policy (YtsClient              *self,
+                           char const             *remote_service_id,
+                           TpFileTransferChannel  *channel)
+{
+  YtsClientPrivate  *priv = GET_PRIVATE (self);
+  GList             *iter;
+
+  for (iter = priv->incoming_file_policies; iter; iter = iter->next) {
+    if (yts_incoming_file_policy_matches (
+                            iter->data,
+                            remote_service_id,
+                            tp_file_transfer_channel_get_mime_type (channel))) {
+      return iter->data;
+    }
+  }
+
+  return NULL;
+}
+
+/*
+ * Returns whether the application should be told about @incoming.
+ */
+static bool
+apply_incoming_file_policy (YtsClient              *self,
+                            char const             *remote_service_id,
+                            TpFileTransferChannel  *channel,
+                            YtsIncomingFile        *incoming)
+{
+  YtsIncomingFilePolicy *policy;
+  GError                *error = NULL;
+
+  policy = find_incoming_file_policy (self, remote_service_id, channel);
+  if (NULL == policy) {
+    return true;
+  }
+
+  if (!yts_incoming_file_policy_accept (
+                              policy,
+                              incoming,
+                              tp_file_transfer_channel_get_filename (channel),
+                              tp_file_transfer_channel_get_size (channel),
+                              &error)) {
+    DEBUG ("Rejecting incoming file from %s (%s)",
+           remote_service_id, error->message);
+    g_clear_error (&error);
+    yts_incoming_file_reject (incoming, NULL);
+    return false;
+  }
+
+  return true;
+}
+
 static void
 _file_handler_handle_channels (TpSimpleHandler          *handler,
                                TpAccount                *account,
@@ -845,8 +1517,19 @@ _file_handler_handle_channels (TpSimpleHandler          *handler,
 
       if (g_initable_init (G_INITABLE (incoming), NULL, &error)) {
 
-        g_signal_emit (self, signals[INCOMING_FILE], 0,
-                       service, props, incoming);
+        YtsIncomingBundle *bundle = yts_incoming_bundle_new (incoming);
+
+        if (bundle) {
+          g_signal_emit (self, signals[INCOMING_BUNDLE], 0,
+                         service, props, bundle);
+          g_object_unref (bundle);
+        } else if (apply_incoming_file_policy (self,
+                                               remote_service_id,
+                                               channel,
+                                               incoming)) {
+          g_signal_emit (self, signals[INCOMING_FILE], 0,
+                         service, props, incoming);
+        }
 
       } else {
 
@@ -873,7 +1556,7 @@ _client_status_foreach_interest_add (YtsClientStatus const  *client_status,
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
 
-  tp_yts_client_add_interest (priv->tp_client, capability);
+  yts_transport_add_interest (priv->transport, capability);
 
   return true;
 }
@@ -886,7 +1569,7 @@ _client_status_foreach_capability_add (YtsClientStatus const  *client_status,
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
 
-  tp_yts_client_add_capability (priv->tp_client, capability);
+  yts_transport_add_capability (priv->transport, capability);
 
   return true;
 }
@@ -902,7 +1585,8 @@ setup_tp_client (YtsClient  *self,
   g_return_if_fail (TP_IS_ACCOUNT (account));
 
   priv->tp_account = account;
-  priv->tp_client = tp_yts_client_new (priv->service_id, account);
+  attach_transport (self, YTS_TRANSPORT (
+                      yts_telepathy_transport_new (account, priv->service_id)));
 
   if (YTS_DEBUG_TELEPATHY & ytstenut_get_debug_flags ()) {
     yts_client_setup_debug (self);
@@ -1027,39 +1711,84 @@ _roster_send_message (YtsRoster    *roster,
 }
 
 static YtsOutgoingFile *
-_roster_send_file (YtsRoster   *roster,
-                   YtsContact  *contact,
-                   YtsService  *service,
-                   GFile       *file,
-                   char const  *description,
-                   GError     **error_out,
-                   YtsClient   *self)
+_roster_send_file (YtsRoster          *roster,
+                   YtsContact         *contact,
+                   YtsService         *service,
+                   GFile              *file,
+                   char const         *description,
+                   YtsTransferPriority priority,
+                   GError            **error_out,
+                   YtsClient          *self)
 {
   YtsClientPrivate  *priv = GET_PRIVATE (self);
   YtsOutgoingFile   *outgoing;
-  char const        *recipient_contact_id;
-  char const        *recipient_service_id;
-  GError            *error = NULL;
 
   g_return_val_if_fail (YTS_IS_CLIENT (self), NULL);
 
-  recipient_contact_id = yts_contact_get_id (contact);
-  recipient_service_id = yts_service_get_id (service);
-  outgoing = yts_outgoing_file_new (priv->tp_account,
-                                    file,
-                                    priv->service_id,
-                                    recipient_contact_id,
-                                    recipient_service_id,
-                                    description);
+  if (NULL == priv->transport) {
+    g_set_error_literal (error_out, G_IO_ERROR, G_IO_ERROR_NOT_CONNECTED,
+                         "Client is not connected");
+    return NULL;
+  }
 
-  g_initable_init (G_INITABLE (outgoing), NULL, &error);
-  if (error) {
-    g_object_unref (outgoing);
-    g_propagate_error (error_out, error);
-    g_clear_error (&error);
+  outgoing = yts_transport_send_file (priv->transport,
+                                      contact,
+                                      yts_service_get_id (service),
+                                      file,
+                                      description,
+                                      error_out);
+  if (NULL == outgoing) {
+    return NULL;
+  }
+
+  yts_transfer_scheduler_enqueue (priv->transfer_scheduler,
+                                  outgoing,
+                                  priority);
+
+  return outgoing;
+}
+
+static YtsOutgoingFile *
+_roster_send_stream (YtsRoster          *roster,
+                     YtsContact         *contact,
+                     YtsService         *service,
+                     GInputStream       *stream,
+                     uint64_t            size,
+                     char const         *name,
+                     char const         *content_type,
+                     char const         *description,
+                     YtsTransferPriority priority,
+                     GError            **error_out,
+                     YtsClient          *self)
+{
+  YtsClientPrivate  *priv = GET_PRIVATE (self);
+  YtsOutgoingFile   *outgoing;
+
+  g_return_val_if_fail (YTS_IS_CLIENT (self), NULL);
+
+  if (NULL == priv->transport) {
+    g_set_error_literal (error_out, G_IO_ERROR, G_IO_ERROR_NOT_CONNECTED,
+                         "Client is not connected");
     return NULL;
   }
 
+  outgoing = yts_transport_send_stream (priv->transport,
+                                        contact,
+                                        yts_service_get_id (service),
+                                        stream,
+                                        size,
+                                        name,
+                                        content_type,
+                                        description,
+                                        error_out);
+  if (NULL == outgoing) {
+    return NULL;
+  }
+
+  yts_transfer_scheduler_enqueue (priv->transfer_scheduler,
+                                  outgoing,
+                                  priority);
+
   return outgoing;
 }
 
@@ -1151,11 +1880,22 @@ yts_client_constructed (GObject *object)
   if (G_OBJECT_CLASS (yts_client_parent_class)->constructed)
     G_OBJECT_CLASS (yts_client_parent_class)->constructed (object);
 
+  if (!YTS_SEND_QUEUE_LIMITS_VALID (&priv->send_queue_limits)) {
+    g_critical ("send-queue-low-water (%u) must not exceed "
+                "send-queue-high-water (%u), using the defaults",
+                priv->send_queue_limits.low_water,
+                priv->send_queue_limits.high_water);
+    priv->send_queue_limits.high_water = YTS_SEND_QUEUE_DEFAULT_HIGH_WATER;
+    priv->send_queue_limits.low_water = YTS_SEND_QUEUE_DEFAULT_LOW_WATER;
+  }
+
   priv->roster   = yts_roster_impl_new ();
   g_signal_connect (priv->roster, "send-message",
                     G_CALLBACK (_roster_send_message), object);
   g_signal_connect (priv->roster, "send-file",
                     G_CALLBACK (_roster_send_file), object);
+  g_signal_connect (priv->roster, "send-stream",
+                    G_CALLBACK (_roster_send_stream), object);
   g_signal_connect (priv->roster, "contact-removed",
                     G_CALLBACK (_roster_contact_removed), object);
 
@@ -1176,6 +1916,12 @@ yts_client_constructed (GObject *object)
 
   priv->client_status = yts_client_status_new (priv->service_id);
 
+  /* A transport passed at construction replaces the Telepathy account. */
+  if (priv->transport) {
+    attach_transport (YTS_CLIENT (object), priv->transport);
+    return;
+  }
+
   priv->tp_am = tp_yts_account_manager_dup ();
   if (!TP_IS_YTS_ACCOUNT_MANAGER (priv->tp_am)) {
     g_error ("Missing Account Manager");
@@ -1253,7 +1999,23 @@ yts_client_get_property (GObject    *object,
       g_value_set_object (value, priv->tp_account);
       break;
     case PROP_TP_STATUS:
-      g_value_set_object (value, priv->tp_status);
+      g_value_set_object (value,
+                          yts_client_get_tp_status (YTS_CLIENT (object)));
+      break;
+    case PROP_STATISTICS_INTERVAL:
+      g_value_set_uint (value, priv->statistics_interval);
+      break;
+    case PROP_SEND_QUEUE_HIGH_WATER:
+      g_value_set_uint (value, priv->send_queue_limits.high_water);
+      break;
+    case PROP_SEND_QUEUE_LOW_WATER:
+      g_value_set_uint (value, priv->send_queue_limits.low_water);
+      break;
+    case PROP_SEND_QUEUE_EXPIRY:
+      g_value_set_uint (value, priv->send_queue_limits.expiry_s);
+      break;
+    case PROP_SEND_QUEUE_POLICY:
+      g_value_set_enum (value, priv->send_queue_limits.policy);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -1284,6 +2046,30 @@ yts_client_set_property (GObject      *object,
     case PROP_PROTOCOL:
       priv->protocol = g_value_get_enum (value);
       break;
+    case PROP_TRANSPORT:
+      /* Construct-only */
+      priv->transport = g_value_dup_object (value);
+      break;
+    case PROP_STATISTICS_INTERVAL:
+      yts_client_set_statistics_interval (YTS_CLIENT (object),
+                                          g_value_get_uint (value));
+      break;
+    case PROP_SEND_QUEUE_HIGH_WATER:
+      priv->send_queue_limits.high_water = g_value_get_uint (value);
+      apply_send_queue_limits (YTS_CLIENT (object));
+      break;
+    case PROP_SEND_QUEUE_LOW_WATER:
+      priv->send_queue_limits.low_water = g_value_get_uint (value);
+      apply_send_queue_limits (YTS_CLIENT (object));
+      break;
+    case PROP_SEND_QUEUE_EXPIRY:
+      priv->send_queue_limits.expiry_s = g_value_get_uint (value);
+      apply_send_queue_limits (YTS_CLIENT (object));
+      break;
+    case PROP_SEND_QUEUE_POLICY:
+      priv->send_queue_limits.policy = g_value_get_enum (value);
+      apply_send_queue_limits (YTS_CLIENT (object));
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -1312,6 +2098,19 @@ yts_client_dispose (GObject *object)
       priv->unwanted = NULL;
     }
 
+  if (priv->transfer_scheduler)
+    {
+      g_object_unref (priv->transfer_scheduler);
+      priv->transfer_scheduler = NULL;
+    }
+
+  if (priv->incoming_file_policies)
+    {
+      g_list_foreach (priv->incoming_file_policies, (GFunc) g_object_unref, NULL);
+      g_list_free (priv->incoming_file_policies);
+      priv->incoming_file_policies = NULL;
+    }
+
   if (priv->tp_file_handler)
     {
       tp_base_client_unregister (priv->tp_file_handler);
@@ -1348,6 +2147,56 @@ yts_client_dispose (GObject *object)
       priv->services = NULL;
     }
 
+  if (priv->local_messages_id)
+    {
+      g_source_remove (priv->local_messages_id);
+      priv->local_messages_id = 0;
+    }
+
+  if (priv->statistics_id)
+    {
+      g_source_remove (priv->statistics_id);
+      priv->statistics_id = 0;
+    }
+
+  if (priv->latency_dump_id)
+    {
+      g_source_remove (priv->latency_dump_id);
+      priv->latency_dump_id = 0;
+    }
+
+  if (priv->reconnect_id)
+    {
+      g_source_remove (priv->reconnect_id);
+      priv->reconnect_id = 0;
+    }
+
+  if (priv->stable_id)
+    {
+      g_source_remove (priv->stable_id);
+      priv->stable_id = 0;
+    }
+
+  if (priv->local_messages)
+    {
+      g_queue_foreach (priv->local_messages, (GFunc) local_message_free, NULL);
+      g_queue_free (priv->local_messages);
+      priv->local_messages = NULL;
+    }
+
+  /* Dispose does not replay. */
+  drop_local_transport (YTS_CLIENT (object), false);
+
+  if (priv->transport)
+    {
+      g_signal_handlers_disconnect_matched (priv->transport,
+                                            G_SIGNAL_MATCH_DATA,
+                                            0, 0, NULL, NULL, object);
+      yts_transport_disconnect (priv->transport);
+      g_object_unref (priv->transport);
+      priv->transport = NULL;
+    }
+
   if (priv->invocations)
     {
       g_hash_table_destroy (priv->invocations);
@@ -1371,6 +2220,11 @@ yts_client_finalize (GObject *object)
   g_free (priv->account_id);
   g_free (priv->service_id);
   g_object_unref (priv->client_status);
+  yts_latency_table_free (priv->queueing_latency);
+  yts_latency_table_free (priv->processing_latency);
+  g_queue_foreach (priv->replay_messages, (GFunc) replay_message_free, NULL);
+  g_queue_free (priv->replay_messages);
+  g_hash_table_destroy (priv->replay_atoms);
 
   G_OBJECT_CLASS (yts_client_parent_class)->finalize (object);
 }
@@ -1477,6 +2331,96 @@ yts_client_class_init (YtsClientClass *klass)
                                G_PARAM_READABLE);
   g_object_class_install_property (object_class, PROP_TP_STATUS, pspec);
 
+  /*
+   * YtsClient:transport:
+   *
+   * Internal, transport to use instead of a Telepathy account.
+   * See yts_client_new_loopback().
+   */
+  pspec = g_param_spec_object ("transport", "", "",
+                               YTS_TYPE_TRANSPORT,
+                               G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY);
+  g_object_class_install_property (object_class, PROP_TRANSPORT, pspec);
+
+  /**
+   * YtsClient:statistics-interval:
+   *
+   * Seconds between emissions of #YtsClient::stats-updated, 0 to disable
+   * them.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint ("statistics-interval", "", "",
+                             0, G_MAXUINT, 0,
+                             G_PARAM_READWRITE);
+  g_object_class_install_property (object_class,
+                                   PROP_STATISTICS_INTERVAL,
+                                   pspec);
+
+  /**
+   * YtsClient:send-queue-high-water:
+   *
+   * Number of messages held back per contact while it is not reachable yet,
+   * before #YtsClient:send-queue-policy applies and
+   * #YtsClient::send-queue-congested is emitted. 0 for no limit.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint ("send-queue-high-water", "", "",
+                             0, G_MAXUINT, YTS_SEND_QUEUE_DEFAULT_HIGH_WATER,
+                             G_PARAM_READWRITE);
+  g_object_class_install_property (object_class,
+                                   PROP_SEND_QUEUE_HIGH_WATER,
+                                   pspec);
+
+  /**
+   * YtsClient:send-queue-low-water:
+   *
+   * Number of messages a congested send queue has to drain to before
+   * #YtsClient::send-queue-congested reports it clear again. Must not
+   * exceed #YtsClient:send-queue-high-water, otherwise the limits are not
+   * applied.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint ("send-queue-low-water", "", "",
+                             0, G_MAXUINT, YTS_SEND_QUEUE_DEFAULT_LOW_WATER,
+                             G_PARAM_READWRITE);
+  g_object_class_install_property (object_class,
+                                   PROP_SEND_QUEUE_LOW_WATER,
+                                   pspec);
+
+  /**
+   * YtsClient:send-queue-expiry:
+   *
+   * Seconds a message may wait for its recipient, 0 for no limit. Expired
+   * messages fail with %YTS_ERROR_EXPIRED.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint ("send-queue-expiry", "", "",
+                             0, G_MAXUINT, 0,
+                             G_PARAM_READWRITE);
+  g_object_class_install_property (object_class,
+                                   PROP_SEND_QUEUE_EXPIRY,
+                                   pspec);
+
+  /**
+   * YtsClient:send-queue-policy:
+   *
+   * What to do with a message when the send queue is full, see
+   * #YtsSendQueuePolicy.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_enum ("send-queue-policy", "", "",
+                             YTS_TYPE_SEND_QUEUE_POLICY,
+                             YTS_SEND_QUEUE_POLICY_REJECT_NEW,
+                             G_PARAM_READWRITE);
+  g_object_class_install_property (object_class,
+                                   PROP_SEND_QUEUE_POLICY,
+                                   pspec);
+
   /**
    * YtsClient::authenticated:
    * @self: object which emitted the signal.
@@ -1632,6 +2576,10 @@ yts_client_class_init (YtsClientClass *klass)
    * handler needs to call #yts_incoming_file_accept(), otherwise the transfer
    * will be cancelled.
    *
+   * Files handled by an #YtsIncomingFilePolicy have already been accepted
+   * when the signal is emitted, and those rejected by a policy are not
+   * signalled at all.
+   *
    * Since: 0.1
    */
   signals[INCOMING_FILE] =
@@ -1644,7 +2592,84 @@ yts_client_class_init (YtsClientClass *klass)
                   YTS_TYPE_SERVICE,
                   G_TYPE_HASH_TABLE,
                   YTS_TYPE_INCOMING_FILE);
+
+  /**
+   * YtsClient::incoming-bundle:
+   * @self: object which emitted the signal.
+   * @service: #YtsService sending the bundle.
+   * @properties: an a{sv} #GHashTable containing transfer properties, see
+   *              telepathy channel properties.
+   * @incoming: the #YtsIncomingBundle that is being sent.
+   *
+   * Like #YtsClient::incoming-file, but for a number of files sent through
+   * yts_service_send_bundle(). To accept them, the signal handler needs to
+   * call yts_incoming_bundle_accept(), otherwise the transfer will be
+   * cancelled.
+   *
+   * Since: 0.4
+   */
+  signals[INCOMING_BUNDLE] =
+    g_signal_new ("incoming-bundle",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL,
+                  yts_marshal_VOID__OBJECT_BOXED_OBJECT,
+                  G_TYPE_NONE, 3,
+                  YTS_TYPE_SERVICE,
+                  G_TYPE_HASH_TABLE,
+                  YTS_TYPE_INCOMING_BUNDLE);
+
+  /**
+   * YtsClient::stats-updated:
+   * @self: object which emitted the signal.
+   * @statistics: snapshot as returned by yts_client_get_statistics().
+   *
+   * Emitted every #YtsClient:statistics-interval seconds, for feeding
+   * monitoring.
+   *
+   * Since: 0.4
+   */
+  signals[STATS_UPDATED] =
+    g_signal_new ("stats-updated",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL,
+                  yts_marshal_VOID__VARIANT,
+                  G_TYPE_NONE, 1,
+                  G_TYPE_VARIANT);
+
+  /**
+   * YtsClient::send-queue-congested:
+   * @self: object which emitted the signal.
+   * @contact_id: JID of the contact messages are held back for.
+   * @congested: whether the queue reached #YtsClient:send-queue-high-water,
+   *             or drained to #YtsClient:send-queue-low-water again.
+   *
+   * Backpressure for producers, emitted when messages to a contact that
+   * is not reachable yet pile up, and when that clears.
+   *
+   * Since: 0.4
+   */
+  signals[SEND_QUEUE_CONGESTED] =
+    g_signal_new ("send-queue-congested",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL,
+                  yts_marshal_VOID__STRING_BOOLEAN,
+                  G_TYPE_NONE, 2,
+                  G_TYPE_STRING,
+                  G_TYPE_BOOLEAN);
+}
+
+#ifdef G_OS_UNIX
+static bool
+_latency_dump_signal (YtsClient *self)
+{
+  yts_client_dump_latency_statistics (self);
+
+  return true;
 }
+#endif
 
 static void
 yts_client_init (YtsClient *self)
@@ -1665,6 +2690,30 @@ yts_client_init (YtsClient *self)
                                          g_str_equal,
                                          g_free,
                                          (GDestroyNotify) proxy_list_destroy);
+
+  priv->local_messages = g_queue_new ();
+
+  priv->replay_messages = g_queue_new ();
+  priv->replay_atoms = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  priv->transfer_scheduler = yts_transfer_scheduler_new ();
+
+  priv->queueing_latency = yts_latency_table_new ();
+  priv->processing_latency = yts_latency_table_new ();
+
+  priv->send_queue_limits.high_water = YTS_SEND_QUEUE_DEFAULT_HIGH_WATER;
+  priv->send_queue_limits.low_water = YTS_SEND_QUEUE_DEFAULT_LOW_WATER;
+  priv->send_queue_limits.expiry_s = 0;
+  priv->send_queue_limits.policy = YTS_SEND_QUEUE_POLICY_REJECT_NEW;
+
+#ifdef G_OS_UNIX
+  if (g_getenv ("YTS_LATENCY_DUMP")) {
+    priv->latency_dump_id =
+      g_unix_signal_add (SIGUSR2,
+                         (GSourceFunc) _latency_dump_signal,
+                         self);
+  }
+#endif
 }
 
 YtsClient *
@@ -1703,22 +2752,49 @@ yts_client_new_p2p (char const *service_id)
                        NULL);
 }
 
-static GVariant *
-variant_new_from_escaped_literal (char const *string)
+/**
+ * yts_client_new_loopback:
+ * @mesh_id: name of the in-process mesh to join.
+ * @contact_id: contact ID this client appears under on the mesh.
+ * @service_id: Unique ID for this service; UIDs must follow the dbus
+ *              convention for unique names.
+ *
+ * Creates a new #YtsClient object that does not go through Telepathy.
+ * Clients within the same process that join the same @mesh_id discover
+ * each other once connected, and exchange messages and status through
+ * the main loop. This is meant for testing and benchmarking services
+ * without a connection manager. File transfer is not available.
+ *
+ * Returns: (transfer full): a #YtsClient object.
+ *
+ * Since: 0.4
+ */
+YtsClient *
+yts_client_new_loopback (char const *mesh_id,
+                         char const *contact_id,
+                         char const *service_id)
 {
-  GVariant  *v;
-  char      *unescaped;
+  YtsLoopbackTransport  *transport;
+  YtsClient             *self;
+
+  g_return_val_if_fail (mesh_id, NULL);
+  g_return_val_if_fail (contact_id, NULL);
+  g_return_val_if_fail (service_id, NULL);
 
-  unescaped = g_uri_unescape_string (string, NULL);
-  v = g_variant_new_parsed (unescaped);
-  g_free (unescaped);
+  transport = yts_loopback_transport_new (mesh_id, contact_id, service_id);
+  self = g_object_new (YTS_TYPE_CLIENT,
+                       "service-id",  service_id,
+                       "transport",   transport,
+                       NULL);
+  g_object_unref (transport);
 
-  return v;
+  return self;
 }
 
 static gboolean
 dispatch_to_service (YtsClient  *self,
                      char const *sender_contact_id,
+                     char const *sender_service_id,
                      char const *xml)
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
@@ -1727,20 +2803,34 @@ dispatch_to_service (YtsClient  *self,
   char const    *proxy_id;
   char const    *capability;
   char const    *type;
+  char const    *invocation_id;
   YtsContact   *contact;
   gboolean       dispatched = FALSE;
+  int64_t        received_time = g_get_monotonic_time ();
+  size_t         size = strlen (xml);
+
+  YTS_PROBE3 (message__receive,
+              sender_contact_id, sender_service_id, size);
+
+  priv->bytes_received += size;
 
   parser = rest_xml_parser_new ();
   node = rest_xml_parser_parse_from_data (parser, xml, strlen (xml));
   if (NULL == node) {
     // FIXME report error
+    priv->dispatch_failures++;
     g_critical ("%s : Failed to parse message '%s'", G_STRLOC, xml);
     return false;
   }
 
-  proxy_id = rest_xml_node_get_attr (node, "from-service");
+  /* Messages over the local transport don't pass through the connection
+   * manager, which is what adds the sender's service. */
+  proxy_id = sender_service_id ?
+               sender_service_id :
+               rest_xml_node_get_attr (node, "from-service");
   if (NULL == proxy_id) {
     // FIXME report error
+    priv->dispatch_failures++;
     g_critical ("%s : Malformed message, 'from-service' missing in '%s'",
                 G_STRLOC,
                 xml);
@@ -1750,6 +2840,7 @@ dispatch_to_service (YtsClient  *self,
   capability = rest_xml_node_get_attr (node, "capability");
   if (NULL == capability) {
     // FIXME report error
+    priv->dispatch_failures++;
     g_critical ("%s : Malformed message, 'capability' missing in '%s'",
                 G_STRLOC,
                 xml);
@@ -1759,15 +2850,21 @@ dispatch_to_service (YtsClient  *self,
   type = rest_xml_node_get_attr (node, "type");
   if (NULL == type) {
     // FIXME report error
+    priv->dispatch_failures++;
     g_critical ("%s : Malformed message, 'type' missing in '%s'",
                 G_STRLOC,
                 xml);
     return false;
   }
 
+  priv->messages_received[message_type_index (type)]++;
+
+  invocation_id = rest_xml_node_get_attr (node, "invocation");
+
   contact = yts_roster_find_contact_by_id (priv->roster, sender_contact_id);
   if (NULL == contact) {
     // FIXME report error
+    priv->dispatch_failures++;
     g_critical ("%s : Contact for '%s' not found",
                 G_STRLOC,
                 sender_contact_id);
@@ -1783,7 +2880,7 @@ dispatch_to_service (YtsClient  *self,
     {
       char const *escaped_payload = rest_xml_node_get_attr (node, "payload");
       GVariant *payload = escaped_payload ?
-                            variant_new_from_escaped_literal (escaped_payload) :
+                            yts_metadata_unescape_payload (escaped_payload) :
                             NULL;
       if (payload)
         {
@@ -1802,7 +2899,7 @@ dispatch_to_service (YtsClient  *self,
     {
       char const *escaped_payload = rest_xml_node_get_attr (node, "payload");
       GVariant *payload = escaped_payload ?
-                            variant_new_from_escaped_literal (escaped_payload) :
+                            yts_metadata_unescape_payload (escaped_payload) :
                             NULL;
       if (payload)
         {
@@ -1822,7 +2919,7 @@ dispatch_to_service (YtsClient  *self,
     {
       char const *escaped_payload = rest_xml_node_get_attr (node, "payload");
       GVariant *payload = escaped_payload ?
-                            variant_new_from_escaped_literal (escaped_payload) :
+                            yts_metadata_unescape_payload (escaped_payload) :
                             NULL;
       if (payload)
         {
@@ -1864,16 +2961,18 @@ dispatch_to_service (YtsClient  *self,
       if (adapter)
         {
           bool keep_sae;
-          char const *invocation_id = rest_xml_node_get_attr (node, "invocation");
           char const *aspect = rest_xml_node_get_attr (node, "aspect");
           char const *args = rest_xml_node_get_attr (node, "arguments");
-          GVariant *arguments = args ? variant_new_from_escaped_literal (args) : NULL;
+          GVariant *arguments = args ? yts_metadata_unescape_payload (args) : NULL;
 
           // FIXME check return value
           client_establish_invocation (self,
                                        invocation_id,
                                        contact,
-                                       proxy_id);
+                                       proxy_id,
+                                       capability,
+                                       aspect,
+                                       received_time);
           keep_sae = yts_service_adapter_invoke (adapter,
                                                   invocation_id,
                                                   aspect,
@@ -1893,7 +2992,7 @@ dispatch_to_service (YtsClient  *self,
     {
       char const *aspect = rest_xml_node_get_attr (node, "aspect");
       char const *args = rest_xml_node_get_attr (node, "arguments");
-      GVariant *arguments = args ? variant_new_from_escaped_literal (args) : NULL;
+      GVariant *arguments = args ? yts_metadata_unescape_payload (args) : NULL;
 
       dispatched = yts_contact_dispatch_event (contact,
                                                 capability,
@@ -1902,9 +3001,8 @@ dispatch_to_service (YtsClient  *self,
     }
   else if (0 == g_strcmp0 ("response", type))
     {
-      char const *invocation_id = rest_xml_node_get_attr (node, "invocation");
       char const *ret = rest_xml_node_get_attr (node, "response");
-      GVariant *response = ret ? variant_new_from_escaped_literal (ret) : NULL;
+      GVariant *response = ret ? yts_metadata_unescape_payload (ret) : NULL;
 
       dispatched = yts_contact_dispatch_response (contact,
                                                    capability,
@@ -1914,249 +3012,130 @@ dispatch_to_service (YtsClient  *self,
   else
     {
       // FIXME report error
+      priv->dispatch_failures++;
       g_critical ("%s : Unknown message type '%s'", G_STRLOC, type);
     }
 
+  YTS_PROBE6 (message__dispatch,
+              sender_contact_id, proxy_id, type, capability, invocation_id,
+              dispatched);
+
   g_object_unref (parser);
   return dispatched;
 }
 
 static void
-yts_client_yts_channels_received_cb (TpYtsClient *tp_client,
-                                      YtsClient  *client)
+_transport_ready (YtsTransport *transport,
+                  YtsClient    *self)
 {
-  TpYtsChannel  *ch;
-
-  while ((ch = tp_yts_client_accept_channel (tp_client)))
-    {
-      char const      *from;
-      GHashTable      *props;
-      GHashTableIter   iter;
-      gpointer         key, value;
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  GHashTable *statuses;
 
-      from = tp_channel_get_initiator_identifier (TP_CHANNEL (ch));
+  if (YTS_IS_TELEPATHY_TRANSPORT (transport)) {
+    g_object_notify (G_OBJECT (self), "tp-status");
+  }
 
-      g_object_get (ch, "channel-properties", &props, NULL);
-      g_assert (props);
+  yts_client_schedule_backoff_reset (self);
 
-      g_hash_table_iter_init (&iter, props);
-      while (g_hash_table_iter_next (&iter, &key, &value))
-        {
-          GValue      *v = value;
-          char        *k = key;
+  /* Advertise statii that have been set before the transport was ready,
+   * or again after reconnecting, in one go. */
+  statuses = g_hash_table_new (g_str_hash, g_str_equal);
+  yts_client_status_foreach_capability (
+    priv->client_status,
+    (YtsClientStatusCapabilityIterator) _client_status_foreach_capability_collect_status,
+    statuses);
+  yts_transport_advertise_statuses (priv->transport, statuses);
+  g_hash_table_destroy (statuses);
+
+  if (priv->offline) {
+    priv->offline = false;
+    replay_messages (self);
+  }
 
-          if (!g_strcmp0 (k, "org.freedesktop.ytstenut.xpmn.Channel.RequestBody"))
-            {
-              char const *xml_payload = g_value_get_string (v);
-              gboolean dispatched = dispatch_to_service (client,
-                                                         from,
-                                                         xml_payload);
+  /* Without an account there is no separate authentication step. */
+  if (NULL == priv->tp_am)
+    {
+      g_signal_emit (self, signals[AUTHENTICATED], 0);
+    }
 
-              // FIXME this should probably be emitted anyway, for consistency.
-              if (!dispatched)
-                {
-                  g_signal_emit (client, signals[RAW_MESSAGE], 0, xml_payload);
-                }
-            }
-        }
+  if (!priv->ready)
+    {
+      g_message ("Emitting 'ready' signal");
+      g_signal_emit (self, signals[READY], 0);
     }
 }
 
-/**
- * yts_client_disconnect:
- * @self: object on which to invoke this method.
- *
- * Disconnects @self.
- *
- * Since: 0.1
- */
-void
-yts_client_disconnect (YtsClient *self)
+static void
+_transport_disconnected (YtsTransport *transport,
+                         YtsClient    *self)
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
 
-  g_return_if_fail (YTS_IS_CLIENT (self));
-
-  /* cancel any pending reconnect timeout */
-  if (priv->reconnect_id)
-    {
-      g_source_remove (priv->reconnect_id);
-      priv->reconnect_id = 0;
-    }
+  yts_client_cleanup_connection_resources (self);
 
-  /* clear flag indicating pending connect */
-  priv->connect = FALSE;
-
-  /*
-   * Since this was a disconnect at our end, clear the reconnect flag,
-   * to avoid the signal closure from installing a reconnect callback.
-   */
-  priv->reconnect = FALSE;
+  /* Without an account the transport connects by itself, so reconnecting
+   * is up to us unless yts_client_disconnect() was called. */
+  if (NULL == priv->tp_am &&
+      priv->connect &&
+      0 == priv->reconnect_id)
+    yts_client_schedule_reconnect (self);
 
-  if (priv->tp_conn)
-    tp_cli_connection_call_disconnect  (priv->tp_conn,
-                                        -1, NULL, NULL, NULL, NULL);
+  g_signal_emit (self, signals[DISCONNECTED], 0);
 }
 
+/*
+ * Shared by the transport and the local transport, service_id is NULL
+ * when the sender's service is only known from the message itself.
+ */
 static void
-yts_client_connected_cb (TpConnection   *proxy,
-                          const GError  *error,
-                          YtsClient     *self,
-                          GObject       *weak_object)
+_transport_message_received (GObject    *transport,
+                             char const *contact_id,
+                             char const *service_id,
+                             char const *xml,
+                             YtsClient  *self)
 {
-  if (error)
-    {
-      g_warning (G_STRLOC ": %s: %s", __FUNCTION__, error->message);
+  gboolean dispatched;
 
-      yts_client_disconnect (self);
-      yts_client_reconnect_after (self, RECONNECT_DELAY);
-    }
-}
+  dispatched = dispatch_to_service (self, contact_id, service_id, xml);
 
-static void
-yts_client_error_cb (TpConnection *proxy,
-                      char const   *arg_Error,
-                      GHashTable   *arg_Details,
-                      gpointer      user_data,
-                      GObject      *weak_object)
-{
-  g_message ("Error: %s", arg_Error);
+  // FIXME this should probably be emitted anyway, for consistency.
+  if (!dispatched) {
+    g_signal_emit (self, signals[RAW_MESSAGE], 0, xml);
+  }
 }
 
 static void
-yts_client_status_cb (TpConnection  *proxy,
-                       guint         arg_Status,
-                       guint         arg_Reason,
-                       YtsClient    *self,
-                       GObject      *weak_object)
+_transport_service_added (YtsTransport      *transport,
+                          char const        *contact_id,
+                          char const        *service_id,
+                          char const        *type,
+                          char const *const *caps,
+                          GHashTable        *names,
+                          GHashTable        *statuses,
+                          YtsClient         *self)
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
 
-  char const *status[] = {"'connected'   ",
-                          "'connecting'  ",
-                          "'disconnected'"};
-  char const *reason[] =
-    {
-      "NONE_SPECIFIED",
-      "REQUESTED",
-      "NETWORK_ERROR",
-      "AUTHENTICATION_FAILED",
-      "ENCRYPTION_ERROR",
-      "NAME_IN_USE",
-      "CERT_NOT_PROVIDED",
-      "CERT_UNTRUSTED",
-      "CERT_EXPIRED",
-      "CERT_NOT_ACTIVATED",
-      "CERT_HOSTNAME_MISMATCH",
-      "CERT_FINGERPRINT_MISMATCH",
-      "CERT_SELF_SIGNED",
-      "CERT_OTHER_ERROR"
-    };
-
-  if (priv->disposed)
-    return;
-
-  g_message ("Connection: %s: '%s'",
-           status[arg_Status], reason[arg_Reason]);
-
-  if (arg_Status == TP_CONNECTION_STATUS_CONNECTED)
-    {
-      g_signal_emit (self, signals[AUTHENTICATED], 0);
-    }
-  else if (arg_Status == TP_CONNECTION_STATUS_DISCONNECTED)
-    {
-      yts_client_cleanup_connection_resources (self);
-
-      if (priv->reconnect)
-        yts_client_reconnect_after (self, RECONNECT_DELAY);
-
-      g_signal_emit (self, signals[DISCONNECTED], 0);
-    }
-}
-
-static gboolean
-yts_client_process_one_service (YtsClient         *self,
-                                char const        *contact_id,
-                                char const        *service_id,
-                                const GValueArray *service_info)
-{
-  YtsClientPrivate *priv = GET_PRIVATE (self);
-  char const        *type;
-  GHashTable        *names;
-  char             **caps;
-  GHashTable        *service_statuses;
-
-  if (service_info->n_values != 3)
-    {
-      g_warning ("Missformed service description (nvalues == %d)",
-                 service_info->n_values);
-      return FALSE;
-    }
-
-  g_message ("Processing service %s:%s", contact_id, service_id);
-
-  type  = g_value_get_string (&service_info->values[0]);
-  names = g_value_get_boxed (&service_info->values[1]);
-  caps  = g_value_get_boxed (&service_info->values[2]);
-
-  service_statuses = g_hash_table_new_full (g_str_hash,
-                                            g_str_equal,
-                                            g_free,
-                                            g_free);
-  if (priv->tp_status) {
-    GHashTable *discovered_statuses = tp_yts_status_get_discovered_statuses (
-                                                              priv->tp_status);
-    if (discovered_statuses) {
-      GHashTable *contact_statuses = g_hash_table_lookup (discovered_statuses,
-                                                          contact_id);
-      if (contact_statuses) {
-        unsigned i;
-        for (i = 0; caps && caps[i]; i++) {
-          GHashTable *capability_statuses = g_hash_table_lookup (contact_statuses,
-                                                                 caps[i]);
-          if (capability_statuses) {
-            char const *status_xml = g_hash_table_lookup (capability_statuses,
-                                                          service_id);
-            if (status_xml) {
-              g_hash_table_insert (service_statuses,
-                                   g_strdup (caps[i]),
-                                   g_strdup (status_xml));
-            }
-          }
-        }
-      }
-    }
-  }
-
   yts_roster_add_service (priv->roster,
-                          priv->tp_conn,
+                          transport,
                           contact_id,
                           service_id,
                           type,
-                          (char const **)caps,
+                          caps,
                           names,
-                          service_statuses);
+                          statuses);
 
-  g_hash_table_unref (service_statuses);
-
-  return TRUE;
-}
-
-static void
-yts_client_service_added_cb (TpYtsStatus        *tp_status,
-                             char const         *contact_id,
-                             char const         *service_id,
-                             const GValueArray  *service_info,
-                             YtsClient          *self)
-{
-  yts_client_process_one_service (self, contact_id, service_id, service_info);
+  /* Services on this host are talked to directly from now on. */
+  if (priv->local_transport) {
+    yts_local_transport_connect (priv->local_transport, contact_id, service_id);
+  }
 }
 
 static void
-yts_client_service_removed_cb (TpYtsStatus  *tp_status,
-                               char const   *contact_id,
-                               char const   *service_id,
-                               YtsClient    *self)
+_transport_service_removed (YtsTransport  *transport,
+                            char const    *contact_id,
+                            char const    *service_id,
+                            YtsClient     *self)
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
   GHashTableIter   iter;
@@ -2211,104 +3190,340 @@ yts_client_service_removed_cb (TpYtsStatus  *tp_status,
 }
 
 static void
-yts_client_process_status (YtsClient *self)
+_transport_status_changed (GObject      *transport,
+                           char const   *contact_id,
+                           char const   *fqc_id,
+                           char const   *service_id,
+                           char const   *status_xml,
+                           YtsClient    *self)
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
-  GHashTable        *services;
 
-  if ((services = tp_yts_status_get_discovered_services (priv->tp_status)))
-    {
-      char           *contact_id;
-      GHashTable     *service;
-      GHashTableIter  iter;
+  yts_roster_update_contact_status (priv->roster,
+                                    contact_id,
+                                    service_id,
+                                    fqc_id,
+                                    status_xml);
+}
+
+static void
+_transport_error (YtsTransport *transport,
+                  unsigned      error,
+                  YtsClient    *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  void *atom;
 
-      if (g_hash_table_size (services) <= 0)
-        g_message ("No services discovered so far");
+  /* Completion of pending sends is reported this way too. */
+  if (YTS_ERROR_SUCCESS != yts_error_get_code (error)) {
+    priv->send_failures++;
+  }
 
-      g_hash_table_iter_init (&iter, services);
-      while (g_hash_table_iter_next (&iter,
-                                     (void **) &contact_id,
-                                     (void **) &service))
-        {
-          char           *service_id;
-          GValueArray    *service_info;
-          GHashTableIter  iter2;
-
-          g_hash_table_iter_init (&iter2, service);
-          while (g_hash_table_iter_next (&iter2,
-                                         (void **) &service_id,
-                                         (void **) &service_info))
-            {
-              yts_client_process_one_service (self,
-                                              contact_id,
-                                              service_id,
-                                              service_info);
-            }
-        }
-    }
-  else
-    g_message ("No discovered services");
+  /* Replayed messages complete under the atom their sender got. */
+  atom = g_hash_table_lookup (priv->replay_atoms,
+                              GUINT_TO_POINTER (yts_error_get_atom (error)));
+  if (atom &&
+      YTS_ERROR_PENDING != yts_error_get_code (error)) {
+    g_hash_table_remove (priv->replay_atoms,
+                         GUINT_TO_POINTER (yts_error_get_atom (error)));
+    error = yts_error_make (GPOINTER_TO_UINT (atom),
+                            yts_error_get_code (error));
+  }
+
+  yts_client_emit_error (self, error);
 }
 
 static void
-_tp_yts_status_changed (TpYtsStatus *tp_status,
-                        char const  *contact_id,
-                        char const  *fqc_id,
-                        char const  *service_id,
-                        char const  *status_xml,
-                        YtsClient   *self)
+_transport_send_queue_congested (YtsTransport *transport,
+                                 char const   *contact_id,
+                                 gboolean      congested,
+                                 YtsClient    *self)
+{
+  g_signal_emit (self, signals[SEND_QUEUE_CONGESTED], 0,
+                 contact_id, congested);
+}
+
+static void
+apply_send_queue_limits (YtsClient *self)
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
 
-  yts_roster_update_contact_status (priv->roster,
-                                    contact_id,
-                                    service_id,
-                                    fqc_id,
-                                    status_xml);
+  /* The watermarks may be crossed for a moment while they are set one
+   * after the other, the transport only gets consistent limits. */
+  if (priv->transport &&
+      YTS_SEND_QUEUE_LIMITS_VALID (&priv->send_queue_limits)) {
+    yts_transport_set_send_queue_limits (priv->transport,
+                                         &priv->send_queue_limits);
+  }
 }
 
 static void
-yts_client_yts_status_cb (GObject       *obj,
-                          GAsyncResult  *res,
-                          YtsClient     *self)
+attach_transport (YtsClient     *self,
+                  YtsTransport  *transport)
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
-  TpAccount         *acc    = TP_ACCOUNT (obj);
-  GError            *error  = NULL;
-  TpYtsStatus       *tp_status;
 
-  if (!(tp_status = tp_yts_status_ensure_finish (acc, res,&error)))
-    {
-      g_error ("Failed to obtain tp_status: %s", error->message);
+  priv->transport = transport;
+
+  g_signal_connect (transport, "ready",
+                    G_CALLBACK (_transport_ready), self);
+  g_signal_connect (transport, "disconnected",
+                    G_CALLBACK (_transport_disconnected), self);
+  g_signal_connect (transport, "message-received",
+                    G_CALLBACK (_transport_message_received), self);
+  g_signal_connect (transport, "service-added",
+                    G_CALLBACK (_transport_service_added), self);
+  g_signal_connect (transport, "service-removed",
+                    G_CALLBACK (_transport_service_removed), self);
+  g_signal_connect (transport, "status-changed",
+                    G_CALLBACK (_transport_status_changed), self);
+  g_signal_connect (transport, "error",
+                    G_CALLBACK (_transport_error), self);
+  g_signal_connect (transport, "send-queue-congested",
+                    G_CALLBACK (_transport_send_queue_congested), self);
+
+  apply_send_queue_limits (self);
+}
+
+/*
+ * A message could not be written to a peer on this host after all, send
+ * it the long way round.
+ */
+static void
+_local_transport_undelivered (YtsLocalTransport *local_transport,
+                              char const        *contact_id,
+                              char const        *service_id,
+                              char const        *xml,
+                              YtsClient         *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  YtsContact  *contact = NULL;
+  YtsMetadata *message;
+  YtsError     error;
+  unsigned     code;
+
+  if (priv->roster) {
+    contact = yts_roster_find_contact_by_id (priv->roster, contact_id);
+  }
+
+  message = yts_metadata_new_from_xml (xml);
+
+  if (NULL == message ||
+      NULL == contact ||
+      NULL == priv->transport) {
+    priv->send_failures++;
+    error = yts_error_new (YTS_ERROR_NO_MSG_CHANNEL);
+  } else if (priv->offline) {
+    error = replay_queue_push (self, contact, service_id, message);
+  } else {
+    error = yts_transport_send_message (priv->transport,
+                                        contact,
+                                        service_id,
+                                        message);
+    if (YTS_ERROR_SUCCESS != yts_error_get_code (error) &&
+        YTS_ERROR_PENDING != yts_error_get_code (error)) {
+      priv->send_failures++;
     }
+  }
 
-  g_message ("Processing tp_status");
+  code = yts_error_get_code (error);
+  if (YTS_ERROR_SUCCESS != code &&
+      YTS_ERROR_PENDING != code) {
+    g_warning ("%s : Message to local peer %s/%s lost",
+               G_STRLOC, contact_id, service_id);
+    yts_client_emit_error (self, error);
+  }
 
-  priv->tp_status = tp_status;
-  g_object_notify (G_OBJECT (self), "tp-status");
+  if (message) {
+    g_object_unref (message);
+  }
+}
 
-  tp_g_signal_connect_object (tp_status, "service-added",
-                              G_CALLBACK (yts_client_service_added_cb),
-                              self, 0);
-  tp_g_signal_connect_object (tp_status, "service-removed",
-                              G_CALLBACK (yts_client_service_removed_cb),
-                              self, 0);
-  tp_g_signal_connect_object (tp_status, "status-changed",
-                              G_CALLBACK (_tp_yts_status_changed),
-                              self, 0);
+static bool
+_client_status_foreach_capability_advertise_local (YtsClientStatus const *client_status,
+                                                   char const            *capability,
+                                                   char const            *status_xml,
+                                                   YtsLocalTransport     *local_transport)
+{
+  yts_local_transport_advertise_status (local_transport,
+                                        capability,
+                                        status_xml);
+
+  return true;
+}
+
+static void
+start_local_transport (YtsClient *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  char const  *contact_id;
+  GError      *error = NULL;
+
+  contact_id = yts_client_get_contact_id (self);
+  if (priv->local_transport ||
+      NULL == contact_id ||
+      NULL == priv->service_id) {
+    return;
+  }
+
+  priv->local_transport = yts_local_transport_new (contact_id,
+                                                   priv->service_id);
+  if (!yts_local_transport_start (priv->local_transport, &error)) {
+    /* Not fatal, everything goes through Telepathy then. */
+    g_message ("Local transport not available: %s", error->message);
+    g_clear_error (&error);
+    g_object_unref (priv->local_transport);
+    priv->local_transport = NULL;
+    return;
+  }
 
-  /* Advertise statii that have been set before our TpStatus was ready. */
+  g_signal_connect (priv->local_transport, "message",
+                    G_CALLBACK (_transport_message_received), self);
+  g_signal_connect (priv->local_transport, "status-changed",
+                    G_CALLBACK (_transport_status_changed), self);
+  g_signal_connect (priv->local_transport, "undelivered",
+                    G_CALLBACK (_local_transport_undelivered), self);
+
+  /* Statii set before the connection was ready. */
   yts_client_status_foreach_capability (
     priv->client_status,
-    (YtsClientStatusCapabilityIterator) _client_status_foreach_capability_advertise_status,
-    self);
+    (YtsClientStatusCapabilityIterator) _client_status_foreach_capability_advertise_local,
+    priv->local_transport);
+}
 
-  yts_client_process_status (self);
+/**
+ * yts_client_disconnect:
+ * @self: object on which to invoke this method.
+ *
+ * Disconnects @self.
+ *
+ * Since: 0.1
+ */
+void
+yts_client_disconnect (YtsClient *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  ReplayMessage *m;
 
-  if (!priv->ready)
+  g_return_if_fail (YTS_IS_CLIENT (self));
+
+  /* cancel any pending reconnect timeout */
+  if (priv->reconnect_id)
     {
-      g_message ("Emitting 'ready' signal");
-      g_signal_emit (self, signals[READY], 0);
+      g_source_remove (priv->reconnect_id);
+      priv->reconnect_id = 0;
+    }
+
+  /* clear flag indicating pending connect */
+  priv->connect = FALSE;
+
+  /*
+   * Since this was a disconnect at our end, clear the reconnect flag,
+   * to avoid the signal closure from installing a reconnect callback.
+   */
+  priv->reconnect = FALSE;
+  priv->reconnect_attempts = 0;
+
+  /* Nothing is going to send what was kept for after reconnecting. */
+  priv->offline = false;
+  while ((m = g_queue_pop_head (priv->replay_messages))) {
+    replay_message_fail (self, m, YTS_ERROR_NO_MSG_CHANNEL);
+  }
+
+  if (priv->tp_conn)
+    tp_cli_connection_call_disconnect  (priv->tp_conn,
+                                        -1, NULL, NULL, NULL, NULL);
+  else if (NULL == priv->tp_am && priv->transport)
+    yts_transport_disconnect (priv->transport);
+}
+
+static void
+yts_client_connected_cb (TpConnection   *proxy,
+                          const GError  *error,
+                          YtsClient     *self,
+                          GObject       *weak_object)
+{
+  if (error)
+    {
+      YtsClientPrivate *priv = GET_PRIVATE (self);
+
+      g_warning (G_STRLOC ": %s: %s", __FUNCTION__, error->message);
+
+      /* Not yts_client_disconnect(), messages waiting for the connection
+       * are kept for the next attempt. */
+      if (priv->tp_conn)
+        tp_cli_connection_call_disconnect  (priv->tp_conn,
+                                            -1, NULL, NULL, NULL, NULL);
+      yts_client_schedule_reconnect (self);
+    }
+}
+
+static void
+yts_client_error_cb (TpConnection *proxy,
+                      char const   *arg_Error,
+                      GHashTable   *arg_Details,
+                      gpointer      user_data,
+                      GObject      *weak_object)
+{
+  g_message ("Error: %s", arg_Error);
+}
+
+static void
+yts_client_status_cb (TpConnection  *proxy,
+                       guint         arg_Status,
+                       guint         arg_Reason,
+                       YtsClient    *self,
+                       GObject      *weak_object)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+
+  char const *status[] = {"'connected'   ",
+                          "'connecting'  ",
+                          "'disconnected'"};
+  char const *reason[] =
+    {
+      "NONE_SPECIFIED",
+      "REQUESTED",
+      "NETWORK_ERROR",
+      "AUTHENTICATION_FAILED",
+      "ENCRYPTION_ERROR",
+      "NAME_IN_USE",
+      "CERT_NOT_PROVIDED",
+      "CERT_UNTRUSTED",
+      "CERT_EXPIRED",
+      "CERT_NOT_ACTIVATED",
+      "CERT_HOSTNAME_MISMATCH",
+      "CERT_FINGERPRINT_MISMATCH",
+      "CERT_SELF_SIGNED",
+      "CERT_OTHER_ERROR"
+    };
+
+  if (priv->disposed)
+    return;
+
+  g_message ("Connection: %s: '%s'",
+           status[arg_Status], reason[arg_Reason]);
+
+  if (arg_Status == TP_CONNECTION_STATUS_CONNECTED)
+    {
+      yts_client_schedule_backoff_reset (self);
+      g_signal_emit (self, signals[AUTHENTICATED], 0);
+    }
+  else if (arg_Status == TP_CONNECTION_STATUS_DISCONNECTED)
+    {
+      if (YTS_IS_TELEPATHY_TRANSPORT (priv->transport))
+        yts_telepathy_transport_take_send_queues (
+                          YTS_TELEPATHY_TRANSPORT (priv->transport),
+                          (YtsTelepathyTransportQueuedFunc) _transport_take_queued,
+                          self);
+
+      yts_client_cleanup_connection_resources (self);
+
+      /* Unless a failed connection attempt has scheduled it already. */
+      if (priv->reconnect && 0 == priv->reconnect_id)
+        yts_client_schedule_reconnect (self);
+
+      g_signal_emit (self, signals[DISCONNECTED], 0);
     }
 }
 
@@ -2318,26 +3533,15 @@ yts_client_connection_ready_cb (TpConnection *conn,
                                 YtsClient   *self)
 {
   YtsClientPrivate *priv = GET_PRIVATE (self);
-  GCancellable      *cancellable;
 
   if (tp_connection_is_ready (conn))
     {
       g_message ("TP Connection entered ready state");
 
-      cancellable = g_cancellable_new ();
+      start_local_transport (self);
 
-      tp_yts_status_ensure_async (priv->tp_account,
-                                  cancellable,
-                                  (GAsyncReadyCallback) yts_client_yts_status_cb,
-                                  self);
-
-      /*
-       * TODO -- this should be stored, so we can clean up in dispose any
-       * pending op, ???
-       *
-       * But the TpYtsStatus docs say it's not used ...
-       */
-      g_object_unref (cancellable);
+      yts_telepathy_transport_ensure_status (
+                                  YTS_TELEPATHY_TRANSPORT (priv->transport));
     }
 }
 
@@ -2355,16 +3559,14 @@ yts_client_connection_prepare_cb (GObject       *connection,
     }
   else
     {
-      if (!tp_yts_client_register (priv->tp_client, &error))
+      if (!yts_telepathy_transport_register (
+                                  YTS_TELEPATHY_TRANSPORT (priv->transport),
+                                  &error))
         {
           g_error ("Failed to register account: %s", error->message);
         }
       else
         g_message ("Registered TpYtsClient");
-
-      tp_g_signal_connect_object (priv->tp_client, "received-channels",
-                              G_CALLBACK (yts_client_yts_channels_received_cb),
-                              self, 0);
 #if 0
       /* TODO -- */
       /*
@@ -2561,7 +3763,14 @@ yts_client_connect (YtsClient *self)
 
   priv->connect = TRUE;
 
-  if (priv->tp_conn)
+  if (NULL == priv->tp_am && priv->transport)
+    {
+      /*
+       * No account, the transport connects by itself.
+       */
+      yts_transport_connect (priv->transport);
+    }
+  else if (priv->tp_conn)
     {
       /*
        * We already have the connection, so just connect.
@@ -2585,13 +3794,13 @@ yts_client_refresh_roster (YtsClient *self)
 
   g_message ("Refreshing roster");
 
-  if (!priv->tp_status)
+  if (!priv->transport)
     return;
 
   yts_roster_clear (priv->roster);
   yts_roster_clear (priv->unwanted);
 
-  yts_client_process_status (self);
+  yts_transport_refresh (priv->transport);
 }
 
 /**
@@ -2624,9 +3833,9 @@ yts_client_add_capability (YtsClient          *self,
 
     if (yts_client_status_add_capability (priv->client_status, capability)) {
       /* Advertise right away if possible, otherwise the advertising will
-       * happen when the tp_client is ready. */
-      if (priv->tp_client) {
-        tp_yts_client_add_capability (priv->tp_client, capability);
+       * happen when the transport is set up. */
+      if (priv->transport) {
+        yts_transport_add_capability (priv->transport, capability);
       }
     } else {
       g_message ("Capablity '%s' already set", capability);
@@ -2639,9 +3848,9 @@ yts_client_add_capability (YtsClient          *self,
 
     if (yts_client_status_add_interest (priv->client_status, capability)) {
       /* Advertise right away if possible, otherwise the advertising will
-       * happen when the tp_client is ready. */
-      if (priv->tp_client) {
-        tp_yts_client_add_interest (priv->tp_client, capability);
+       * happen when the transport is set up. */
+      if (priv->transport) {
+        yts_transport_add_interest (priv->transport, capability);
       }
     } else {
       g_message ("Interest '%s' already set", capability);
@@ -2675,13 +3884,422 @@ yts_client_get_roster (YtsClient const *self)
 }
 
 /**
- * yts_client_emit_error:
+ * yts_client_get_transfer_scheduler:
  * @self: object on which to invoke this method.
- * @error: #YtsError
  *
- * Emits the #YtsClient::error signal with the suplied error parameter.
+ * Get the scheduler queueing the outgoing file transfers of this client.
  *
- * This function is intened primarily for internal use, but can be also used by
+ * Returns: (transfer none): the client's #YtsTransferScheduler.
+ *
+ * Since: 0.4
+ */
+YtsTransferScheduler *const
+yts_client_get_transfer_scheduler (YtsClient const *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_CLIENT (self), NULL);
+
+  return priv->transfer_scheduler;
+}
+
+typedef struct {
+  unsigned  n_contacts;
+  unsigned  n_services;
+} RosterCount;
+
+static bool
+_roster_count_service (YtsContact *contact,
+                       char const *service_id,
+                       YtsService *service,
+                       RosterCount *count)
+{
+  count->n_services++;
+  return true;
+}
+
+static bool
+_roster_count_contact (YtsRoster   *roster,
+                       char const  *contact_id,
+                       YtsContact  *contact,
+                       RosterCount *count)
+{
+  count->n_contacts++;
+  yts_contact_foreach_service (contact,
+                               (YtsContactServiceIterator) _roster_count_service,
+                               count);
+  return true;
+}
+
+static GVariant *
+message_counts_new (uint64_t const *counts)
+{
+  GVariantBuilder builder;
+  unsigned        i;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{st}"));
+  for (i = 0; i < N_MESSAGE_TYPES; i++) {
+    g_variant_builder_add (&builder, "{st}", _message_types[i], counts[i]);
+  }
+
+  return g_variant_builder_end (&builder);
+}
+
+/**
+ * yts_client_get_statistics:
+ * @self: object on which to invoke this method.
+ *
+ * Take a snapshot of the client's runtime counters and resource usage, for
+ * monitoring and troubleshooting. The result is a dictionary of type
+ * <literal>a{sv}</literal> with the following keys:
+ *
+ * <itemizedlist>
+ *  <listitem>"messages-sent", "messages-received": <literal>a{st}</literal>
+ *    message counts by type.</listitem>
+ *  <listitem>"bytes-sent", "bytes-received": <literal>t</literal> message
+ *    payload in bytes.</listitem>
+ *  <listitem>"send-failures", "dispatch-failures", "invocation-timeouts":
+ *    <literal>t</literal> error counts.</listitem>
+ *  <listitem>"invocations-pending", "local-messages-pending",
+ *    "messages-waiting-for-contact", "messages-waiting-for-reconnect",
+ *    "channels-open", "proxies", "services",
+ *    "roster-contacts", "roster-services", "unwanted-contacts",
+ *    "transfers-running", "transfers-queued": <literal>u</literal> current
+ *    sizes.</listitem>
+ *  <listitem>"transfer-bytes-per-second": <literal>t</literal> combined
+ *    throughput of the running outgoing transfers.</listitem>
+ * </itemizedlist>
+ *
+ * Counters are cumulative since the client was created, unknown keys
+ * should be ignored.
+ *
+ * Returns: (transfer full): statistics snapshot.
+ *
+ * Since: 0.4
+ */
+GVariant *
+yts_client_get_statistics (YtsClient *self)
+{
+  YtsClientPrivate        *priv = GET_PRIVATE (self);
+  YtsTransportStatistics   transport;
+  YtsTransportStatistics   local;
+  GVariantBuilder          builder;
+  GHashTableIter           iter;
+  ProxyList               *proxy_list;
+  RosterCount              roster = { 0, 0 };
+  RosterCount              unwanted = { 0, 0 };
+  unsigned                 n_proxies = 0;
+  unsigned                 n_running = 0;
+  unsigned                 n_queued = 0;
+  uint64_t                 bytes_per_second = 0;
+
+  g_return_val_if_fail (YTS_IS_CLIENT (self), NULL);
+
+  memset (&transport, 0, sizeof (transport));
+  memset (&local, 0, sizeof (local));
+  if (priv->transport) {
+    yts_transport_get_statistics (priv->transport, &transport);
+  }
+  if (priv->local_transport) {
+    yts_local_transport_get_statistics (priv->local_transport, &local);
+  }
+
+  g_hash_table_iter_init (&iter, priv->proxies);
+  while (g_hash_table_iter_next (&iter, NULL, (void **) &proxy_list)) {
+    n_proxies += g_list_length (proxy_list->list);
+  }
+
+  if (priv->roster) {
+    yts_roster_foreach_contact (priv->roster,
+                                (YtsRosterContactIterator) _roster_count_contact,
+                                &roster);
+  }
+  if (priv->unwanted) {
+    yts_roster_foreach_contact (priv->unwanted,
+                                (YtsRosterContactIterator) _roster_count_contact,
+                                &unwanted);
+  }
+
+  if (priv->transfer_scheduler) {
+    yts_transfer_scheduler_get_statistics (priv->transfer_scheduler,
+                                           &n_running,
+                                           &n_queued,
+                                           &bytes_per_second);
+  }
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+
+  g_variant_builder_add (&builder, "{sv}", "messages-sent",
+                         message_counts_new (priv->messages_sent));
+  g_variant_builder_add (&builder, "{sv}", "messages-received",
+                         message_counts_new (priv->messages_received));
+  g_variant_builder_add (&builder, "{sv}", "bytes-sent",
+                         g_variant_new_uint64 (transport.bytes_sent +
+                                               local.bytes_sent));
+  g_variant_builder_add (&builder, "{sv}", "bytes-received",
+                         g_variant_new_uint64 (priv->bytes_received));
+  g_variant_builder_add (&builder, "{sv}", "send-failures",
+                         g_variant_new_uint64 (priv->send_failures));
+  g_variant_builder_add (&builder, "{sv}", "dispatch-failures",
+                         g_variant_new_uint64 (priv->dispatch_failures));
+  g_variant_builder_add (&builder, "{sv}", "invocation-timeouts",
+                         g_variant_new_uint64 (priv->invocation_timeouts));
+
+  g_variant_builder_add (&builder, "{sv}", "invocations-pending",
+                         g_variant_new_uint32 (
+                            g_hash_table_size (priv->invocations)));
+  g_variant_builder_add (&builder, "{sv}", "local-messages-pending",
+                         g_variant_new_uint32 (
+                            priv->local_messages ?
+                              g_queue_get_length (priv->local_messages) : 0));
+  g_variant_builder_add (&builder, "{sv}", "messages-waiting-for-contact",
+                         g_variant_new_uint32 (transport.messages_waiting +
+                                               local.messages_waiting));
+  g_variant_builder_add (&builder, "{sv}", "messages-waiting-for-reconnect",
+                         g_variant_new_uint32 (
+                           g_queue_get_length (priv->replay_messages)));
+  g_variant_builder_add (&builder, "{sv}", "channels-open",
+                         g_variant_new_uint32 (transport.channels_open +
+                                               local.channels_open));
+  g_variant_builder_add (&builder, "{sv}", "proxies",
+                         g_variant_new_uint32 (n_proxies));
+  g_variant_builder_add (&builder, "{sv}", "services",
+                         g_variant_new_uint32 (
+                            g_hash_table_size (priv->services)));
+  g_variant_builder_add (&builder, "{sv}", "roster-contacts",
+                         g_variant_new_uint32 (roster.n_contacts));
+  g_variant_builder_add (&builder, "{sv}", "roster-services",
+                         g_variant_new_uint32 (roster.n_services));
+  g_variant_builder_add (&builder, "{sv}", "unwanted-contacts",
+                         g_variant_new_uint32 (unwanted.n_contacts));
+
+  g_variant_builder_add (&builder, "{sv}", "transfers-running",
+                         g_variant_new_uint32 (n_running));
+  g_variant_builder_add (&builder, "{sv}", "transfers-queued",
+                         g_variant_new_uint32 (n_queued));
+  g_variant_builder_add (&builder, "{sv}", "transfer-bytes-per-second",
+                         g_variant_new_uint64 (bytes_per_second));
+
+  return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+static bool
+_statistics_timeout (YtsClient *self)
+{
+  GVariant *statistics;
+
+  statistics = yts_client_get_statistics (self);
+  g_signal_emit (self, signals[STATS_UPDATED], 0, statistics);
+  g_variant_unref (statistics);
+
+  return true;
+}
+
+/**
+ * yts_client_set_statistics_interval:
+ * @self: object on which to invoke this method.
+ * @interval: seconds between #YtsClient::stats-updated emissions, 0 to stop
+ *            them.
+ *
+ * Periodically publish yts_client_get_statistics() snapshots.
+ *
+ * Since: 0.4
+ */
+void
+yts_client_set_statistics_interval (YtsClient *self,
+                                    unsigned   interval)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+
+  g_return_if_fail (YTS_IS_CLIENT (self));
+
+  if (interval == priv->statistics_interval) {
+    return;
+  }
+
+  if (priv->statistics_id) {
+    g_source_remove (priv->statistics_id);
+    priv->statistics_id = 0;
+  }
+
+  priv->statistics_interval = interval;
+  if (interval) {
+    priv->statistics_id =
+      g_timeout_add_seconds (interval,
+                             (GSourceFunc) _statistics_timeout,
+                             self);
+  }
+
+  g_object_notify (G_OBJECT (self), "statistics-interval");
+}
+
+/**
+ * yts_client_get_statistics_interval:
+ * @self: object on which to invoke this method.
+ *
+ * Returns: seconds between #YtsClient::stats-updated emissions, 0 if
+ *          disabled.
+ *
+ * Since: 0.4
+ */
+unsigned
+yts_client_get_statistics_interval (YtsClient const *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_CLIENT (self), 0);
+
+  return priv->statistics_interval;
+}
+
+/**
+ * yts_client_get_latency_statistics:
+ * @self: object on which to invoke this method.
+ *
+ * Get latency histograms for the invocations of services published by this
+ * client. The result is of type <literal>a{sv}</literal> with keys
+ * "queueing", the time from a message's arrival until it is handed to the
+ * service, and "processing", the time the service takes to respond. Each
+ * holds an <literal>a{sa{sa{sv}}}</literal> dictionary from capability to
+ * aspect to a histogram summary, see
+ * yts_proxy_service_get_latency_statistics() for its keys. End-to-end
+ * latency is measured by the invoking side's #YtsProxyService.
+ *
+ * Returns: (transfer full): latency statistics.
+ *
+ * Since: 0.4
+ */
+GVariant *
+yts_client_get_latency_statistics (YtsClient *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  GVariantBuilder builder;
+
+  g_return_val_if_fail (YTS_IS_CLIENT (self), NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+  g_variant_builder_add (&builder, "{sv}", "queueing",
+                         yts_latency_table_to_variant (priv->queueing_latency));
+  g_variant_builder_add (&builder, "{sv}", "processing",
+                         yts_latency_table_to_variant (priv->processing_latency));
+
+  return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+static bool
+_dump_service_latency (YtsContact *contact,
+                       char const *service_id,
+                       YtsService *service,
+                       void       *data)
+{
+  if (YTS_IS_PROXY_SERVICE (service)) {
+    yts_proxy_service_dump_latency_statistics (YTS_PROXY_SERVICE (service));
+  }
+
+  return true;
+}
+
+static bool
+_dump_contact_latency (YtsRoster  *roster,
+                       char const *contact_id,
+                       YtsContact *contact,
+                       void       *data)
+{
+  yts_contact_foreach_service (contact, _dump_service_latency, NULL);
+
+  return true;
+}
+
+/**
+ * yts_client_dump_latency_statistics:
+ * @self: object on which to invoke this method.
+ *
+ * Print the latency histograms of this client's services and of the proxy
+ * services in its roster to standard error. If the environment variable
+ * <literal>YTS_LATENCY_DUMP</literal> is set, this also happens when the
+ * process receives <literal>SIGUSR2</literal>.
+ *
+ * Since: 0.4
+ */
+void
+yts_client_dump_latency_statistics (YtsClient *self)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+
+  g_return_if_fail (YTS_IS_CLIENT (self));
+
+  yts_latency_table_dump (priv->queueing_latency, "queueing");
+  yts_latency_table_dump (priv->processing_latency, "processing");
+
+  if (priv->roster) {
+    yts_roster_foreach_contact (priv->roster, _dump_contact_latency, NULL);
+  }
+}
+
+/**
+ * yts_client_add_incoming_file_policy:
+ * @self: object on which to invoke this method.
+ * @policy: policy to add.
+ *
+ * Have incoming files matching @policy accepted automatically. Policies
+ * are consulted in the order they have been added.
+ *
+ * Since: 0.4
+ */
+void
+yts_client_add_incoming_file_policy (YtsClient              *self,
+                                     YtsIncomingFilePolicy  *policy)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+
+  g_return_if_fail (YTS_IS_CLIENT (self));
+  g_return_if_fail (YTS_IS_INCOMING_FILE_POLICY (policy));
+
+  priv->incoming_file_policies = g_list_append (priv->incoming_file_policies,
+                                                g_object_ref (policy));
+}
+
+/**
+ * yts_client_remove_incoming_file_policy:
+ * @self: object on which to invoke this method.
+ * @policy: policy to remove.
+ *
+ * Stop applying @policy to incoming files.
+ *
+ * Returns: %true if @policy had been added to @self.
+ *
+ * Since: 0.4
+ */
+bool
+yts_client_remove_incoming_file_policy (YtsClient              *self,
+                                        YtsIncomingFilePolicy  *policy)
+{
+  YtsClientPrivate *priv = GET_PRIVATE (self);
+  GList *link;
+
+  g_return_val_if_fail (YTS_IS_CLIENT (self), false);
+
+  link = g_list_find (priv->incoming_file_policies, policy);
+  if (NULL == link) {
+    return false;
+  }
+
+  priv->incoming_file_policies = g_list_delete_link (
+                                              priv->incoming_file_policies,
+                                              link);
+  g_object_unref (policy);
+
+  return true;
+}
+
+/**
+ * yts_client_emit_error:
+ * @self: object on which to invoke this method.
+ * @error: #YtsError
+ *
+ * Emits the #YtsClient::error signal with the suplied error parameter.
+ *
+ * This function is intened primarily for internal use, but can be also used by
  * toolkit libraries that need to generate asynchronous errors. Any function
  * call that returns the %YTS_ERROR_PENDING code to the caller should
  * eventually lead to emission of the ::error signal with either an appropriate
@@ -2717,9 +4335,9 @@ yts_client_get_contact_id (YtsClient const *self)
   YtsClientPrivate *priv = GET_PRIVATE (self);
 
   g_return_val_if_fail (YTS_IS_CLIENT (self), NULL);
-  g_return_val_if_fail (priv->tp_account, NULL);
+  g_return_val_if_fail (priv->transport, NULL);
 
-  return tp_account_get_normalized_name (priv->tp_account);
+  return yts_transport_get_contact_id (priv->transport);
 }
 
 /**
@@ -2757,7 +4375,11 @@ yts_client_get_tp_status (YtsClient *self)
 
   g_return_val_if_fail (YTS_IS_CLIENT (self), NULL);
 
-  return priv->tp_status;
+  if (!YTS_IS_TELEPATHY_TRANSPORT (priv->transport))
+    return NULL;
+
+  return yts_telepathy_transport_get_tp_status (
+                                  YTS_TELEPATHY_TRANSPORT (priv->transport));
 }
 
 /**
@@ -2800,10 +4422,10 @@ yts_client_set_status_by_capability (YtsClient    *self,
 
   /* Check if the capability is already advertised. */
   if (yts_client_status_add_capability (priv->client_status, capability)) {
-    /* Add capability if we already have a tp_client,
-     * otherwise that's done when it's ready. */
-    if (priv->tp_client) {
-      tp_yts_client_add_capability (priv->tp_client, capability);
+    /* Add capability if we already have a transport,
+     * otherwise that's done when it's set up. */
+    if (priv->transport) {
+      yts_transport_add_capability (priv->transport, capability);
     }
   }
 
@@ -2812,290 +4434,81 @@ yts_client_set_status_by_capability (YtsClient    *self,
                                                  attribs,
                                                  status_xml);
 
-  /* Advertise if we already have a tp_status,
+  /* Advertise if we already have a transport,
    * otherwise that's done when it's ready. */
-  if (priv->client_status) {
-    tp_yts_status_advertise_status_async (priv->tp_status,
-                                          capability,
-                                          priv->service_id,
-                                          capability_status_xml,
-                                          NULL,
-                                          _tp_yts_status_advertise_status_cb,
-                                          self);
+  if (priv->transport) {
+    yts_transport_advertise_status (priv->transport,
+                                    capability,
+                                    capability_status_xml);
   }
-}
-
-struct YtsCLChannelData
-{
-  YtsClient  *client;
-  YtsContact *contact;
-  GHashTable  *attrs;
-  char        *xml;
-  char        *service_id;
-  YtsError    error;
-  gboolean     status_done;
-  int          ref_count;
-};
-
-static void
-yts_cl_channel_data_unref (struct YtsCLChannelData *d)
-{
-  d->ref_count--;
 
-  if (d->ref_count <= 0)
-    {
-      g_hash_table_unref (d->attrs);
-      g_free (d->xml);
-      g_free (d->service_id);
-      g_free (d);
-    }
-}
-
-static struct YtsCLChannelData *
-yts_cl_channel_data_ref (struct YtsCLChannelData *d)
-{
-  d->ref_count++;
-  return d;
+  if (priv->local_transport) {
+    yts_local_transport_advertise_status (priv->local_transport,
+                                          capability,
+                                          capability_status_xml);
+  }
 }
 
-static void
-yts_client_msg_replied_cb (TpYtsChannel *proxy,
-                            GHashTable   *attributes,
-                            char const   *body,
-                            gpointer      data,
-                            GObject      *weak_object)
+YtsError
+yts_client_send_message (YtsClient   *client,
+                           YtsContact  *contact,
+                           char const   *service_id,
+                           YtsMetadata *message)
 {
-  GHashTableIter            iter;
-  gpointer                  key, value;
-  struct YtsCLChannelData *d = data;
-
-  g_message ("Got reply with attributes:");
+  YtsClientPrivate *priv = GET_PRIVATE (client);
+  char const *type = yts_metadata_get_attribute (message, "type");
+  YtsError error;
 
-  g_hash_table_iter_init (&iter, attributes);
-
-  while (g_hash_table_iter_next (&iter, &key, &value))
+  if (YTS_PROBE_ENABLED (message__send))
     {
-      g_message ("    %s = %s\n",
-                 (char const *) key, (char const  *) value);
+      YTS_PROBE5 (message__send,
+                  yts_contact_get_id (contact), service_id, type,
+                  yts_metadata_get_attribute (message, "capability"),
+                  yts_metadata_get_attribute (message, "invocation"));
     }
 
-  g_message ("    body: %s\n", body);
-
-  if (!d->status_done)
-    {
-      guint32   a;
-      YtsError e;
-
-      a = yts_error_get_atom (d->error);
-      e = yts_error_make (a, YTS_ERROR_SUCCESS);
-
-      yts_client_emit_error (d->client, e);
-
-      d->status_done = TRUE;
-    }
-
-  yts_cl_channel_data_unref (d);
-}
-
-static void
-yts_client_msg_failed_cb (TpYtsChannel *proxy,
-                           guint         error_type,
-                           char const   *stanza_error_name,
-                           char const   *ytstenut_error_name,
-                           char const   *text,
-                           gpointer      data,
-                           GObject      *weak_object)
-{
-  guint32                   a;
-  YtsError                 e;
-  struct YtsCLChannelData *d = data;
-
-  a = yts_error_get_atom (d->error);
-
-  g_warning ("Sending of message failed: type %u, %s, %s, %s",
-             error_type, stanza_error_name, ytstenut_error_name, text);
-
-  e = yts_error_make (a, YTS_ERROR_NO_MSG_CHANNEL);
-
-  yts_client_emit_error (d->client, e);
-
-  d->status_done = TRUE;
-
-  yts_cl_channel_data_unref (d);
-}
+  priv->messages_sent[message_type_index (type)]++;
 
-static void
-yts_client_msg_closed_cb (TpChannel *channel,
-                           gpointer   data,
-                           GObject   *weak_object)
-{
-  struct YtsCLChannelData *d = data;
-
-  g_message ("Channel closed");
-
-  if (!d->status_done)
+  if (is_local_service (client, contact, service_id) &&
+      send_local_message (client, contact, message))
     {
-      guint32   a;
-      YtsError e;
-
-      a = yts_error_get_atom (d->error);
-      e = yts_error_make (a, YTS_ERROR_SUCCESS);
-
-      yts_client_emit_error (d->client, e);
-
-      d->status_done = TRUE;
+      return yts_error_new (YTS_ERROR_SUCCESS);
     }
 
-  yts_cl_channel_data_unref (d);
-}
-
-static void
-yts_client_msg_request_cb (GObject      *source_object,
-                            GAsyncResult *result,
-                            gpointer      data)
-{
-  GError *error = NULL;
-
-  if (!tp_yts_channel_request_finish (
-          TP_YTS_CHANNEL (source_object), result, &error))
+  /* Peers on the same host are reached directly, others through the
+   * transport. */
+  if (priv->local_transport &&
+      yts_local_transport_send (priv->local_transport,
+                                yts_contact_get_id (contact),
+                                service_id,
+                                message))
     {
-      g_warning ("Failed to Request on channel: %s\n", error->message);
+      return yts_error_new (YTS_ERROR_SUCCESS);
     }
-  else
-    {
-      g_message ("Channel requested");
-    }
-
-  g_clear_error (&error);
-}
-
-static void
-yts_client_outgoing_channel_cb (GObject      *obj,
-                                 GAsyncResult *res,
-                                 gpointer      data)
-{
-  TpYtsChannel             *ch;
-  TpYtsClient              *client = TP_YTS_CLIENT (obj);
-  GError                   *error  = NULL;
-  struct YtsCLChannelData *d      = data;
-
-  if (!(ch = tp_yts_client_request_channel_finish (client, res, &error)))
-    {
-      guint32   a;
-      YtsError e;
-
-      a = yts_error_get_atom (d->error);
-
-      g_warning ("Failed to open outgoing channel: %s", error->message);
-      g_clear_error (&error);
-
-      e = yts_error_make (a, YTS_ERROR_NO_MSG_CHANNEL);
 
-      yts_client_emit_error (d->client, e);
-    }
-  else
+  if (NULL == priv->transport)
     {
-      g_message ("Got message channel, sending request");
-
-      tp_yts_channel_connect_to_replied (ch, yts_client_msg_replied_cb,
-                                         yts_cl_channel_data_ref (d),
-                                         NULL, NULL, NULL);
-      tp_yts_channel_connect_to_failed (ch, yts_client_msg_failed_cb,
-                                        yts_cl_channel_data_ref (d),
-                                        NULL, NULL, NULL);
-      tp_cli_channel_connect_to_closed (TP_CHANNEL (ch),
-                                        yts_client_msg_closed_cb,
-                                        yts_cl_channel_data_ref (d),
-                                        NULL, NULL, NULL);
-
-      tp_yts_channel_request_async (ch, NULL, yts_client_msg_request_cb, NULL);
+      priv->send_failures++;
+      return yts_error_new (YTS_ERROR_NO_MSG_CHANNEL);
     }
 
-  yts_cl_channel_data_unref (d);
-}
-
-static YtsError
-yts_client_dispatch_message (struct YtsCLChannelData *d)
-{
-  TpContact         *tp_contact;
-  YtsClientPrivate *priv = GET_PRIVATE (d->client);
-
-  g_message ("Dispatching delayed message to %s", d->service_id);
-
-  tp_contact = yts_contact_get_tp_contact (d->contact);
-  g_assert (tp_contact);
-
-  tp_yts_client_request_channel_async (priv->tp_client,
-                                       tp_contact,
-                                       d->service_id,
-                                       TP_YTS_REQUEST_TYPE_GET,
-                                       d->attrs,
-                                       d->xml,
-                                       NULL,
-                                       yts_client_outgoing_channel_cb,
-                                       d);
-
-  return d->error;
-}
-
-static void
-yts_client_notify_tp_contact_cb (YtsContact              *contact,
-                                  GParamSpec               *pspec,
-                                  struct YtsCLChannelData *d)
-{
-  g_message ("Contact ready");
-  yts_client_dispatch_message (d);
-  g_signal_handlers_disconnect_by_func (contact,
-                                        yts_client_notify_tp_contact_cb,
-                                        d);
-}
-
-YtsError
-yts_client_send_message (YtsClient   *client,
-                           YtsContact  *contact,
-                           char const   *service_id,
-                           YtsMetadata *message)
-{
-  GHashTable               *attrs;
-  struct YtsCLChannelData *d;
-  YtsError                 e;
-  char                     *xml = NULL;
-
-  if (!(attrs = yts_metadata_extract (message, &xml)))
+  /* Sent when the connection is back. */
+  if (priv->offline)
     {
-      g_warning ("Failed to extract content from YtsMessage object");
-
-      e = yts_error_new (YTS_ERROR_INVALID_PARAMETER);
-      g_free (xml);
-      return e;
+      return replay_queue_push (client, contact, service_id, message);
     }
 
-  e = yts_error_new (YTS_ERROR_PENDING);
-
-  d              = g_new (struct YtsCLChannelData, 1);
-  d->error       = e;
-  d->client      = client;
-  d->contact     = contact;
-  d->status_done = FALSE;
-  d->ref_count   = 1;
-  d->attrs       = attrs;
-  d->xml         = xml;
-  d->service_id  = g_strdup (service_id);
-
-  if (yts_contact_get_tp_contact (contact))
-    {
-      yts_client_dispatch_message (d);
-    }
-  else
+  error = yts_transport_send_message (priv->transport,
+                                      contact,
+                                      service_id,
+                                      message);
+  if (YTS_ERROR_SUCCESS != yts_error_get_code (error) &&
+      YTS_ERROR_PENDING != yts_error_get_code (error))
     {
-      g_message ("Contact not ready, postponing message dispatch");
-
-      g_signal_connect (contact, "notify::tp-contact",
-                        G_CALLBACK (yts_client_notify_tp_contact_cb),
-                        d);
+      priv->send_failures++;
     }
 
-  return e;
+  return error;
 }
 
 static void
@@ -3133,6 +4546,13 @@ _adapter_event (YtsServiceAdapter  *adapter,
 
   /* Dispatch to all registered proxies. */
   proxy_list = g_hash_table_lookup (priv->proxies, fqc_id);
+
+  if (YTS_PROBE_ENABLED (event__send)) {
+    YTS_PROBE3 (event__send,
+                fqc_id, aspect,
+                proxy_list ? g_list_length (proxy_list->list) : 0);
+  }
+
   if (proxy_list) {
     GList const *iter;
     for (iter = proxy_list->list; iter; iter = iter->next) {
@@ -25,7 +25,9 @@
 #include <stdint.h>
 #include <glib-object.h>
 #include <ytstenut/yts-capability.h>
+#include <ytstenut/yts-incoming-file-policy.h>
 #include <ytstenut/yts-roster.h>
+#include <ytstenut/yts-transfer-scheduler.h>
 
 G_BEGIN_DECLS
 
@@ -71,6 +73,23 @@ typedef enum { /*< prefix=YTS_PROTOCOL >*/
   YTS_PROTOCOL_LOCAL_XMPP
 } YtsProtocol;
 
+/**
+ * YtsSendQueuePolicy:
+ * @YTS_SEND_QUEUE_POLICY_REJECT_NEW: refuse new messages with
+ *                                    %YTS_ERROR_QUEUE_FULL.
+ * @YTS_SEND_QUEUE_POLICY_DROP_OLDEST: make room by failing the message that
+ *                                     has waited longest.
+ *
+ * What to do with messages to a contact that is not reachable yet, once
+ * #YtsClient:send-queue-high-water of them are waiting.
+ *
+ * Since: 0.4
+ */
+typedef enum { /*< prefix=YTS_SEND_QUEUE_POLICY >*/
+  YTS_SEND_QUEUE_POLICY_REJECT_NEW = 0,
+  YTS_SEND_QUEUE_POLICY_DROP_OLDEST
+} YtsSendQueuePolicy;
+
 YtsClient *
 yts_client_new_c2s (char const *account_id,
                     char const *service_id);
@@ -78,6 +97,11 @@ yts_client_new_c2s (char const *account_id,
 YtsClient *
 yts_client_new_p2p (char const *service_id);
 
+YtsClient *
+yts_client_new_loopback (char const *mesh_id,
+                         char const *contact_id,
+                         char const *service_id);
+
 void
 yts_client_disconnect (YtsClient *self);
 
@@ -106,6 +130,33 @@ yts_client_add_capability (YtsClient          *self,
 YtsRoster *const
 yts_client_get_roster (YtsClient const *self);
 
+YtsTransferScheduler *const
+yts_client_get_transfer_scheduler (YtsClient const *self);
+
+GVariant *
+yts_client_get_statistics (YtsClient *self);
+
+void
+yts_client_set_statistics_interval (YtsClient *self,
+                                    unsigned   interval);
+
+unsigned
+yts_client_get_statistics_interval (YtsClient const *self);
+
+GVariant *
+yts_client_get_latency_statistics (YtsClient *self);
+
+void
+yts_client_dump_latency_statistics (YtsClient *self);
+
+void
+yts_client_add_incoming_file_policy (YtsClient              *self,
+                                     YtsIncomingFilePolicy  *policy);
+
+bool
+yts_client_remove_incoming_file_policy (YtsClient              *self,
+                                        YtsIncomingFilePolicy  *policy);
+
 char const *
 yts_client_get_contact_id (YtsClient const *self);
 
@@ -0,0 +1,573 @@
+#!/usr/bin/env python
+#
+# Copyright (c) 2012 Intel Corp.
+#
+# This  library is free  software; you can  redistribute it and/or
+# modify it  under  the terms  of the  GNU Lesser  General  Public
+# License  as published  by the Free  Software  Foundation; either
+# version 2 of the License, or (at your option) any later version.
+#
+# This library is distributed  in the hope that it will be useful,
+# but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library. If not, see
+# <http://www.gnu.org/licenses/>.
+#
+# Authored by: Rob Staudinger <robsta@linux.intel.com>
+#
+
+"""
+Generate adapter and proxy glue from an interface description.
+
+The description is line based, '#' starts a comment:
+
+  interface <TypeName> <function_prefix> <header>
+  proxy <ProxyTypeName> <header>
+  property <name> <gvariant-type> readonly|readwrite
+  method <name> [<gvariant-type of the response>]
+
+For interface "YtsVPPlayer yts_vp_player", <output-dir>/<basename>-glue.h
+and <output-dir>/<basename>-glue.c are written, which provide
+
+  yts_vp_player_aspect_from_string()
+      maps an aspect name to an enum value using a perfect hash, so
+      dispatch is a single switch instead of a chain of string comparisons.
+
+  yts_vp_player_glue_invoke()
+  yts_vp_player_glue_collect_properties()
+  yts_vp_player_glue_connect_adapter()
+      type checked unmarshalling of invocations into the interface's
+      setters and methods, and marshalling of properties, change
+      notifications and method responses, for the adapter side.
+
+  yts_vp_player_glue_dispatch_event()
+      type checked unmarshalling of events into the proxy's setters.
+
+Properties are accessed through <prefix>_get_<name>() and
+<prefix>_set_<name>(). Methods without a response type are called as
+<prefix>_<name>(self), methods with one as <prefix>_<name>(self,
+invocation_id) and need to emit a "<name>-response" signal.
+"""
+
+from __future__ import print_function
+
+import optparse
+import os
+import sys
+
+# GVariant type -> (C argument type, C return type, constructor, getter,
+#                   free function for the getter's return value)
+TYPES = {
+  'b':  ('bool', 'bool',
+         'g_variant_new_boolean (%s)', 'g_variant_get_boolean (%s)', None),
+  'i':  ('int32_t', 'int32_t',
+         'g_variant_new_int32 (%s)', 'g_variant_get_int32 (%s)', None),
+  'u':  ('uint32_t', 'uint32_t',
+         'g_variant_new_uint32 (%s)', 'g_variant_get_uint32 (%s)', None),
+  'x':  ('int64_t', 'int64_t',
+         'g_variant_new_int64 (%s)', 'g_variant_get_int64 (%s)', None),
+  't':  ('uint64_t', 'uint64_t',
+         'g_variant_new_uint64 (%s)', 'g_variant_get_uint64 (%s)', None),
+  'd':  ('double', 'double',
+         'g_variant_new_double (%s)', 'g_variant_get_double (%s)', None),
+  's':  ('char const *', 'char *',
+         'g_variant_new_string (%s)', 'g_variant_get_string (%s, NULL)',
+         'g_free'),
+  'as': ('char const *const *', 'char **',
+         'g_variant_new_strv ((char const *const *) %s, -1)',
+         'g_variant_get_strv (%s, NULL)', 'g_strfreev'),
+}
+
+class Error(Exception):
+  pass
+
+class Property(object):
+  def __init__(self, name, type_, writable):
+    self.name = name
+    self.type = type_
+    self.writable = writable
+
+class Method(object):
+  def __init__(self, name, return_type):
+    self.name = name
+    self.return_type = return_type
+
+class Interface(object):
+  def __init__(self):
+    self.type_name = None
+    self.prefix = None
+    self.header = None
+    self.proxy_type_name = None
+    self.proxy_header = None
+    self.properties = []
+    self.methods = []
+
+  def aspects(self):
+    return [p.name for p in self.properties] + [m.name for m in self.methods]
+
+def identifier(name):
+  return name.replace('-', '_')
+
+def parse(path):
+  iface = Interface()
+  f = open(path)
+  for lineno, line in enumerate(f, 1):
+    words = line.split('#', 1)[0].split()
+    if not words:
+      continue
+    where = '%s:%d' % (path, lineno)
+    keyword, args = words[0], words[1:]
+    if keyword == 'interface' and len(args) == 3:
+      iface.type_name, iface.prefix, iface.header = args
+    elif keyword == 'proxy' and len(args) == 2:
+      iface.proxy_type_name, iface.proxy_header = args
+    elif keyword == 'property' and len(args) == 3:
+      name, type_, access = args
+      if type_ not in TYPES:
+        raise Error('%s: unsupported type "%s"' % (where, type_))
+      if access not in ('readonly', 'readwrite'):
+        raise Error('%s: unknown access "%s"' % (where, access))
+      iface.properties.append(Property(name, type_, access == 'readwrite'))
+    elif keyword == 'method' and len(args) in (1, 2):
+      return_type = args[1] if len(args) == 2 else None
+      if return_type and return_type not in TYPES:
+        raise Error('%s: unsupported type "%s"' % (where, return_type))
+      iface.methods.append(Method(args[0], return_type))
+    else:
+      raise Error('%s: syntax error' % where)
+  f.close()
+
+  if not iface.type_name or not iface.proxy_type_name:
+    raise Error('%s: "interface" and "proxy" are required' % path)
+  aspects = iface.aspects()
+  if len(set(aspects)) != len(aspects):
+    raise Error('%s: duplicate aspect names' % path)
+  return iface
+
+#
+# Perfect hash, FNV-1a with a seed, see aspect_from_string in the C template.
+#
+
+def fnv1a(name, seed):
+  h = (2166136261 ^ seed) & 0xffffffff
+  for c in name.encode('utf-8'):
+    if not isinstance(c, int):
+      c = ord(c)
+    h ^= c
+    h = (h * 16777619) & 0xffffffff
+  return h
+
+def perfect_hash(names):
+  size = max(len(names), 1)
+  while True:
+    for seed in range(0, 1 << 16):
+      slots = set(fnv1a(n, seed) % size for n in names)
+      if len(slots) == len(names):
+        return seed, size
+    size += 1
+
+#
+# Output
+#
+
+class Writer(object):
+  def __init__(self, iface, source):
+    self.iface = iface
+    self.source = source
+    self.lines = []
+
+  def __call__(self, text=''):
+    self.lines.append(text)
+
+  def write(self, path):
+    f = open(path, 'w')
+    f.write('\n'.join(self.lines) + '\n')
+    f.close()
+
+  def banner(self):
+    self('/*')
+    self(' * Generated by yts-codegen.py from %s, do not edit.' % self.source)
+    self(' */')
+    self()
+
+def declare(type_, name):
+  """'char const *' and 'value' -> 'char const *value'."""
+  return '%s%s%s' % (type_, '' if type_.endswith('*') else ' ', name)
+
+def signature(w, name, params, end=''):
+  """Emit a function name and its parameters, one per line, with the
+  types and the names lined up in columns."""
+  split = []
+  for type_, param in params:
+    base = type_.rstrip('* ')
+    split.append((base, type_[len(base):].strip(), param))
+  base_width = max(len(base) for base, stars, param in split)
+  star_width = max(len(stars) for base, stars, param in split)
+  indent = ' ' * (len(name) + 2)
+  for i, (base, stars, param) in enumerate(split):
+    head = '%s (' % name if i == 0 else indent
+    tail = ')' + end if i == len(split) - 1 else ','
+    w('%s%s %s%s%s%s' % (head, base.ljust(base_width),
+                         ' ' * (star_width - len(stars)), stars, param, tail))
+
+def aspect_enum(iface, name):
+  return '%s_ASPECT_%s' % (iface.prefix.upper(), identifier(name).upper())
+
+def invoke_params(iface):
+  return [('%s *' % iface.type_name, 'self'),
+          ('char const *', 'invocation_id'),
+          ('char const *', 'aspect'),
+          ('GVariant *', 'arguments'),
+          ('bool *', 'keep_sae')]
+
+def connect_params(iface):
+  return [('%s *' % iface.type_name, 'self'),
+          ('YtsServiceAdapter *', 'adapter')]
+
+def dispatch_params(iface):
+  return [('%s *' % iface.proxy_type_name, 'self'),
+          ('%sGlue const *' % iface.proxy_type_name, 'glue'),
+          ('char const *', 'aspect'),
+          ('GVariant *', 'arguments')]
+
+def write_header(iface, source, path):
+  prefix = iface.prefix
+  guard = '%s_GLUE_H' % prefix.upper()
+  w = Writer(iface, source)
+  w.banner()
+  w('#ifndef %s' % guard)
+  w('#define %s' % guard)
+  w()
+  w('#include <stdbool.h>')
+  w('#include <stdint.h>')
+  w('#include <glib-object.h>')
+  w('#include <ytstenut/yts-service-adapter.h>')
+  w('#include <%s>' % iface.header)
+  w('#include <%s>' % iface.proxy_header)
+  w()
+  w('G_BEGIN_DECLS')
+  w()
+  w('typedef enum {')
+  w('  %s_ASPECT_INVALID = -1,' % prefix.upper())
+  for name in iface.aspects():
+    w('  %s,' % aspect_enum(iface, name))
+  w('  %s_N_ASPECTS' % prefix.upper())
+  w('} %sAspect;' % iface.type_name)
+  w()
+  w('%sAspect' % iface.type_name)
+  w('%s_aspect_from_string (char const *aspect);' % prefix)
+  w()
+  w('char const *')
+  w('%s_aspect_to_string (%sAspect aspect);' % (prefix, iface.type_name))
+  w()
+  w('/* Adapter side */')
+  w()
+  w('bool')
+  signature(w, '%s_glue_invoke' % prefix, invoke_params(iface), ';')
+  w()
+  w('GVariant *')
+  w('%s_glue_collect_properties (%s *self);' % (prefix, iface.type_name))
+  w()
+  w('void')
+  signature(w, '%s_glue_connect_adapter' % prefix, connect_params(iface), ';')
+  w()
+  w('/* Proxy side */')
+  w()
+  w('typedef struct {')
+  for p in iface.properties:
+    w('  void (*set_%s) (%s *self, %s);' % (
+      identifier(p.name), iface.proxy_type_name,
+      declare(TYPES[p.type][0], identifier(p.name))))
+  if not iface.properties:
+    w('  void *unused;')
+  w('} %sGlue;' % iface.proxy_type_name)
+  w()
+  w('bool')
+  signature(w, '%s_glue_dispatch_event' % prefix, dispatch_params(iface), ';')
+  w()
+  w('G_END_DECLS')
+  w()
+  w('#endif /* %s */' % guard)
+  w.write(path)
+
+def write_unmarshal(w, indent, type_, call):
+  """Emit code passing 'arguments' to call % value."""
+  getter = TYPES[type_][3] % 'arguments'
+  if type_ == 'as':
+    w('%schar const **value = %s;' % (indent, getter))
+    w('%s%s;' % (indent, call % '(char const *const *) value'))
+    w('%sg_free (value); /* See g_variant_get_strv(). */' % indent)
+  else:
+    w('%s%s;' % (indent, call % getter))
+
+def write_source(iface, source, header_name, path):
+  prefix = iface.prefix
+  type_name = iface.type_name
+  aspects = iface.aspects()
+  seed, size = perfect_hash(aspects)
+  slots = [None] * size
+  for name in aspects:
+    slots[fnv1a(name, seed) % size] = name
+
+  w = Writer(iface, source)
+  w.banner()
+  w('#include "config.h"')
+  w()
+  w('#include <string.h>')
+  w()
+  w('#include "%s"' % header_name)
+  w()
+
+  # Aspect names
+
+  w('static char const *const _aspect_names[] = {')
+  for name in aspects:
+    w('  "%s",' % name)
+  w('  NULL')
+  w('};')
+  w()
+  w('/* Perfect hash over the aspect names. */')
+  w('static signed char const _aspect_slots[%d] = {' % size)
+  for name in slots:
+    w('  %s,' % (aspect_enum(iface, name) if name else
+                 '%s_ASPECT_INVALID' % prefix.upper()))
+  w('};')
+  w()
+  w('%sAspect' % type_name)
+  w('%s_aspect_from_string (char const *aspect)' % prefix)
+  w('{')
+  w('  uint32_t hash = 2166136261u ^ %du;' % seed)
+  w('  char const *p;')
+  w('  int i;')
+  w()
+  w('  if (NULL == aspect) {')
+  w('    return %s_ASPECT_INVALID;' % prefix.upper())
+  w('  }')
+  w()
+  w('  for (p = aspect; *p; p++) {')
+  w('    hash ^= (unsigned char) *p;')
+  w('    hash *= 16777619u;')
+  w('  }')
+  w()
+  w('  i = _aspect_slots[hash %% %d];' % size)
+  w('  if (i >= 0 &&')
+  w('      0 == strcmp (_aspect_names[i], aspect)) {')
+  w('    return (%sAspect) i;' % type_name)
+  w('  }')
+  w()
+  w('  return %s_ASPECT_INVALID;' % prefix.upper())
+  w('}')
+  w()
+  w('char const *')
+  w('%s_aspect_to_string (%sAspect aspect)' % (prefix, type_name))
+  w('{')
+  w('  g_return_val_if_fail (aspect >= 0 && aspect < %s_N_ASPECTS, NULL);'
+    % prefix.upper())
+  w()
+  w('  return _aspect_names[aspect];')
+  w('}')
+  w()
+
+  # Adapter side
+
+  w('/*')
+  w(' * Adapter side')
+  w(' */')
+  w()
+  w('bool')
+  signature(w, '%s_glue_invoke' % prefix, invoke_params(iface))
+  w('{')
+  w('  switch (%s_aspect_from_string (aspect)) {' % prefix)
+  w()
+  for p in iface.properties:
+    if not p.writable:
+      continue
+    w('    case %s:' % aspect_enum(iface, p.name))
+    w('      if (arguments &&')
+    w('          g_variant_is_of_type (arguments, G_VARIANT_TYPE ("%s"))) {'
+      % p.type)
+    write_unmarshal(w, '        ', p.type,
+                    '%s_set_%s (self, %%s)' % (prefix, identifier(p.name)))
+    w('        return true;')
+    w('      }')
+    w('      break;')
+    w()
+  for m in iface.methods:
+    w('    case %s:' % aspect_enum(iface, m.name))
+    if m.return_type:
+      w('      %s_%s (self, invocation_id);' % (prefix, identifier(m.name)))
+      w('      /* Responds through the "%s-response" signal,' % m.name)
+      w('       * so keep the return envelope. */')
+      w('      *keep_sae = true;')
+    else:
+      w('      %s_%s (self);' % (prefix, identifier(m.name)))
+    w('      return true;')
+    w()
+  w('    default:')
+  w('      break;')
+  w('  }')
+  w()
+  w('  return false;')
+  w('}')
+  w()
+
+  w('/*')
+  w(' * Returns floating reference, or NULL if the property is unset.')
+  w(' */')
+  w('static GVariant *')
+  signature(w, 'get_property_variant', [('%s *' % type_name, 'self'),
+                                        ('%sAspect' % type_name, 'aspect')])
+  w('{')
+  w('  GVariant *variant = NULL;')
+  w()
+  w('  switch (aspect) {')
+  w()
+  for p in iface.properties:
+    arg_type, ret_type, ctor, getter, free = TYPES[p.type]
+    w('    case %s: {' % aspect_enum(iface, p.name))
+    w('      %s = %s_get_%s (self);' % (declare(ret_type, 'value'), prefix,
+                                          identifier(p.name)))
+    if free:
+      w('      if (value) {')
+      w('        variant = %s;' % (ctor % 'value'))
+      w('        %s (value);' % free)
+      w('      }')
+    else:
+      w('      variant = %s;' % (ctor % 'value'))
+    w('    } break;')
+    w()
+  w('    default:')
+  w('      break;')
+  w('  }')
+  w()
+  w('  return variant;')
+  w('}')
+  w()
+
+  w('GVariant *')
+  w('%s_glue_collect_properties (%s *self)' % (prefix, type_name))
+  w('{')
+  w('  GVariantBuilder builder;')
+  w()
+  w('  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));')
+  w()
+  for p in iface.properties:
+    w('  {')
+    w('    GVariant *value = get_property_variant (self, %s);'
+      % aspect_enum(iface, p.name))
+    w('    if (value) {')
+    w('      g_variant_builder_add (&builder, "{sv}", "%s", value);' % p.name)
+    w('    }')
+    w('  }')
+    w()
+  w('  return g_variant_builder_end (&builder);')
+  w('}')
+  w()
+
+  w('static void')
+  signature(w, '_notify', [('%s *' % type_name, 'self'),
+                           ('GParamSpec *', 'pspec'),
+                           ('YtsServiceAdapter *', 'adapter')])
+  w('{')
+  w('  %sAspect aspect = %s_aspect_from_string (pspec->name);'
+    % (type_name, prefix))
+  w('  GVariant *value = get_property_variant (self, aspect);')
+  w()
+  w('  if (value) {')
+  w('    yts_service_adapter_send_event (adapter, pspec->name, value);')
+  w('  }')
+  w('}')
+  w()
+
+  for m in iface.methods:
+    if not m.return_type:
+      continue
+    arg_type = TYPES[m.return_type][0]
+    ctor = TYPES[m.return_type][2]
+    w('static void')
+    signature(w, '_%s_response' % identifier(m.name),
+              [('%s *' % type_name, 'self'),
+               ('char const *', 'invocation_id'),
+               (arg_type, 'return_value'),
+               ('YtsServiceAdapter *', 'adapter')])
+    w('{')
+    w('  yts_service_adapter_send_response (adapter,')
+    w('                                     invocation_id,')
+    w('                                     %s);' % (ctor % 'return_value'))
+    w('}')
+    w()
+
+  w('void')
+  signature(w, '%s_glue_connect_adapter' % prefix, connect_params(iface))
+  w('{')
+  for p in iface.properties:
+    w('  g_signal_connect_object (self, "notify::%s",' % p.name)
+    w('                           G_CALLBACK (_notify), adapter, 0);')
+  for m in iface.methods:
+    if not m.return_type:
+      continue
+    w('  g_signal_connect_object (self, "%s-response",' % m.name)
+    w('                           G_CALLBACK (_%s_response), adapter, 0);'
+      % identifier(m.name))
+  w('}')
+  w()
+
+  # Proxy side
+
+  w('/*')
+  w(' * Proxy side')
+  w(' */')
+  w()
+  w('bool')
+  signature(w, '%s_glue_dispatch_event' % prefix, dispatch_params(iface))
+  w('{')
+  w('  switch (%s_aspect_from_string (aspect)) {' % prefix)
+  w()
+  for p in iface.properties:
+    w('    case %s:' % aspect_enum(iface, p.name))
+    w('      if (arguments &&')
+    w('          g_variant_is_of_type (arguments, G_VARIANT_TYPE ("%s"))) {'
+      % p.type)
+    write_unmarshal(w, '        ', p.type,
+                    'glue->set_%s (self, %%s)' % identifier(p.name))
+    w('        return true;')
+    w('      }')
+    w('      break;')
+    w()
+  w('    default:')
+  w('      break;')
+  w('  }')
+  w()
+  w('  return false;')
+  w('}')
+  w.write(path)
+
+def main(argv):
+  parser = optparse.OptionParser(usage='%prog [options] INTERFACE-FILE...')
+  parser.add_option('--output-dir', default='.',
+                    help='directory to write the glue files to')
+  options, args = parser.parse_args(argv[1:])
+  if not args:
+    parser.error('no interface description given')
+
+  for path in args:
+    try:
+      iface = parse(path)
+    except Error as e:
+      print('yts-codegen.py: %s' % e, file=sys.stderr)
+      return 1
+    basename = os.path.splitext(os.path.basename(path))[0]
+    header_name = '%s-glue.h' % basename
+    source = os.path.basename(path)
+    write_header(iface, source,
+                 os.path.join(options.output_dir, header_name))
+    write_source(iface, source, header_name,
+                 os.path.join(options.output_dir, '%s-glue.c' % basename))
+
+  return 0
+
+if __name__ == '__main__':
+  sys.exit(main(sys.argv))
@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include "yts-contact-impl.h"
+#include "yts-enum-types.h"
 #include "yts-marshal.h"
 
 G_DEFINE_TYPE (YtsContactImpl, yts_contact_impl, YTS_TYPE_CONTACT)
@@ -30,6 +31,7 @@ G_DEFINE_TYPE (YtsContactImpl, yts_contact_impl, YTS_TYPE_CONTACT)
 enum {
   SIG_SEND_MESSAGE,
   SIG_SEND_FILE,
+  SIG_SEND_STREAM,
 
   N_SIGNALS
 };
@@ -60,12 +62,28 @@ yts_contact_impl_class_init (YtsContactImplClass *klass)
                                           G_TYPE_FROM_CLASS (object_class),
                                           G_SIGNAL_RUN_LAST,
                                           0, NULL, NULL,
-                                          yts_marshal_OBJECT__OBJECT_OBJECT_STRING_POINTER,
-                                          YTS_TYPE_OUTGOING_FILE, 4,
+                                          yts_marshal_OBJECT__OBJECT_OBJECT_STRING_ENUM_POINTER,
+                                          YTS_TYPE_OUTGOING_FILE, 5,
                                           YTS_TYPE_SERVICE,
                                           G_TYPE_FILE,
                                           G_TYPE_STRING,
+                                          YTS_TYPE_TRANSFER_PRIORITY,
                                           G_TYPE_POINTER);
+
+  _signals[SIG_SEND_STREAM] = g_signal_new ("send-stream",
+                                            G_TYPE_FROM_CLASS (object_class),
+                                            G_SIGNAL_RUN_LAST,
+                                            0, NULL, NULL,
+                                            yts_marshal_OBJECT__OBJECT_OBJECT_UINT64_STRING_STRING_STRING_ENUM_POINTER,
+                                            YTS_TYPE_OUTGOING_FILE, 8,
+                                            YTS_TYPE_SERVICE,
+                                            G_TYPE_INPUT_STREAM,
+                                            G_TYPE_UINT64,
+                                            G_TYPE_STRING,
+                                            G_TYPE_STRING,
+                                            G_TYPE_STRING,
+                                            YTS_TYPE_TRANSFER_PRIORITY,
+                                            G_TYPE_POINTER);
 }
 
 static void
@@ -81,6 +99,14 @@ yts_contact_impl_new (TpContact *tp_contact)
                        NULL);
 }
 
+YtsContact *
+yts_contact_impl_new_for_id (char const *contact_id)
+{
+  return g_object_new (YTS_TYPE_CONTACT_IMPL,
+                       "id", contact_id,
+                       NULL);
+}
+
 void
 yts_contact_impl_send_message (YtsContactImpl *self,
                                YtsService     *service,
@@ -95,19 +121,41 @@ yts_contact_impl_send_message (YtsContactImpl *self,
 }
 
 YtsOutgoingFile *
-yts_contact_impl_send_file (YtsContactImpl   *self,
-                            YtsService       *service,
-                            GFile            *file,
-                            char const       *description,
-                            GError          **error_out)
+yts_contact_impl_send_file (YtsContactImpl     *self,
+                            YtsService         *service,
+                            GFile              *file,
+                            char const         *description,
+                            YtsTransferPriority priority,
+                            GError            **error_out)
 {
   YtsOutgoingFile *transfer;
 
   transfer = NULL;
   g_signal_emit (self, _signals[SIG_SEND_FILE], 0,
-                 service, file, description, error_out,
+                 service, file, description, priority, error_out,
                  &transfer);
 
   return transfer;
 }
 
+YtsOutgoingFile *
+yts_contact_impl_send_stream (YtsContactImpl     *self,
+                              YtsService         *service,
+                              GInputStream       *stream,
+                              uint64_t            size,
+                              char const         *name,
+                              char const         *content_type,
+                              char const         *description,
+                              YtsTransferPriority priority,
+                              GError            **error_out)
+{
+  YtsOutgoingFile *transfer;
+
+  transfer = NULL;
+  g_signal_emit (self, _signals[SIG_SEND_STREAM], 0,
+                 service, stream, size, name, content_type, description,
+                 priority, error_out,
+                 &transfer);
+
+  return transfer;
+}
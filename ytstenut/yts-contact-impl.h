@@ -21,12 +21,14 @@
 #ifndef YTS_CONTACT_IMPL_H
 #define YTS_CONTACT_IMPL_H
 
+#include <stdint.h>
 #include <glib-object.h>
 #include <gio/gio.h>
 #include <telepathy-glib/contact.h>
 #include <ytstenut/yts-contact-internal.h>
 #include <ytstenut/yts-metadata.h>
 #include <ytstenut/yts-outgoing-file.h>
+#include <ytstenut/yts-transfer-scheduler.h>
 
 G_BEGIN_DECLS
 
@@ -61,17 +63,32 @@ yts_contact_impl_get_type (void) G_GNUC_CONST;
 YtsContact *
 yts_contact_impl_new (TpContact *tp_contact);
 
+YtsContact *
+yts_contact_impl_new_for_id (char const *contact_id);
+
 void
 yts_contact_impl_send_message (YtsContactImpl *self,
                                YtsService     *service,
                                YtsMetadata    *message);
 
 YtsOutgoingFile *
-yts_contact_impl_send_file (YtsContactImpl   *self,
-                            YtsService       *service,
-                            GFile            *file,
-                            char const       *description,
-                            GError          **error_out);
+yts_contact_impl_send_file (YtsContactImpl     *self,
+                            YtsService         *service,
+                            GFile              *file,
+                            char const         *description,
+                            YtsTransferPriority priority,
+                            GError            **error_out);
+
+YtsOutgoingFile *
+yts_contact_impl_send_stream (YtsContactImpl     *self,
+                              YtsService         *service,
+                              GInputStream       *stream,
+                              uint64_t            size,
+                              char const         *name,
+                              char const         *content_type,
+                              char const         *description,
+                              YtsTransferPriority priority,
+                              GError            **error_out);
 
 G_END_DECLS
 
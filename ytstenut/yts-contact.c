@@ -34,6 +34,7 @@
 #include "yts-contact-internal.h"
 #include "yts-enum-types.h"
 #include "yts-error.h"
+#include "yts-invocation-message.h"
 #include "yts-marshal.h"
 #include "yts-proxy-service-internal.h"
 #include "yts-service-internal.h"
@@ -55,11 +56,21 @@ G_DEFINE_ABSTRACT_TYPE (YtsContact, yts_contact, G_TYPE_OBJECT)
  * and provides access to any services (#YtsService) available on the device.
  */
 
+/* Number of outstanding invocations tracked per generation, see
+ * track_invocation(). */
+#define MAX_TRACKED_INVOCATIONS 128
+
 typedef struct {
   GHashTable   *services;   /* hash of YtsService instances */
   /* string (service ID) => GHashTable<string fqc_id => string status_xml> */
   GHashTable   *deferred_service_statuses;
   TpContact    *tp_contact; /* TpContact associated with YtsContact */
+  char         *id;         /* for contacts without TpContact */
+  /* GQuark (fqc_id) => GPtrArray<YtsProxyService>, not owned. */
+  GHashTable   *proxy_services;
+  /* string (invocation ID) => YtsProxyService, not owned. */
+  GHashTable   *invocations;
+  GHashTable   *invocations_previous;
 } YtsContactPrivate;
 
 enum {
@@ -88,22 +99,153 @@ _tp_contact_notify_alias (GObject     *tp_contact,
   g_object_notify (G_OBJECT (self), "name");
 }
 
+static GPtrArray *
+lookup_proxy_services (YtsContact *self,
+                       char const *fqc_id)
+{
+  YtsContactPrivate *priv = GET_PRIVATE (self);
+  GQuark quark;
+
+  /* Capabilities never seen before can not be in the index. */
+  quark = fqc_id ? g_quark_try_string (fqc_id) : 0;
+  if (0 == quark) {
+    return NULL;
+  }
+
+  return g_hash_table_lookup (priv->proxy_services, GUINT_TO_POINTER (quark));
+}
+
+static void
+index_proxy_service (YtsContact       *self,
+                     YtsProxyService  *service)
+{
+  YtsContactPrivate *priv = GET_PRIVATE (self);
+  char     **fqc_ids;
+  unsigned   i;
+
+  fqc_ids = yts_capability_get_fqc_ids (YTS_CAPABILITY (service));
+  for (i = 0; fqc_ids && fqc_ids[i]; i++) {
+    void *key = GUINT_TO_POINTER (g_quark_from_string (fqc_ids[i]));
+    GPtrArray *services = g_hash_table_lookup (priv->proxy_services, key);
+    if (NULL == services) {
+      services = g_ptr_array_new ();
+      g_hash_table_insert (priv->proxy_services, key, services);
+    }
+    g_ptr_array_add (services, service);
+  }
+  g_strfreev (fqc_ids);
+}
+
+static bool
+_remove_proxy_service (void       *key,
+                       GPtrArray  *services,
+                       void       *service)
+{
+  g_ptr_array_remove_fast (services, service);
+
+  return services->len == 0;
+}
+
+static bool
+_is_service (void *key,
+             void *value,
+             void *service)
+{
+  return value == service;
+}
+
+static void
+unindex_proxy_service (YtsContact       *self,
+                       YtsProxyService  *service)
+{
+  YtsContactPrivate *priv = GET_PRIVATE (self);
+
+  g_hash_table_foreach_remove (priv->proxy_services,
+                               (GHRFunc) _remove_proxy_service,
+                               service);
+  g_hash_table_foreach_remove (priv->invocations,
+                               (GHRFunc) _is_service,
+                               service);
+  g_hash_table_foreach_remove (priv->invocations_previous,
+                               (GHRFunc) _is_service,
+                               service);
+}
+
+/*
+ * Remember which service an invocation has been sent from, so the
+ * response can be routed back directly. Not every invocation is
+ * answered, so entries are kept in two generations: once the current one
+ * is full, the previous one is dropped. Responses for invocations
+ * forgotten that way are still routed by capability.
+ */
+static void
+track_invocation (YtsContact      *self,
+                  YtsProxyService *service,
+                  char const      *invocation_id)
+{
+  YtsContactPrivate *priv = GET_PRIVATE (self);
+
+  if (g_hash_table_size (priv->invocations) >= MAX_TRACKED_INVOCATIONS) {
+    GHashTable *previous = priv->invocations_previous;
+    g_hash_table_remove_all (previous);
+    priv->invocations_previous = priv->invocations;
+    priv->invocations = previous;
+  }
+
+  g_hash_table_insert (priv->invocations, g_strdup (invocation_id), service);
+}
+
+static YtsProxyService *
+take_invocation (YtsContact *self,
+                 char const *invocation_id)
+{
+  YtsContactPrivate *priv = GET_PRIVATE (self);
+  YtsProxyService *service;
+
+  if (NULL == invocation_id) {
+    return NULL;
+  }
+
+  service = g_hash_table_lookup (priv->invocations, invocation_id);
+  if (service) {
+    g_hash_table_remove (priv->invocations, invocation_id);
+    return service;
+  }
+
+  service = g_hash_table_lookup (priv->invocations_previous, invocation_id);
+  if (service) {
+    g_hash_table_remove (priv->invocations_previous, invocation_id);
+  }
+
+  return service;
+}
+
 static void
 _service_send_message (YtsService   *service,
                        YtsMetadata  *message,
                        YtsContact   *self)
 {
+  if (YTS_IS_PROXY_SERVICE (service) &&
+      YTS_IS_INVOCATION_MESSAGE (message)) {
+    char const *invocation_id = yts_metadata_get_attribute (message,
+                                                            "invocation");
+    if (invocation_id) {
+      track_invocation (self, YTS_PROXY_SERVICE (service), invocation_id);
+    }
+  }
+
   /* This is a bit of a hack, we require the non-abstract subclass to
    * implement this interface. */
   yts_contact_impl_send_message (YTS_CONTACT_IMPL (self), service, message);
 }
 
 static YtsOutgoingFile *
-_service_send_file (YtsService   *service,
-                    GFile        *file,
-                    char const   *description,
-                    GError      **error_out,
-                    YtsContact   *self)
+_service_send_file (YtsService         *service,
+                    GFile              *file,
+                    char const         *description,
+                    YtsTransferPriority priority,
+                    GError            **error_out,
+                    YtsContact         *self)
 {
   /* This is a bit of a hack, we require the non-abstract subclass to
    * implement this interface. */
@@ -111,9 +253,34 @@ _service_send_file (YtsService   *service,
                                      service,
                                      file,
                                      description,
+                                     priority,
                                      error_out);
 }
 
+static YtsOutgoingFile *
+_service_send_stream (YtsService         *service,
+                      GInputStream       *stream,
+                      uint64_t            size,
+                      char const         *name,
+                      char const         *content_type,
+                      char const         *description,
+                      YtsTransferPriority priority,
+                      GError            **error_out,
+                      YtsContact         *self)
+{
+  /* This is a bit of a hack, we require the non-abstract subclass to
+   * implement this interface. */
+  return yts_contact_impl_send_stream (YTS_CONTACT_IMPL (self),
+                                       service,
+                                       stream,
+                                       size,
+                                       name,
+                                       content_type,
+                                       description,
+                                       priority,
+                                       error_out);
+}
+
 static void
 _service_added (YtsContact  *self,
                 YtsService  *service,
@@ -123,7 +290,8 @@ _service_added (YtsContact  *self,
   const char        *service_id  = yts_service_get_id (service);
   GHashTable        *id_status_map;
 
-  DEBUG ("contact=%s service=%s", yts_contact_get_id (self), service_id);
+  YTS_NOTE (CONTACT, "contact=%s service=%s",
+            yts_contact_get_id (self), service_id);
 
   g_return_if_fail (service_id && *service_id);
   g_return_if_fail (!g_hash_table_lookup (priv->services, service_id));
@@ -136,6 +304,12 @@ _service_added (YtsContact  *self,
                     G_CALLBACK (_service_send_message), self);
   g_signal_connect (service, "send-file",
                     G_CALLBACK (_service_send_file), self);
+  g_signal_connect (service, "send-stream",
+                    G_CALLBACK (_service_send_stream), self);
+
+  if (YTS_IS_PROXY_SERVICE (service)) {
+    index_proxy_service (self, YTS_PROXY_SERVICE (service));
+  }
 
   /* Apply deferred status updates */
 
@@ -165,10 +339,16 @@ _service_removed (YtsContact  *self,
   YtsContactPrivate *priv = GET_PRIVATE (self);
   const char        *service_id  = yts_service_get_id (service);
 
-  DEBUG ("contact=%s service=%s", yts_contact_get_id (self), service_id);
+  YTS_NOTE (CONTACT, "contact=%s service=%s",
+            yts_contact_get_id (self), service_id);
 
   g_return_if_fail (service_id && *service_id);
 
+  /* Before dropping our reference. */
+  if (YTS_IS_PROXY_SERVICE (service)) {
+    unindex_proxy_service (self, YTS_PROXY_SERVICE (service));
+  }
+
   if (!g_hash_table_remove (priv->services, service_id))
     g_warning (G_STRLOC ": unknown service with service-id %s", service_id);
 
@@ -178,6 +358,9 @@ _service_removed (YtsContact  *self,
   g_signal_handlers_disconnect_by_func (service,
                                         _service_send_file,
                                         self);
+  g_signal_handlers_disconnect_by_func (service,
+                                        _service_send_stream,
+                                        self);
 }
 
 static void
@@ -195,7 +378,7 @@ _get_property (GObject    *object,
       break;
     case PROP_NAME:
       g_value_set_string (value,
-                          tp_contact_get_alias (priv->tp_contact));
+                          yts_contact_get_name (YTS_CONTACT (object)));
       break;
     case PROP_TP_CONTACT:
       g_value_set_object (value, priv->tp_contact);
@@ -215,11 +398,16 @@ _set_property (GObject      *object,
   YtsContactPrivate *priv = GET_PRIVATE (object);
 
   switch (property_id) {
+    case PROP_ID:
+      priv->id = g_value_dup_string (value);
+      break;
     case PROP_TP_CONTACT: {
-      g_return_if_fail (g_value_get_object (value));
+      /* Contacts reached over the loopback transport have none. */
       priv->tp_contact = g_value_dup_object (value);
-      g_signal_connect (priv->tp_contact, "notify::alias",
-                        G_CALLBACK (_tp_contact_notify_alias), object);
+      if (priv->tp_contact) {
+        g_signal_connect (priv->tp_contact, "notify::alias",
+                          G_CALLBACK (_tp_contact_notify_alias), object);
+      }
     } break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -245,6 +433,8 @@ _dispose (GObject *object)
               self);
           g_signal_handlers_disconnect_by_func (v, _service_send_file,
               self);
+          g_signal_handlers_disconnect_by_func (v, _service_send_stream,
+              self);
         }
 
       g_hash_table_destroy (priv->services);
@@ -256,6 +446,21 @@ _dispose (GObject *object)
     priv->deferred_service_statuses = NULL;
   }
 
+  if (priv->proxy_services) {
+    g_hash_table_destroy (priv->proxy_services);
+    priv->proxy_services = NULL;
+  }
+
+  if (priv->invocations) {
+    g_hash_table_destroy (priv->invocations);
+    priv->invocations = NULL;
+  }
+
+  if (priv->invocations_previous) {
+    g_hash_table_destroy (priv->invocations_previous);
+    priv->invocations_previous = NULL;
+  }
+
   // FIXME tie to tp_contact lifecycle
   if (priv->tp_contact)
     {
@@ -272,6 +477,10 @@ _dispose (GObject *object)
 static void
 _finalize (GObject *object)
 {
+  YtsContactPrivate *priv = GET_PRIVATE (object);
+
+  g_free (priv->id);
+
   G_OBJECT_CLASS (yts_contact_parent_class)->finalize (object);
 }
 
@@ -291,11 +500,13 @@ yts_contact_class_init (YtsContactClass *klass)
   /**
    * YtsContact:id:
    *
-   * The JID of this contact.
+   * The JID of this contact. Only set at construction time for contacts
+   * that are not backed by a #TpContact.
    */
   pspec = g_param_spec_string ("id", "", "",
                                NULL,
-                               G_PARAM_READABLE);
+                               G_PARAM_READWRITE |
+                               G_PARAM_CONSTRUCT_ONLY);
   g_object_class_install_property (object_class, PROP_ID, pspec);
 
   /**
@@ -376,6 +587,21 @@ yts_contact_init (YtsContact *self)
 
   priv->deferred_service_statuses = g_hash_table_new_full (g_str_hash,
       g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+
+  priv->proxy_services = g_hash_table_new_full (g_direct_hash,
+                                                g_direct_equal,
+                                                NULL,
+                                                (GDestroyNotify) g_ptr_array_unref);
+
+  priv->invocations = g_hash_table_new_full (g_str_hash,
+                                             g_str_equal,
+                                             g_free,
+                                             NULL);
+
+  priv->invocations_previous = g_hash_table_new_full (g_str_hash,
+                                                      g_str_equal,
+                                                      g_free,
+                                                      NULL);
 }
 
 /**
@@ -392,9 +618,10 @@ yts_contact_get_id (YtsContact const *self)
   YtsContactPrivate *priv = GET_PRIVATE (self);
 
   g_return_val_if_fail (YTS_IS_CONTACT (self), NULL);
-  g_return_val_if_fail (priv->tp_contact, NULL);
 
-  return tp_contact_get_identifier (priv->tp_contact);
+  return priv->tp_contact ?
+           tp_contact_get_identifier (priv->tp_contact) :
+           priv->id;
 }
 
 /**
@@ -413,9 +640,10 @@ yts_contact_get_name (YtsContact const *self)
   YtsContactPrivate *priv = GET_PRIVATE (self);
 
   g_return_val_if_fail (YTS_IS_CONTACT (self), NULL);
-  g_return_val_if_fail (priv->tp_contact, NULL);
 
-  return tp_contact_get_alias (priv->tp_contact);
+  return priv->tp_contact ?
+           tp_contact_get_alias (priv->tp_contact) :
+           priv->id;
 }
 
 /**
@@ -445,9 +673,9 @@ yts_contact_add_service (YtsContact *self,
   /*
    * Emit the signal; the run-first signal closure will do the rest
    */
-  g_message ("New service %s on %s",
-             yts_service_get_id (service),
-             yts_contact_get_id (self));
+  YTS_NOTE (CONTACT, "New service %s on %s",
+            yts_service_get_id (service),
+            yts_contact_get_id (self));
 
   g_signal_emit (self, _signals[SIG_SERVICE_ADDED], 0, service);
 }
@@ -468,7 +696,8 @@ yts_contact_remove_service_by_id (YtsContact  *self,
   YtsContactPrivate *priv = GET_PRIVATE (self);
   YtsService        *service;
 
-  DEBUG ("contact=%s service=%s", yts_contact_get_id (self), service_id);
+  YTS_NOTE (CONTACT, "contact=%s service=%s",
+            yts_contact_get_id (self), service_id);
 
   g_return_if_fail (service_id && *service_id);
 
@@ -503,29 +732,23 @@ yts_contact_dispatch_event (YtsContact  *self,
                              char const   *aspect,
                              GVariant     *arguments)
 {
-  YtsContactPrivate *priv = GET_PRIVATE (self);
-  char const      *service_id;
-  YtsService      *service;
-  GHashTableIter   iter;
-  bool             dispatched = FALSE;
+  GPtrArray *services;
+  unsigned   i;
+  bool       dispatched = FALSE;
 
   g_return_val_if_fail (YTS_IS_CONTACT (self), FALSE);
 
-  g_hash_table_iter_init (&iter, priv->services);
-  while (g_hash_table_iter_next (&iter,
-                                 (void **) &service_id,
-                                 (void **) &service)) {
-    if (YTS_IS_PROXY_SERVICE (service) &&
-        yts_capability_has_fqc_id (YTS_CAPABILITY (service), capability)) {
-
-      /* Dispatch to all matching services, be happy if one of them accepts. */
-      dispatched = dispatched ||
-              yts_proxy_service_dispatch_event (YTS_PROXY_SERVICE (service),
-                                                 capability,
-                                                 aspect,
-                                                 arguments);
-    }
+  services = lookup_proxy_services (self, capability);
+  for (i = 0; services && i < services->len; i++) {
+
+    /* Dispatch to all matching services, be happy if one of them accepts. */
+    dispatched = yts_proxy_service_dispatch_event (
+                                  YTS_PROXY_SERVICE (services->pdata[i]),
+                                  capability,
+                                  aspect,
+                                  arguments) || dispatched;
   }
+
   return dispatched;
 }
 
@@ -535,32 +758,37 @@ yts_contact_dispatch_response (YtsContact *self,
                                 char const  *invocation_id,
                                 GVariant    *response)
 {
-  YtsContactPrivate *priv = GET_PRIVATE (self);
-  char const      *service_id;
-  YtsService      *service;
-  GHashTableIter   iter;
-  bool             dispatched = FALSE;
+  YtsProxyService *service;
+  GPtrArray       *services;
+  unsigned         i;
 
   g_return_val_if_fail (YTS_IS_CONTACT (self), FALSE);
 
-  g_hash_table_iter_init (&iter, priv->services);
-  while (g_hash_table_iter_next (&iter,
-                                 (void **) &service_id,
-                                 (void **) &service)) {
-    if (YTS_IS_PROXY_SERVICE (service) &&
-        yts_capability_has_fqc_id (YTS_CAPABILITY (service), capability)) {
+  /* Straight back to where the invocation came from. */
+  service = take_invocation (self, invocation_id);
+  if (service &&
+      yts_proxy_service_dispatch_response (service,
+                                           capability,
+                                           invocation_id,
+                                           response)) {
+    return true;
+  }
 
+  /* Not tracked (any more), ask the services having the capability. */
+  services = lookup_proxy_services (self, capability);
+  for (i = 0; services && i < services->len; i++) {
+    if (services->pdata[i] != service &&
+        yts_proxy_service_dispatch_response (
+                                  YTS_PROXY_SERVICE (services->pdata[i]),
+                                  capability,
+                                  invocation_id,
+                                  response)) {
       /* Invocations are unique, so just go home after delivery. */
-      dispatched =
-            yts_proxy_service_dispatch_response (YTS_PROXY_SERVICE (service),
-                                                  capability,
-                                                  invocation_id,
-                                                  response);
-      if (dispatched)
-        break;
+      return true;
     }
   }
-  return dispatched;
+
+  return false;
 }
 
 void
@@ -572,13 +800,13 @@ yts_contact_update_service_status (YtsContact *self,
   YtsContactPrivate *priv = GET_PRIVATE (self);
   YtsService *service;
 
-  DEBUG ("contact=%s service=%s fqc=%s", yts_contact_get_id (self),
-      service_id, fqc_id);
+  YTS_NOTE (CONTACT, "contact=%s service=%s fqc=%s",
+            yts_contact_get_id (self), service_id, fqc_id);
   service = g_hash_table_lookup (priv->services, service_id);
 
   if (service != NULL)
     {
-      DEBUG ("Service already exists, updating status now");
+      YTS_NOTE (CONTACT, "Service already exists, updating status now");
       yts_service_update_status (service, fqc_id, status_xml);
     }
   else
@@ -590,7 +818,8 @@ yts_contact_update_service_status (YtsContact *self,
       GHashTable *id_status_map = g_hash_table_lookup (
           priv->deferred_service_statuses, service_id);
 
-      DEBUG ("Service does not already exist, saving its status for later");
+      YTS_NOTE (CONTACT,
+                "Service does not already exist, saving its status for later");
 
       if (id_status_map == NULL)
         {
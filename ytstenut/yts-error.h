@@ -39,6 +39,12 @@ G_BEGIN_DECLS
  * @YTS_ERROR_INVALID_PARAMETER: Invalid parameter supplied to function
  * @YTS_ERROR_NOT_ALLOWED: the operation is not allowed.
  * @YTS_ERROR_NO_ROUTE: no route to complete the operation
+ * @YTS_ERROR_NO_MSG_CHANNEL: no channel to send the message on
+ * @YTS_ERROR_QUEUE_FULL: the message was refused or dropped because too
+ * many are already waiting for the recipient, see
+ * #YtsClient:send-queue-high-water
+ * @YTS_ERROR_EXPIRED: the message waited for the recipient longer than
+ * #YtsClient:send-queue-expiry
  * @YTS_ERROR_UNKNOWN: some other,unspecified, error condition.
  * @YTS_ERROR_CUSTOM_START: custom error codes can start at this value
  * @YTS_ERROR_CUSTOM_END: custom error code must not exceed this value
@@ -57,6 +63,8 @@ typedef enum { /*< prefix=YTS_ERROR >*/
   YTS_ERROR_NOT_ALLOWED,
   YTS_ERROR_NO_ROUTE,
   YTS_ERROR_NO_MSG_CHANNEL,
+  YTS_ERROR_QUEUE_FULL,
+  YTS_ERROR_EXPIRED,
 
   /* Last predefined error code */
   YTS_ERROR_UNKNOWN      = 0x00007fff,
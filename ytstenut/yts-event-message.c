@@ -21,6 +21,7 @@
 
 #include <stdbool.h>
 
+#include "yts-metadata-internal.h"
 #include "yts-event-message.h"
 
 G_DEFINE_TYPE (YtsEventMessage, yts_event_message, YTS_TYPE_METADATA)
@@ -85,6 +86,7 @@ yts_event_message_new (char const  *capability,
                         GVariant    *arguments)
 {
   RestXmlNode *node;
+  YtsMetadata *message;
 
   node = rest_xml_node_add_child (NULL, "message");
   /* PONDERING need those keywords be made reserved */
@@ -92,18 +94,13 @@ yts_event_message_new (char const  *capability,
   rest_xml_node_add_attr (node, "capability", capability);
   rest_xml_node_add_attr (node, "aspect", aspect);
 
-  if (arguments) {
-    char *args = g_variant_print (arguments, false);
-    /* FIXME this is just a stopgap solution to lacking g_markup_unescape_text()
-     * want to move to complex message bodies anywy. */
-    char *escaped_args = g_uri_escape_string (args, NULL, true);
-    rest_xml_node_add_attr (node, "arguments", escaped_args);
-    g_free (escaped_args);
-    g_free (args);
-  }
+  message = g_object_new (YTS_TYPE_EVENT_MESSAGE,
+                          "top-level-node", node,
+                          NULL);
+
+  /* Serialised on demand only. */
+  yts_metadata_set_payload (message, "arguments", arguments);
 
-  return g_object_new (YTS_TYPE_EVENT_MESSAGE,
-                       "top-level-node", node,
-                       NULL);
+  return message;
 }
 
@@ -19,34 +19,11 @@
  */
 #include "config.h"
 
-#include <stdlib.h>
-#include <string.h>
-
+#include "yts-capability-registry-internal.h"
 #include "yts-factory.h"
 
-#include "video-profile/yts-vp-player-adapter.h"
-#include "video-profile/yts-vp-player-proxy.h"
-#include "video-profile/yts-vp-transcript-adapter.h"
-#include "video-profile/yts-vp-transcript-proxy.h"
-
 G_DEFINE_ABSTRACT_TYPE (YtsFactory, yts_factory, G_TYPE_OBJECT)
 
-typedef struct {
-  char const *fqc_id;
-  GType       adapter_gtype;
-  GType       proxy_gtype;
-} FactoryEntry;
-
-static GArray *_table = NULL;
-
-static int
-_factory_entry_compare (const void *fe1,
-                        const void *fe2)
-{
-  return strcmp (((FactoryEntry *) fe1)->fqc_id,
-                 ((FactoryEntry *) fe2)->fqc_id);
-}
-
 static void
 _dispose (GObject *object)
 {
@@ -58,26 +35,7 @@ yts_factory_class_init (YtsFactoryClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
-  FactoryEntry table[] = {
-    { "org.freedesktop.ytstenut.VideoProfile.Player",
-       yts_vp_player_adapter_get_type (),
-       yts_vp_player_proxy_get_type () },
-    { "org.freedesktop.ytstenut.VideoProfile.Transcript",
-       yts_vp_transcript_adapter_get_type (),
-       yts_vp_transcript_proxy_get_type () }
-  };
-
   object_class->dispose = _dispose;
-
-  if (NULL == _table) {
-    _table = g_array_sized_new (false,
-                                false,
-                                sizeof (FactoryEntry),
-                                G_N_ELEMENTS (table));
-    memcpy (_table->data, table, sizeof (table));
-    _table->len = G_N_ELEMENTS (table);
-    g_array_sort (_table, _factory_entry_compare);
-  }
 }
 
 static void
@@ -89,58 +47,26 @@ bool
 yts_factory_has_fqc_id (YtsFactory const  *self,
                         char const        *fqc_id)
 {
-  FactoryEntry const *entry;
-  FactoryEntry        needle;
-
-  needle.fqc_id = fqc_id;
-  entry = bsearch (&needle,
-                   _table->data,
-                   _table->len,
-                   sizeof (FactoryEntry),
-                   _factory_entry_compare);
+  return yts_capability_registry_has_fqc_id (fqc_id);
+}
 
-  return (bool) entry;
+bool
+yts_factory_has_proxy_for_fqc_id (YtsFactory const  *self,
+                                  char const        *fqc_id)
+{
+  return yts_capability_registry_has_proxy (fqc_id);
 }
 
 GType
 yts_factory_get_proxy_gtype_for_fqc_id (YtsFactory const  *self,
                                         char const        *fqc_id)
 {
-  FactoryEntry const *entry;
-  FactoryEntry        needle;
-
-  needle.fqc_id = fqc_id;
-  entry = bsearch (&needle,
-                   _table->data,
-                   _table->len,
-                   sizeof (FactoryEntry),
-                   _factory_entry_compare);
-
-  if (entry) {
-    return entry->proxy_gtype;
-  }
-
-  return G_TYPE_INVALID;
+  return yts_capability_registry_get_proxy_gtype (fqc_id);
 }
 
 GType
 yts_factory_get_adapter_gtype_for_fqc_id (YtsFactory const  *self,
                                           char const        *fqc_id)
 {
-  FactoryEntry const *entry;
-  FactoryEntry        needle;
-
-  needle.fqc_id = fqc_id;
-  entry = bsearch (&needle,
-                   _table->data,
-                   _table->len,
-                   sizeof (FactoryEntry),
-                   _factory_entry_compare);
-
-  if (entry) {
-    return entry->adapter_gtype;
-  }
-
-  return G_TYPE_INVALID;
+  return yts_capability_registry_get_adapter_gtype (fqc_id);
 }
-
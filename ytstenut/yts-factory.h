@@ -59,6 +59,10 @@ bool
 yts_factory_has_fqc_id (YtsFactory const  *self,
                         char const        *fqc_id);
 
+bool
+yts_factory_has_proxy_for_fqc_id (YtsFactory const  *self,
+                                  char const        *fqc_id);
+
 GType
 yts_factory_get_proxy_gtype_for_fqc_id (YtsFactory const  *self,
                                         char const        *fqc_id);
@@ -0,0 +1,155 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_FILE_TRANSFER_INTERNAL_H
+#define YTS_FILE_TRANSFER_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <telepathy-glib/enums.h>
+#include <ytstenut/yts-file-transfer.h>
+
+G_BEGIN_DECLS
+
+/* Keys into the file transfer channel's metadata hash. */
+#define YTS_FILE_TRANSFER_METADATA_FROM_SERVICE "FromService"
+#define YTS_FILE_TRANSFER_METADATA_PREFIX_CHECKSUM "PrefixChecksum"
+#define YTS_FILE_TRANSFER_METADATA_CHECKSUM "SHA256"
+#define YTS_FILE_TRANSFER_METADATA_BUNDLE "Bundle"
+
+/* Content type of the channel carrying a bundle's concatenated entries. */
+#define YTS_FILE_TRANSFER_BUNDLE_CONTENT_TYPE "application/x-ytstenut-bundle"
+
+/* Block size for reading files to checksum them. */
+#define YTS_FILE_TRANSFER_CHECKSUM_BLOCK_SIZE (64 * 1024)
+
+/* Number of leading bytes covered by the prefix checksum. */
+#define YTS_FILE_TRANSFER_PREFIX_SIZE (64 * 1024)
+
+/* File attribute tagging a partially received file with the identity of
+ * the transfer it belongs to, so it can be resumed. */
+#define YTS_FILE_TRANSFER_ATTRIBUTE_RESUME_KEY "xattr::ytstenut.resume-key"
+
+/* Socket type used when streaming transfers through the connection
+ * manager's socket directly, rather than having tp-glib handle a GFile. */
+#ifdef G_OS_WIN32
+#define YTS_FILE_TRANSFER_SOCKET_ADDRESS_TYPE TP_SOCKET_ADDRESS_TYPE_IPV4
+#else
+#define YTS_FILE_TRANSFER_SOCKET_ADDRESS_TYPE TP_SOCKET_ADDRESS_TYPE_UNIX
+#endif
+
+char *
+yts_file_transfer_compute_prefix_checksum (GFile   *file,
+                                           GError **error);
+
+bool
+yts_file_transfer_update_checksum (GChecksum     *checksum,
+                                   GFile         *file,
+                                   uint64_t       length,
+                                   GCancellable  *cancellable,
+                                   GError       **error);
+
+char *
+yts_file_transfer_compute_checksum (GFile         *file,
+                                    GCancellable  *cancellable,
+                                    GError       **error);
+
+/*
+ * Bookkeeping for progress, throughput and time estimation. Updated
+ * from the channel's transferred-bytes notifications only, no timers.
+ */
+typedef struct {
+  /* Configuration */
+  unsigned  notify_interval_ms;
+  float     notify_threshold;
+  /* Data */
+  uint64_t  size;
+  uint64_t  transferred_bytes;
+  uint64_t  bytes_per_second;
+  int64_t   sample_time;
+  uint64_t  sample_bytes;
+  int64_t   notify_time;
+  float     notify_progress;
+} YtsFileTransferMeter;
+
+void
+yts_file_transfer_meter_init (YtsFileTransferMeter *meter);
+
+void
+yts_file_transfer_meter_start (YtsFileTransferMeter *meter,
+                               uint64_t              offset);
+
+bool
+yts_file_transfer_meter_update (YtsFileTransferMeter  *meter,
+                                uint64_t               transferred_bytes);
+
+float
+yts_file_transfer_meter_get_progress (YtsFileTransferMeter const *meter);
+
+int64_t
+yts_file_transfer_meter_get_time_remaining (YtsFileTransferMeter const *meter);
+
+void
+yts_file_transfer_notify_progress (YtsFileTransfer *self);
+
+/*
+ * Bundle entry. The manifest lists entries as "size\tcontent-type\tname",
+ * their content follows each other in the channel without framing.
+ */
+typedef struct {
+  char      *name;
+  char      *content_type;
+  uint64_t   size;
+  uint64_t   offset;
+} YtsBundleEntry;
+
+typedef void (*YtsBundleProgressFunc) (unsigned  index,
+                                       float     progress,
+                                       void     *data);
+
+YtsBundleEntry *
+yts_bundle_entry_new (char const  *name,
+                      char const  *content_type,
+                      uint64_t     size,
+                      uint64_t     offset);
+
+void
+yts_bundle_entry_free (YtsBundleEntry *entry);
+
+float
+yts_bundle_entry_get_progress (YtsBundleEntry const *entry,
+                               uint64_t              transferred_bytes);
+
+char **
+yts_bundle_manifest_encode (GPtrArray *entries);
+
+GPtrArray *
+yts_bundle_manifest_decode (char const *const *manifest);
+
+unsigned
+yts_bundle_update_progress (GPtrArray             *entries,
+                            unsigned               first,
+                            uint64_t               transferred_bytes,
+                            YtsBundleProgressFunc  func,
+                            void                  *data);
+
+G_END_DECLS
+
+#endif /* YTS_FILE_TRANSFER_INTERNAL_H */
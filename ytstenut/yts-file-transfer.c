@@ -20,8 +20,9 @@
 #include "config.h"
 
 #include <stdbool.h>
+#include <string.h>
 
-#include "yts-file-transfer.h"
+#include "yts-file-transfer-internal.h"
 #include "yts-marshal.h"
 
 /* HACK, include known implementers headers for type checks. */
@@ -83,6 +84,74 @@ yts_file_transfer_default_init (YtsFileTransferInterface *interface)
                                 G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
     g_object_interface_install_property (interface, pspec);
 
+    /**
+     * YtsFileTransfer:transferred-bytes:
+     *
+     * Read-only property that holds the number of bytes transferred so far.
+     * Updated together with #YtsFileTransfer:progress.
+     *
+     * Since: 0.4
+     */
+    pspec = g_param_spec_uint64 ("transferred-bytes", "", "",
+                                 0, G_MAXUINT64, 0,
+                                 G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+    g_object_interface_install_property (interface, pspec);
+
+    /**
+     * YtsFileTransfer:bytes-per-second:
+     *
+     * Read-only property that holds the moving average of the transfer rate.
+     * Updated together with #YtsFileTransfer:progress.
+     *
+     * Since: 0.4
+     */
+    pspec = g_param_spec_uint64 ("bytes-per-second", "", "",
+                                 0, G_MAXUINT64, 0,
+                                 G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+    g_object_interface_install_property (interface, pspec);
+
+    /**
+     * YtsFileTransfer:time-remaining:
+     *
+     * Read-only property that holds the estimated number of seconds until
+     * the transfer completes, or -1 if not known yet.
+     * Updated together with #YtsFileTransfer:progress.
+     *
+     * Since: 0.4
+     */
+    pspec = g_param_spec_int64 ("time-remaining", "", "",
+                                -1, G_MAXINT64, -1,
+                                G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+    g_object_interface_install_property (interface, pspec);
+
+    /**
+     * YtsFileTransfer:notify-interval:
+     *
+     * Minimum number of milliseconds between two change notifications of
+     * #YtsFileTransfer:progress. Completion, error and cancellation are
+     * always notified immediately.
+     *
+     * Since: 0.4
+     */
+    pspec = g_param_spec_uint ("notify-interval", "", "",
+                               0, G_MAXUINT,
+                               YTS_FILE_TRANSFER_NOTIFY_INTERVAL_DEFAULT,
+                               G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+    g_object_interface_install_property (interface, pspec);
+
+    /**
+     * YtsFileTransfer:notify-threshold:
+     *
+     * Minimum change of #YtsFileTransfer:progress before it is notified.
+     *
+     * Since: 0.4
+     */
+    pspec = g_param_spec_float ("notify-threshold", "", "",
+                                0.0, 1.0,
+                                YTS_FILE_TRANSFER_NOTIFY_THRESHOLD_DEFAULT,
+                                G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+    g_object_interface_install_property (interface, pspec);
+
     /**
      * YtsFileTransfer::error:
      * @self: object which emitted the signal.
@@ -170,3 +239,437 @@ yts_file_transfer_get_progress (YtsFileTransfer *self)
   return progress;
 }
 
+
+/**
+ * yts_file_transfer_get_transferred_bytes:
+ * @self: object on which to invoke this method.
+ *
+ * See #YtsFileTransfer:transferred-bytes property for details.
+ *
+ * Returns: number of bytes transferred so far.
+ *
+ * Since: 0.4
+ */
+uint64_t
+yts_file_transfer_get_transferred_bytes (YtsFileTransfer *self)
+{
+  guint64 transferred_bytes;
+
+  g_return_val_if_fail (YTS_IS_FILE_TRANSFER (self), 0);
+
+  g_object_get (self, "transferred-bytes", &transferred_bytes, NULL);
+
+  return transferred_bytes;
+}
+
+/**
+ * yts_file_transfer_get_bytes_per_second:
+ * @self: object on which to invoke this method.
+ *
+ * See #YtsFileTransfer:bytes-per-second property for details.
+ *
+ * Returns: average transfer rate.
+ *
+ * Since: 0.4
+ */
+uint64_t
+yts_file_transfer_get_bytes_per_second (YtsFileTransfer *self)
+{
+  guint64 bytes_per_second;
+
+  g_return_val_if_fail (YTS_IS_FILE_TRANSFER (self), 0);
+
+  g_object_get (self, "bytes-per-second", &bytes_per_second, NULL);
+
+  return bytes_per_second;
+}
+
+/**
+ * yts_file_transfer_get_time_remaining:
+ * @self: object on which to invoke this method.
+ *
+ * See #YtsFileTransfer:time-remaining property for details.
+ *
+ * Returns: estimated seconds until completion, or -1.
+ *
+ * Since: 0.4
+ */
+int64_t
+yts_file_transfer_get_time_remaining (YtsFileTransfer *self)
+{
+  gint64 time_remaining;
+
+  g_return_val_if_fail (YTS_IS_FILE_TRANSFER (self), -1);
+
+  g_object_get (self, "time-remaining", &time_remaining, NULL);
+
+  return time_remaining;
+}
+
+/*
+ * YtsFileTransferMeter
+ */
+
+/* Microseconds between two throughput samples. */
+#define METER_SAMPLE_INTERVAL (G_USEC_PER_SEC / 4)
+
+void
+yts_file_transfer_meter_init (YtsFileTransferMeter *meter)
+{
+  memset (meter, 0, sizeof (*meter));
+  meter->notify_interval_ms = YTS_FILE_TRANSFER_NOTIFY_INTERVAL_DEFAULT;
+  meter->notify_threshold = YTS_FILE_TRANSFER_NOTIFY_THRESHOLD_DEFAULT;
+  meter->sample_time = g_get_monotonic_time ();
+  meter->notify_time = meter->sample_time;
+}
+
+/*
+ * Start metering at @offset, the length of a resumed transfer's prefix.
+ * The prefix counts towards progress but not throughput.
+ */
+void
+yts_file_transfer_meter_start (YtsFileTransferMeter *meter,
+                               uint64_t              offset)
+{
+  meter->transferred_bytes = offset;
+  meter->sample_bytes = offset;
+  meter->sample_time = g_get_monotonic_time ();
+  meter->notify_time = meter->sample_time;
+  meter->notify_progress = yts_file_transfer_meter_get_progress (meter);
+}
+
+/*
+ * Returns whether the change is significant enough to be notified.
+ */
+bool
+yts_file_transfer_meter_update (YtsFileTransferMeter  *meter,
+                                uint64_t               transferred_bytes)
+{
+  int64_t now = g_get_monotonic_time ();
+  int64_t elapsed;
+  float   progress;
+
+  meter->transferred_bytes = transferred_bytes;
+
+  elapsed = now - meter->sample_time;
+  if (elapsed >= METER_SAMPLE_INTERVAL &&
+      transferred_bytes >= meter->sample_bytes) {
+
+    uint64_t rate = (transferred_bytes - meter->sample_bytes) *
+                    G_USEC_PER_SEC / elapsed;
+
+    /* Exponential moving average, smoothes out bursts. */
+    meter->bytes_per_second = meter->bytes_per_second ?
+                                (3 * meter->bytes_per_second + rate) / 4 :
+                                rate;
+    meter->sample_time = now;
+    meter->sample_bytes = transferred_bytes;
+  }
+
+  progress = yts_file_transfer_meter_get_progress (meter);
+  if (progress >= 1.0 ||
+      ((now - meter->notify_time) / 1000 >= meter->notify_interval_ms &&
+       progress - meter->notify_progress >= meter->notify_threshold)) {
+
+    meter->notify_time = now;
+    meter->notify_progress = progress;
+    return true;
+  }
+
+  return false;
+}
+
+float
+yts_file_transfer_meter_get_progress (YtsFileTransferMeter const *meter)
+{
+  if (0 == meter->size) {
+    return 0.0;
+  }
+
+  return MIN (1.0, (float) meter->transferred_bytes / meter->size);
+}
+
+int64_t
+yts_file_transfer_meter_get_time_remaining (YtsFileTransferMeter const *meter)
+{
+  if (0 == meter->bytes_per_second ||
+      meter->transferred_bytes > meter->size) {
+    return -1;
+  }
+
+  return (meter->size - meter->transferred_bytes) / meter->bytes_per_second;
+}
+
+/*
+ * Emit the notifications for all the progress-related properties in one go.
+ */
+void
+yts_file_transfer_notify_progress (YtsFileTransfer *self)
+{
+  g_object_freeze_notify (G_OBJECT (self));
+  g_object_notify (G_OBJECT (self), "transferred-bytes");
+  g_object_notify (G_OBJECT (self), "bytes-per-second");
+  g_object_notify (G_OBJECT (self), "time-remaining");
+  g_object_notify (G_OBJECT (self), "progress");
+  g_object_thaw_notify (G_OBJECT (self));
+}
+
+/*
+ * Compute the checksum over the first YTS_FILE_TRANSFER_PREFIX_SIZE bytes of
+ * @file. Used to make sure a partial download actually belongs to the file
+ * that's being offered before resuming it.
+ */
+char *
+yts_file_transfer_compute_prefix_checksum (GFile   *file,
+                                           GError **error)
+{
+  GFileInputStream  *stream;
+  GChecksum         *checksum;
+  char              *buffer;
+  gsize              n_read = 0;
+  char              *ret = NULL;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  stream = g_file_read (file, NULL, error);
+  if (NULL == stream) {
+    return NULL;
+  }
+
+  buffer = g_malloc (YTS_FILE_TRANSFER_PREFIX_SIZE);
+  if (g_input_stream_read_all (G_INPUT_STREAM (stream),
+                               buffer,
+                               YTS_FILE_TRANSFER_PREFIX_SIZE,
+                               &n_read,
+                               NULL,
+                               error)) {
+    checksum = g_checksum_new (G_CHECKSUM_SHA1);
+    g_checksum_update (checksum, (guchar const *) buffer, n_read);
+    ret = g_strdup (g_checksum_get_string (checksum));
+    g_checksum_free (checksum);
+  }
+
+  g_free (buffer);
+  g_object_unref (stream);
+
+  return ret;
+}
+
+/*
+ * Feed the first @length bytes of @file into @checksum, G_MAXUINT64 for all
+ * of it. Blocking, so better run it in a thread.
+ */
+bool
+yts_file_transfer_update_checksum (GChecksum     *checksum,
+                                   GFile         *file,
+                                   uint64_t       length,
+                                   GCancellable  *cancellable,
+                                   GError       **error)
+{
+  GFileInputStream  *stream;
+  char              *buffer;
+  gssize             n_read;
+
+  g_return_val_if_fail (checksum, false);
+  g_return_val_if_fail (G_IS_FILE (file), false);
+
+  stream = g_file_read (file, cancellable, error);
+  if (NULL == stream) {
+    return false;
+  }
+
+  buffer = g_malloc (YTS_FILE_TRANSFER_CHECKSUM_BLOCK_SIZE);
+
+  do {
+    n_read = g_input_stream_read (G_INPUT_STREAM (stream),
+                                  buffer,
+                                  MIN (YTS_FILE_TRANSFER_CHECKSUM_BLOCK_SIZE,
+                                       length),
+                                  cancellable,
+                                  error);
+    if (n_read > 0) {
+      g_checksum_update (checksum, (guchar const *) buffer, n_read);
+      length -= n_read;
+    }
+  } while (n_read > 0 && length > 0);
+
+  g_free (buffer);
+  g_object_unref (stream);
+
+  return n_read >= 0;
+}
+
+/*
+ * Compute the SHA-256 checksum over the whole of @file. Blocking, so better
+ * run it in a thread.
+ */
+char *
+yts_file_transfer_compute_checksum (GFile         *file,
+                                    GCancellable  *cancellable,
+                                    GError       **error)
+{
+  GChecksum *checksum;
+  char      *ret = NULL;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+  if (yts_file_transfer_update_checksum (checksum,
+                                         file,
+                                         G_MAXUINT64,
+                                         cancellable,
+                                         error)) {
+    ret = g_strdup (g_checksum_get_string (checksum));
+  }
+
+  g_checksum_free (checksum);
+
+  return ret;
+}
+
+YtsBundleEntry *
+yts_bundle_entry_new (char const  *name,
+                      char const  *content_type,
+                      uint64_t     size,
+                      uint64_t     offset)
+{
+  YtsBundleEntry *entry;
+
+  entry = g_new0 (YtsBundleEntry, 1);
+  entry->name = g_strdup (name);
+  entry->content_type = g_strdup (content_type);
+  entry->size = size;
+  entry->offset = offset;
+
+  return entry;
+}
+
+void
+yts_bundle_entry_free (YtsBundleEntry *entry)
+{
+  g_free (entry->name);
+  g_free (entry->content_type);
+  g_free (entry);
+}
+
+float
+yts_bundle_entry_get_progress (YtsBundleEntry const *entry,
+                               uint64_t              transferred_bytes)
+{
+  if (transferred_bytes <= entry->offset) {
+    return 0 == entry->size && transferred_bytes == entry->offset ? 1.0 : 0.0;
+  }
+
+  if (transferred_bytes >= entry->offset + entry->size) {
+    return 1.0;
+  }
+
+  return (float) (transferred_bytes - entry->offset) / entry->size;
+}
+
+char **
+yts_bundle_manifest_encode (GPtrArray *entries)
+{
+  char      **manifest;
+  unsigned    i;
+
+  manifest = g_new0 (char *, entries->len + 1);
+  for (i = 0; i < entries->len; i++) {
+    YtsBundleEntry const *entry = g_ptr_array_index (entries, i);
+    manifest[i] = g_strdup_printf ("%" G_GUINT64_FORMAT "\t%s\t%s",
+                                   entry->size,
+                                   entry->content_type ?
+                                     entry->content_type : "",
+                                   entry->name);
+  }
+
+  return manifest;
+}
+
+/*
+ * Returns an array of #YtsBundleEntry, or %NULL if @manifest is malformed.
+ * Names are plain file names, anything that could escape the target
+ * directory is rejected.
+ */
+GPtrArray *
+yts_bundle_manifest_decode (char const *const *manifest)
+{
+  GPtrArray *entries;
+  uint64_t   offset = 0;
+  unsigned   i;
+
+  entries = g_ptr_array_new_with_free_func (
+                                  (GDestroyNotify) yts_bundle_entry_free);
+
+  for (i = 0; manifest && manifest[i]; i++) {
+
+    char      **tokens = g_strsplit (manifest[i], "\t", 3);
+    char       *end = NULL;
+    uint64_t    size = 0;
+    bool        valid;
+
+    valid = g_strv_length (tokens) == 3;
+    if (valid) {
+      size = g_ascii_strtoull (tokens[0], &end, 10);
+      valid = end != tokens[0] && *end == '\0' &&
+              tokens[2][0] != '\0' &&
+              strchr (tokens[2], '/') == NULL &&
+              strchr (tokens[2], '\\') == NULL &&
+              0 != strcmp (tokens[2], ".") &&
+              0 != strcmp (tokens[2], "..");
+    }
+
+    if (valid) {
+      g_ptr_array_add (entries,
+                       yts_bundle_entry_new (tokens[2],
+                                             tokens[1][0] ? tokens[1] : NULL,
+                                             size,
+                                             offset));
+      offset += size;
+    }
+
+    g_strfreev (tokens);
+
+    if (!valid) {
+      g_ptr_array_free (entries, true);
+      return NULL;
+    }
+  }
+
+  return entries;
+}
+
+/*
+ * Report progress of the entries covered by @transferred_bytes, starting at
+ * @first. Returns the index of the first unfinished entry.
+ */
+unsigned
+yts_bundle_update_progress (GPtrArray             *entries,
+                            unsigned               first,
+                            uint64_t               transferred_bytes,
+                            YtsBundleProgressFunc  func,
+                            void                  *data)
+{
+  unsigned i;
+
+  for (i = first; i < entries->len; i++) {
+
+    YtsBundleEntry const *entry = g_ptr_array_index (entries, i);
+    float progress;
+
+    if (entry->offset > transferred_bytes) {
+      break;
+    }
+
+    progress = yts_bundle_entry_get_progress (entry, transferred_bytes);
+    func (i, progress, data);
+
+    if (progress < 1.0) {
+      break;
+    }
+    first = i + 1;
+  }
+
+  return first;
+}
@@ -21,6 +21,7 @@
 #ifndef YTS_FILE_TRANSFER_H
 #define YTS_FILE_TRANSFER_H
 
+#include <stdint.h>
 #include <glib-object.h>
 #include <gio/gio.h>
 
@@ -37,6 +38,9 @@ G_BEGIN_DECLS
 #define YTS_FILE_TRANSFER_GET_INTERFACE(obj) \
   (G_TYPE_INSTANCE_GET_INTERFACE ((obj), YTS_TYPE_FILE_TRANSFER, YtsFileTransferInterface))
 
+#define YTS_FILE_TRANSFER_NOTIFY_INTERVAL_DEFAULT 100
+#define YTS_FILE_TRANSFER_NOTIFY_THRESHOLD_DEFAULT 0.001
+
 typedef struct YtsFileTransfer YtsFileTransfer;
 
 typedef struct {
@@ -55,6 +59,15 @@ yts_file_transfer_get_file (YtsFileTransfer *self);
 float
 yts_file_transfer_get_progress (YtsFileTransfer *self);
 
+uint64_t
+yts_file_transfer_get_transferred_bytes (YtsFileTransfer *self);
+
+uint64_t
+yts_file_transfer_get_bytes_per_second (YtsFileTransfer *self);
+
+int64_t
+yts_file_transfer_get_time_remaining (YtsFileTransfer *self);
+
 G_END_DECLS
 
 #endif /* YTS_FILE_TRANSFER_H */
@@ -0,0 +1,374 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "yts-histogram.h"
+
+/*
+ * Values below 2^SUB_BITS get a bucket each. Above that every power of two
+ * is split into 2^SUB_BITS buckets of equal width, up to 2^MAX_BITS
+ * microseconds (about 12 days), larger values are clamped.
+ */
+#define SUB_BITS 3
+#define SUB_COUNT (1 << SUB_BITS)
+#define MAX_BITS 40
+#define N_BUCKETS ((MAX_BITS - SUB_BITS + 1) * SUB_COUNT)
+
+/*
+ * Aspects come straight off the wire, so their number per capability is
+ * capped. Further aspects share a single histogram.
+ */
+#define MAX_ASPECTS 32
+#define OTHER_ASPECT "(other)"
+
+struct YtsHistogram {
+  uint64_t  count;
+  uint64_t  sum;
+  int64_t   min;
+  int64_t   max;
+  uint64_t  buckets[N_BUCKETS];
+};
+
+static unsigned
+bit_length (uint64_t value)
+{
+  unsigned n = 0;
+
+  while (value) {
+    value >>= 1;
+    n++;
+  }
+
+  return n;
+}
+
+static unsigned
+bucket_for_value (uint64_t value)
+{
+  unsigned magnitude;
+  unsigned shift;
+
+  if (value < SUB_COUNT) {
+    return value;
+  }
+
+  magnitude = bit_length (value) - 1;
+  if (magnitude >= MAX_BITS) {
+    return N_BUCKETS - 1;
+  }
+
+  shift = magnitude - SUB_BITS;
+  return ((shift + 1) << SUB_BITS) + (value >> shift) - SUB_COUNT;
+}
+
+/* Highest value that falls into @bucket. */
+static uint64_t
+bucket_upper_bound (unsigned bucket)
+{
+  unsigned shift;
+  unsigned sub;
+
+  if (bucket < SUB_COUNT) {
+    return bucket;
+  }
+
+  shift = (bucket >> SUB_BITS) - 1;
+  sub = bucket & (SUB_COUNT - 1);
+  return ((uint64_t) (SUB_COUNT + sub + 1) << shift) - 1;
+}
+
+YtsHistogram *
+yts_histogram_new (void)
+{
+  return g_new0 (YtsHistogram, 1);
+}
+
+void
+yts_histogram_free (YtsHistogram *self)
+{
+  g_free (self);
+}
+
+void
+yts_histogram_record (YtsHistogram  *self,
+                      int64_t        value)
+{
+  g_return_if_fail (self);
+
+  /* The monotonic clock does not go backwards, but be safe. */
+  if (value < 0) {
+    value = 0;
+  }
+
+  if (0 == self->count || value < self->min) {
+    self->min = value;
+  }
+  if (value > self->max) {
+    self->max = value;
+  }
+
+  self->count++;
+  self->sum += value;
+  self->buckets[bucket_for_value (value)]++;
+}
+
+uint64_t
+yts_histogram_get_count (YtsHistogram const *self)
+{
+  g_return_val_if_fail (self, 0);
+
+  return self->count;
+}
+
+/*
+ * Value at or below which @percentile (0 to 100) of the recorded values
+ * fall, rounded up to the bucket boundary but never past the maximum.
+ */
+int64_t
+yts_histogram_get_percentile (YtsHistogram const  *self,
+                              double               percentile)
+{
+  uint64_t  rank;
+  uint64_t  seen = 0;
+  unsigned  i;
+
+  g_return_val_if_fail (self, 0);
+
+  if (0 == self->count) {
+    return 0;
+  }
+
+  percentile = CLAMP (percentile, 0.0, 100.0);
+  rank = (uint64_t) (percentile / 100.0 * self->count + 0.5);
+  rank = CLAMP (rank, 1, self->count);
+
+  for (i = 0; i < N_BUCKETS; i++) {
+    seen += self->buckets[i];
+    if (seen >= rank) {
+      return MIN ((int64_t) bucket_upper_bound (i), self->max);
+    }
+  }
+
+  return self->max;
+}
+
+/*
+ * Summary as a{sv}: "count" (t), "min", "mean", "p50", "p90", "p99",
+ * "p99.9" and "max" (x, microseconds).
+ */
+GVariant *
+yts_histogram_to_variant (YtsHistogram const *self)
+{
+  GVariantBuilder builder;
+
+  g_return_val_if_fail (self, NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+  g_variant_builder_add (&builder, "{sv}", "count",
+                         g_variant_new_uint64 (self->count));
+  g_variant_builder_add (&builder, "{sv}", "min",
+                         g_variant_new_int64 (self->min));
+  g_variant_builder_add (&builder, "{sv}", "mean",
+                         g_variant_new_int64 (self->count ?
+                                              self->sum / self->count : 0));
+  g_variant_builder_add (&builder, "{sv}", "p50",
+                         g_variant_new_int64 (
+                            yts_histogram_get_percentile (self, 50.0)));
+  g_variant_builder_add (&builder, "{sv}", "p90",
+                         g_variant_new_int64 (
+                            yts_histogram_get_percentile (self, 90.0)));
+  g_variant_builder_add (&builder, "{sv}", "p99",
+                         g_variant_new_int64 (
+                            yts_histogram_get_percentile (self, 99.0)));
+  g_variant_builder_add (&builder, "{sv}", "p99.9",
+                         g_variant_new_int64 (
+                            yts_histogram_get_percentile (self, 99.9)));
+  g_variant_builder_add (&builder, "{sv}", "max",
+                         g_variant_new_int64 (self->max));
+
+  return g_variant_builder_end (&builder);
+}
+
+char *
+yts_histogram_to_string (YtsHistogram const *self)
+{
+  g_return_val_if_fail (self, NULL);
+
+  return g_strdup_printf ("n=%" G_GUINT64_FORMAT
+                          " min=%" G_GINT64_FORMAT
+                          " p50=%" G_GINT64_FORMAT
+                          " p90=%" G_GINT64_FORMAT
+                          " p99=%" G_GINT64_FORMAT
+                          " max=%" G_GINT64_FORMAT " us",
+                          self->count,
+                          self->min,
+                          yts_histogram_get_percentile (self, 50.0),
+                          yts_histogram_get_percentile (self, 90.0),
+                          yts_histogram_get_percentile (self, 99.0),
+                          self->max);
+}
+
+/*
+ * YtsLatencyTable
+ */
+
+struct YtsLatencyTable {
+  /* capability -> (aspect -> YtsHistogram) */
+  GHashTable *capabilities;
+};
+
+YtsLatencyTable *
+yts_latency_table_new (void)
+{
+  YtsLatencyTable *self;
+
+  self = g_new0 (YtsLatencyTable, 1);
+  self->capabilities = g_hash_table_new_full (g_str_hash,
+                                              g_str_equal,
+                                              g_free,
+                                              (GDestroyNotify) g_hash_table_destroy);
+
+  return self;
+}
+
+void
+yts_latency_table_free (YtsLatencyTable *self)
+{
+  g_return_if_fail (self);
+
+  g_hash_table_destroy (self->capabilities);
+  g_free (self);
+}
+
+void
+yts_latency_table_record (YtsLatencyTable *self,
+                          char const      *capability,
+                          char const      *aspect,
+                          int64_t          value)
+{
+  GHashTable    *aspects;
+  YtsHistogram  *histogram;
+
+  g_return_if_fail (self);
+
+  /* Messages from misbehaving peers may lack either. */
+  capability = capability ? capability : "";
+  aspect = aspect ? aspect : "";
+
+  aspects = g_hash_table_lookup (self->capabilities, capability);
+  if (NULL == aspects) {
+    aspects = g_hash_table_new_full (g_str_hash,
+                                     g_str_equal,
+                                     g_free,
+                                     (GDestroyNotify) yts_histogram_free);
+    g_hash_table_insert (self->capabilities, g_strdup (capability), aspects);
+  }
+
+  histogram = g_hash_table_lookup (aspects, aspect);
+  if (NULL == histogram &&
+      g_hash_table_size (aspects) >= MAX_ASPECTS) {
+    aspect = OTHER_ASPECT;
+    histogram = g_hash_table_lookup (aspects, aspect);
+  }
+  if (NULL == histogram) {
+    histogram = yts_histogram_new ();
+    g_hash_table_insert (aspects, g_strdup (aspect), histogram);
+  }
+
+  yts_histogram_record (histogram, value);
+}
+
+/*
+ * Returns a floating a{sa{sa{sv}}}, capability to aspect to the
+ * histogram's summary.
+ */
+GVariant *
+yts_latency_table_to_variant (YtsLatencyTable const *self)
+{
+  GVariantBuilder  builder;
+  GHashTableIter   iter;
+  char const      *capability;
+  GHashTable      *aspects;
+
+  g_return_val_if_fail (self, NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sa{sa{sv}}}"));
+
+  g_hash_table_iter_init (&iter, self->capabilities);
+  while (g_hash_table_iter_next (&iter,
+                                 (void **) &capability,
+                                 (void **) &aspects)) {
+
+    GHashTableIter   aspect_iter;
+    char const      *aspect;
+    YtsHistogram    *histogram;
+
+    g_variant_builder_open (&builder, G_VARIANT_TYPE ("{sa{sa{sv}}}"));
+    g_variant_builder_add (&builder, "s", capability);
+    g_variant_builder_open (&builder, G_VARIANT_TYPE ("a{sa{sv}}"));
+
+    g_hash_table_iter_init (&aspect_iter, aspects);
+    while (g_hash_table_iter_next (&aspect_iter,
+                                   (void **) &aspect,
+                                   (void **) &histogram)) {
+      g_variant_builder_add (&builder, "{s@a{sv}}",
+                             aspect,
+                             yts_histogram_to_variant (histogram));
+    }
+
+    g_variant_builder_close (&builder);
+    g_variant_builder_close (&builder);
+  }
+
+  return g_variant_builder_end (&builder);
+}
+
+void
+yts_latency_table_dump (YtsLatencyTable const *self,
+                        char const            *name)
+{
+  GHashTableIter   iter;
+  char const      *capability;
+  GHashTable      *aspects;
+
+  g_return_if_fail (self);
+
+  g_hash_table_iter_init (&iter, self->capabilities);
+  while (g_hash_table_iter_next (&iter,
+                                 (void **) &capability,
+                                 (void **) &aspects)) {
+
+    GHashTableIter   aspect_iter;
+    char const      *aspect;
+    YtsHistogram    *histogram;
+
+    g_hash_table_iter_init (&aspect_iter, aspects);
+    while (g_hash_table_iter_next (&aspect_iter,
+                                   (void **) &aspect,
+                                   (void **) &histogram)) {
+      char *summary = yts_histogram_to_string (histogram);
+      g_printerr ("%s %s %s: %s\n", name, capability, aspect, summary);
+      g_free (summary);
+    }
+  }
+}
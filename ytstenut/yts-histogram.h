@@ -0,0 +1,86 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_HISTOGRAM_H
+#define YTS_HISTOGRAM_H
+
+#include <stdint.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Fixed-size latency histogram in the style of HdrHistogram. Values are
+ * microseconds, bucketed log-linearly so the relative error stays below
+ * 1/8 from one microsecond up to days, in constant memory.
+ */
+typedef struct YtsHistogram YtsHistogram;
+
+YtsHistogram *
+yts_histogram_new (void);
+
+void
+yts_histogram_free (YtsHistogram *self);
+
+void
+yts_histogram_record (YtsHistogram  *self,
+                      int64_t        value);
+
+uint64_t
+yts_histogram_get_count (YtsHistogram const *self);
+
+int64_t
+yts_histogram_get_percentile (YtsHistogram const  *self,
+                              double               percentile);
+
+GVariant *
+yts_histogram_to_variant (YtsHistogram const *self);
+
+char *
+yts_histogram_to_string (YtsHistogram const *self);
+
+/*
+ * Histograms keyed by capability and aspect. Past a fixed number of aspects
+ * per capability, the remaining ones are recorded under "(other)".
+ */
+typedef struct YtsLatencyTable YtsLatencyTable;
+
+YtsLatencyTable *
+yts_latency_table_new (void);
+
+void
+yts_latency_table_free (YtsLatencyTable *self);
+
+void
+yts_latency_table_record (YtsLatencyTable *self,
+                          char const      *capability,
+                          char const      *aspect,
+                          int64_t          value);
+
+GVariant *
+yts_latency_table_to_variant (YtsLatencyTable const *self);
+
+void
+yts_latency_table_dump (YtsLatencyTable const *self,
+                        char const            *name);
+
+G_END_DECLS
+
+#endif /* YTS_HISTOGRAM_H */
@@ -0,0 +1,50 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_INCOMING_BUNDLE_INTERNAL_H
+#define YTS_INCOMING_BUNDLE_INTERNAL_H
+
+#include <ytstenut/yts-incoming-bundle.h>
+
+G_BEGIN_DECLS
+
+#define YTS_INCOMING_BUNDLE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), YTS_TYPE_INCOMING_BUNDLE, YtsIncomingBundleClass))
+
+#define YTS_IS_INCOMING_BUNDLE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), YTS_TYPE_INCOMING_BUNDLE))
+
+#define YTS_INCOMING_BUNDLE_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), YTS_TYPE_INCOMING_BUNDLE, YtsIncomingBundleClass))
+
+struct YtsIncomingBundle {
+  GObject parent;
+};
+
+typedef struct {
+  GObjectClass parent;
+} YtsIncomingBundleClass;
+
+YtsIncomingBundle *
+yts_incoming_bundle_new (YtsIncomingFile *transfer);
+
+G_END_DECLS
+
+#endif /* YTS_INCOMING_BUNDLE_INTERNAL_H */
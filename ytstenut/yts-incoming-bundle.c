@@ -0,0 +1,522 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "yts-bundle-output-stream.h"
+#include "yts-file-transfer-internal.h"
+#include "yts-incoming-bundle-internal.h"
+#include "yts-incoming-file-internal.h"
+#include "yts-marshal.h"
+
+G_DEFINE_TYPE (YtsIncomingBundle, yts_incoming_bundle, G_TYPE_OBJECT)
+
+/**
+ * SECTION: yts-incoming-bundle
+ * @short_description: Multi-file download.
+ *
+ * #YtsIncomingBundle receives a number of files sent through a single file
+ * transfer channel, see #YtsClient::incoming-bundle. The entries are known
+ * up front, so the receiver may pick the ones it wants when accepting. The
+ * others are still transferred, but discarded.
+ *
+ * Overall progress, errors and cancellation are reported by the underlying
+ * #YtsIncomingFile, see yts_incoming_bundle_get_transfer().
+ */
+
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), YTS_TYPE_INCOMING_BUNDLE, YtsIncomingBundlePrivate))
+
+enum {
+  PROP_0,
+  PROP_TRANSFER
+};
+
+enum {
+  SIG_ENTRY_PROGRESS,
+  SIG_ENTRY_COMPLETED,
+  N_SIGNALS
+};
+
+static unsigned _signals[N_SIGNALS] = { 0, };
+
+typedef struct {
+  YtsIncomingFile *transfer;
+  GPtrArray       *entries;
+  GPtrArray       *targets;
+  GOutputStream   *stream;
+  unsigned         first;
+  unsigned         n_completed;
+} YtsIncomingBundlePrivate;
+
+static void
+_object_unref0 (void *object)
+{
+  if (object) {
+    g_object_unref (object);
+  }
+}
+
+static bool
+is_selected (char const *const  *names,
+             char const         *name)
+{
+  unsigned i;
+
+  if (NULL == names) {
+    return true;
+  }
+
+  for (i = 0; names[i]; i++) {
+    if (0 == g_strcmp0 (names[i], name)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void
+_entry_progress (unsigned            index,
+                 float               progress,
+                 YtsIncomingBundle  *self)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (self);
+
+  if (g_ptr_array_index (priv->targets, index)) {
+    g_signal_emit (self, _signals[SIG_ENTRY_PROGRESS], 0, index, progress);
+  }
+}
+
+/*
+ * Announce entries that have been written to disk in the meantime.
+ */
+static void
+update_completed (YtsIncomingBundle *self)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (self);
+  unsigned n_completed;
+
+  n_completed = yts_bundle_output_stream_get_n_completed (
+                                    YTS_BUNDLE_OUTPUT_STREAM (priv->stream));
+
+  while (priv->n_completed < n_completed) {
+    GFile *target = g_ptr_array_index (priv->targets, priv->n_completed);
+    if (target) {
+      g_signal_emit (self, _signals[SIG_ENTRY_COMPLETED], 0,
+                     priv->n_completed, target);
+    }
+    priv->n_completed++;
+  }
+}
+
+static void
+_transfer_notify_transferred_bytes (YtsIncomingFile   *transfer,
+                                    GParamSpec        *pspec,
+                                    YtsIncomingBundle *self)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (self);
+  uint64_t transferred_bytes;
+
+  transferred_bytes = yts_file_transfer_get_transferred_bytes (
+                                                  YTS_FILE_TRANSFER (transfer));
+  priv->first = yts_bundle_update_progress (
+                                    priv->entries,
+                                    priv->first,
+                                    transferred_bytes,
+                                    (YtsBundleProgressFunc) _entry_progress,
+                                    self);
+  update_completed (self);
+}
+
+static void
+_get_property (GObject    *object,
+               unsigned    property_id,
+               GValue     *value,
+               GParamSpec *pspec)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (object);
+
+  switch (property_id) {
+    case PROP_TRANSFER:
+      g_value_set_object (value, priv->transfer);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+_dispose (GObject *object)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (object);
+
+  if (priv->transfer) {
+    g_signal_handlers_disconnect_by_func (priv->transfer,
+                                          _transfer_notify_transferred_bytes,
+                                          object);
+    g_object_unref (priv->transfer);
+    priv->transfer = NULL;
+  }
+
+  if (priv->stream) {
+    g_object_unref (priv->stream);
+    priv->stream = NULL;
+  }
+
+  G_OBJECT_CLASS (yts_incoming_bundle_parent_class)->dispose (object);
+}
+
+static void
+_finalize (GObject *object)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (object);
+
+  if (priv->entries) {
+    g_ptr_array_unref (priv->entries);
+    priv->entries = NULL;
+  }
+
+  if (priv->targets) {
+    g_ptr_array_unref (priv->targets);
+    priv->targets = NULL;
+  }
+
+  G_OBJECT_CLASS (yts_incoming_bundle_parent_class)->finalize (object);
+}
+
+static void
+yts_incoming_bundle_class_init (YtsIncomingBundleClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GParamSpec   *pspec;
+
+  g_type_class_add_private (klass, sizeof (YtsIncomingBundlePrivate));
+
+  object_class->get_property = _get_property;
+  object_class->dispose = _dispose;
+  object_class->finalize = _finalize;
+
+  /**
+   * YtsIncomingBundle:transfer:
+   *
+   * The #YtsIncomingFile carrying the bundle.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_object ("transfer", "", "",
+                               YTS_TYPE_INCOMING_FILE,
+                               G_PARAM_READABLE |
+                               G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_TRANSFER, pspec);
+
+  /**
+   * YtsIncomingBundle::entry-progress:
+   * @self: object which emitted the signal.
+   * @index: index of the entry.
+   * @progress: progress of the entry, from 0.0 to 1.0.
+   *
+   * Emitted when an accepted entry's progress changes, throttled like
+   * #YtsFileTransfer:progress.
+   *
+   * Since: 0.4
+   */
+  _signals[SIG_ENTRY_PROGRESS] = g_signal_new ("entry-progress",
+                                               G_TYPE_FROM_CLASS (object_class),
+                                               G_SIGNAL_RUN_LAST,
+                                               0, NULL, NULL,
+                                               yts_marshal_VOID__UINT_FLOAT,
+                                               G_TYPE_NONE, 2,
+                                               G_TYPE_UINT,
+                                               G_TYPE_FLOAT);
+
+  /**
+   * YtsIncomingBundle::entry-completed:
+   * @self: object which emitted the signal.
+   * @index: index of the entry.
+   * @file: the file the entry has been written to.
+   *
+   * Emitted when an accepted entry has been received completely.
+   *
+   * Since: 0.4
+   */
+  _signals[SIG_ENTRY_COMPLETED] = g_signal_new ("entry-completed",
+                                                G_TYPE_FROM_CLASS (object_class),
+                                                G_SIGNAL_RUN_LAST,
+                                                0, NULL, NULL,
+                                                yts_marshal_VOID__UINT_OBJECT,
+                                                G_TYPE_NONE, 2,
+                                                G_TYPE_UINT,
+                                                G_TYPE_FILE);
+}
+
+static void
+yts_incoming_bundle_init (YtsIncomingBundle *self)
+{
+}
+
+/*
+ * Returns %NULL if @transfer does not carry a (valid) bundle.
+ */
+YtsIncomingBundle *
+yts_incoming_bundle_new (YtsIncomingFile *transfer)
+{
+  YtsIncomingBundle         *self;
+  YtsIncomingBundlePrivate  *priv;
+  char const *const         *manifest;
+  GPtrArray                 *entries;
+
+  g_return_val_if_fail (YTS_IS_INCOMING_FILE (transfer), NULL);
+
+  manifest = yts_incoming_file_get_metadata (transfer,
+                                             YTS_FILE_TRANSFER_METADATA_BUNDLE);
+  if (NULL == manifest) {
+    return NULL;
+  }
+
+  entries = yts_bundle_manifest_decode (manifest);
+  if (NULL == entries) {
+    g_warning ("%s : Ignoring malformed bundle manifest", G_STRLOC);
+    return NULL;
+  }
+
+  self = g_object_new (YTS_TYPE_INCOMING_BUNDLE, NULL);
+  priv = GET_PRIVATE (self);
+  priv->transfer = g_object_ref (transfer);
+  priv->entries = entries;
+
+  return self;
+}
+
+/**
+ * yts_incoming_bundle_get_transfer:
+ * @self: object on which to invoke this method.
+ *
+ * Returns: (transfer none): the #YtsIncomingFile carrying the bundle.
+ *
+ * Since: 0.4
+ */
+YtsIncomingFile *const
+yts_incoming_bundle_get_transfer (YtsIncomingBundle *self)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_INCOMING_BUNDLE (self), NULL);
+
+  return priv->transfer;
+}
+
+/**
+ * yts_incoming_bundle_get_n_entries:
+ * @self: object on which to invoke this method.
+ *
+ * Returns: number of files in the bundle.
+ *
+ * Since: 0.4
+ */
+unsigned
+yts_incoming_bundle_get_n_entries (YtsIncomingBundle *self)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_INCOMING_BUNDLE (self), 0);
+
+  return priv->entries->len;
+}
+
+/**
+ * yts_incoming_bundle_get_entry_name:
+ * @self: object on which to invoke this method.
+ * @index: index of the entry.
+ *
+ * Returns: file name of entry @index.
+ *
+ * Since: 0.4
+ */
+char const *
+yts_incoming_bundle_get_entry_name (YtsIncomingBundle *self,
+                                    unsigned           index)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (self);
+  YtsBundleEntry const *entry;
+
+  g_return_val_if_fail (YTS_IS_INCOMING_BUNDLE (self), NULL);
+  g_return_val_if_fail (index < priv->entries->len, NULL);
+
+  entry = g_ptr_array_index (priv->entries, index);
+  return entry->name;
+}
+
+/**
+ * yts_incoming_bundle_get_entry_content_type:
+ * @self: object on which to invoke this method.
+ * @index: index of the entry.
+ *
+ * Returns: content type of entry @index, or %NULL if unknown.
+ *
+ * Since: 0.4
+ */
+char const *
+yts_incoming_bundle_get_entry_content_type (YtsIncomingBundle *self,
+                                            unsigned           index)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (self);
+  YtsBundleEntry const *entry;
+
+  g_return_val_if_fail (YTS_IS_INCOMING_BUNDLE (self), NULL);
+  g_return_val_if_fail (index < priv->entries->len, NULL);
+
+  entry = g_ptr_array_index (priv->entries, index);
+  return entry->content_type;
+}
+
+/**
+ * yts_incoming_bundle_get_entry_size:
+ * @self: object on which to invoke this method.
+ * @index: index of the entry.
+ *
+ * Returns: size of entry @index in bytes.
+ *
+ * Since: 0.4
+ */
+uint64_t
+yts_incoming_bundle_get_entry_size (YtsIncomingBundle *self,
+                                    unsigned           index)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (self);
+  YtsBundleEntry const *entry;
+
+  g_return_val_if_fail (YTS_IS_INCOMING_BUNDLE (self), 0);
+  g_return_val_if_fail (index < priv->entries->len, 0);
+
+  entry = g_ptr_array_index (priv->entries, index);
+  return entry->size;
+}
+
+/**
+ * yts_incoming_bundle_get_entry_progress:
+ * @self: object on which to invoke this method.
+ * @index: index of the entry.
+ *
+ * Returns: progress of entry @index, from 0.0 to 1.0.
+ *
+ * Since: 0.4
+ */
+float
+yts_incoming_bundle_get_entry_progress (YtsIncomingBundle *self,
+                                        unsigned           index)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (self);
+  uint64_t transferred_bytes;
+
+  g_return_val_if_fail (YTS_IS_INCOMING_BUNDLE (self), 0.0);
+  g_return_val_if_fail (index < priv->entries->len, 0.0);
+
+  transferred_bytes = yts_file_transfer_get_transferred_bytes (
+                                            YTS_FILE_TRANSFER (priv->transfer));
+
+  return yts_bundle_entry_get_progress (g_ptr_array_index (priv->entries,
+                                                           index),
+                                        transferred_bytes);
+}
+
+/**
+ * yts_incoming_bundle_accept:
+ * @self: object on which to invoke this method.
+ * @directory: directory to store the entries in.
+ * @names: (allow-none): %NULL-terminated list of entry names to accept, or
+ *         %NULL to accept all entries.
+ * @error_out: error out pointer.
+ *
+ * Accept the bundle, writing the selected entries to @directory. Existing
+ * files are overwritten.
+ *
+ * Returns: %true if the transfer could be accepted.
+ *
+ * Since: 0.4
+ */
+bool
+yts_incoming_bundle_accept (YtsIncomingBundle  *self,
+                            GFile              *directory,
+                            char const *const  *names,
+                            GError            **error_out)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (self);
+  unsigned i;
+
+  g_return_val_if_fail (YTS_IS_INCOMING_BUNDLE (self), false);
+  g_return_val_if_fail (G_IS_FILE (directory), false);
+
+  if (priv->stream) {
+    if (error_out) {
+      *error_out = g_error_new (YTS_INCOMING_FILE_ERROR,
+                                YTS_INCOMING_FILE_ERROR_ALREADY_ACCEPTED,
+                                "Incoming bundle has already been accepted");
+    }
+    return false;
+  }
+
+  priv->targets = g_ptr_array_new_with_free_func (_object_unref0);
+  for (i = 0; i < priv->entries->len; i++) {
+
+    YtsBundleEntry const *entry = g_ptr_array_index (priv->entries, i);
+    GFile *target = NULL;
+
+    if (is_selected (names, entry->name)) {
+      target = g_file_get_child (directory, entry->name);
+    }
+
+    g_ptr_array_add (priv->targets, target);
+  }
+
+  priv->stream = yts_bundle_output_stream_new (priv->entries, priv->targets);
+
+  g_signal_connect (priv->transfer, "notify::transferred-bytes",
+                    G_CALLBACK (_transfer_notify_transferred_bytes), self);
+
+  return yts_incoming_file_accept_stream (priv->transfer,
+                                          priv->stream,
+                                          error_out);
+}
+
+/**
+ * yts_incoming_bundle_reject:
+ * @self: object on which to invoke this method.
+ * @error_out: error out pointer.
+ *
+ * Reject the bundle.
+ *
+ * Returns: %true if the transfer could be rejected.
+ *
+ * Since: 0.4
+ */
+bool
+yts_incoming_bundle_reject (YtsIncomingBundle  *self,
+                            GError            **error_out)
+{
+  YtsIncomingBundlePrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_INCOMING_BUNDLE (self), false);
+
+  return yts_incoming_file_reject (priv->transfer, error_out);
+}
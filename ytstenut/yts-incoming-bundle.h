@@ -0,0 +1,79 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_INCOMING_BUNDLE_H
+#define YTS_INCOMING_BUNDLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <ytstenut/yts-incoming-file.h>
+
+G_BEGIN_DECLS
+
+#define YTS_TYPE_INCOMING_BUNDLE yts_incoming_bundle_get_type()
+
+#define YTS_INCOMING_BUNDLE(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), YTS_TYPE_INCOMING_BUNDLE, YtsIncomingBundle))
+
+#define YTS_IS_INCOMING_BUNDLE(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), YTS_TYPE_INCOMING_BUNDLE))
+
+typedef struct YtsIncomingBundle YtsIncomingBundle;
+
+GType
+yts_incoming_bundle_get_type (void) G_GNUC_CONST;
+
+YtsIncomingFile *const
+yts_incoming_bundle_get_transfer (YtsIncomingBundle *self);
+
+unsigned
+yts_incoming_bundle_get_n_entries (YtsIncomingBundle *self);
+
+char const *
+yts_incoming_bundle_get_entry_name (YtsIncomingBundle *self,
+                                    unsigned           index);
+
+char const *
+yts_incoming_bundle_get_entry_content_type (YtsIncomingBundle *self,
+                                            unsigned           index);
+
+uint64_t
+yts_incoming_bundle_get_entry_size (YtsIncomingBundle *self,
+                                    unsigned           index);
+
+float
+yts_incoming_bundle_get_entry_progress (YtsIncomingBundle *self,
+                                        unsigned           index);
+
+bool
+yts_incoming_bundle_accept (YtsIncomingBundle  *self,
+                            GFile              *directory,
+                            char const *const  *names,
+                            GError            **error);
+
+bool
+yts_incoming_bundle_reject (YtsIncomingBundle  *self,
+                            GError            **error);
+
+G_END_DECLS
+
+#endif /* YTS_INCOMING_BUNDLE_H */
@@ -50,6 +50,16 @@ yts_incoming_file_new (TpFileTransferChannel *tp_channel);
 GFile *const
 yts_incoming_file_get_file (YtsIncomingFile *self);
 
+bool
+yts_incoming_file_accept_file_stream (YtsIncomingFile  *self,
+                                      GFile            *file,
+                                      GOutputStream    *stream,
+                                      GError          **error_out);
+
+char const *const *
+yts_incoming_file_get_metadata (YtsIncomingFile *self,
+                                char const      *key);
+
 G_END_DECLS
 
 #endif /* YTS_INCOMING_FILE_INTERNAL_H */
@@ -0,0 +1,62 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_INCOMING_FILE_POLICY_INTERNAL_H
+#define YTS_INCOMING_FILE_POLICY_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <ytstenut/yts-incoming-file.h>
+#include <ytstenut/yts-incoming-file-policy.h>
+
+G_BEGIN_DECLS
+
+#define YTS_INCOMING_FILE_POLICY_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), YTS_TYPE_INCOMING_FILE_POLICY, YtsIncomingFilePolicyClass))
+
+#define YTS_IS_INCOMING_FILE_POLICY_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), YTS_TYPE_INCOMING_FILE_POLICY))
+
+#define YTS_INCOMING_FILE_POLICY_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), YTS_TYPE_INCOMING_FILE_POLICY, YtsIncomingFilePolicyClass))
+
+struct YtsIncomingFilePolicy {
+  GObject parent;
+};
+
+typedef struct {
+  GObjectClass parent;
+} YtsIncomingFilePolicyClass;
+
+bool
+yts_incoming_file_policy_matches (YtsIncomingFilePolicy *self,
+                                  char const            *service_id,
+                                  char const            *content_type);
+
+bool
+yts_incoming_file_policy_accept (YtsIncomingFilePolicy  *self,
+                                 YtsIncomingFile        *incoming,
+                                 char const             *name,
+                                 uint64_t                size,
+                                 GError                **error_out);
+
+G_END_DECLS
+
+#endif /* YTS_INCOMING_FILE_POLICY_INTERNAL_H */
@@ -0,0 +1,620 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#ifdef G_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <gio/gunixoutputstream.h>
+#endif
+
+#include "yts-incoming-file-internal.h"
+#include "yts-incoming-file-policy-internal.h"
+#include "ytstenut-internal.h"
+
+G_DEFINE_TYPE (YtsIncomingFilePolicy, yts_incoming_file_policy, G_TYPE_OBJECT)
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN PACKAGE"\0file-transfer\0"G_STRLOC
+
+/**
+ * SECTION: yts-incoming-file-policy
+ * @short_description: Automatically accept incoming files.
+ *
+ * #YtsIncomingFilePolicy describes which incoming files to accept without
+ * involving the application, and where to store them. Policies are
+ * registered with yts_client_add_incoming_file_policy(), the first one
+ * matching an incoming file's sender and content type decides.
+ *
+ * Files larger than #YtsIncomingFilePolicy:max-size, exceeding the
+ * #YtsIncomingFilePolicy:quota, or not fitting on the file system are
+ * rejected right away. Otherwise the target file is preallocated before
+ * accepting, so large transfers neither fragment the disk nor run out of
+ * space halfway through.
+ */
+
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), YTS_TYPE_INCOMING_FILE_POLICY, YtsIncomingFilePolicyPrivate))
+
+enum {
+  PROP_0,
+  PROP_DIRECTORY,
+  PROP_SERVICE_IDS,
+  PROP_CONTENT_TYPES,
+  PROP_MAX_SIZE,
+  PROP_QUOTA,
+  PROP_ACCEPTED_BYTES
+};
+
+typedef struct {
+  /* Properties */
+  GFile     *directory;
+  char     **service_ids;
+  char     **content_types;
+  uint64_t   max_size;
+  uint64_t   quota;
+  uint64_t   accepted_bytes;
+} YtsIncomingFilePolicyPrivate;
+
+static bool
+strv_contains (char const *const  *strv,
+               char const         *str)
+{
+  unsigned i;
+
+  for (i = 0; strv[i]; i++) {
+    if (0 == g_strcmp0 (strv[i], str)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*
+ * Find a name not taken in the target directory yet, along the lines of
+ * "name (1).ext".
+ */
+static GFile *
+create_target (YtsIncomingFilePolicy *self,
+               char const            *name)
+{
+  YtsIncomingFilePolicyPrivate *priv = GET_PRIVATE (self);
+  char        *basename;
+  char const  *extension;
+  GFile       *target;
+  unsigned     i;
+
+  basename = name ? g_path_get_basename (name) : NULL;
+  if (NULL == basename ||
+      0 == strcmp (basename, ".") ||
+      0 == strcmp (basename, "..") ||
+      0 == strcmp (basename, G_DIR_SEPARATOR_S)) {
+    g_free (basename);
+    basename = g_strdup ("incoming");
+  }
+
+  target = g_file_get_child (priv->directory, basename);
+
+  extension = strrchr (basename, '.');
+  if (NULL == extension || extension == basename) {
+    extension = basename + strlen (basename);
+  }
+
+  for (i = 1; g_file_query_exists (target, NULL); i++) {
+    char *stem = g_strndup (basename, extension - basename);
+    char *unique = g_strdup_printf ("%s (%u)%s", stem, i, extension);
+    g_object_unref (target);
+    target = g_file_get_child (priv->directory, unique);
+    g_free (unique);
+    g_free (stem);
+  }
+
+  g_free (basename);
+
+  return target;
+}
+
+/*
+ * Create @target and reserve @size bytes for it.
+ */
+static GOutputStream *
+create_stream (GFile     *target,
+               uint64_t   size,
+               GError   **error_out)
+{
+#ifdef G_OS_UNIX
+  char  *path;
+  int    fd;
+
+  path = g_file_get_path (target);
+  if (NULL == path) {
+    if (error_out) {
+      *error_out = g_error_new (YTS_INCOMING_FILE_POLICY_ERROR,
+                                YTS_INCOMING_FILE_POLICY_ERROR_CREATE_FAILED,
+                                "Target directory is not local");
+    }
+    return NULL;
+  }
+
+  fd = g_open (path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+  if (fd < 0) {
+    int errsv = errno;
+    if (error_out) {
+      *error_out = g_error_new (YTS_INCOMING_FILE_POLICY_ERROR,
+                                YTS_INCOMING_FILE_POLICY_ERROR_CREATE_FAILED,
+                                "Failed to create %s (%s)",
+                                path, g_strerror (errsv));
+    }
+    g_free (path);
+    return NULL;
+  }
+
+#ifdef HAVE_POSIX_FALLOCATE
+  if (size > 0) {
+    int err = posix_fallocate (fd, 0, size);
+    if (ENOSPC == err) {
+      if (error_out) {
+        *error_out = g_error_new (YTS_INCOMING_FILE_POLICY_ERROR,
+                                  YTS_INCOMING_FILE_POLICY_ERROR_NO_SPACE,
+                                  "Not enough space for %s",
+                                  path);
+      }
+      close (fd);
+      g_unlink (path);
+      g_free (path);
+      return NULL;
+    } else if (err) {
+      /* Not supported by the file system, carry on without. */
+      DEBUG ("Failed to preallocate %s (%s)", path, g_strerror (err));
+    }
+  }
+#endif
+
+  g_free (path);
+
+  return g_unix_output_stream_new (fd, true);
+
+#else /* G_OS_UNIX */
+
+  GFileOutputStream *stream;
+
+  stream = g_file_create (target, G_FILE_CREATE_NONE, NULL, error_out);
+  return stream ? G_OUTPUT_STREAM (stream) : NULL;
+
+#endif /* G_OS_UNIX */
+}
+
+static void
+_get_property (GObject    *object,
+               unsigned    property_id,
+               GValue     *value,
+               GParamSpec *pspec)
+{
+  YtsIncomingFilePolicyPrivate *priv = GET_PRIVATE (object);
+
+  switch (property_id) {
+    case PROP_DIRECTORY:
+      g_value_set_object (value, priv->directory);
+      break;
+    case PROP_SERVICE_IDS:
+      g_value_set_boxed (value, priv->service_ids);
+      break;
+    case PROP_CONTENT_TYPES:
+      g_value_set_boxed (value, priv->content_types);
+      break;
+    case PROP_MAX_SIZE:
+      g_value_set_uint64 (value, priv->max_size);
+      break;
+    case PROP_QUOTA:
+      g_value_set_uint64 (value, priv->quota);
+      break;
+    case PROP_ACCEPTED_BYTES:
+      g_value_set_uint64 (value, priv->accepted_bytes);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+_set_property (GObject      *object,
+               unsigned      property_id,
+               const GValue *value,
+               GParamSpec   *pspec)
+{
+  YtsIncomingFilePolicyPrivate *priv = GET_PRIVATE (object);
+
+  switch (property_id) {
+    case PROP_DIRECTORY:
+      /* Construct-only */
+      priv->directory = g_value_dup_object (value);
+      break;
+    case PROP_SERVICE_IDS:
+      g_strfreev (priv->service_ids);
+      priv->service_ids = g_value_dup_boxed (value);
+      break;
+    case PROP_CONTENT_TYPES:
+      g_strfreev (priv->content_types);
+      priv->content_types = g_value_dup_boxed (value);
+      break;
+    case PROP_MAX_SIZE:
+      priv->max_size = g_value_get_uint64 (value);
+      break;
+    case PROP_QUOTA:
+      priv->quota = g_value_get_uint64 (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+_finalize (GObject *object)
+{
+  YtsIncomingFilePolicyPrivate *priv = GET_PRIVATE (object);
+
+  if (priv->directory) {
+    g_object_unref (priv->directory);
+    priv->directory = NULL;
+  }
+
+  if (priv->service_ids) {
+    g_strfreev (priv->service_ids);
+    priv->service_ids = NULL;
+  }
+
+  if (priv->content_types) {
+    g_strfreev (priv->content_types);
+    priv->content_types = NULL;
+  }
+
+  G_OBJECT_CLASS (yts_incoming_file_policy_parent_class)->finalize (object);
+}
+
+static void
+yts_incoming_file_policy_class_init (YtsIncomingFilePolicyClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GParamSpec   *pspec;
+
+  g_type_class_add_private (klass, sizeof (YtsIncomingFilePolicyPrivate));
+
+  object_class->get_property = _get_property;
+  object_class->set_property = _set_property;
+  object_class->finalize = _finalize;
+
+  /**
+   * YtsIncomingFilePolicy:directory:
+   *
+   * Directory to store accepted files in.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_object ("directory", "", "",
+                               G_TYPE_FILE,
+                               G_PARAM_READWRITE |
+                               G_PARAM_CONSTRUCT_ONLY |
+                               G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_DIRECTORY, pspec);
+
+  /**
+   * YtsIncomingFilePolicy:service-ids:
+   *
+   * IDs of the services to accept files from, or %NULL for any.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_boxed ("service-ids", "", "",
+                              G_TYPE_STRV,
+                              G_PARAM_READWRITE |
+                              G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_SERVICE_IDS, pspec);
+
+  /**
+   * YtsIncomingFilePolicy:content-types:
+   *
+   * Content types to accept, or %NULL for any. Subtypes match as well,
+   * e.g. "audio/x-vorbis+ogg" matches "audio/ogg".
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_boxed ("content-types", "", "",
+                              G_TYPE_STRV,
+                              G_PARAM_READWRITE |
+                              G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_CONTENT_TYPES, pspec);
+
+  /**
+   * YtsIncomingFilePolicy:max-size:
+   *
+   * Size limit in bytes for a single file, 0 for no limit.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint64 ("max-size", "", "",
+                               0, G_MAXUINT64, 0,
+                               G_PARAM_READWRITE |
+                               G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_MAX_SIZE, pspec);
+
+  /**
+   * YtsIncomingFilePolicy:quota:
+   *
+   * Limit in bytes for all files accepted through this policy, 0 for no
+   * limit.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint64 ("quota", "", "",
+                               0, G_MAXUINT64, 0,
+                               G_PARAM_READWRITE |
+                               G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_QUOTA, pspec);
+
+  /**
+   * YtsIncomingFilePolicy:accepted-bytes:
+   *
+   * Number of bytes accepted through this policy so far, counted against
+   * #YtsIncomingFilePolicy:quota. Transfers that fail or are cancelled
+   * don't count.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint64 ("accepted-bytes", "", "",
+                               0, G_MAXUINT64, 0,
+                               G_PARAM_READABLE |
+                               G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_ACCEPTED_BYTES, pspec);
+}
+
+static void
+yts_incoming_file_policy_init (YtsIncomingFilePolicy *self)
+{
+}
+
+/**
+ * yts_incoming_file_policy_new:
+ * @directory: directory to store accepted files in.
+ *
+ * Create a policy accepting any file into @directory. Restrict it through
+ * its properties.
+ *
+ * Returns: (transfer full): a new #YtsIncomingFilePolicy.
+ *
+ * Since: 0.4
+ */
+YtsIncomingFilePolicy *
+yts_incoming_file_policy_new (GFile *directory)
+{
+  g_return_val_if_fail (G_IS_FILE (directory), NULL);
+
+  return g_object_new (YTS_TYPE_INCOMING_FILE_POLICY,
+                       "directory", directory,
+                       NULL);
+}
+
+/**
+ * yts_incoming_file_policy_get_directory:
+ * @self: object on which to invoke this method.
+ *
+ * Returns: (transfer none): the directory accepted files are stored in.
+ *
+ * Since: 0.4
+ */
+GFile *const
+yts_incoming_file_policy_get_directory (YtsIncomingFilePolicy *self)
+{
+  YtsIncomingFilePolicyPrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_INCOMING_FILE_POLICY (self), NULL);
+
+  return priv->directory;
+}
+
+/*
+ * Whether @self is responsible for a file from @service_id of type
+ * @content_type. Size limits are checked when accepting, so oversized
+ * files are rejected instead of being left to the application.
+ */
+bool
+yts_incoming_file_policy_matches (YtsIncomingFilePolicy *self,
+                                  char const            *service_id,
+                                  char const            *content_type)
+{
+  YtsIncomingFilePolicyPrivate *priv = GET_PRIVATE (self);
+  unsigned i;
+
+  g_return_val_if_fail (YTS_IS_INCOMING_FILE_POLICY (self), false);
+
+  if (priv->service_ids &&
+      !strv_contains ((char const *const *) priv->service_ids, service_id)) {
+    return false;
+  }
+
+  if (priv->content_types) {
+    if (NULL == content_type) {
+      return false;
+    }
+    for (i = 0; priv->content_types[i]; i++) {
+      if (g_content_type_is_a (content_type, priv->content_types[i])) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  return true;
+}
+
+/*
+ * Bytes of an accepted file count against the quota until the transfer
+ * fails or is cancelled. Attached to the incoming file.
+ */
+
+typedef struct {
+  YtsIncomingFilePolicy *policy;  /* weak */
+  uint64_t               size;
+  bool                   released;
+} AcceptedFile;
+
+static void
+accepted_file_free (AcceptedFile *accepted)
+{
+  if (accepted->policy) {
+    g_object_remove_weak_pointer (G_OBJECT (accepted->policy),
+                                  (void **) &accepted->policy);
+  }
+  g_slice_free (AcceptedFile, accepted);
+}
+
+static void
+accepted_file_release (AcceptedFile *accepted)
+{
+  YtsIncomingFilePolicyPrivate *priv;
+
+  if (accepted->released ||
+      NULL == accepted->policy) {
+    return;
+  }
+
+  accepted->released = true;
+
+  priv = GET_PRIVATE (accepted->policy);
+  priv->accepted_bytes -= MIN (accepted->size, priv->accepted_bytes);
+  g_object_notify (G_OBJECT (accepted->policy), "accepted-bytes");
+}
+
+static void
+_incoming_file_error (YtsIncomingFile *incoming,
+                      GError const    *error,
+                      AcceptedFile    *accepted)
+{
+  accepted_file_release (accepted);
+}
+
+static void
+_incoming_file_cancelled (YtsIncomingFile *incoming,
+                          AcceptedFile    *accepted)
+{
+  accepted_file_release (accepted);
+}
+
+bool
+yts_incoming_file_policy_accept (YtsIncomingFilePolicy  *self,
+                                 YtsIncomingFile        *incoming,
+                                 char const             *name,
+                                 uint64_t                size,
+                                 GError                **error_out)
+{
+  YtsIncomingFilePolicyPrivate *priv = GET_PRIVATE (self);
+  GFileInfo     *info;
+  GFile         *target;
+  GOutputStream *stream;
+  bool           ret;
+
+  g_return_val_if_fail (YTS_IS_INCOMING_FILE_POLICY (self), false);
+  g_return_val_if_fail (YTS_IS_INCOMING_FILE (incoming), false);
+
+  if (priv->max_size > 0 &&
+      size > priv->max_size) {
+    if (error_out) {
+      *error_out = g_error_new (YTS_INCOMING_FILE_POLICY_ERROR,
+                                YTS_INCOMING_FILE_POLICY_ERROR_TOO_LARGE,
+                                "File size %" G_GUINT64_FORMAT " exceeds "
+                                "limit of %" G_GUINT64_FORMAT,
+                                size, priv->max_size);
+    }
+    return false;
+  }
+
+  if (priv->quota > 0 &&
+      priv->accepted_bytes + size > priv->quota) {
+    if (error_out) {
+      *error_out = g_error_new (YTS_INCOMING_FILE_POLICY_ERROR,
+                                YTS_INCOMING_FILE_POLICY_ERROR_OVER_QUOTA,
+                                "File size %" G_GUINT64_FORMAT " exceeds "
+                                "remaining quota of %" G_GUINT64_FORMAT,
+                                size, priv->quota - priv->accepted_bytes);
+    }
+    return false;
+  }
+
+  info = g_file_query_filesystem_info (priv->directory,
+                                       G_FILE_ATTRIBUTE_FILESYSTEM_FREE,
+                                       NULL,
+                                       NULL);
+  if (info) {
+    if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE) &&
+        size > g_file_info_get_attribute_uint64 (info,
+                                        G_FILE_ATTRIBUTE_FILESYSTEM_FREE)) {
+      if (error_out) {
+        *error_out = g_error_new (YTS_INCOMING_FILE_POLICY_ERROR,
+                                  YTS_INCOMING_FILE_POLICY_ERROR_NO_SPACE,
+                                  "Not enough space for %" G_GUINT64_FORMAT
+                                  " bytes",
+                                  size);
+      }
+      g_object_unref (info);
+      return false;
+    }
+    g_object_unref (info);
+  }
+
+  target = create_target (self, name);
+  stream = create_stream (target, size, error_out);
+  if (NULL == stream) {
+    g_object_unref (target);
+    return false;
+  }
+
+  ret = yts_incoming_file_accept_file_stream (incoming,
+                                              target,
+                                              stream,
+                                              error_out);
+  if (ret) {
+    AcceptedFile *accepted = g_slice_new0 (AcceptedFile);
+    accepted->policy = self;
+    accepted->size = size;
+    g_object_add_weak_pointer (G_OBJECT (self), (void **) &accepted->policy);
+    g_object_set_data_full (G_OBJECT (incoming),
+                            "yts-incoming-file-policy-accepted",
+                            accepted,
+                            (GDestroyNotify) accepted_file_free);
+    g_signal_connect (incoming, "error",
+                      G_CALLBACK (_incoming_file_error), accepted);
+    g_signal_connect (incoming, "cancelled",
+                      G_CALLBACK (_incoming_file_cancelled), accepted);
+
+    priv->accepted_bytes += size;
+    g_object_notify (G_OBJECT (self), "accepted-bytes");
+  }
+
+  g_object_unref (stream);
+  g_object_unref (target);
+
+  return ret;
+}
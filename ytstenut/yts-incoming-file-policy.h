@@ -0,0 +1,59 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_INCOMING_FILE_POLICY_H
+#define YTS_INCOMING_FILE_POLICY_H
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define YTS_TYPE_INCOMING_FILE_POLICY yts_incoming_file_policy_get_type()
+
+#define YTS_INCOMING_FILE_POLICY(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), YTS_TYPE_INCOMING_FILE_POLICY, YtsIncomingFilePolicy))
+
+#define YTS_IS_INCOMING_FILE_POLICY(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), YTS_TYPE_INCOMING_FILE_POLICY))
+
+typedef struct YtsIncomingFilePolicy YtsIncomingFilePolicy;
+
+GType
+yts_incoming_file_policy_get_type (void) G_GNUC_CONST;
+
+#define YTS_INCOMING_FILE_POLICY_ERROR g_quark_from_static_string ("yts-incoming-file-policy-error")
+
+enum {
+  YTS_INCOMING_FILE_POLICY_ERROR_TOO_LARGE,
+  YTS_INCOMING_FILE_POLICY_ERROR_OVER_QUOTA,
+  YTS_INCOMING_FILE_POLICY_ERROR_NO_SPACE,
+  YTS_INCOMING_FILE_POLICY_ERROR_CREATE_FAILED
+};
+
+YtsIncomingFilePolicy *
+yts_incoming_file_policy_new (GFile *directory);
+
+GFile *const
+yts_incoming_file_policy_get_directory (YtsIncomingFilePolicy *self);
+
+G_END_DECLS
+
+#endif /* YTS_INCOMING_FILE_POLICY_H */
@@ -25,8 +25,14 @@
 #include <stdint.h>
 #include <telepathy-glib/telepathy-glib.h>
 
-#include "yts-file-transfer.h"
+#include "yts-checksum-output-stream.h"
+#include "yts-file-transfer-internal.h"
 #include "yts-incoming-file-internal.h"
+#include "yts-probes.h"
+#include "ytstenut-internal.h"
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN PACKAGE"\0file-transfer\0"G_STRLOC
 
 static void
 _initable_interface_init (GInitableIface *interface);
@@ -49,6 +55,17 @@ G_DEFINE_TYPE_WITH_CODE (YtsIncomingFile,
  * #YtsIncomingFile represents an incoming file downlod operation from another
  * Ytstenut service.
  *
+ * Interrupted downloads are resumed transparently: when the file passed to
+ * yts_incoming_file_accept() is a partial download of the very same file
+ * (same name, size, modification time and sending service), only the
+ * missing tail is requested from the sender. Should a resumed download be
+ * interrupted again, the bytes it received are kept in the partial file
+ * and the next attempt continues from there.
+ *
+ * Small payloads can be received without touching the file system by
+ * means of yts_incoming_file_accept_stream(), e.g. into a
+ * #GMemoryOutputStream. Such transfers are not resumable.
+ *
  * TODO add cancellation in dispose(), and cancel API. Take care not to touch
  * self any more after cancellation.
  */
@@ -62,9 +79,16 @@ enum {
   /* YtsFileTransfer */
   PROP_FILE_TRANSFER_FILE,
   PROP_FILE_TRANSFER_PROGRESS,
+  PROP_FILE_TRANSFER_TRANSFERRED_BYTES,
+  PROP_FILE_TRANSFER_BYTES_PER_SECOND,
+  PROP_FILE_TRANSFER_TIME_REMAINING,
+  PROP_FILE_TRANSFER_NOTIFY_INTERVAL,
+  PROP_FILE_TRANSFER_NOTIFY_THRESHOLD,
 
   /* YtsIncomingFile */
-  PROP_TP_CHANNEL
+  PROP_TP_CHANNEL,
+  PROP_INITIAL_OFFSET,
+  PROP_VERIFIED
 };
 
 typedef struct {
@@ -76,6 +100,19 @@ typedef struct {
   /* Data */
   TpFileTransferChannel *tp_channel;
   uint64_t               size;
+  uint64_t               initial_offset;
+  YtsFileTransferMeter   meter;
+  char                  *resume_key;
+  /* Content verification, the checksum moves into the stream once the
+   * transfer starts. */
+  char                  *expected_checksum;
+  GChecksum             *checksum;
+  bool                   verified;
+  /* Streaming */
+  GOutputStream         *stream;
+  GSocketConnection     *connection;
+  bool                   stream_done;
+  bool                   channel_done;
 } YtsIncomingFilePrivate;
 
 static gboolean
@@ -113,12 +150,34 @@ _file_transfer_interface_init (YtsFileTransferInterface *interface)
  * YtsIncomingFile
  */
 
+/*
+ * Keep what has been received so far when a transfer is interrupted.
+ * Once splicing, the splice closes the file itself. Before that, close it
+ * here so the partial file is complete on disk, and can be appended to by
+ * the next attempt. The resume key is left in place, so the next offer
+ * resumes from the then current size, including the bytes of this attempt.
+ */
+static void
+keep_partial_file (YtsIncomingFile *self)
+{
+  YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
+
+  if (priv->file &&
+      priv->stream &&
+      NULL == priv->connection &&
+      !g_output_stream_is_closed (priv->stream)) {
+    g_output_stream_close (priv->stream, NULL, NULL);
+  }
+}
+
 static void
 set_and_emit_error (YtsIncomingFile  *self,
                     GError           *error)
 {
   YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
 
+  keep_partial_file (self);
+
   g_signal_emit_by_name (self, "error", error);
   priv->progress = -0.1;
   g_object_notify (G_OBJECT (self), "progress");
@@ -139,6 +198,156 @@ _channel_close (GObject       *source,
   }
 }
 
+static char const *
+get_metadata_value (YtsIncomingFile *self,
+                    char const      *key)
+{
+  char const *const *values;
+
+  values = yts_incoming_file_get_metadata (self, key);
+  if (values && values[0]) {
+    return values[0];
+  }
+
+  return NULL;
+}
+
+/*
+ * Identifies the transfer, so a partial file can be matched against a
+ * later offer of the same file.
+ */
+static char *
+create_resume_key (YtsIncomingFile *self)
+{
+  YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
+  GDateTime *date;
+  int64_t    mtime = 0;
+
+  date = tp_file_transfer_channel_get_date (priv->tp_channel);
+  if (date) {
+    mtime = g_date_time_to_unix (date);
+  }
+
+  return g_strdup_printf ("%s:%" G_GUINT64_FORMAT ":%" G_GINT64_FORMAT ":%s",
+                          tp_file_transfer_channel_get_filename (priv->tp_channel),
+                          priv->size,
+                          mtime,
+                          get_metadata_value (self,
+                                      YTS_FILE_TRANSFER_METADATA_FROM_SERVICE));
+}
+
+/*
+ * Returns the number of bytes of @file that can be kept, 0 if the transfer
+ * has to start over.
+ */
+static uint64_t
+find_resume_offset (YtsIncomingFile *self,
+                    GFile           *file)
+{
+  YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
+  GFileInfo   *info;
+  char const  *key;
+  char const  *remote_checksum;
+  uint64_t     size;
+  uint64_t     offset = 0;
+
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                            YTS_FILE_TRANSFER_ATTRIBUTE_RESUME_KEY,
+                            G_FILE_QUERY_INFO_NONE,
+                            NULL,
+                            NULL);
+  if (NULL == info) {
+    /* Most likely the file does not exist. */
+    return 0;
+  }
+
+  key = g_file_info_get_attribute_string (info,
+                                          YTS_FILE_TRANSFER_ATTRIBUTE_RESUME_KEY);
+  size = g_file_info_get_size (info);
+
+  if (0 == g_strcmp0 (key, priv->resume_key) &&
+      size > 0 &&
+      size < priv->size) {
+
+    remote_checksum = get_metadata_value (self,
+                                  YTS_FILE_TRANSFER_METADATA_PREFIX_CHECKSUM);
+    if (remote_checksum) {
+      char *checksum = NULL;
+      if (size >= YTS_FILE_TRANSFER_PREFIX_SIZE) {
+        checksum = yts_file_transfer_compute_prefix_checksum (file, NULL);
+      }
+      if (0 == g_strcmp0 (checksum, remote_checksum)) {
+        offset = size;
+      } else {
+        DEBUG ("Prefix checksum mismatch, not resuming");
+      }
+      g_free (checksum);
+    } else {
+      offset = size;
+    }
+  }
+
+  g_object_unref (info);
+
+  return offset;
+}
+
+static void
+set_completed (YtsIncomingFile *self)
+{
+  YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
+
+  /* Not resumable any more. */
+  if (priv->file) {
+    g_file_set_attribute (priv->file,
+                          YTS_FILE_TRANSFER_ATTRIBUTE_RESUME_KEY,
+                          G_FILE_ATTRIBUTE_TYPE_INVALID,
+                          NULL,
+                          G_FILE_QUERY_INFO_NONE,
+                          NULL,
+                          NULL);
+  }
+
+  priv->meter.transferred_bytes = priv->size;
+  priv->progress = 1.1;
+  yts_file_transfer_notify_progress (YTS_FILE_TRANSFER (self));
+}
+
+/*
+ * Called when all data has been written to the stream, and the stream
+ * closed.
+ */
+static void
+finish_transfer (YtsIncomingFile *self)
+{
+  YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
+
+  if (YTS_IS_CHECKSUM_OUTPUT_STREAM (priv->stream)) {
+
+    YtsChecksumOutputStream *stream = YTS_CHECKSUM_OUTPUT_STREAM (priv->stream);
+    char const *checksum = yts_checksum_output_stream_get_checksum (stream);
+    uint64_t    size = priv->initial_offset +
+                       yts_checksum_output_stream_get_n_written (stream);
+
+    if (size != priv->size ||
+        0 != g_strcmp0 (checksum, priv->expected_checksum)) {
+
+      GError *error = g_error_new (YTS_INCOMING_FILE_ERROR,
+                                   YTS_INCOMING_FILE_ERROR_CHECKSUM_MISMATCH,
+                                   "Received file does not match checksum");
+      set_and_emit_error (self, error);
+      g_error_free (error);
+      return;
+    }
+
+    priv->verified = true;
+    g_object_notify (G_OBJECT (self), "verified");
+  }
+
+  set_completed (self);
+}
+
 static void
 _channel_notify_state (TpFileTransferChannel  *channel,
                        GParamSpec             *pspec,
@@ -151,14 +360,24 @@ _channel_notify_state (TpFileTransferChannel  *channel,
 
   state = tp_file_transfer_channel_get_state (channel, &reason);
 
+  if (YTS_PROBE_ENABLED (incoming__file__state)) {
+    YTS_PROBE5 (incoming__file__state,
+                tp_proxy_get_object_path (channel), state, reason,
+                priv->meter.transferred_bytes, priv->size);
+  }
+
   if (state == TP_FILE_TRANSFER_STATE_COMPLETED) {
 
-    priv->progress = 1.1;
-    g_object_notify (G_OBJECT (self), "progress");
+    /* Only done once all data has been written to the stream too. */
+    priv->channel_done = true;
+    if (priv->stream_done) {
+      finish_transfer (self);
+    }
     close_channel = true;
 
   } else if (reason == TP_FILE_TRANSFER_STATE_CHANGE_REASON_REMOTE_STOPPED) {
 
+    keep_partial_file (self);
     g_signal_emit_by_name (self, "cancelled");
     priv->progress = -0.1;
     g_object_notify (G_OBJECT (self), "progress");
@@ -198,11 +417,15 @@ _channel_notify_transferred_bytes (TpFileTransferChannel  *channel,
                                    YtsIncomingFile        *self)
 {
   YtsIncomingFilePrivate  *priv = GET_PRIVATE (self);
-  float transferred_bytes;
+  uint64_t transferred_bytes;
 
   transferred_bytes = tp_file_transfer_channel_get_transferred_bytes (channel);
-  priv->progress = transferred_bytes / priv->size;
-  g_object_notify (G_OBJECT (self), "progress");
+
+  if (yts_file_transfer_meter_update (&priv->meter,
+                                      priv->initial_offset + transferred_bytes)) {
+    priv->progress = yts_file_transfer_meter_get_progress (&priv->meter);
+    yts_file_transfer_notify_progress (YTS_FILE_TRANSFER (self));
+  }
 }
 
 static gboolean
@@ -242,12 +465,35 @@ _get_property (GObject    *object,
     case PROP_FILE_TRANSFER_PROGRESS:
       g_value_set_float (value, priv->progress);
       break;
+    case PROP_FILE_TRANSFER_TRANSFERRED_BYTES:
+      g_value_set_uint64 (value, priv->meter.transferred_bytes);
+      break;
+    case PROP_FILE_TRANSFER_BYTES_PER_SECOND:
+      g_value_set_uint64 (value, priv->meter.bytes_per_second);
+      break;
+    case PROP_FILE_TRANSFER_TIME_REMAINING:
+      g_value_set_int64 (value,
+                         yts_file_transfer_meter_get_time_remaining (
+                                                              &priv->meter));
+      break;
+    case PROP_FILE_TRANSFER_NOTIFY_INTERVAL:
+      g_value_set_uint (value, priv->meter.notify_interval_ms);
+      break;
+    case PROP_FILE_TRANSFER_NOTIFY_THRESHOLD:
+      g_value_set_float (value, priv->meter.notify_threshold);
+      break;
 
     /* YtsIncomingFile */
 
     case PROP_TP_CHANNEL:
       g_value_set_object (value, priv->tp_channel);
       break;
+    case PROP_INITIAL_OFFSET:
+      g_value_set_uint64 (value, priv->initial_offset);
+      break;
+    case PROP_VERIFIED:
+      g_value_set_boolean (value, priv->verified);
+      break;
 
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -272,6 +518,12 @@ _set_property (GObject      *object,
       if (g_value_get_object (value))
         priv->file = g_value_dup_object (value);
       break;
+    case PROP_FILE_TRANSFER_NOTIFY_INTERVAL:
+      priv->meter.notify_interval_ms = g_value_get_uint (value);
+      break;
+    case PROP_FILE_TRANSFER_NOTIFY_THRESHOLD:
+      priv->meter.notify_threshold = g_value_get_float (value);
+      break;
 
     /* YtsIncomingFile */
 
@@ -279,6 +531,7 @@ _set_property (GObject      *object,
       /* Construct-only */
       priv->tp_channel = g_value_dup_object (value);
       priv->size = tp_file_transfer_channel_get_size (priv->tp_channel);
+      priv->meter.size = priv->size;
       } break;
 
   default:
@@ -312,6 +565,31 @@ _finalize (GObject *object)
     priv->file = NULL;
   }
 
+  if (priv->resume_key) {
+    g_free (priv->resume_key);
+    priv->resume_key = NULL;
+  }
+
+  if (priv->expected_checksum) {
+    g_free (priv->expected_checksum);
+    priv->expected_checksum = NULL;
+  }
+
+  if (priv->checksum) {
+    g_checksum_free (priv->checksum);
+    priv->checksum = NULL;
+  }
+
+  if (priv->stream) {
+    g_object_unref (priv->stream);
+    priv->stream = NULL;
+  }
+
+  if (priv->connection) {
+    g_object_unref (priv->connection);
+    priv->connection = NULL;
+  }
+
   G_OBJECT_CLASS (yts_incoming_file_parent_class)->finalize (object);
 }
 
@@ -336,6 +614,21 @@ yts_incoming_file_class_init (YtsIncomingFileClass *klass)
   g_object_class_override_property (object_class,
                                     PROP_FILE_TRANSFER_PROGRESS,
                                     "progress");
+  g_object_class_override_property (object_class,
+                                    PROP_FILE_TRANSFER_TRANSFERRED_BYTES,
+                                    "transferred-bytes");
+  g_object_class_override_property (object_class,
+                                    PROP_FILE_TRANSFER_BYTES_PER_SECOND,
+                                    "bytes-per-second");
+  g_object_class_override_property (object_class,
+                                    PROP_FILE_TRANSFER_TIME_REMAINING,
+                                    "time-remaining");
+  g_object_class_override_property (object_class,
+                                    PROP_FILE_TRANSFER_NOTIFY_INTERVAL,
+                                    "notify-interval");
+  g_object_class_override_property (object_class,
+                                    PROP_FILE_TRANSFER_NOTIFY_THRESHOLD,
+                                    "notify-threshold");
 
   /* YtsIncomingFile properties */
 
@@ -345,11 +638,43 @@ yts_incoming_file_class_init (YtsIncomingFileClass *klass)
                                G_PARAM_CONSTRUCT_ONLY |
                                G_PARAM_STATIC_STRINGS);
   g_object_class_install_property (object_class, PROP_TP_CHANNEL, pspec);
+
+  /**
+   * YtsIncomingFile:initial-offset:
+   *
+   * Offset in bytes from which the file is being received. Non-zero when
+   * a previously interrupted transfer is resumed.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint64 ("initial-offset", "", "",
+                               0, G_MAXUINT64, 0,
+                               G_PARAM_READABLE |
+                               G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_INITIAL_OFFSET, pspec);
+
+  /**
+   * YtsIncomingFile:verified:
+   *
+   * Whether the received file has been verified against the checksum
+   * provided by the sender. Set upon completion, a mismatch is reported
+   * through #YtsFileTransfer::error instead.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_boolean ("verified", "", "",
+                                false,
+                                G_PARAM_READABLE |
+                                G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_VERIFIED, pspec);
 }
 
 static void
 yts_incoming_file_init (YtsIncomingFile *self)
 {
+  YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
+
+  yts_file_transfer_meter_init (&priv->meter);
 }
 
 YtsIncomingFile *
@@ -370,41 +695,216 @@ yts_incoming_file_get_file (YtsIncomingFile *self)
   return priv->file;
 }
 
+/*
+ * Values the sender put into the channel's metadata under @key, or %NULL.
+ */
+char const *const *
+yts_incoming_file_get_metadata (YtsIncomingFile *self,
+                                char const      *key)
+{
+  YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
+  GHashTable *props;
+  GHashTable *metadata;
+
+  g_return_val_if_fail (YTS_IS_INCOMING_FILE (self), NULL);
+  g_return_val_if_fail (priv->tp_channel, NULL);
+
+  props = tp_channel_borrow_immutable_properties (TP_CHANNEL (priv->tp_channel));
+  metadata = tp_asv_get_boxed (props,
+                               TP_PROP_CHANNEL_INTERFACE_FILE_TRANSFER_METADATA_METADATA,
+                               TP_HASH_TYPE_METADATA);
+  if (metadata) {
+    return g_hash_table_lookup (metadata, key);
+  }
+
+  return NULL;
+}
+
+bool
+yts_incoming_file_reject (YtsIncomingFile  *self,
+                          GError          **error)
+{
+  YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_INCOMING_FILE (self), false);
+  g_return_val_if_fail (TP_IS_FILE_TRANSFER_CHANNEL (priv->tp_channel), false);
+
+  tp_channel_close_async (TP_CHANNEL (priv->tp_channel),
+                          _channel_close,
+                          self);
+  g_object_unref (priv->tp_channel);
+  priv->tp_channel = NULL;
+
+  return true;
+}
+
 static void
-_channel_accept_file (GObject       *source,
-                      GAsyncResult  *result,
-                      gpointer       data)
+_stream_splice (GObject       *source,
+                GAsyncResult  *result,
+                void          *data)
 {
   YtsIncomingFile         *self = YTS_INCOMING_FILE (data);
   YtsIncomingFilePrivate  *priv = GET_PRIVATE (self);
-  GError *error_in = NULL;
+  GError                  *error_in = NULL;
 
-  tp_file_transfer_channel_accept_file_finish (priv->tp_channel,
-                                               result,
-                                               &error_in);
+  g_output_stream_splice_finish (G_OUTPUT_STREAM (source), result, &error_in);
   if (error_in) {
+    GError *error_out = g_error_new (YTS_INCOMING_FILE_ERROR,
+                                     YTS_INCOMING_FILE_ERROR_LOCAL,
+                                     "Failed to write to stream "
+                                     "(%s)",
+                                     error_in->message);
+    set_and_emit_error (self, error_out);
+    g_error_free (error_out);
+    g_clear_error (&error_in);
+  } else {
+    priv->stream_done = true;
+    if (priv->channel_done) {
+      finish_transfer (self);
+    }
+  }
+
+  g_object_unref (self);
+}
+
+static void
+_socket_client_connect (GObject       *source,
+                        GAsyncResult  *result,
+                        void          *data)
+{
+  YtsIncomingFile         *self = YTS_INCOMING_FILE (data);
+  YtsIncomingFilePrivate  *priv = GET_PRIVATE (self);
+  GError                  *error_in = NULL;
+
+  priv->connection = g_socket_client_connect_finish (G_SOCKET_CLIENT (source),
+                                                     result,
+                                                     &error_in);
+  if (error_in) {
+    GError *error_out = g_error_new (YTS_INCOMING_FILE_ERROR,
+                                     YTS_INCOMING_FILE_ERROR_ACCEPT_FAILED,
+                                     "Failed to connect to the transfer socket "
+                                     "(%s)",
+                                     error_in->message);
+    set_and_emit_error (self, error_out);
+    g_error_free (error_out);
+    g_clear_error (&error_in);
+  } else {
+    /* Data only arrives once the channel is open, reading just blocks
+     * until then. */
+    GInputStream *input = g_io_stream_get_input_stream (
+                                            G_IO_STREAM (priv->connection));
+    g_output_stream_splice_async (priv->stream,
+                                  input,
+                                  G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE |
+                                  G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                  G_PRIORITY_DEFAULT,
+                                  NULL,
+                                  _stream_splice,
+                                  g_object_ref (self));
+  }
+
+  g_object_unref (self);
+}
+
+static void
+_channel_accept_stream (TpChannel    *proxy,
+                        GValue const *address,
+                        GError const *error,
+                        void         *data,
+                        GObject      *weak_object)
+{
+  YtsIncomingFile *self = YTS_INCOMING_FILE (weak_object);
+  GSocketAddress  *socket_address;
+  GSocketClient   *client;
+  GError          *error_in = NULL;
+
+  if (error) {
     GError *error_out = g_error_new (YTS_INCOMING_FILE_ERROR,
                                      YTS_INCOMING_FILE_ERROR_ACCEPT_FAILED,
                                      "Failed to start file transfer "
                                      "(%s)",
+                                     error->message);
+    set_and_emit_error (self, error_out);
+    g_error_free (error_out);
+    return;
+  }
+
+  socket_address = tp_g_socket_address_from_variant (
+                                          YTS_FILE_TRANSFER_SOCKET_ADDRESS_TYPE,
+                                          address,
+                                          &error_in);
+  if (error_in) {
+    GError *error_out = g_error_new (YTS_INCOMING_FILE_ERROR,
+                                     YTS_INCOMING_FILE_ERROR_ACCEPT_FAILED,
+                                     "Invalid transfer socket address "
+                                     "(%s)",
                                      error_in->message);
     set_and_emit_error (self, error_out);
     g_error_free (error_out);
     g_clear_error (&error_in);
+    return;
   }
+
+  client = g_socket_client_new ();
+  g_socket_client_connect_async (client,
+                                 G_SOCKET_CONNECTABLE (socket_address),
+                                 NULL,
+                                 _socket_client_connect,
+                                 g_object_ref (self));
+  g_object_unref (client);
+  g_object_unref (socket_address);
 }
 
-bool
-yts_incoming_file_accept (YtsIncomingFile  *self,
-                          GFile            *file,
-                          GError          **error_out)
+/*
+ * Start receiving into priv->stream, from priv->initial_offset. Content
+ * verification hashes what is written to the stream, so it doesn't depend
+ * on what the target reads back as later on.
+ */
+static void
+start_transfer (YtsIncomingFile *self)
 {
   YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
+  GValue *access_control_param;
+
+  if (priv->checksum) {
+    GOutputStream *stream = yts_checksum_output_stream_new (priv->stream,
+                                                            priv->checksum);
+    priv->checksum = NULL;
+    g_object_unref (priv->stream);
+    priv->stream = stream;
+  }
 
-  g_return_val_if_fail (YTS_IS_INCOMING_FILE (self), false);
-  g_return_val_if_fail (G_IS_FILE (file), false);
+  yts_file_transfer_meter_start (&priv->meter, priv->initial_offset);
+
+  g_signal_connect (priv->tp_channel, "notify::state",
+                    G_CALLBACK (_channel_notify_state), self);
+
+  g_signal_connect (priv->tp_channel, "notify::transferred-bytes",
+                    G_CALLBACK (_channel_notify_transferred_bytes), self);
+
+  access_control_param = tp_g_value_slice_new_uint (0);
+  tp_cli_channel_type_file_transfer_call_accept_file (
+                                          TP_CHANNEL (priv->tp_channel),
+                                          -1,
+                                          YTS_FILE_TRANSFER_SOCKET_ADDRESS_TYPE,
+                                          TP_SOCKET_ACCESS_CONTROL_LOCALHOST,
+                                          access_control_param,
+                                          priv->initial_offset,
+                                          _channel_accept_stream,
+                                          NULL,
+                                          NULL,
+                                          G_OBJECT (self));
+  tp_g_value_slice_free (access_control_param);
+}
 
-  if (G_IS_FILE (priv->file)) {
+static bool
+check_not_accepted (YtsIncomingFile  *self,
+                    GError          **error_out)
+{
+  YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
+
+  if (G_IS_FILE (priv->file) ||
+      G_IS_OUTPUT_STREAM (priv->stream)) {
     if (error_out) {
       *error_out = g_error_new (YTS_INCOMING_FILE_ERROR,
                                 YTS_INCOMING_FILE_ERROR_ALREADY_ACCEPTED,
@@ -413,39 +913,217 @@ yts_incoming_file_accept (YtsIncomingFile  *self,
     return false;
   }
 
-  priv->file = g_object_ref (file);
-  g_object_notify (G_OBJECT (self), "file");
+  return true;
+}
 
-  g_signal_connect (priv->tp_channel, "notify::state",
-                    G_CALLBACK (_channel_notify_state), self);
+/* Verify the content as it arrives, if the sender told us what to expect. */
+static void
+setup_checksum (YtsIncomingFile *self)
+{
+  YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
 
-  g_signal_connect (priv->tp_channel, "notify::transferred-bytes",
-                    G_CALLBACK (_channel_notify_transferred_bytes), self);
+  priv->expected_checksum = g_strdup (get_metadata_value (self,
+                                        YTS_FILE_TRANSFER_METADATA_CHECKSUM));
+  if (priv->expected_checksum) {
+    priv->checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  }
+}
+
+/*
+ * Accept into @stream. If @stream writes to @file, the content is verified,
+ * but not resumable.
+ */
+static bool
+accept_stream (YtsIncomingFile  *self,
+               GOutputStream    *stream,
+               GFile            *file,
+               GError          **error_out)
+{
+  YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
+
+  if (!check_not_accepted (self, error_out)) {
+    return false;
+  }
+
+  priv->stream = g_object_ref (stream);
+
+  if (file) {
+    priv->file = g_object_ref (file);
+    g_object_notify (G_OBJECT (self), "file");
+    setup_checksum (self);
+  }
 
-  tp_file_transfer_channel_accept_file_async (priv->tp_channel,
-                                              priv->file,
-                                              0,
-                                              _channel_accept_file,
-                                              self);
+  start_transfer (self);
 
   return true;
 }
 
+/**
+ * yts_incoming_file_accept_stream:
+ * @self: object on which to invoke this method.
+ * @stream: stream to write the received content to.
+ * @error_out: error out pointer.
+ *
+ * Accept the incoming file, writing its content to @stream instead of a
+ * file. @stream is closed when the transfer has finished.
+ *
+ * Returns: %true if the transfer could be accepted.
+ *
+ * Since: 0.4
+ */
 bool
-yts_incoming_file_reject (YtsIncomingFile  *self,
-                          GError          **error)
+yts_incoming_file_accept_stream (YtsIncomingFile  *self,
+                                 GOutputStream    *stream,
+                                 GError          **error_out)
+{
+  g_return_val_if_fail (YTS_IS_INCOMING_FILE (self), false);
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), false);
+
+  return accept_stream (self, stream, NULL, error_out);
+}
+
+/*
+ * Accept into @stream, which has been opened on @file by the caller, e.g.
+ * because it has been preallocated. Going through the stream avoids tp-glib
+ * replacing the file.
+ */
+bool
+yts_incoming_file_accept_file_stream (YtsIncomingFile  *self,
+                                      GFile            *file,
+                                      GOutputStream    *stream,
+                                      GError          **error_out)
+{
+  g_return_val_if_fail (YTS_IS_INCOMING_FILE (self), false);
+  g_return_val_if_fail (G_IS_FILE (file), false);
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), false);
+
+  return accept_stream (self, stream, file, error_out);
+}
+
+static void
+_checksum_prefix_thread (GSimpleAsyncResult *result,
+                         GObject            *object,
+                         GCancellable       *cancellable)
+{
+  YtsIncomingFilePrivate *priv = GET_PRIVATE (object);
+  GError *error = NULL;
+
+  if (!yts_file_transfer_update_checksum (priv->checksum,
+                                          priv->file,
+                                          priv->initial_offset,
+                                          cancellable,
+                                          &error)) {
+    g_simple_async_result_take_error (result, error);
+  }
+}
+
+static void
+_checksum_prefix (GObject      *source,
+                  GAsyncResult *result,
+                  void         *data)
+{
+  YtsIncomingFile         *self = YTS_INCOMING_FILE (source);
+  YtsIncomingFilePrivate  *priv = GET_PRIVATE (self);
+  GError                  *error = NULL;
+
+  if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (result),
+                                             &error)) {
+    /* Not fatal, the transfer just can't be verified. */
+    DEBUG ("Can not verify transfer (%s)", error->message);
+    g_clear_error (&error);
+    g_checksum_free (priv->checksum);
+    priv->checksum = NULL;
+  }
+
+  if (priv->tp_channel) {
+    start_transfer (self);
+  }
+}
+
+bool
+yts_incoming_file_accept (YtsIncomingFile  *self,
+                          GFile            *file,
+                          GError          **error_out)
 {
   YtsIncomingFilePrivate *priv = GET_PRIVATE (self);
+  GFileOutputStream *stream;
+  GError            *error_in = NULL;
+  uint64_t           offset;
 
   g_return_val_if_fail (YTS_IS_INCOMING_FILE (self), false);
-  g_return_val_if_fail (TP_IS_FILE_TRANSFER_CHANNEL (priv->tp_channel), false);
+  g_return_val_if_fail (G_IS_FILE (file), false);
 
-  tp_channel_close_async (TP_CHANNEL (priv->tp_channel),
-                          _channel_close,
-                          self);
-  g_object_unref (priv->tp_channel);
-  priv->tp_channel = NULL;
+  if (!check_not_accepted (self, error_out)) {
+    return false;
+  }
+
+  priv->resume_key = create_resume_key (self);
+  offset = find_resume_offset (self, file);
+
+  /* The partial file has to be there under its name all along, so it
+   * can be found for resuming, hence no g_file_replace(). */
+  if (offset > 0) {
+    stream = g_file_append_to (file, G_FILE_CREATE_NONE, NULL, &error_in);
+  } else {
+    g_file_delete (file, NULL, NULL);
+    stream = g_file_create (file, G_FILE_CREATE_NONE, NULL, &error_in);
+  }
+
+  if (NULL == stream) {
+    if (error_out) {
+      *error_out = g_error_new (YTS_INCOMING_FILE_ERROR,
+                                YTS_INCOMING_FILE_ERROR_ACCEPT_FAILED,
+                                "Failed to open file for writing (%s)",
+                                error_in->message);
+    }
+    g_clear_error (&error_in);
+    return false;
+  }
+
+  priv->stream = G_OUTPUT_STREAM (stream);
+  priv->file = g_object_ref (file);
+  g_object_notify (G_OBJECT (self), "file");
+
+  setup_checksum (self);
+
+  /* Tag the (partial) file, so the transfer can be resumed should it be
+   * interrupted. Not all file systems support this, in which case
+   * interrupted transfers just start over. */
+  if (!g_file_set_attribute_string (priv->file,
+                                    YTS_FILE_TRANSFER_ATTRIBUTE_RESUME_KEY,
+                                    priv->resume_key,
+                                    G_FILE_QUERY_INFO_NONE,
+                                    NULL,
+                                    &error_in)) {
+    DEBUG ("Transfer will not be resumable (%s)", error_in->message);
+    g_clear_error (&error_in);
+  }
+
+  if (offset > 0) {
+
+    DEBUG ("Resuming at offset %" G_GUINT64_FORMAT, offset);
+
+    priv->initial_offset = offset;
+    g_object_notify (G_OBJECT (self), "initial-offset");
+
+    if (priv->checksum) {
+      /* The checksum covers the partial file too, off the main thread.
+       * The result holds a reference to self. */
+      GSimpleAsyncResult *result;
+      result = g_simple_async_result_new (G_OBJECT (self),
+                                          _checksum_prefix,
+                                          NULL,
+                                          yts_incoming_file_accept);
+      g_simple_async_result_run_in_thread (result,
+                                           _checksum_prefix_thread,
+                                           G_PRIORITY_LOW,
+                                           NULL);
+      g_object_unref (result);
+      return true;
+    }
+  }
+
+  start_transfer (self);
 
   return true;
 }
-
@@ -22,7 +22,7 @@
 #define YTS_INCOMING_FILE_H
 
 #include <stdbool.h>
-#include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -46,7 +46,9 @@ enum {
   YTS_INCOMING_FILE_ERROR_ACCEPT_FAILED,
   YTS_INCOMING_FILE_ERROR_ALREADY_ACCEPTED,
   YTS_INCOMING_FILE_ERROR_LOCAL,
-  YTS_INCOMING_FILE_ERROR_REMOTE
+  YTS_INCOMING_FILE_ERROR_REMOTE,
+  YTS_INCOMING_FILE_ERROR_RESUME_FAILED,
+  YTS_INCOMING_FILE_ERROR_CHECKSUM_MISMATCH
 };
 
 bool
@@ -54,6 +56,11 @@ yts_incoming_file_accept (YtsIncomingFile  *self,
                           GFile            *file,
                           GError          **error);
 
+bool
+yts_incoming_file_accept_stream (YtsIncomingFile  *self,
+                                 GOutputStream    *stream,
+                                 GError          **error);
+
 bool
 yts_incoming_file_reject (YtsIncomingFile  *self,
                           GError          **error);
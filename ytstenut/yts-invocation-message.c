@@ -22,6 +22,7 @@
 
 #include <stdbool.h>
 
+#include "yts-metadata-internal.h"
 #include "yts-invocation-message.h"
 
 G_DEFINE_TYPE (YtsInvocationMessage, yts_invocation_message, YTS_TYPE_METADATA)
@@ -87,6 +88,7 @@ yts_invocation_message_new (char const *invocation_id,
                              GVariant   *arguments)
 {
   RestXmlNode *node;
+  YtsMetadata *message;
 
   node = rest_xml_node_add_child (NULL, "message");
   /* PONDERING need those keywords be made reserved */
@@ -95,18 +97,13 @@ yts_invocation_message_new (char const *invocation_id,
   rest_xml_node_add_attr (node, "capability", capability);
   rest_xml_node_add_attr (node, "aspect", aspect);
 
-  if (arguments) {
-    char *args = g_variant_print (arguments, false);
-    /* FIXME this is just a stopgap solution to lacking g_markup_unescape_text()
-     * want to move to complex message bodies anywy. */
-    char *escaped_args = g_uri_escape_string (args, NULL, true);
-    rest_xml_node_add_attr (node, "arguments", escaped_args);
-    g_free (escaped_args);
-    g_free (args);
-  }
+  message = g_object_new (YTS_TYPE_INVOCATION_MESSAGE,
+                          "top-level-node", node,
+                          NULL);
+
+  /* Serialised on demand only. */
+  yts_metadata_set_payload (message, "arguments", arguments);
 
-  return g_object_new (YTS_TYPE_INVOCATION_MESSAGE,
-                       "top-level-node", node,
-                       NULL);
+  return message;
 }
 
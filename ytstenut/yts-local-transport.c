@@ -0,0 +1,1145 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <gio/gio.h>
+#ifdef HAVE_LOCAL_TRANSPORT
+#include <gio/gunixsocketaddress.h>
+#endif
+
+#include "yts-local-transport.h"
+#include "yts-marshal.h"
+#include "yts-metadata.h"
+#include "ytstenut-internal.h"
+
+G_DEFINE_TYPE (YtsLocalTransport, yts_local_transport, G_TYPE_OBJECT)
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN PACKAGE"\0local-transport\0"G_STRLOC
+
+/*
+ * YtsLocalTransport carries messages between clients running on the same
+ * host without going through the connection manager. Every client listens
+ * on an abstract Unix socket named after a hash of its contact and service
+ * id. Sending to a peer first tries to connect to the peer's socket; when
+ * nobody is listening there the peer is remote, this is remembered for a
+ * while, and the caller falls back to Telepathy. Services discovered
+ * through Telepathy are probed the same way, so peers on this host find
+ * each other before the first message and exchange statuses directly.
+ *
+ * Sockets are SOCK_SEQPACKET, so every frame is one packet:
+ *
+ *   uint32 magic, uint16 type, uint16 reserved, uint32 length, payload
+ *
+ * all in host byte order. The first frame on a connection is a HELLO
+ * carrying "contact-id\0service-id\0" of the connecting side. Both sides
+ * then send a STATUS frame "fqc-id\0status-xml\0" for every capability
+ * status they advertise, and again whenever one changes. MESSAGE frames
+ * carry the message XML.
+ *
+ * Messages still queued when a connection breaks are handed back through
+ * the "undelivered" signal so they can go through Telepathy instead.
+ */
+
+#define FRAME_MAGIC 0x31535459 /* "YTS1" */
+#define FRAME_HEADER_SIZE 12
+#define MAX_FRAME_SIZE (128 * 1024)
+#define MAX_PAYLOAD_SIZE (MAX_FRAME_SIZE - FRAME_HEADER_SIZE)
+
+/* How long to remember that a peer is not on this host, seconds. */
+#define UNREACHABLE_TTL_S 30
+
+enum {
+  FRAME_HELLO = 1,
+  FRAME_MESSAGE = 2,
+  FRAME_STATUS = 3
+};
+
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), YTS_TYPE_LOCAL_TRANSPORT, YtsLocalTransportPrivate))
+
+enum {
+  SIG_MESSAGE,
+  SIG_STATUS_CHANGED,
+  SIG_UNDELIVERED,
+
+  N_SIGNALS
+};
+
+typedef struct {
+  char        *contact_id;
+  char        *service_id;
+  GSocket     *listener;
+  GSource     *listener_source;
+  GList       *connections;   /* owned, of Connection */
+  GHashTable  *peers;         /* peer key -> Connection, unowned */
+  GHashTable  *unreachable;   /* peer key -> int64_t expiry, seconds */
+  GHashTable  *statuses;      /* fqc id -> status xml, owned */
+  uint8_t     *buffer;
+  uint64_t     bytes_sent;
+} YtsLocalTransportPrivate;
+
+typedef struct {
+  YtsLocalTransport *transport;
+  GSocket           *socket;
+  GSource           *in_source;
+  GSource           *out_source;
+  GQueue             out_queue;   /* of GByteArray */
+  char              *peer_key;
+  char              *peer_contact_id;
+  char              *peer_service_id;
+} Connection;
+
+static unsigned _signals[N_SIGNALS] = { 0, };
+
+#ifdef HAVE_LOCAL_TRANSPORT
+
+static char *
+make_peer_key (char const *contact_id,
+               char const *service_id)
+{
+  return g_strdup_printf ("%s/%s", contact_id, service_id);
+}
+
+static GSocketAddress *
+make_address (char const *peer_key)
+{
+  GSocketAddress  *address;
+  char            *digest;
+  char            *path;
+
+  /* Abstract socket names are limited in length, ids are not. */
+  digest = g_compute_checksum_for_string (G_CHECKSUM_SHA1, peer_key, -1);
+  path = g_strdup_printf ("ytstenut-%s", digest);
+  address = g_unix_socket_address_new_with_type (path, -1,
+                                              G_UNIX_SOCKET_ADDRESS_ABSTRACT);
+  g_free (path);
+  g_free (digest);
+
+  return address;
+}
+
+static bool
+check_peer_credentials (GSocket *socket)
+{
+  GCredentials  *credentials;
+  GError        *error = NULL;
+  bool           ret;
+
+  credentials = g_socket_get_credentials (socket, &error);
+  if (NULL == credentials) {
+    g_warning ("%s : %s", G_STRLOC, error->message);
+    g_clear_error (&error);
+    return false;
+  }
+
+  ret = (uid_t) g_credentials_get_unix_user (credentials, NULL) == getuid ();
+  if (!ret) {
+    g_warning ("%s : Rejecting local peer running as a different user",
+               G_STRLOC);
+  }
+
+  g_object_unref (credentials);
+  return ret;
+}
+
+static GByteArray *
+frame_new (uint16_t      type,
+           void const   *payload,
+           uint32_t      length)
+{
+  GByteArray  *frame;
+  uint32_t     magic = FRAME_MAGIC;
+  uint16_t     reserved = 0;
+
+  frame = g_byte_array_sized_new (FRAME_HEADER_SIZE + length);
+  g_byte_array_append (frame, (guint8 const *) &magic, sizeof (magic));
+  g_byte_array_append (frame, (guint8 const *) &type, sizeof (type));
+  g_byte_array_append (frame, (guint8 const *) &reserved, sizeof (reserved));
+  g_byte_array_append (frame, (guint8 const *) &length, sizeof (length));
+  g_byte_array_append (frame, payload, length);
+
+  return frame;
+}
+
+static void
+frame_free (GByteArray *frame)
+{
+  g_byte_array_free (frame, true);
+}
+
+/*
+ * Remove the messages from the queue of @conn, returns their payloads in
+ * order. Other frames stay queued.
+ */
+static GList *
+connection_take_messages (Connection *conn)
+{
+  GList *messages = NULL;
+  GList *iter;
+
+  iter = conn->out_queue.head;
+  while (iter) {
+    GByteArray  *frame = iter->data;
+    GList       *next = iter->next;
+    uint16_t     type;
+
+    /* Frames are only ever written whole, none of these has been started. */
+    memcpy (&type, frame->data + 4, sizeof (type));
+    if (type == FRAME_MESSAGE) {
+      if (conn->peer_contact_id) {
+        messages = g_list_prepend (messages,
+                      g_strndup ((char const *) frame->data + FRAME_HEADER_SIZE,
+                                 frame->len - FRAME_HEADER_SIZE));
+      }
+      g_queue_delete_link (&conn->out_queue, iter);
+      frame_free (frame);
+    }
+    iter = next;
+  }
+
+  return g_list_reverse (messages);
+}
+
+static void
+connection_close (Connection *conn)
+{
+  YtsLocalTransportPrivate *priv = GET_PRIVATE (conn->transport);
+  GByteArray  *frame;
+  GList       *undelivered;
+  GList       *iter;
+
+  if (conn->peer_key &&
+      conn == g_hash_table_lookup (priv->peers, conn->peer_key)) {
+    g_hash_table_remove (priv->peers, conn->peer_key);
+  }
+
+  priv->connections = g_list_remove (priv->connections, conn);
+
+  if (conn->in_source) {
+    g_source_destroy (conn->in_source);
+    g_source_unref (conn->in_source);
+  }
+
+  if (conn->out_source) {
+    g_source_destroy (conn->out_source);
+    g_source_unref (conn->out_source);
+  }
+
+  undelivered = connection_take_messages (conn);
+  while (NULL != (frame = g_queue_pop_head (&conn->out_queue))) {
+    frame_free (frame);
+  }
+
+  /* The connection is off the books already, handlers may send again. */
+  for (iter = undelivered; iter; iter = iter->next) {
+    g_signal_emit (conn->transport, _signals[SIG_UNDELIVERED], 0,
+                   conn->peer_contact_id,
+                   conn->peer_service_id,
+                   (char const *) iter->data);
+    g_free (iter->data);
+  }
+  g_list_free (undelivered);
+
+  g_socket_close (conn->socket, NULL);
+  g_object_unref (conn->socket);
+  g_free (conn->peer_key);
+  g_free (conn->peer_contact_id);
+  g_free (conn->peer_service_id);
+  g_slice_free (Connection, conn);
+}
+
+static GByteArray *
+status_frame_new (char const *fqc_id,
+                  char const *status_xml)
+{
+  GByteArray  *frame;
+  GString     *payload;
+
+  payload = g_string_new (fqc_id);
+  g_string_append_c (payload, '\0');
+  g_string_append (payload, status_xml);
+  g_string_append_c (payload, '\0');
+  frame = frame_new (FRAME_STATUS, payload->str, payload->len);
+  g_string_free (payload, true);
+
+  return frame;
+}
+
+static bool connection_send (Connection *conn, GByteArray *frame);
+
+/*
+ * Returns: %false when the connection is broken, see connection_send().
+ */
+static bool
+connection_send_statuses (Connection *conn)
+{
+  YtsLocalTransportPrivate *priv = GET_PRIVATE (conn->transport);
+  GHashTableIter   iter;
+  char const      *fqc_id;
+  char const      *status_xml;
+
+  g_hash_table_iter_init (&iter, priv->statuses);
+  while (g_hash_table_iter_next (&iter,
+                                 (void **) &fqc_id,
+                                 (void **) &status_xml)) {
+    if (!connection_send (conn, status_frame_new (fqc_id, status_xml))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * Split a payload made of two nul-terminated strings.
+ */
+static bool
+split_payload (char const  *payload,
+               uint32_t     length,
+               char const **first,
+               char const **second)
+{
+  if (length < 2 ||
+      payload[length - 1] != '\0' ||
+      NULL == memchr (payload, '\0', length - 1)) {
+    return false;
+  }
+
+  *first = payload;
+  *second = payload + strlen (payload) + 1;
+
+  /* Nothing may follow the second string. */
+  return *second + strlen (*second) + 1 == payload + length;
+}
+
+static bool
+handle_hello (Connection  *conn,
+              char const  *payload,
+              uint32_t     length)
+{
+  YtsLocalTransportPrivate *priv = GET_PRIVATE (conn->transport);
+  char const *contact_id;
+  char const *service_id;
+
+  if (!split_payload (payload, length, &contact_id, &service_id) ||
+      '\0' == contact_id[0] ||
+      '\0' == service_id[0]) {
+    return false;
+  }
+
+  g_free (conn->peer_key);
+  g_free (conn->peer_contact_id);
+  g_free (conn->peer_service_id);
+  conn->peer_contact_id = g_strdup (contact_id);
+  conn->peer_service_id = g_strdup (service_id);
+  conn->peer_key = make_peer_key (contact_id, service_id);
+
+  /* The peer may just have started, and it can take our messages too. */
+  g_hash_table_remove (priv->unreachable, conn->peer_key);
+  if (NULL == g_hash_table_lookup (priv->peers, conn->peer_key)) {
+    g_hash_table_insert (priv->peers, g_strdup (conn->peer_key), conn);
+  }
+
+  /* A broken connection is noticed and closed on the next read. */
+  if (!connection_send_statuses (conn)) {
+    g_debug ("%s : Could not send statuses to local peer %s",
+             G_STRLOC, conn->peer_key);
+  }
+
+  return true;
+}
+
+static bool
+handle_status (Connection *conn,
+               char const *payload,
+               uint32_t    length)
+{
+  char const *fqc_id;
+  char const *status_xml;
+
+  if (NULL == conn->peer_contact_id ||
+      !split_payload (payload, length, &fqc_id, &status_xml) ||
+      '\0' == fqc_id[0]) {
+    return false;
+  }
+
+  g_signal_emit (conn->transport, _signals[SIG_STATUS_CHANGED], 0,
+                 conn->peer_contact_id,
+                 fqc_id,
+                 conn->peer_service_id,
+                 status_xml);
+
+  return true;
+}
+
+static bool
+handle_frame (Connection  *conn,
+              uint8_t     *frame,
+              gssize       size)
+{
+  uint32_t  magic;
+  uint16_t  type;
+  uint32_t  length;
+
+  if (size < FRAME_HEADER_SIZE) {
+    return false;
+  }
+
+  memcpy (&magic, frame, sizeof (magic));
+  memcpy (&type, frame + 4, sizeof (type));
+  memcpy (&length, frame + 8, sizeof (length));
+
+  if (magic != FRAME_MAGIC ||
+      length != (uint32_t) (size - FRAME_HEADER_SIZE)) {
+    return false;
+  }
+
+  switch (type) {
+    case FRAME_HELLO:
+      return handle_hello (conn, (char const *) frame + FRAME_HEADER_SIZE,
+                           length);
+    case FRAME_STATUS:
+      return handle_status (conn, (char const *) frame + FRAME_HEADER_SIZE,
+                            length);
+    case FRAME_MESSAGE:
+      if (NULL == conn->peer_contact_id) {
+        return false;
+      }
+      /* The buffer has room for one byte past the largest frame. */
+      frame[size] = '\0';
+      g_signal_emit (conn->transport, _signals[SIG_MESSAGE], 0,
+                     conn->peer_contact_id,
+                     conn->peer_service_id,
+                     (char const *) frame + FRAME_HEADER_SIZE);
+      return true;
+    default:
+      /* Unknown frame types are skipped for forward compatibility. */
+      return true;
+  }
+}
+
+static gboolean
+_connection_in (GSocket       *socket,
+                GIOCondition   condition,
+                Connection    *conn)
+{
+  YtsLocalTransportPrivate *priv = GET_PRIVATE (conn->transport);
+  GError  *error = NULL;
+  gssize   size;
+
+  /* One frame per dispatch, signal handlers may send to this very peer
+   * and close the connection under our feet when that fails. */
+
+  /* Receive one more than the largest frame to detect truncation. */
+  size = g_socket_receive (socket, (char *) priv->buffer, MAX_FRAME_SIZE + 1,
+                           NULL, &error);
+  if (size < 0 &&
+      g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+    g_clear_error (&error);
+    return true;
+  }
+
+  if (size < 0) {
+    g_warning ("%s : %s", G_STRLOC, error->message);
+    g_clear_error (&error);
+    connection_close (conn);
+    return false;
+  }
+
+  if (size == 0) {
+    /* Peer went away. */
+    connection_close (conn);
+    return false;
+  }
+
+  if (size > MAX_FRAME_SIZE ||
+      !handle_frame (conn, priv->buffer, size)) {
+    g_warning ("%s : Malformed frame from local peer, disconnecting",
+               G_STRLOC);
+    connection_close (conn);
+    return false;
+  }
+
+  return true;
+}
+
+static gboolean
+_connection_out (GSocket      *socket,
+                 GIOCondition  condition,
+                 Connection   *conn)
+{
+  GByteArray  *frame;
+  GError      *error = NULL;
+  gssize       size;
+
+  while (NULL != (frame = g_queue_peek_head (&conn->out_queue))) {
+
+    size = g_socket_send (socket, (char const *) frame->data, frame->len,
+                          NULL, &error);
+    if (size < 0 &&
+        g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+      g_clear_error (&error);
+      return true;
+    }
+
+    if (size != (gssize) frame->len) {
+      g_warning ("%s : %s", G_STRLOC,
+                 error ? error->message : "Short write");
+      g_clear_error (&error);
+      connection_close (conn);
+      return false;
+    }
+
+    g_queue_pop_head (&conn->out_queue);
+    frame_free (frame);
+  }
+
+  g_source_unref (conn->out_source);
+  conn->out_source = NULL;
+  return false;
+}
+
+/*
+ * Returns: %false when the connection is broken. The frame is consumed
+ * either way, the caller must close the connection on failure.
+ */
+static bool
+connection_send (Connection *conn,
+                 GByteArray *frame)
+{
+  GError  *error = NULL;
+  gssize   size;
+
+  if (!g_queue_is_empty (&conn->out_queue)) {
+    g_queue_push_tail (&conn->out_queue, frame);
+    return true;
+  }
+
+  size = g_socket_send (conn->socket, (char const *) frame->data, frame->len,
+                        NULL, &error);
+  if (size == (gssize) frame->len) {
+    frame_free (frame);
+    return true;
+  }
+
+  if (size < 0 &&
+      g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+    g_clear_error (&error);
+    g_queue_push_tail (&conn->out_queue, frame);
+    conn->out_source = g_socket_create_source (conn->socket, G_IO_OUT, NULL);
+    g_source_set_callback (conn->out_source, (GSourceFunc) _connection_out,
+                           conn, NULL);
+    g_source_attach (conn->out_source, NULL);
+    return true;
+  }
+
+  g_debug ("%s : %s", G_STRLOC, error ? error->message : "Short write");
+  g_clear_error (&error);
+  frame_free (frame);
+  return false;
+}
+
+static Connection *
+connection_new (YtsLocalTransport *self,
+                GSocket           *socket)
+{
+  YtsLocalTransportPrivate *priv = GET_PRIVATE (self);
+  Connection *conn;
+
+  conn = g_slice_new0 (Connection);
+  conn->transport = self;
+  conn->socket = socket;
+  g_queue_init (&conn->out_queue);
+
+  conn->in_source = g_socket_create_source (socket, G_IO_IN, NULL);
+  g_source_set_callback (conn->in_source, (GSourceFunc) _connection_in,
+                         conn, NULL);
+  g_source_attach (conn->in_source, NULL);
+
+  priv->connections = g_list_prepend (priv->connections, conn);
+
+  return conn;
+}
+
+static Connection *
+connection_connect (YtsLocalTransport *self,
+                    char const        *peer_key,
+                    char const        *contact_id,
+                    char const        *service_id)
+{
+  YtsLocalTransportPrivate *priv = GET_PRIVATE (self);
+  GSocketAddress  *address;
+  GSocket         *socket;
+  Connection      *conn;
+  GByteArray      *hello;
+  GString         *payload;
+  bool             connected;
+
+  socket = g_socket_new (G_SOCKET_FAMILY_UNIX,
+                         G_SOCKET_TYPE_SEQPACKET,
+                         G_SOCKET_PROTOCOL_DEFAULT,
+                         NULL);
+  if (NULL == socket) {
+    return NULL;
+  }
+
+  g_socket_set_blocking (socket, false);
+
+  /* Local connects complete immediately or fail, there is no
+   * in-progress state worth waiting for. */
+  address = make_address (peer_key);
+  connected = g_socket_connect (socket, address, NULL, NULL) &&
+              check_peer_credentials (socket);
+  g_object_unref (address);
+
+  if (!connected) {
+    g_object_unref (socket);
+    return NULL;
+  }
+
+  conn = connection_new (self, socket);
+  conn->peer_key = g_strdup (peer_key);
+  conn->peer_contact_id = g_strdup (contact_id);
+  conn->peer_service_id = g_strdup (service_id);
+  g_hash_table_insert (priv->peers, g_strdup (peer_key), conn);
+
+  payload = g_string_new (priv->contact_id);
+  g_string_append_c (payload, '\0');
+  g_string_append (payload, priv->service_id);
+  g_string_append_c (payload, '\0');
+  hello = frame_new (FRAME_HELLO, payload->str, payload->len);
+  g_string_free (payload, true);
+
+  if (!connection_send (conn, hello) ||
+      !connection_send_statuses (conn)) {
+    connection_close (conn);
+    return NULL;
+  }
+
+  return conn;
+}
+
+static gboolean
+_listener_in (GSocket           *listener,
+              GIOCondition       condition,
+              YtsLocalTransport *self)
+{
+  GSocket *socket;
+  GError  *error = NULL;
+
+  while (NULL != (socket = g_socket_accept (listener, NULL, &error))) {
+    g_socket_set_blocking (socket, false);
+    if (check_peer_credentials (socket)) {
+      /* Peer identity is established by its HELLO frame. */
+      connection_new (self, socket);
+    } else {
+      g_object_unref (socket);
+    }
+  }
+
+  if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+    g_warning ("%s : %s", G_STRLOC, error->message);
+  }
+  g_clear_error (&error);
+
+  return true;
+}
+
+static bool
+is_unreachable (YtsLocalTransport *self,
+                char const        *peer_key)
+{
+  YtsLocalTransportPrivate *priv = GET_PRIVATE (self);
+  int64_t *expiry;
+
+  expiry = g_hash_table_lookup (priv->unreachable, peer_key);
+  if (NULL == expiry) {
+    return false;
+  }
+
+  if (*expiry > g_get_monotonic_time () / G_USEC_PER_SEC) {
+    return true;
+  }
+
+  g_hash_table_remove (priv->unreachable, peer_key);
+  return false;
+}
+
+static void
+set_unreachable (YtsLocalTransport *self,
+                 char const        *peer_key)
+{
+  YtsLocalTransportPrivate *priv = GET_PRIVATE (self);
+  int64_t *expiry;
+
+  expiry = g_new (int64_t, 1);
+  *expiry = g_get_monotonic_time () / G_USEC_PER_SEC + UNREACHABLE_TTL_S;
+  g_hash_table_insert (priv->unreachable, g_strdup (peer_key), expiry);
+}
+
+/*
+ * Returns: the connection to the peer, or %NULL if it is not on this host.
+ */
+static Connection *
+ensure_connection (YtsLocalTransport *self,
+                   char const        *contact_id,
+                   char const        *service_id)
+{
+  YtsLocalTransportPrivate *priv = GET_PRIVATE (self);
+  Connection  *conn;
+  char        *key;
+
+  if (NULL == priv->listener ||
+      (0 == g_strcmp0 (contact_id, priv->contact_id) &&
+       0 == g_strcmp0 (service_id, priv->service_id))) {
+    return NULL;
+  }
+
+  key = make_peer_key (contact_id, service_id);
+
+  conn = g_hash_table_lookup (priv->peers, key);
+  if (NULL == conn &&
+      !is_unreachable (self, key)) {
+    conn = connection_connect (self, key, contact_id, service_id);
+    if (NULL == conn) {
+      set_unreachable (self, key);
+    }
+  }
+
+  g_free (key);
+
+  return conn;
+}
+
+#endif /* HAVE_LOCAL_TRANSPORT */
+
+static void
+_dispose (GObject *object)
+{
+  YtsLocalTransportPrivate *priv = GET_PRIVATE (object);
+
+#ifdef HAVE_LOCAL_TRANSPORT
+  while (priv->connections) {
+    connection_close ((Connection *) priv->connections->data);
+  }
+#endif
+
+  if (priv->listener_source) {
+    g_source_destroy (priv->listener_source);
+    g_source_unref (priv->listener_source);
+    priv->listener_source = NULL;
+  }
+
+  if (priv->listener) {
+    g_socket_close (priv->listener, NULL);
+    g_object_unref (priv->listener);
+    priv->listener = NULL;
+  }
+
+  G_OBJECT_CLASS (yts_local_transport_parent_class)->dispose (object);
+}
+
+static void
+_finalize (GObject *object)
+{
+  YtsLocalTransportPrivate *priv = GET_PRIVATE (object);
+
+  g_free (priv->contact_id);
+  g_free (priv->service_id);
+  g_hash_table_destroy (priv->peers);
+  g_hash_table_destroy (priv->unreachable);
+  g_hash_table_destroy (priv->statuses);
+  g_free (priv->buffer);
+
+  G_OBJECT_CLASS (yts_local_transport_parent_class)->finalize (object);
+}
+
+static void
+yts_local_transport_class_init (YtsLocalTransportClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  g_type_class_add_private (klass, sizeof (YtsLocalTransportPrivate));
+
+  object_class->dispose = _dispose;
+  object_class->finalize = _finalize;
+
+  /*
+   * YtsLocalTransport::message:
+   * @self: object which emitted the signal.
+   * @contact_id: contact id of the sending peer.
+   * @service_id: service id of the sending peer.
+   * @xml: message as sent.
+   *
+   * A message from a peer on this host has been received.
+   */
+  _signals[SIG_MESSAGE] = g_signal_new ("message",
+                                        G_TYPE_FROM_CLASS (object_class),
+                                        G_SIGNAL_RUN_LAST,
+                                        0, NULL, NULL,
+                                        yts_marshal_VOID__STRING_STRING_STRING,
+                                        G_TYPE_NONE, 3,
+                                        G_TYPE_STRING,
+                                        G_TYPE_STRING,
+                                        G_TYPE_STRING);
+
+  /*
+   * YtsLocalTransport::status-changed:
+   * @self: object which emitted the signal.
+   * @contact_id: contact id of the sending peer.
+   * @fqc_id: fully qualified capability id.
+   * @service_id: service id of the sending peer.
+   * @status_xml: status as advertised.
+   *
+   * A peer on this host has advertised a status, same as
+   * #YtsTransport::status-changed.
+   */
+  _signals[SIG_STATUS_CHANGED] = g_signal_new ("status-changed",
+                                        G_TYPE_FROM_CLASS (object_class),
+                                        G_SIGNAL_RUN_LAST,
+                                        0, NULL, NULL,
+                                        yts_marshal_VOID__STRING_STRING_STRING_STRING,
+                                        G_TYPE_NONE, 4,
+                                        G_TYPE_STRING,
+                                        G_TYPE_STRING,
+                                        G_TYPE_STRING,
+                                        G_TYPE_STRING);
+
+  /*
+   * YtsLocalTransport::undelivered:
+   * @self: object which emitted the signal.
+   * @contact_id: contact id of the recipient.
+   * @service_id: service id of the recipient.
+   * @xml: message as sent.
+   *
+   * The connection to a peer on this host broke before the message could
+   * be written, it needs to go through Telepathy instead.
+   */
+  _signals[SIG_UNDELIVERED] = g_signal_new ("undelivered",
+                                        G_TYPE_FROM_CLASS (object_class),
+                                        G_SIGNAL_RUN_LAST,
+                                        0, NULL, NULL,
+                                        yts_marshal_VOID__STRING_STRING_STRING,
+                                        G_TYPE_NONE, 3,
+                                        G_TYPE_STRING,
+                                        G_TYPE_STRING,
+                                        G_TYPE_STRING);
+}
+
+static void
+yts_local_transport_init (YtsLocalTransport *self)
+{
+  YtsLocalTransportPrivate *priv = GET_PRIVATE (self);
+
+  priv->peers = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                       g_free, NULL);
+  priv->unreachable = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             g_free, g_free);
+  priv->statuses = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, g_free);
+}
+
+YtsLocalTransport *
+yts_local_transport_new (char const *contact_id,
+                         char const *service_id)
+{
+  YtsLocalTransport *self;
+  YtsLocalTransportPrivate *priv;
+
+  g_return_val_if_fail (contact_id && service_id, NULL);
+
+  self = g_object_new (YTS_TYPE_LOCAL_TRANSPORT, NULL);
+  priv = GET_PRIVATE (self);
+
+  priv->contact_id = g_strdup (contact_id);
+  priv->service_id = g_strdup (service_id);
+
+  return self;
+}
+
+/*
+ * yts_local_transport_start:
+ * @self: object on which to invoke this method.
+ * @error: return location for an error.
+ *
+ * Start listening for peers on this host.
+ *
+ * Returns: %false when the local transport is not available, in which
+ * case all messages go through Telepathy.
+ */
+bool
+yts_local_transport_start (YtsLocalTransport  *self,
+                           GError            **error)
+{
+#ifdef HAVE_LOCAL_TRANSPORT
+  YtsLocalTransportPrivate *priv;
+  GSocketAddress  *address;
+  char            *key;
+  bool             listening;
+
+  g_return_val_if_fail (YTS_IS_LOCAL_TRANSPORT (self), false);
+
+  priv = GET_PRIVATE (self);
+
+  if (priv->listener) {
+    return true;
+  }
+
+  priv->listener = g_socket_new (G_SOCKET_FAMILY_UNIX,
+                                 G_SOCKET_TYPE_SEQPACKET,
+                                 G_SOCKET_PROTOCOL_DEFAULT,
+                                 error);
+  if (NULL == priv->listener) {
+    return false;
+  }
+
+  g_socket_set_blocking (priv->listener, false);
+
+  key = make_peer_key (priv->contact_id, priv->service_id);
+  address = make_address (key);
+  listening = g_socket_bind (priv->listener, address, false, error) &&
+              g_socket_listen (priv->listener, error);
+  g_object_unref (address);
+  g_free (key);
+
+  if (!listening) {
+    g_object_unref (priv->listener);
+    priv->listener = NULL;
+    return false;
+  }
+
+  priv->buffer = g_malloc (MAX_FRAME_SIZE + 1);
+
+  priv->listener_source = g_socket_create_source (priv->listener, G_IO_IN,
+                                                  NULL);
+  g_source_set_callback (priv->listener_source, (GSourceFunc) _listener_in,
+                         self, NULL);
+  g_source_attach (priv->listener_source, NULL);
+
+  return true;
+#else
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                       "Local transport not supported on this platform");
+  return false;
+#endif
+}
+
+/*
+ * yts_local_transport_send:
+ * @self: object on which to invoke this method.
+ * @contact_id: contact id of the recipient.
+ * @service_id: service id of the recipient.
+ * @message: message to send.
+ *
+ * Send @message to a peer if it is running on this host. The message is
+ * only serialised once the peer is known to be local.
+ *
+ * Returns: %true if the message has been handed to a local peer, %false
+ * if it needs to go through Telepathy.
+ */
+bool
+yts_local_transport_send (YtsLocalTransport *self,
+                          char const        *contact_id,
+                          char const        *service_id,
+                          YtsMetadata       *message)
+{
+#ifdef HAVE_LOCAL_TRANSPORT
+  YtsLocalTransportPrivate *priv;
+  Connection  *conn;
+  char        *xml;
+  size_t       length;
+  bool         sent;
+
+  g_return_val_if_fail (YTS_IS_LOCAL_TRANSPORT (self), false);
+  g_return_val_if_fail (contact_id && service_id, false);
+  g_return_val_if_fail (YTS_IS_METADATA (message), false);
+
+  priv = GET_PRIVATE (self);
+
+  conn = ensure_connection (self, contact_id, service_id);
+  if (NULL == conn) {
+    return false;
+  }
+
+  xml = yts_metadata_to_string (message);
+  length = strlen (xml);
+  if (length > MAX_PAYLOAD_SIZE) {
+    /* Rare enough that Telepathy can take it. */
+    g_free (xml);
+    return false;
+  }
+
+  sent = connection_send (conn, frame_new (FRAME_MESSAGE, xml, length));
+  g_free (xml);
+  if (sent) {
+    priv->bytes_sent += length;
+  } else {
+    connection_close (conn);
+  }
+
+  return sent;
+#else
+  return false;
+#endif
+}
+
+/*
+ * yts_local_transport_connect:
+ * @self: object on which to invoke this method.
+ * @contact_id: contact id of a newly discovered service.
+ * @service_id: id of the service.
+ *
+ * Try to reach a service discovered through Telepathy on this host, so
+ * statuses are exchanged directly from now on.
+ *
+ * Returns: %true if the service is running on this host.
+ */
+bool
+yts_local_transport_connect (YtsLocalTransport *self,
+                             char const        *contact_id,
+                             char const        *service_id)
+{
+#ifdef HAVE_LOCAL_TRANSPORT
+  g_return_val_if_fail (YTS_IS_LOCAL_TRANSPORT (self), false);
+  g_return_val_if_fail (contact_id && service_id, false);
+
+  return NULL != ensure_connection (self, contact_id, service_id);
+#else
+  return false;
+#endif
+}
+
+/*
+ * yts_local_transport_advertise_status:
+ * @self: object on which to invoke this method.
+ * @fqc_id: fully qualified capability id.
+ * @status_xml: status to advertise.
+ *
+ * Pass a status to all peers on this host, now and when they connect.
+ */
+void
+yts_local_transport_advertise_status (YtsLocalTransport *self,
+                                      char const        *fqc_id,
+                                      char const        *status_xml)
+{
+  YtsLocalTransportPrivate *priv;
+#ifdef HAVE_LOCAL_TRANSPORT
+  GList *iter;
+#endif
+
+  g_return_if_fail (YTS_IS_LOCAL_TRANSPORT (self));
+  g_return_if_fail (fqc_id && status_xml);
+
+  priv = GET_PRIVATE (self);
+
+  g_hash_table_insert (priv->statuses, g_strdup (fqc_id),
+                                       g_strdup (status_xml));
+
+#ifdef HAVE_LOCAL_TRANSPORT
+  iter = priv->connections;
+  while (iter) {
+    Connection *conn = iter->data;
+    iter = iter->next;
+    /* Accepted connections only know their peer after HELLO, which
+     * brings the current statuses along. */
+    if (conn->peer_key &&
+        !connection_send (conn, status_frame_new (fqc_id, status_xml))) {
+      connection_close (conn);
+    }
+  }
+#endif
+}
+
+/*
+ * yts_local_transport_take_queued:
+ * @self: object on which to invoke this method.
+ * @func: called for every message, in order per peer.
+ * @data: context to pass to @func.
+ *
+ * Hand out all messages still waiting to be written to peers on this host,
+ * and forget them, so they are not reported through
+ * #YtsLocalTransport::undelivered any more. Used before the transport goes
+ * away, @func must not call back into @self.
+ */
+void
+yts_local_transport_take_queued (YtsLocalTransport           *self,
+                                 YtsLocalTransportQueuedFunc  func,
+                                 void                        *data)
+{
+#ifdef HAVE_LOCAL_TRANSPORT
+  YtsLocalTransportPrivate *priv;
+  GList *iter;
+
+  g_return_if_fail (YTS_IS_LOCAL_TRANSPORT (self));
+  g_return_if_fail (func);
+
+  priv = GET_PRIVATE (self);
+
+  for (iter = priv->connections; iter; iter = iter->next) {
+    Connection  *conn = iter->data;
+    GList       *messages;
+    GList       *msg_iter;
+
+    messages = connection_take_messages (conn);
+    for (msg_iter = messages; msg_iter; msg_iter = msg_iter->next) {
+      func (conn->peer_contact_id,
+            conn->peer_service_id,
+            (char const *) msg_iter->data,
+            data);
+      g_free (msg_iter->data);
+    }
+    g_list_free (messages);
+  }
+#endif
+}
+
+/*
+ * yts_local_transport_get_statistics:
+ *
+ * Frames queued for a peer that is not reading count as waiting messages,
+ * connections as open channels.
+ */
+void
+yts_local_transport_get_statistics (YtsLocalTransport      *self,
+                                    YtsTransportStatistics *statistics)
+{
+  YtsLocalTransportPrivate *priv;
+  GList *iter;
+
+  g_return_if_fail (YTS_IS_LOCAL_TRANSPORT (self));
+  g_return_if_fail (statistics);
+
+  priv = GET_PRIVATE (self);
+
+  memset (statistics, 0, sizeof (*statistics));
+  statistics->bytes_sent = priv->bytes_sent;
+
+  for (iter = priv->connections; iter; iter = iter->next) {
+    Connection *conn = iter->data;
+    statistics->messages_waiting += g_queue_get_length (&conn->out_queue);
+    statistics->channels_open++;
+  }
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_LOCAL_TRANSPORT_H
+#define YTS_LOCAL_TRANSPORT_H
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include <ytstenut/yts-metadata.h>
+#include <ytstenut/yts-transport.h>
+
+G_BEGIN_DECLS
+
+#define YTS_TYPE_LOCAL_TRANSPORT (yts_local_transport_get_type ())
+
+#define YTS_LOCAL_TRANSPORT(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), YTS_TYPE_LOCAL_TRANSPORT, YtsLocalTransport))
+
+#define YTS_LOCAL_TRANSPORT_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), YTS_TYPE_LOCAL_TRANSPORT, YtsLocalTransportClass))
+
+#define YTS_IS_LOCAL_TRANSPORT(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), YTS_TYPE_LOCAL_TRANSPORT))
+
+#define YTS_IS_LOCAL_TRANSPORT_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), YTS_TYPE_LOCAL_TRANSPORT))
+
+#define YTS_LOCAL_TRANSPORT_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), YTS_TYPE_LOCAL_TRANSPORT, YtsLocalTransportClass))
+
+typedef struct {
+  GObject parent;
+} YtsLocalTransport;
+
+typedef struct {
+  GObjectClass parent;
+} YtsLocalTransportClass;
+
+GType
+yts_local_transport_get_type (void) G_GNUC_CONST;
+
+YtsLocalTransport *
+yts_local_transport_new (char const *contact_id,
+                         char const *service_id);
+
+bool
+yts_local_transport_start (YtsLocalTransport  *self,
+                           GError            **error);
+
+bool
+yts_local_transport_send (YtsLocalTransport *self,
+                          char const        *contact_id,
+                          char const        *service_id,
+                          YtsMetadata       *message);
+
+bool
+yts_local_transport_connect (YtsLocalTransport *self,
+                             char const        *contact_id,
+                             char const        *service_id);
+
+void
+yts_local_transport_advertise_status (YtsLocalTransport *self,
+                                      char const        *fqc_id,
+                                      char const        *status_xml);
+
+typedef void
+(*YtsLocalTransportQueuedFunc) (char const  *contact_id,
+                                char const  *service_id,
+                                char const  *xml,
+                                void        *data);
+
+void
+yts_local_transport_take_queued (YtsLocalTransport           *self,
+                                 YtsLocalTransportQueuedFunc  func,
+                                 void                        *data);
+
+void
+yts_local_transport_get_statistics (YtsLocalTransport      *self,
+                                    YtsTransportStatistics *statistics);
+
+G_END_DECLS
+
+#endif /* YTS_LOCAL_TRANSPORT_H */
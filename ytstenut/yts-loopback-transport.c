@@ -0,0 +1,645 @@
+/*
+ * Copyright © 2011 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "yts-contact-impl.h"
+#include "yts-loopback-transport.h"
+#include "yts-metadata-internal.h"
+#include "ytstenut-internal.h"
+
+static void
+_transport_interface_init (YtsTransportInterface *interface);
+
+G_DEFINE_TYPE_WITH_CODE (YtsLoopbackTransport,
+                         yts_loopback_transport,
+                         G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (YTS_TYPE_TRANSPORT,
+                                                _transport_interface_init))
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN PACKAGE"\0client\0"G_STRLOC
+
+/*
+ * YtsLoopbackTransport connects clients within one process. Transports
+ * created with the same mesh ID see each other's services once connected,
+ * and can exchange messages and status.
+ *
+ * Everything a transport would receive from the network is queued on the
+ * mesh and delivered from a single idle handler, in the order it was
+ * queued. So delivery is asynchronous like with a real transport, but
+ * deterministic. Interests are not taken into account, every service sees
+ * all others. File transfer is not supported, #YtsIncomingFile and
+ * #YtsOutgoingFile are built on Telepathy file-transfer channels.
+ */
+
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), YTS_TYPE_LOOPBACK_TRANSPORT, YtsLoopbackTransportPrivate))
+
+#define SERVICE_TYPE "application"
+
+typedef struct {
+  char        *id;
+  GHashTable  *members;   /* "contact/service" => YtsLoopbackTransport, unowned */
+  GQueue       events;
+  unsigned     dispatch_id;
+} Mesh;
+
+typedef struct {
+  char        *mesh_id;
+  char        *contact_id;
+  char        *service_id;
+  char        *key;
+  GPtrArray   *capabilities;  /* null-terminated */
+  GHashTable  *names;
+  GHashTable  *statuses;      /* fqc-id => status xml */
+  Mesh        *mesh;          /* while connected */
+  uint64_t     bytes_sent;
+} YtsLoopbackTransportPrivate;
+
+typedef enum {
+  EVENT_READY,
+  EVENT_DISCONNECTED,
+  EVENT_SERVICE_ADDED,
+  EVENT_SERVICE_REMOVED,
+  EVENT_STATUS_CHANGED,
+  EVENT_MESSAGE
+} EventType;
+
+typedef struct {
+  EventType              type;
+  YtsLoopbackTransport  *target;
+  YtsLoopbackTransport  *source;  /* EVENT_SERVICE_ADDED only */
+  char                  *contact_id;
+  char                  *service_id;
+  char                  *fqc_id;
+  char                  *xml;
+} Event;
+
+/* Mesh ID => Mesh */
+static GHashTable *_meshes = NULL;
+
+static Event *
+event_new (EventType             type,
+           YtsLoopbackTransport *target,
+           YtsLoopbackTransport *source)
+{
+  YtsLoopbackTransportPrivate *priv = GET_PRIVATE (source);
+  Event *event;
+
+  event = g_slice_new0 (Event);
+  event->type = type;
+  event->target = g_object_ref (target);
+  if (EVENT_SERVICE_ADDED == type) {
+    event->source = g_object_ref (source);
+  }
+  event->contact_id = g_strdup (priv->contact_id);
+  event->service_id = g_strdup (priv->service_id);
+
+  return event;
+}
+
+static void
+event_free (Event *event)
+{
+  g_object_unref (event->target);
+  if (event->source) {
+    g_object_unref (event->source);
+  }
+  g_free (event->contact_id);
+  g_free (event->service_id);
+  g_free (event->fqc_id);
+  g_free (event->xml);
+  g_slice_free (Event, event);
+}
+
+static void
+event_deliver (Event *event,
+               Mesh  *mesh)
+{
+  YtsLoopbackTransportPrivate *priv = GET_PRIVATE (event->target);
+  YtsTransport *target = YTS_TRANSPORT (event->target);
+
+  /* Whatever was on its way to a transport that left is lost. */
+  if (EVENT_DISCONNECTED != event->type &&
+      priv->mesh != mesh) {
+    return;
+  }
+
+  switch (event->type) {
+    case EVENT_READY:
+      yts_transport_emit_ready (target);
+      break;
+    case EVENT_DISCONNECTED:
+      yts_transport_emit_disconnected (target);
+      break;
+    case EVENT_SERVICE_ADDED: {
+      YtsLoopbackTransportPrivate *source = GET_PRIVATE (event->source);
+      yts_transport_emit_service_added (
+                            target,
+                            event->contact_id,
+                            event->service_id,
+                            SERVICE_TYPE,
+                            (char const *const *) source->capabilities->pdata,
+                            source->names,
+                            source->statuses);
+    } break;
+    case EVENT_SERVICE_REMOVED:
+      yts_transport_emit_service_removed (target,
+                                          event->contact_id,
+                                          event->service_id);
+      break;
+    case EVENT_STATUS_CHANGED:
+      yts_transport_emit_status_changed (target,
+                                         event->contact_id,
+                                         event->fqc_id,
+                                         event->service_id,
+                                         event->xml);
+      break;
+    case EVENT_MESSAGE:
+      yts_transport_emit_message_received (target,
+                                           event->contact_id,
+                                           event->service_id,
+                                           event->xml);
+      break;
+  }
+}
+
+static void
+mesh_free_if_unused (Mesh *mesh)
+{
+  if (g_hash_table_size (mesh->members) > 0 ||
+      !g_queue_is_empty (&mesh->events) ||
+      mesh->dispatch_id) {
+    return;
+  }
+
+  g_hash_table_remove (_meshes, mesh->id);
+  g_hash_table_destroy (mesh->members);
+  g_free (mesh->id);
+  g_slice_free (Mesh, mesh);
+}
+
+static gboolean
+_mesh_dispatch (Mesh *mesh)
+{
+  GQueue  events;
+  Event  *event;
+
+  /* Events queued while delivering go out with the next round. */
+  events = mesh->events;
+  g_queue_init (&mesh->events);
+
+  while (NULL != (event = g_queue_pop_head (&events))) {
+    event_deliver (event, mesh);
+    event_free (event);
+  }
+
+  if (!g_queue_is_empty (&mesh->events)) {
+    return true;
+  }
+
+  mesh->dispatch_id = 0;
+  mesh_free_if_unused (mesh);
+  return false;
+}
+
+static void
+mesh_queue (Mesh  *mesh,
+            Event *event)
+{
+  g_queue_push_tail (&mesh->events, event);
+
+  if (0 == mesh->dispatch_id) {
+    mesh->dispatch_id = g_idle_add ((GSourceFunc) _mesh_dispatch, mesh);
+  }
+}
+
+static void
+mesh_queue_others (Mesh                 *mesh,
+                   YtsLoopbackTransport *source,
+                   EventType             type,
+                   char const           *fqc_id,
+                   char const           *xml)
+{
+  GHashTableIter         iter;
+  YtsLoopbackTransport  *member;
+
+  g_hash_table_iter_init (&iter, mesh->members);
+  while (g_hash_table_iter_next (&iter, NULL, (void **) &member)) {
+    if (member != source) {
+      Event *event = event_new (type, member, source);
+      event->fqc_id = g_strdup (fqc_id);
+      event->xml = g_strdup (xml);
+      mesh_queue (mesh, event);
+    }
+  }
+}
+
+static Mesh *
+mesh_get (char const *mesh_id)
+{
+  Mesh *mesh;
+
+  if (NULL == _meshes) {
+    _meshes = g_hash_table_new (g_str_hash, g_str_equal);
+  }
+
+  mesh = g_hash_table_lookup (_meshes, mesh_id);
+  if (NULL == mesh) {
+    mesh = g_slice_new0 (Mesh);
+    mesh->id = g_strdup (mesh_id);
+    mesh->members = g_hash_table_new (g_str_hash, g_str_equal);
+    g_queue_init (&mesh->events);
+    g_hash_table_insert (_meshes, mesh->id, mesh);
+  }
+
+  return mesh;
+}
+
+static void
+leave (YtsLoopbackTransport *self,
+       bool                  notify)
+{
+  YtsLoopbackTransportPrivate *priv = GET_PRIVATE (self);
+  Mesh *mesh = priv->mesh;
+
+  if (NULL == mesh) {
+    return;
+  }
+
+  g_hash_table_remove (mesh->members, priv->key);
+  priv->mesh = NULL;
+
+  mesh_queue_others (mesh, self, EVENT_SERVICE_REMOVED, NULL, NULL);
+  if (notify) {
+    mesh_queue (mesh, event_new (EVENT_DISCONNECTED, self, self));
+  }
+
+  mesh_free_if_unused (mesh);
+}
+
+/*
+ * YtsTransport implementation
+ */
+
+static char const *
+_get_contact_id (YtsTransport *self)
+{
+  YtsLoopbackTransportPrivate *priv = GET_PRIVATE (self);
+
+  return priv->contact_id;
+}
+
+static void
+_connect (YtsTransport *self)
+{
+  YtsLoopbackTransportPrivate *priv = GET_PRIVATE (self);
+  GHashTableIter         iter;
+  YtsLoopbackTransport  *member;
+  Mesh                  *mesh;
+
+  if (priv->mesh) {
+    return;
+  }
+
+  mesh = mesh_get (priv->mesh_id);
+
+  if (g_hash_table_lookup (mesh->members, priv->key)) {
+    g_critical ("%s : Service %s already on mesh %s",
+                G_STRLOC, priv->key, priv->mesh_id);
+    mesh_free_if_unused (mesh);
+    return;
+  }
+
+  /* Learn about everybody else, and let them know about us. */
+  g_hash_table_iter_init (&iter, mesh->members);
+  while (g_hash_table_iter_next (&iter, NULL, (void **) &member)) {
+    mesh_queue (mesh, event_new (EVENT_SERVICE_ADDED,
+                                 YTS_LOOPBACK_TRANSPORT (self),
+                                 member));
+    mesh_queue (mesh, event_new (EVENT_SERVICE_ADDED,
+                                 member,
+                                 YTS_LOOPBACK_TRANSPORT (self)));
+  }
+
+  g_hash_table_insert (mesh->members, priv->key, self);
+  priv->mesh = mesh;
+
+  mesh_queue (mesh, event_new (EVENT_READY,
+                               YTS_LOOPBACK_TRANSPORT (self),
+                               YTS_LOOPBACK_TRANSPORT (self)));
+}
+
+static void
+_disconnect (YtsTransport *self)
+{
+  leave (YTS_LOOPBACK_TRANSPORT (self), true);
+}
+
+static void
+_add_capability (YtsTransport *self,
+                 char const   *fqc_id)
+{
+  YtsLoopbackTransportPrivate *priv = GET_PRIVATE (self);
+  unsigned i;
+
+  for (i = 0; i < priv->capabilities->len - 1; i++) {
+    if (0 == g_strcmp0 (fqc_id, g_ptr_array_index (priv->capabilities, i))) {
+      return;
+    }
+  }
+
+  /* Replace the terminator. */
+  g_ptr_array_index (priv->capabilities, priv->capabilities->len - 1) =
+                                                            g_strdup (fqc_id);
+  g_ptr_array_add (priv->capabilities, NULL);
+
+  /* Services can not be updated, announce it again. */
+  if (priv->mesh) {
+    mesh_queue_others (priv->mesh, YTS_LOOPBACK_TRANSPORT (self),
+                       EVENT_SERVICE_REMOVED, NULL, NULL);
+    mesh_queue_others (priv->mesh, YTS_LOOPBACK_TRANSPORT (self),
+                       EVENT_SERVICE_ADDED, NULL, NULL);
+  }
+}
+
+static void
+_add_interest (YtsTransport *self,
+               char const   *fqc_id)
+{
+  /* All services are discovered. */
+}
+
+static void
+_advertise_status (YtsTransport *self,
+                   char const   *fqc_id,
+                   char const   *status_xml)
+{
+  YtsLoopbackTransportPrivate *priv = GET_PRIVATE (self);
+
+  g_hash_table_insert (priv->statuses,
+                       g_strdup (fqc_id),
+                       g_strdup (status_xml));
+
+  if (priv->mesh) {
+    mesh_queue_others (priv->mesh, YTS_LOOPBACK_TRANSPORT (self),
+                       EVENT_STATUS_CHANGED, fqc_id, status_xml);
+  }
+}
+
+static void
+_refresh (YtsTransport *self)
+{
+  YtsLoopbackTransportPrivate *priv = GET_PRIVATE (self);
+  GHashTableIter         iter;
+  YtsLoopbackTransport  *member;
+
+  if (NULL == priv->mesh) {
+    return;
+  }
+
+  g_hash_table_iter_init (&iter, priv->mesh->members);
+  while (g_hash_table_iter_next (&iter, NULL, (void **) &member)) {
+    if (member != YTS_LOOPBACK_TRANSPORT (self)) {
+      mesh_queue (priv->mesh, event_new (EVENT_SERVICE_ADDED,
+                                         YTS_LOOPBACK_TRANSPORT (self),
+                                         member));
+    }
+  }
+}
+
+static YtsError
+_send_message (YtsTransport *self,
+               YtsContact   *contact,
+               char const   *service_id,
+               YtsMetadata  *message)
+{
+  YtsLoopbackTransportPrivate *priv = GET_PRIVATE (self);
+  YtsLoopbackTransport  *recipient;
+  Event                 *event;
+  char                  *key;
+
+  if (NULL == priv->mesh) {
+    return yts_error_new (YTS_ERROR_NO_ROUTE);
+  }
+
+  key = g_strdup_printf ("%s/%s", yts_contact_get_id (contact), service_id);
+  recipient = g_hash_table_lookup (priv->mesh->members, key);
+  g_free (key);
+
+  if (NULL == recipient) {
+    return yts_error_new (YTS_ERROR_NO_ROUTE);
+  }
+
+  /* Serialise like a network transport would, so the receiving side goes
+   * through the same parsing. */
+  event = event_new (EVENT_MESSAGE, recipient, YTS_LOOPBACK_TRANSPORT (self));
+  event->xml = yts_metadata_to_string (message);
+  priv->bytes_sent += strlen (event->xml);
+  mesh_queue (priv->mesh, event);
+
+  return yts_error_new (YTS_ERROR_SUCCESS);
+}
+
+static void
+_resolve_contact_async (YtsTransport        *self,
+                        char const          *contact_id,
+                        GCancellable        *cancellable,
+                        GAsyncReadyCallback  callback,
+                        void                *user_data)
+{
+  GSimpleAsyncResult *result;
+
+  result = g_simple_async_result_new (G_OBJECT (self),
+                                      callback,
+                                      user_data,
+                                      _resolve_contact_async);
+  g_simple_async_result_set_op_res_gpointer (
+                                      result,
+                                      yts_contact_impl_new_for_id (contact_id),
+                                      g_object_unref);
+  g_simple_async_result_complete_in_idle (result);
+  g_object_unref (result);
+}
+
+static YtsContact *
+_resolve_contact_finish (YtsTransport  *self,
+                         GAsyncResult  *result,
+                         GError       **error)
+{
+  GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  g_return_val_if_fail (g_simple_async_result_is_valid (result,
+                                                        G_OBJECT (self),
+                                                        _resolve_contact_async),
+                        NULL);
+
+  return g_object_ref (g_simple_async_result_get_op_res_gpointer (simple));
+}
+
+static YtsOutgoingFile *
+_send_file (YtsTransport  *self,
+            YtsContact    *contact,
+            char const    *service_id,
+            GFile         *file,
+            char const    *description,
+            GError       **error)
+{
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                       "File transfer is not supported on loopback");
+  return NULL;
+}
+
+static YtsOutgoingFile *
+_send_stream (YtsTransport  *self,
+              YtsContact    *contact,
+              char const    *service_id,
+              GInputStream  *stream,
+              uint64_t       size,
+              char const    *name,
+              char const    *content_type,
+              char const    *description,
+              GError       **error)
+{
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                       "File transfer is not supported on loopback");
+  return NULL;
+}
+
+static void
+_get_statistics (YtsTransport           *self,
+                 YtsTransportStatistics *statistics)
+{
+  YtsLoopbackTransportPrivate *priv = GET_PRIVATE (self);
+
+  statistics->bytes_sent = priv->bytes_sent;
+}
+
+static void
+_transport_interface_init (YtsTransportInterface *interface)
+{
+  interface->get_contact_id = _get_contact_id;
+  interface->connect = _connect;
+  interface->disconnect = _disconnect;
+  interface->add_capability = _add_capability;
+  interface->add_interest = _add_interest;
+  interface->advertise_status = _advertise_status;
+  interface->refresh = _refresh;
+  interface->send_message = _send_message;
+  interface->resolve_contact_async = _resolve_contact_async;
+  interface->resolve_contact_finish = _resolve_contact_finish;
+  interface->send_file = _send_file;
+  interface->send_stream = _send_stream;
+  interface->get_statistics = _get_statistics;
+}
+
+/*
+ * YtsLoopbackTransport
+ */
+
+static void
+_dispose (GObject *object)
+{
+  /* Nothing can be queued for ourselves any more at this point. */
+  leave (YTS_LOOPBACK_TRANSPORT (object), false);
+
+  G_OBJECT_CLASS (yts_loopback_transport_parent_class)->dispose (object);
+}
+
+static void
+_finalize (GObject *object)
+{
+  YtsLoopbackTransportPrivate *priv = GET_PRIVATE (object);
+
+  g_free (priv->mesh_id);
+  g_free (priv->contact_id);
+  g_free (priv->service_id);
+  g_free (priv->key);
+  g_ptr_array_free (priv->capabilities, true);
+  g_hash_table_destroy (priv->names);
+  g_hash_table_destroy (priv->statuses);
+
+  G_OBJECT_CLASS (yts_loopback_transport_parent_class)->finalize (object);
+}
+
+static void
+yts_loopback_transport_class_init (YtsLoopbackTransportClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  g_type_class_add_private (klass, sizeof (YtsLoopbackTransportPrivate));
+
+  object_class->dispose = _dispose;
+  object_class->finalize = _finalize;
+}
+
+static void
+yts_loopback_transport_init (YtsLoopbackTransport *self)
+{
+  YtsLoopbackTransportPrivate *priv = GET_PRIVATE (self);
+
+  priv->capabilities = g_ptr_array_new_with_free_func (g_free);
+  g_ptr_array_add (priv->capabilities, NULL);
+  priv->names = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                       g_free, g_free);
+  priv->statuses = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, g_free);
+}
+
+YtsLoopbackTransport *
+yts_loopback_transport_new (char const *mesh_id,
+                            char const *contact_id,
+                            char const *service_id)
+{
+  YtsLoopbackTransport *self;
+  YtsLoopbackTransportPrivate *priv;
+
+  g_return_val_if_fail (mesh_id && contact_id && service_id, NULL);
+
+  self = g_object_new (YTS_TYPE_LOOPBACK_TRANSPORT, NULL);
+  priv = GET_PRIVATE (self);
+
+  priv->mesh_id = g_strdup (mesh_id);
+  priv->contact_id = g_strdup (contact_id);
+  priv->service_id = g_strdup (service_id);
+  priv->key = g_strdup_printf ("%s/%s", contact_id, service_id);
+  g_hash_table_insert (priv->names, g_strdup ("C"), g_strdup (service_id));
+
+  return self;
+}
+
+/*
+ * yts_loopback_transport_drop:
+ * @self: object on which to invoke this method.
+ *
+ * Lose the connection to the mesh without having been asked to, the way a
+ * network failure would. For testing how clients cope.
+ */
+void
+yts_loopback_transport_drop (YtsLoopbackTransport *self)
+{
+  g_return_if_fail (YTS_IS_LOOPBACK_TRANSPORT (self));
+
+  leave (self, true);
+}
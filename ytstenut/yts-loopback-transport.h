@@ -0,0 +1,67 @@
+/*
+ * Copyright © 2011 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_LOOPBACK_TRANSPORT_H
+#define YTS_LOOPBACK_TRANSPORT_H
+
+#include <glib-object.h>
+#include <ytstenut/yts-transport.h>
+
+G_BEGIN_DECLS
+
+#define YTS_TYPE_LOOPBACK_TRANSPORT (yts_loopback_transport_get_type ())
+
+#define YTS_LOOPBACK_TRANSPORT(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), YTS_TYPE_LOOPBACK_TRANSPORT, YtsLoopbackTransport))
+
+#define YTS_LOOPBACK_TRANSPORT_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), YTS_TYPE_LOOPBACK_TRANSPORT, YtsLoopbackTransportClass))
+
+#define YTS_IS_LOOPBACK_TRANSPORT(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), YTS_TYPE_LOOPBACK_TRANSPORT))
+
+#define YTS_IS_LOOPBACK_TRANSPORT_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), YTS_TYPE_LOOPBACK_TRANSPORT))
+
+#define YTS_LOOPBACK_TRANSPORT_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), YTS_TYPE_LOOPBACK_TRANSPORT, YtsLoopbackTransportClass))
+
+typedef struct {
+  GObject parent;
+} YtsLoopbackTransport;
+
+typedef struct {
+  GObjectClass parent;
+} YtsLoopbackTransportClass;
+
+GType
+yts_loopback_transport_get_type (void) G_GNUC_CONST;
+
+YtsLoopbackTransport *
+yts_loopback_transport_new (char const *mesh_id,
+                            char const *contact_id,
+                            char const *service_id);
+
+void
+yts_loopback_transport_drop (YtsLoopbackTransport *self);
+
+G_END_DECLS
+
+#endif /* YTS_LOOPBACK_TRANSPORT_H */
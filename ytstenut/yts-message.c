@@ -153,3 +153,38 @@ yts_message_new (const char ** attributes)
   return (YtsMessage*) mdata;
 }
 
+/*
+ * yts_message_new_for_payload:
+ * @type: message type, e.g. "text"
+ * @capability: capability the message is addressed to
+ * @payload: message payload, a floating reference is taken over
+ *
+ * Constructs a message for the low-level service interface, the payload
+ * is printed and escaped into the "payload" attribute right away.
+ *
+ * Returns: (transfer full): newly allocated #YtsMetadata object.
+ */
+YtsMetadata *
+yts_message_new_for_payload (char const *type,
+                             char const *capability,
+                             GVariant   *payload)
+{
+  RestXmlNode *node;
+  char        *payload_str_escaped;
+
+  node = rest_xml_node_add_child (NULL, "message");
+  /* PONDERING need those keywords be made reserved */
+  rest_xml_node_add_attr (node, "type", type);
+  rest_xml_node_add_attr (node, "capability", capability);
+
+  payload_str_escaped = yts_metadata_escape_payload (payload);
+  rest_xml_node_add_attr (node, "payload", payload_str_escaped);
+  g_free (payload_str_escaped);
+
+  if (g_variant_is_floating (payload))
+    g_variant_unref (payload);
+
+  return g_object_new (YTS_TYPE_MESSAGE,
+                       "top-level-node", node,
+                       NULL);
+}
@@ -80,6 +80,10 @@ GType yts_message_get_type (void) G_GNUC_CONST;
 
 YtsMessage *yts_message_new (const char ** attributes);
 
+YtsMetadata *yts_message_new_for_payload (char const *type,
+                                          char const *capability,
+                                          GVariant   *payload);
+
 G_END_DECLS
 
 #endif /* YTS_MESSAGE_H */
@@ -36,5 +36,19 @@ GHashTable *
 yts_metadata_extract (YtsMetadata  *self,
                       char        **body);
 
+void
+yts_metadata_set_payload (YtsMetadata *self,
+                          char const  *name,
+                          GVariant    *payload);
+
+GVariant *
+yts_metadata_get_payload (YtsMetadata *self);
+
+char *
+yts_metadata_escape_payload (GVariant *payload);
+
+GVariant *
+yts_metadata_unescape_payload (char const *escaped);
+
 #endif /* YTS_METADATA_INTERNAL_H */
 
@@ -20,6 +20,7 @@
 
 #include "config.h"
 
+#include <stdbool.h>
 #include <string.h>
 #include <rest/rest-xml-parser.h>
 
@@ -49,6 +50,11 @@ struct _YtsMetadataPrivate
   char         *xml;
   char        **attributes;
 
+  /* Deferred attribute, see yts_metadata_set_payload(). */
+  char         *payload_name;
+  GVariant     *payload;
+  bool          payload_flushed;
+
   guint disposed : 1;
   guint readonly : 1;
 };
@@ -229,15 +235,138 @@ yts_metadata_dispose (GObject *object)
   if (priv->top_level_node)
     rest_xml_node_unref (priv->top_level_node);
 
+  if (priv->payload)
+    {
+      g_variant_unref (priv->payload);
+      priv->payload = NULL;
+    }
+
   G_OBJECT_CLASS (yts_metadata_parent_class)->dispose (object);
 }
 
 static void
 yts_metadata_finalize (GObject *object)
 {
+  YtsMetadata        *self = (YtsMetadata*) object;
+  YtsMetadataPrivate *priv = self->priv;
+
+  g_free (priv->payload_name);
+
   G_OBJECT_CLASS (yts_metadata_parent_class)->finalize (object);
 }
 
+/*
+ * Add the deferred payload attribute to the XML tree, once anything
+ * looks at the tree.
+ */
+static void
+yts_metadata_flush_payload (YtsMetadata *self)
+{
+  YtsMetadataPrivate *priv = self->priv;
+  char *escaped_args;
+
+  if (NULL == priv->payload || priv->payload_flushed)
+    return;
+
+  priv->payload_flushed = true;
+
+  escaped_args = yts_metadata_escape_payload (priv->payload);
+  rest_xml_node_add_attr (priv->top_level_node,
+                          priv->payload_name,
+                          escaped_args);
+  g_free (escaped_args);
+}
+
+/*
+ * yts_metadata_escape_payload:
+ * @payload: #GVariant to serialise
+ *
+ * Print @payload in #GVariant text format, escaped so it can be carried
+ * in an XML attribute.
+ *
+ * Returns: (transfer full): the escaped payload.
+ */
+char *
+yts_metadata_escape_payload (GVariant *payload)
+{
+  char *str;
+  char *escaped;
+
+  str = g_variant_print (payload, false);
+  /* FIXME this is just a stopgap solution to lacking g_markup_unescape_text()
+   * want to move to complex message bodies anywy. */
+  escaped = g_uri_escape_string (str, NULL, true);
+  g_free (str);
+
+  return escaped;
+}
+
+/*
+ * yts_metadata_unescape_payload:
+ * @escaped: payload as produced by yts_metadata_escape_payload()
+ *
+ * Returns: (transfer full): the parsed #GVariant.
+ */
+GVariant *
+yts_metadata_unescape_payload (char const *escaped)
+{
+  GVariant  *v;
+  char      *unescaped;
+
+  unescaped = g_uri_unescape_string (escaped, NULL);
+  v = g_variant_new_parsed (unescaped);
+  g_free (unescaped);
+
+  return v;
+}
+
+/*
+ * yts_metadata_set_payload:
+ * @self: #YtsMetadata
+ * @name: name of the attribute carrying the payload
+ * @payload: the payload
+ *
+ * Attach @payload to the metadata, a floating reference is taken over.
+ * It is only serialised into attribute @name when the XML representation
+ * is needed, so messages delivered within the process can hand over the
+ * #GVariant as is.
+ */
+void
+yts_metadata_set_payload (YtsMetadata *self,
+                          char const  *name,
+                          GVariant    *payload)
+{
+  YtsMetadataPrivate *priv;
+
+  g_return_if_fail (YTS_IS_METADATA (self));
+  g_return_if_fail (name);
+
+  priv = self->priv;
+
+  g_return_if_fail (NULL == priv->payload);
+
+  if (payload)
+    {
+      priv->payload_name = g_strdup (name);
+      priv->payload = g_variant_ref_sink (payload);
+    }
+}
+
+/*
+ * yts_metadata_get_payload:
+ * @self: #YtsMetadata
+ *
+ * Returns: (transfer none): payload passed to yts_metadata_set_payload(),
+ * or %NULL.
+ */
+GVariant *
+yts_metadata_get_payload (YtsMetadata *self)
+{
+  g_return_val_if_fail (YTS_IS_METADATA (self), NULL);
+
+  return self->priv->payload;
+}
+
 /**
  * yts_metadata_get_root_node:
  * @self: #YtsMetadata
@@ -259,6 +388,8 @@ yts_metadata_get_root_node (YtsMetadata *self)
 
   priv = self->priv;
 
+  yts_metadata_flush_payload (self);
+
   return priv->top_level_node;
 }
 
@@ -351,6 +482,10 @@ yts_metadata_get_attribute (YtsMetadata *self, const char *name)
 
   g_return_val_if_fail (priv->top_level_node, NULL);
 
+  if (priv->payload_name &&
+      0 == g_strcmp0 (priv->payload_name, name))
+    yts_metadata_flush_payload (self);
+
   return rest_xml_node_get_attr (priv->top_level_node, name);
 }
 
@@ -404,6 +539,8 @@ yts_metadata_to_string (YtsMetadata *self)
 
   g_return_val_if_fail (priv->top_level_node, NULL);
 
+  yts_metadata_flush_payload (self);
+
   return rest_xml_node_print (priv->top_level_node);
 }
 
@@ -435,6 +572,8 @@ yts_metadata_extract (YtsMetadata *self, char **body)
   priv = self->priv;
   n0 = priv->top_level_node;
 
+  yts_metadata_flush_payload (self);
+
   b = g_strdup (n0->content);
 
   /*
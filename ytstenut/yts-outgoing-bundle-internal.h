@@ -0,0 +1,55 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_OUTGOING_BUNDLE_INTERNAL_H
+#define YTS_OUTGOING_BUNDLE_INTERNAL_H
+
+#include <ytstenut/yts-outgoing-bundle.h>
+#include <ytstenut/yts-service.h>
+
+G_BEGIN_DECLS
+
+#define YTS_OUTGOING_BUNDLE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), YTS_TYPE_OUTGOING_BUNDLE, YtsOutgoingBundleClass))
+
+#define YTS_IS_OUTGOING_BUNDLE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), YTS_TYPE_OUTGOING_BUNDLE))
+
+#define YTS_OUTGOING_BUNDLE_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), YTS_TYPE_OUTGOING_BUNDLE, YtsOutgoingBundleClass))
+
+struct YtsOutgoingBundle {
+  GObject parent;
+};
+
+typedef struct {
+  GObjectClass parent;
+} YtsOutgoingBundleClass;
+
+YtsOutgoingBundle *
+yts_outgoing_bundle_new (YtsService       *service,
+                         GFile *const     *files,
+                         unsigned          n_files,
+                         char const       *description,
+                         GError          **error_out);
+
+G_END_DECLS
+
+#endif /* YTS_OUTGOING_BUNDLE_INTERNAL_H */
@@ -0,0 +1,382 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "yts-bundle-input-stream.h"
+#include "yts-file-transfer-internal.h"
+#include "yts-marshal.h"
+#include "yts-outgoing-bundle-internal.h"
+#include "yts-outgoing-file-internal.h"
+
+G_DEFINE_TYPE (YtsOutgoingBundle, yts_outgoing_bundle, G_TYPE_OBJECT)
+
+/**
+ * SECTION: yts-outgoing-bundle
+ * @short_description: Multi-file upload.
+ *
+ * #YtsOutgoingBundle sends a number of files to another Ytstenut service
+ * through a single file transfer channel, see yts_service_send_bundle().
+ * The files' names, sizes and content types travel as a manifest in the
+ * channel's metadata, their content is sent back to back.
+ *
+ * Overall progress, errors and cancellation are reported by the underlying
+ * #YtsOutgoingFile, see yts_outgoing_bundle_get_transfer().
+ */
+
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), YTS_TYPE_OUTGOING_BUNDLE, YtsOutgoingBundlePrivate))
+
+enum {
+  PROP_0,
+  PROP_TRANSFER
+};
+
+enum {
+  SIG_ENTRY_PROGRESS,
+  N_SIGNALS
+};
+
+static unsigned _signals[N_SIGNALS] = { 0, };
+
+typedef struct {
+  YtsOutgoingFile *transfer;
+  GPtrArray       *files;
+  GPtrArray       *entries;
+  unsigned         first;
+} YtsOutgoingBundlePrivate;
+
+static void
+_entry_progress (unsigned            index,
+                 float               progress,
+                 YtsOutgoingBundle  *self)
+{
+  g_signal_emit (self, _signals[SIG_ENTRY_PROGRESS], 0, index, progress);
+}
+
+static void
+_transfer_notify_transferred_bytes (YtsOutgoingFile   *transfer,
+                                    GParamSpec        *pspec,
+                                    YtsOutgoingBundle *self)
+{
+  YtsOutgoingBundlePrivate *priv = GET_PRIVATE (self);
+  uint64_t transferred_bytes;
+
+  transferred_bytes = yts_file_transfer_get_transferred_bytes (
+                                                  YTS_FILE_TRANSFER (transfer));
+  priv->first = yts_bundle_update_progress (
+                                    priv->entries,
+                                    priv->first,
+                                    transferred_bytes,
+                                    (YtsBundleProgressFunc) _entry_progress,
+                                    self);
+}
+
+static void
+_get_property (GObject    *object,
+               unsigned    property_id,
+               GValue     *value,
+               GParamSpec *pspec)
+{
+  YtsOutgoingBundlePrivate *priv = GET_PRIVATE (object);
+
+  switch (property_id) {
+    case PROP_TRANSFER:
+      g_value_set_object (value, priv->transfer);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+_dispose (GObject *object)
+{
+  YtsOutgoingBundlePrivate *priv = GET_PRIVATE (object);
+
+  if (priv->transfer) {
+    g_signal_handlers_disconnect_by_func (priv->transfer,
+                                          _transfer_notify_transferred_bytes,
+                                          object);
+    g_object_unref (priv->transfer);
+    priv->transfer = NULL;
+  }
+
+  G_OBJECT_CLASS (yts_outgoing_bundle_parent_class)->dispose (object);
+}
+
+static void
+_finalize (GObject *object)
+{
+  YtsOutgoingBundlePrivate *priv = GET_PRIVATE (object);
+
+  if (priv->files) {
+    g_ptr_array_unref (priv->files);
+    priv->files = NULL;
+  }
+
+  if (priv->entries) {
+    g_ptr_array_unref (priv->entries);
+    priv->entries = NULL;
+  }
+
+  G_OBJECT_CLASS (yts_outgoing_bundle_parent_class)->finalize (object);
+}
+
+static void
+yts_outgoing_bundle_class_init (YtsOutgoingBundleClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GParamSpec   *pspec;
+
+  g_type_class_add_private (klass, sizeof (YtsOutgoingBundlePrivate));
+
+  object_class->get_property = _get_property;
+  object_class->dispose = _dispose;
+  object_class->finalize = _finalize;
+
+  /**
+   * YtsOutgoingBundle:transfer:
+   *
+   * The #YtsOutgoingFile carrying the bundle.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_object ("transfer", "", "",
+                               YTS_TYPE_OUTGOING_FILE,
+                               G_PARAM_READABLE |
+                               G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_TRANSFER, pspec);
+
+  /**
+   * YtsOutgoingBundle::entry-progress:
+   * @self: object which emitted the signal.
+   * @index: index of the entry.
+   * @progress: progress of the entry, from 0.0 to 1.0.
+   *
+   * Emitted when an entry's progress changes, throttled like
+   * #YtsFileTransfer:progress.
+   *
+   * Since: 0.4
+   */
+  _signals[SIG_ENTRY_PROGRESS] = g_signal_new ("entry-progress",
+                                               G_TYPE_FROM_CLASS (object_class),
+                                               G_SIGNAL_RUN_LAST,
+                                               0, NULL, NULL,
+                                               yts_marshal_VOID__UINT_FLOAT,
+                                               G_TYPE_NONE, 2,
+                                               G_TYPE_UINT,
+                                               G_TYPE_FLOAT);
+}
+
+static void
+yts_outgoing_bundle_init (YtsOutgoingBundle *self)
+{
+}
+
+YtsOutgoingBundle *
+yts_outgoing_bundle_new (YtsService       *service,
+                         GFile *const     *files,
+                         unsigned          n_files,
+                         char const       *description,
+                         GError          **error_out)
+{
+  YtsOutgoingBundle         *self;
+  YtsOutgoingBundlePrivate  *priv;
+  YtsOutgoingFile           *transfer;
+  GPtrArray                 *file_array;
+  GPtrArray                 *entries;
+  GInputStream              *stream;
+  char                     **manifest;
+  uint64_t                   offset = 0;
+  unsigned                   i;
+
+  g_return_val_if_fail (YTS_IS_SERVICE (service), NULL);
+
+  if (NULL == files || 0 == n_files) {
+    if (error_out) {
+      *error_out = g_error_new (YTS_OUTGOING_FILE_ERROR,
+                                YTS_OUTGOING_FILE_ERROR_NO_FILE,
+                                "No files specified for bundle transfer");
+    }
+    return NULL;
+  }
+
+  file_array = g_ptr_array_new_with_free_func (g_object_unref);
+  entries = g_ptr_array_new_with_free_func (
+                                    (GDestroyNotify) yts_bundle_entry_free);
+
+  for (i = 0; i < n_files; i++) {
+
+    GFileInfo *info;
+
+    info = g_file_query_info (files[i],
+                              G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                              G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                              G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE,
+                              G_FILE_QUERY_INFO_NONE,
+                              NULL,
+                              NULL);
+    if (NULL == info) {
+      if (error_out) {
+        char *uri = g_file_get_uri (files[i]);
+        *error_out = g_error_new (YTS_OUTGOING_FILE_ERROR,
+                                  YTS_OUTGOING_FILE_ERROR_READ_FAILED,
+                                  "Failed to read file %s",
+                                  uri);
+        g_free (uri);
+      }
+      g_ptr_array_unref (entries);
+      g_ptr_array_unref (file_array);
+      return NULL;
+    }
+
+    g_ptr_array_add (file_array, g_object_ref (files[i]));
+    g_ptr_array_add (entries,
+                     yts_bundle_entry_new (g_file_info_get_name (info),
+                                           g_file_info_get_content_type (info),
+                                           g_file_info_get_size (info),
+                                           offset));
+    offset += g_file_info_get_size (info);
+
+    g_object_unref (info);
+  }
+
+  stream = yts_bundle_input_stream_new (file_array, entries);
+  transfer = yts_service_send_stream (service,
+                                      stream,
+                                      offset,
+                                      "bundle",
+                                      YTS_FILE_TRANSFER_BUNDLE_CONTENT_TYPE,
+                                      description,
+                                      error_out);
+  g_object_unref (stream);
+  if (NULL == transfer) {
+    g_ptr_array_unref (entries);
+    g_ptr_array_unref (file_array);
+    return NULL;
+  }
+
+  /* Transfers are started from the scheduler's idle handler, so there's
+   * still time to add the manifest. */
+  manifest = yts_bundle_manifest_encode (entries);
+  yts_outgoing_file_set_metadata (transfer,
+                                  YTS_FILE_TRANSFER_METADATA_BUNDLE,
+                                  (char const *const *) manifest);
+  g_strfreev (manifest);
+
+  self = g_object_new (YTS_TYPE_OUTGOING_BUNDLE, NULL);
+  priv = GET_PRIVATE (self);
+  priv->transfer = transfer;
+  priv->files = file_array;
+  priv->entries = entries;
+
+  g_signal_connect (transfer, "notify::transferred-bytes",
+                    G_CALLBACK (_transfer_notify_transferred_bytes), self);
+
+  return self;
+}
+
+/**
+ * yts_outgoing_bundle_get_transfer:
+ * @self: object on which to invoke this method.
+ *
+ * Returns: (transfer none): the #YtsOutgoingFile carrying the bundle.
+ *
+ * Since: 0.4
+ */
+YtsOutgoingFile *const
+yts_outgoing_bundle_get_transfer (YtsOutgoingBundle *self)
+{
+  YtsOutgoingBundlePrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_OUTGOING_BUNDLE (self), NULL);
+
+  return priv->transfer;
+}
+
+/**
+ * yts_outgoing_bundle_get_n_entries:
+ * @self: object on which to invoke this method.
+ *
+ * Returns: number of files in the bundle.
+ *
+ * Since: 0.4
+ */
+unsigned
+yts_outgoing_bundle_get_n_entries (YtsOutgoingBundle *self)
+{
+  YtsOutgoingBundlePrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_OUTGOING_BUNDLE (self), 0);
+
+  return priv->entries->len;
+}
+
+/**
+ * yts_outgoing_bundle_get_entry_file:
+ * @self: object on which to invoke this method.
+ * @index: index of the entry.
+ *
+ * Returns: (transfer none): the file sent as entry @index.
+ *
+ * Since: 0.4
+ */
+GFile *const
+yts_outgoing_bundle_get_entry_file (YtsOutgoingBundle *self,
+                                    unsigned           index)
+{
+  YtsOutgoingBundlePrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_OUTGOING_BUNDLE (self), NULL);
+  g_return_val_if_fail (index < priv->files->len, NULL);
+
+  return g_ptr_array_index (priv->files, index);
+}
+
+/**
+ * yts_outgoing_bundle_get_entry_progress:
+ * @self: object on which to invoke this method.
+ * @index: index of the entry.
+ *
+ * Returns: progress of entry @index, from 0.0 to 1.0.
+ *
+ * Since: 0.4
+ */
+float
+yts_outgoing_bundle_get_entry_progress (YtsOutgoingBundle *self,
+                                        unsigned           index)
+{
+  YtsOutgoingBundlePrivate *priv = GET_PRIVATE (self);
+  uint64_t transferred_bytes;
+
+  g_return_val_if_fail (YTS_IS_OUTGOING_BUNDLE (self), 0.0);
+  g_return_val_if_fail (index < priv->entries->len, 0.0);
+
+  transferred_bytes = yts_file_transfer_get_transferred_bytes (
+                                            YTS_FILE_TRANSFER (priv->transfer));
+
+  return yts_bundle_entry_get_progress (g_ptr_array_index (priv->entries,
+                                                           index),
+                                        transferred_bytes);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_OUTGOING_BUNDLE_H
+#define YTS_OUTGOING_BUNDLE_H
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <ytstenut/yts-outgoing-file.h>
+
+G_BEGIN_DECLS
+
+#define YTS_TYPE_OUTGOING_BUNDLE yts_outgoing_bundle_get_type()
+
+#define YTS_OUTGOING_BUNDLE(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), YTS_TYPE_OUTGOING_BUNDLE, YtsOutgoingBundle))
+
+#define YTS_IS_OUTGOING_BUNDLE(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), YTS_TYPE_OUTGOING_BUNDLE))
+
+typedef struct YtsOutgoingBundle YtsOutgoingBundle;
+
+GType
+yts_outgoing_bundle_get_type (void) G_GNUC_CONST;
+
+YtsOutgoingFile *const
+yts_outgoing_bundle_get_transfer (YtsOutgoingBundle *self);
+
+unsigned
+yts_outgoing_bundle_get_n_entries (YtsOutgoingBundle *self);
+
+GFile *const
+yts_outgoing_bundle_get_entry_file (YtsOutgoingBundle *self,
+                                    unsigned           index);
+
+float
+yts_outgoing_bundle_get_entry_progress (YtsOutgoingBundle *self,
+                                        unsigned           index);
+
+G_END_DECLS
+
+#endif /* YTS_OUTGOING_BUNDLE_H */
@@ -21,6 +21,7 @@
 #ifndef YTS_OUTGOING_FILE_INTERNAL_H
 #define YTS_OUTGOING_FILE_INTERNAL_H
 
+#include <stdint.h>
 #include <gio/gio.h>
 #include <telepathy-glib/account.h>
 #include <ytstenut/yts-outgoing-file.h>
@@ -52,9 +53,34 @@ yts_outgoing_file_new (TpAccount  *tp_account,
                        char const *recipient_service_id,
                        char const *description);
 
+YtsOutgoingFile *
+yts_outgoing_file_new_for_stream (TpAccount     *tp_account,
+                                  GInputStream  *stream,
+                                  uint64_t       size,
+                                  char const    *name,
+                                  char const    *content_type,
+                                  char const    *sender_service_id,
+                                  char const    *recipient_contact_id,
+                                  char const    *recipient_service_id,
+                                  char const    *description);
+
 GFile *const
 yts_outgoing_file_get_file (YtsOutgoingFile *self);
 
+uint64_t
+yts_outgoing_file_get_size (YtsOutgoingFile *self);
+
+void
+yts_outgoing_file_set_metadata (YtsOutgoingFile   *self,
+                                char const        *key,
+                                char const *const *values);
+
+void
+yts_outgoing_file_start (YtsOutgoingFile *self);
+
+void
+yts_outgoing_file_cancel (YtsOutgoingFile *self);
+
 G_END_DECLS
 
 #endif /* YTS_OUTGOING_FILE_INTERNAL_H */
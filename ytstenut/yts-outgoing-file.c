@@ -25,8 +25,9 @@
 #include <stdint.h>
 #include <telepathy-glib/telepathy-glib.h>
 
-#include "yts-file-transfer.h"
+#include "yts-file-transfer-internal.h"
 #include "yts-outgoing-file-internal.h"
+#include "yts-probes.h"
 
 static void
 _initable_interface_init (GInitableIface *interface);
@@ -49,6 +50,13 @@ G_DEFINE_TYPE_WITH_CODE (YtsOutgoingFile,
  * #YtsOutgoingFile represents an ongoing file upload operation to another
  * Ytstenut service.
  *
+ * Transfers are queued by the client's #YtsTransferScheduler, and only
+ * actually start once it sees fit.
+ *
+ * Instead of a file, the content may also be read from a #GInputStream, see
+ * yts_service_send_stream(). Such transfers are neither resumable nor
+ * checksummed, and #YtsFileTransfer:file is %NULL.
+ *
  * TODO add cancellation in dispose(), and cancel API. Take care not to touch
  * self any more after cancellation.
  */
@@ -62,13 +70,23 @@ enum {
   /* YtsFileTransfer */
   PROP_FILE_TRANSFER_PROGRESS,
   PROP_FILE_TRANSFER_FILE,
+  PROP_FILE_TRANSFER_TRANSFERRED_BYTES,
+  PROP_FILE_TRANSFER_BYTES_PER_SECOND,
+  PROP_FILE_TRANSFER_TIME_REMAINING,
+  PROP_FILE_TRANSFER_NOTIFY_INTERVAL,
+  PROP_FILE_TRANSFER_NOTIFY_THRESHOLD,
 
   /* YtsOutgoingFile */
   PROP_TP_ACCOUNT,
   PROP_DESCRIPTION,
   PROP_RECIPIENT_CONTACT_ID,
   PROP_RECIPIENT_SERVICE_ID,
-  PROP_SENDER_SERVICE_ID
+  PROP_SENDER_SERVICE_ID,
+  PROP_INITIAL_OFFSET,
+  PROP_STREAM,
+  PROP_SIZE,
+  PROP_NAME,
+  PROP_CONTENT_TYPE
 };
 
 typedef struct {
@@ -80,9 +98,24 @@ typedef struct {
   char      *sender_service_id;
   char      *description;
   float      progress;
+  GInputStream *stream;
   /* Data */
   TpFileTransferChannel *tp_channel;
   uint64_t               size;
+  uint64_t               initial_offset;
+  YtsFileTransferMeter   meter;
+  char                  *name;
+  char                  *content_type;
+  int64_t                mtime;
+  char                  *prefix_checksum;
+  char                  *checksum;
+  GHashTable            *metadata;
+  bool                   started;
+  /* Streaming */
+  GSocketConnection     *connection;
+  bool                   connected;
+  bool                   open;
+  bool                   spliced;
 } YtsOutgoingFilePrivate;
 
 static gboolean
@@ -147,11 +180,12 @@ validate (YtsOutgoingFile  *self,
     return false;
   }
 
-  if (!G_IS_FILE (priv->file)) {
+  if (!G_IS_FILE (priv->file) &&
+      !G_IS_INPUT_STREAM (priv->stream)) {
     if (error_out) {
       *error_out = g_error_new (YTS_OUTGOING_FILE_ERROR,
                                 YTS_OUTGOING_FILE_ERROR_NO_FILE,
-                                "No file specified for file transfer");
+                                "No file or stream specified for file transfer");
     }
     return false;
   }
@@ -236,6 +270,205 @@ _channel_provide_file (GObject          *object,
   }
 }
 
+static void
+_stream_splice (GObject       *source,
+                GAsyncResult  *result,
+                void          *data)
+{
+  YtsOutgoingFile *self = YTS_OUTGOING_FILE (data);
+  GError          *error_in = NULL;
+
+  g_output_stream_splice_finish (G_OUTPUT_STREAM (source), result, &error_in);
+  if (error_in) {
+    GError *error_out = g_error_new (YTS_OUTGOING_FILE_ERROR,
+                                     YTS_OUTGOING_FILE_ERROR_TRANSFER_FAILED,
+                                     "Failed to transfer stream "
+                                     "(%s)",
+                                     error_in->message);
+    set_and_emit_error (self, error_out);
+    g_error_free (error_out);
+    g_clear_error (&error_in);
+  }
+
+  /* Completion is signalled through the channel state. */
+
+  g_object_unref (self);
+}
+
+/*
+ * Data may only be written once the socket is connected, the stream
+ * positioned at the negotiated offset, and the channel is open.
+ */
+static void
+splice_stream (YtsOutgoingFile *self)
+{
+  YtsOutgoingFilePrivate *priv = GET_PRIVATE (self);
+  GOutputStream *output;
+
+  if (!priv->connected ||
+      !priv->open ||
+      priv->spliced) {
+    return;
+  }
+
+  priv->spliced = true;
+
+  output = g_io_stream_get_output_stream (G_IO_STREAM (priv->connection));
+  g_output_stream_splice_async (output,
+                                priv->stream,
+                                G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE |
+                                G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                G_PRIORITY_DEFAULT,
+                                NULL,
+                                _stream_splice,
+                                g_object_ref (self));
+}
+
+static void
+_stream_skip (GObject       *source,
+              GAsyncResult  *result,
+              void          *data)
+{
+  YtsOutgoingFile         *self = YTS_OUTGOING_FILE (data);
+  YtsOutgoingFilePrivate  *priv = GET_PRIVATE (self);
+  gssize                   n_skipped;
+  GError                  *error_in = NULL;
+
+  n_skipped = g_input_stream_skip_finish (G_INPUT_STREAM (source),
+                                          result,
+                                          &error_in);
+  if (error_in ||
+      (uint64_t) n_skipped != priv->initial_offset) {
+    GError *error_out = g_error_new (YTS_OUTGOING_FILE_ERROR,
+                                     YTS_OUTGOING_FILE_ERROR_READ_FAILED,
+                                     "Failed to skip to offset %" G_GUINT64_FORMAT
+                                     " (%s)",
+                                     priv->initial_offset,
+                                     error_in ? error_in->message : "short read");
+    set_and_emit_error (self, error_out);
+    g_error_free (error_out);
+    g_clear_error (&error_in);
+  } else {
+    priv->connected = true;
+    splice_stream (self);
+  }
+
+  g_object_unref (self);
+}
+
+static void
+_socket_client_connect (GObject       *source,
+                        GAsyncResult  *result,
+                        void          *data)
+{
+  YtsOutgoingFile         *self = YTS_OUTGOING_FILE (data);
+  YtsOutgoingFilePrivate  *priv = GET_PRIVATE (self);
+  GError                  *error_in = NULL;
+
+  priv->connection = g_socket_client_connect_finish (G_SOCKET_CLIENT (source),
+                                                     result,
+                                                     &error_in);
+  if (error_in) {
+    GError *error_out = g_error_new (YTS_OUTGOING_FILE_ERROR,
+                                     YTS_OUTGOING_FILE_ERROR_TRANSFER_FAILED,
+                                     "Failed to connect to the transfer socket "
+                                     "(%s)",
+                                     error_in->message);
+    set_and_emit_error (self, error_out);
+    g_error_free (error_out);
+    g_clear_error (&error_in);
+
+  } else if (priv->initial_offset > 0) {
+
+    /* Keep self alive via the extra ref. */
+    g_input_stream_skip_async (priv->stream,
+                               priv->initial_offset,
+                               G_PRIORITY_DEFAULT,
+                               NULL,
+                               _stream_skip,
+                               g_object_ref (self));
+  } else {
+
+    priv->connected = true;
+    splice_stream (self);
+  }
+
+  g_object_unref (self);
+}
+
+static void
+_channel_provide_stream (TpChannel    *proxy,
+                         GValue const *address,
+                         GError const *error,
+                         void         *data,
+                         GObject      *weak_object)
+{
+  YtsOutgoingFile *self = YTS_OUTGOING_FILE (weak_object);
+  GSocketAddress  *socket_address;
+  GSocketClient   *client;
+  GError          *error_in = NULL;
+
+  if (error) {
+    GError *error_out = g_error_new (YTS_OUTGOING_FILE_ERROR,
+                                     YTS_OUTGOING_FILE_ERROR_TRANSFER_FAILED,
+                                     "Failed to transfer stream "
+                                     "(%s)",
+                                     error->message);
+    set_and_emit_error (self, error_out);
+    g_error_free (error_out);
+    return;
+  }
+
+  socket_address = tp_g_socket_address_from_variant (
+                                          YTS_FILE_TRANSFER_SOCKET_ADDRESS_TYPE,
+                                          address,
+                                          &error_in);
+  if (error_in) {
+    GError *error_out = g_error_new (YTS_OUTGOING_FILE_ERROR,
+                                     YTS_OUTGOING_FILE_ERROR_TRANSFER_FAILED,
+                                     "Invalid transfer socket address "
+                                     "(%s)",
+                                     error_in->message);
+    set_and_emit_error (self, error_out);
+    g_error_free (error_out);
+    g_clear_error (&error_in);
+    return;
+  }
+
+  client = g_socket_client_new ();
+  g_socket_client_connect_async (client,
+                                 G_SOCKET_CONNECTABLE (socket_address),
+                                 NULL,
+                                 _socket_client_connect,
+                                 g_object_ref (self));
+  g_object_unref (client);
+  g_object_unref (socket_address);
+}
+
+/*
+ * Like tp_file_transfer_channel_provide_file_async(), but feeding the
+ * connection manager's socket from a stream.
+ */
+static void
+provide_stream (YtsOutgoingFile *self)
+{
+  YtsOutgoingFilePrivate *priv = GET_PRIVATE (self);
+  GValue *access_control_param;
+
+  access_control_param = tp_g_value_slice_new_uint (0);
+  tp_cli_channel_type_file_transfer_call_provide_file (
+                                          TP_CHANNEL (priv->tp_channel),
+                                          -1,
+                                          YTS_FILE_TRANSFER_SOCKET_ADDRESS_TYPE,
+                                          TP_SOCKET_ACCESS_CONTROL_LOCALHOST,
+                                          access_control_param,
+                                          _channel_provide_stream,
+                                          NULL,
+                                          NULL,
+                                          G_OBJECT (self));
+  tp_g_value_slice_free (access_control_param);
+}
+
 static void
 _channel_notify_state (TpFileTransferChannel  *channel,
                        GParamSpec             *pspec,
@@ -248,18 +481,45 @@ _channel_notify_state (TpFileTransferChannel  *channel,
 
   state = tp_file_transfer_channel_get_state (priv->tp_channel, &reason);
 
+  if (YTS_PROBE_ENABLED (outgoing__file__state)) {
+    YTS_PROBE5 (outgoing__file__state,
+                tp_proxy_get_object_path (channel), state, reason,
+                priv->meter.transferred_bytes, priv->size);
+  }
+
   if (state == TP_FILE_TRANSFER_STATE_ACCEPTED
       && tp_channel_get_requested (TP_CHANNEL (channel))) {
 
-    tp_file_transfer_channel_provide_file_async (priv->tp_channel,
-                                                 priv->file,
-                                                 _channel_provide_file,
-                                                 self);
+    /* The receiver may have asked to resume a partial download, in which
+     * case the offset has been negotiated by now and the file is provided
+     * starting from there. */
+    g_object_get (channel, "initial-offset", &priv->initial_offset, NULL);
+    if (priv->initial_offset > 0) {
+      g_object_notify (G_OBJECT (self), "initial-offset");
+    }
+    yts_file_transfer_meter_start (&priv->meter, priv->initial_offset);
+
+    if (priv->stream) {
+      provide_stream (self);
+    } else {
+      tp_file_transfer_channel_provide_file_async (priv->tp_channel,
+                                                   priv->file,
+                                                   _channel_provide_file,
+                                                   self);
+    }
+
+  } else if (state == TP_FILE_TRANSFER_STATE_OPEN) {
+
+    priv->open = true;
+    if (priv->stream) {
+      splice_stream (self);
+    }
 
   } else if (state == TP_FILE_TRANSFER_STATE_COMPLETED) {
 
+    priv->meter.transferred_bytes = priv->size;
     priv->progress = 1.1;
-    g_object_notify (G_OBJECT (self), "progress");
+    yts_file_transfer_notify_progress (YTS_FILE_TRANSFER (self));
     close_channel = true;
 
   } else if (reason == TP_FILE_TRANSFER_STATE_CHANGE_REASON_REMOTE_STOPPED) {
@@ -303,11 +563,14 @@ _channel_notify_transferred_bytes (TpFileTransferChannel  *channel,
                                    YtsOutgoingFile        *self)
 {
   YtsOutgoingFilePrivate  *priv = GET_PRIVATE (self);
-  float transferred_bytes;
+  uint64_t transferred_bytes;
 
   transferred_bytes = tp_file_transfer_channel_get_transferred_bytes (channel);
-  priv->progress = transferred_bytes / priv->size;
-  g_object_notify (G_OBJECT (self), "progress");
+  if (yts_file_transfer_meter_update (&priv->meter,
+                                      priv->initial_offset + transferred_bytes)) {
+    priv->progress = yts_file_transfer_meter_get_progress (&priv->meter);
+    yts_file_transfer_notify_progress (YTS_FILE_TRANSFER (self));
+  }
 }
 
 static void
@@ -351,19 +614,26 @@ _initable_init (GInitable      *initable,
 {
   YtsOutgoingFilePrivate *priv = GET_PRIVATE (initable);
   GFileInfo               *info;
-  char const              *name;
-  char const              *mimetype;
   GTimeVal                 mtime;
-  GHashTable              *metadata;
-  char                   **values;
-  GHashTable              *request;
-  TpAccountChannelRequest *channel_request;
   GError                  *error = NULL;
 
   if (!validate (YTS_OUTGOING_FILE (initable), error_out)) {
     return false;
   }
 
+  if (priv->stream) {
+    /* Name, type and size have been passed in. */
+    if (NULL == priv->name) {
+      priv->name = g_strdup ("stream");
+    }
+    if (NULL == priv->content_type) {
+      priv->content_type = g_strdup ("application/octet-stream");
+    }
+    priv->mtime = g_get_real_time () / G_USEC_PER_SEC;
+    priv->meter.size = priv->size;
+    return true;
+  }
+
   info = g_file_query_info (priv->file,
                             "*",
                             G_FILE_QUERY_INFO_NONE,
@@ -381,18 +651,72 @@ _initable_init (GInitable      *initable,
     return false;
   }
 
-  name = g_file_info_get_name (info);
-  mimetype = g_file_info_get_content_type (info);
+  priv->name = g_strdup (g_file_info_get_name (info));
+  priv->content_type = g_strdup (g_file_info_get_content_type (info));
   g_file_info_get_modification_time (info, &mtime);
+  priv->mtime = mtime.tv_sec;
   priv->size = g_file_info_get_size (info);
+  priv->meter.size = priv->size;
+
+  /* Let the receiver verify a partial download before resuming it. Small
+   * files are just sent again. */
+  if (priv->size > YTS_FILE_TRANSFER_PREFIX_SIZE) {
+    priv->prefix_checksum = yts_file_transfer_compute_prefix_checksum (
+                                                                  priv->file,
+                                                                  NULL);
+  }
+
+  /* The request is only issued in yts_outgoing_file_start(). */
+
+  g_object_unref (info);
+
+  return true;
+}
+
+static GHashTable *
+create_request (YtsOutgoingFile *self)
+{
+  YtsOutgoingFilePrivate *priv = GET_PRIVATE (self);
+  GHashTable  *metadata;
+  GHashTable  *request;
+  char       **values;
 
   metadata = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
   values = g_new0 (char *, 2);
   values[0] = priv->sender_service_id;
   g_hash_table_insert (metadata,
-                       g_strdup ("FromService"),
+                       g_strdup (YTS_FILE_TRANSFER_METADATA_FROM_SERVICE),
                        values);
 
+  if (priv->prefix_checksum) {
+    values = g_new0 (char *, 2);
+    values[0] = priv->prefix_checksum;
+    g_hash_table_insert (metadata,
+                         g_strdup (YTS_FILE_TRANSFER_METADATA_PREFIX_CHECKSUM),
+                         values);
+  }
+
+  if (priv->checksum) {
+    values = g_new0 (char *, 2);
+    values[0] = priv->checksum;
+    g_hash_table_insert (metadata,
+                         g_strdup (YTS_FILE_TRANSFER_METADATA_CHECKSUM),
+                         values);
+  }
+
+  if (priv->metadata) {
+    GHashTableIter   iter;
+    char const      *key;
+    char           **extra;
+
+    g_hash_table_iter_init (&iter, priv->metadata);
+    while (g_hash_table_iter_next (&iter, (void **) &key, (void **) &extra)) {
+      /* Borrow the strings, like above. */
+      values = g_memdup (extra, (g_strv_length (extra) + 1) * sizeof (char *));
+      g_hash_table_insert (metadata, g_strdup (key), values);
+    }
+  }
+
   /* Now we have everything prepared to continue, let's create the
    * Ytstenut channel handler with service name specified. */
   request = tp_asv_new (
@@ -410,11 +734,11 @@ _initable_init (GInitable      *initable,
 
       TP_PROP_CHANNEL_TYPE_FILE_TRANSFER_CONTENT_TYPE,
       G_TYPE_STRING,
-      mimetype,
+      priv->content_type,
 
       TP_PROP_CHANNEL_TYPE_FILE_TRANSFER_DATE,
       G_TYPE_INT64,
-      (gint64) mtime.tv_sec,
+      (gint64) priv->mtime,
 
       TP_PROP_CHANNEL_TYPE_FILE_TRANSFER_DESCRIPTION,
       G_TYPE_STRING,
@@ -422,7 +746,7 @@ _initable_init (GInitable      *initable,
 
       TP_PROP_CHANNEL_TYPE_FILE_TRANSFER_FILENAME,
       G_TYPE_STRING,
-      name,
+      priv->name,
 
       TP_PROP_CHANNEL_TYPE_FILE_TRANSFER_INITIAL_OFFSET,
       G_TYPE_UINT64,
@@ -437,13 +761,26 @@ _initable_init (GInitable      *initable,
       G_TYPE_STRING,
       priv->recipient_service_id,
 
-      /* And include our own service name. FIXME this should be a define. */
+      /* And include our own service name. */
       TP_PROP_CHANNEL_INTERFACE_FILE_TRANSFER_METADATA_METADATA,
       TP_HASH_TYPE_METADATA,
       metadata,
 
       NULL);
 
+  g_hash_table_unref (metadata);
+
+  return request;
+}
+
+static void
+request_channel (YtsOutgoingFile *self)
+{
+  YtsOutgoingFilePrivate  *priv = GET_PRIVATE (self);
+  GHashTable              *request;
+  TpAccountChannelRequest *channel_request;
+
+  request = create_request (self);
   channel_request = tp_account_channel_request_new (
                                             priv->tp_account,
                                             request,
@@ -453,12 +790,53 @@ _initable_init (GInitable      *initable,
                                               channel_request,
                                               NULL,
                                               _account_channel_request_create,
-                                              initable);
+                                              self);
 
+  g_object_unref (channel_request);
   g_hash_table_unref (request);
-  g_object_unref (info);
+}
 
-  return true;
+static void
+_compute_checksum_thread (GSimpleAsyncResult  *result,
+                          GObject             *object,
+                          GCancellable        *cancellable)
+{
+  YtsOutgoingFilePrivate *priv = GET_PRIVATE (object);
+  char   *checksum;
+  GError *error = NULL;
+
+  checksum = yts_file_transfer_compute_checksum (priv->file,
+                                                 cancellable,
+                                                 &error);
+  if (checksum) {
+    g_simple_async_result_set_op_res_gpointer (result, checksum, g_free);
+  } else {
+    g_simple_async_result_take_error (result, error);
+  }
+}
+
+static void
+_compute_checksum (GObject      *source,
+                   GAsyncResult *result,
+                   void         *data)
+{
+  YtsOutgoingFile         *self = YTS_OUTGOING_FILE (source);
+  YtsOutgoingFilePrivate  *priv = GET_PRIVATE (self);
+  GSimpleAsyncResult      *simple = G_SIMPLE_ASYNC_RESULT (result);
+  GError                  *error = NULL;
+
+  if (g_simple_async_result_propagate_error (simple, &error)) {
+    /* Not fatal, the receiver just can't verify the file. */
+    g_warning ("%s : Failed to compute checksum (%s)",
+               G_STRLOC,
+               error->message);
+    g_clear_error (&error);
+  } else {
+    priv->checksum = g_strdup (g_simple_async_result_get_op_res_gpointer (
+                                                                    simple));
+  }
+
+  request_channel (self);
 }
 
 static void
@@ -479,6 +857,23 @@ _get_property (GObject    *object,
     case PROP_FILE_TRANSFER_PROGRESS:
       g_value_set_float (value, priv->progress);
       break;
+    case PROP_FILE_TRANSFER_TRANSFERRED_BYTES:
+      g_value_set_uint64 (value, priv->meter.transferred_bytes);
+      break;
+    case PROP_FILE_TRANSFER_BYTES_PER_SECOND:
+      g_value_set_uint64 (value, priv->meter.bytes_per_second);
+      break;
+    case PROP_FILE_TRANSFER_TIME_REMAINING:
+      g_value_set_int64 (value,
+                         yts_file_transfer_meter_get_time_remaining (
+                                                              &priv->meter));
+      break;
+    case PROP_FILE_TRANSFER_NOTIFY_INTERVAL:
+      g_value_set_uint (value, priv->meter.notify_interval_ms);
+      break;
+    case PROP_FILE_TRANSFER_NOTIFY_THRESHOLD:
+      g_value_set_float (value, priv->meter.notify_threshold);
+      break;
 
     /* YtsOutgoingFile */
 
@@ -494,6 +889,18 @@ _get_property (GObject    *object,
     case PROP_SENDER_SERVICE_ID:
       g_value_set_string (value, priv->sender_service_id);
       break;
+    case PROP_INITIAL_OFFSET:
+      g_value_set_uint64 (value, priv->initial_offset);
+      break;
+    case PROP_SIZE:
+      g_value_set_uint64 (value, priv->size);
+      break;
+    case PROP_NAME:
+      g_value_set_string (value, priv->name);
+      break;
+    case PROP_CONTENT_TYPE:
+      g_value_set_string (value, priv->content_type);
+      break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -515,6 +922,12 @@ _set_property (GObject      *object,
       /* Construct-only */
       priv->file = g_value_dup_object (value);
       break;
+    case PROP_FILE_TRANSFER_NOTIFY_INTERVAL:
+      priv->meter.notify_interval_ms = g_value_get_uint (value);
+      break;
+    case PROP_FILE_TRANSFER_NOTIFY_THRESHOLD:
+      priv->meter.notify_threshold = g_value_get_float (value);
+      break;
 
     /* YtsOutgoingFile */
 
@@ -538,6 +951,22 @@ _set_property (GObject      *object,
       /* Construct-only */
       priv->sender_service_id = g_value_dup_string (value);
     break;
+    case PROP_STREAM:
+      /* Construct-only */
+      priv->stream = g_value_dup_object (value);
+      break;
+    case PROP_SIZE:
+      /* Construct-only, only used for streams. */
+      priv->size = g_value_get_uint64 (value);
+      break;
+    case PROP_NAME:
+      /* Construct-only, only used for streams. */
+      priv->name = g_value_dup_string (value);
+      break;
+    case PROP_CONTENT_TYPE:
+      /* Construct-only, only used for streams. */
+      priv->content_type = g_value_dup_string (value);
+      break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -573,6 +1002,16 @@ _finalize (GObject *object)
     priv->file = NULL;
   }
 
+  if (priv->stream) {
+    g_object_unref (priv->stream);
+    priv->stream = NULL;
+  }
+
+  if (priv->connection) {
+    g_object_unref (priv->connection);
+    priv->connection = NULL;
+  }
+
   if (priv->recipient_contact_id) {
     g_free (priv->recipient_contact_id);
     priv->recipient_contact_id = NULL;
@@ -593,6 +1032,31 @@ _finalize (GObject *object)
     priv->description = NULL;
   }
 
+  if (priv->prefix_checksum) {
+    g_free (priv->prefix_checksum);
+    priv->prefix_checksum = NULL;
+  }
+
+  if (priv->checksum) {
+    g_free (priv->checksum);
+    priv->checksum = NULL;
+  }
+
+  if (priv->metadata) {
+    g_hash_table_destroy (priv->metadata);
+    priv->metadata = NULL;
+  }
+
+  if (priv->name) {
+    g_free (priv->name);
+    priv->name = NULL;
+  }
+
+  if (priv->content_type) {
+    g_free (priv->content_type);
+    priv->content_type = NULL;
+  }
+
   G_OBJECT_CLASS (yts_outgoing_file_parent_class)->finalize (object);
 }
 
@@ -617,6 +1081,21 @@ yts_outgoing_file_class_init (YtsOutgoingFileClass *klass)
   g_object_class_override_property (object_class,
                                     PROP_FILE_TRANSFER_PROGRESS,
                                     "progress");
+  g_object_class_override_property (object_class,
+                                    PROP_FILE_TRANSFER_TRANSFERRED_BYTES,
+                                    "transferred-bytes");
+  g_object_class_override_property (object_class,
+                                    PROP_FILE_TRANSFER_BYTES_PER_SECOND,
+                                    "bytes-per-second");
+  g_object_class_override_property (object_class,
+                                    PROP_FILE_TRANSFER_TIME_REMAINING,
+                                    "time-remaining");
+  g_object_class_override_property (object_class,
+                                    PROP_FILE_TRANSFER_NOTIFY_INTERVAL,
+                                    "notify-interval");
+  g_object_class_override_property (object_class,
+                                    PROP_FILE_TRANSFER_NOTIFY_THRESHOLD,
+                                    "notify-threshold");
 
   /* YtsOutgoingFile properties */
 
@@ -693,11 +1172,85 @@ yts_outgoing_file_class_init (YtsOutgoingFileClass *klass)
   g_object_class_install_property (object_class,
                                    PROP_SENDER_SERVICE_ID,
                                    pspec);
+
+  /**
+   * YtsOutgoingFile:initial-offset:
+   *
+   * Offset in bytes from which the file is being sent. Non-zero when the
+   * recipient resumes a previously interrupted transfer.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint64 ("initial-offset", "", "",
+                               0, G_MAXUINT64, 0,
+                               G_PARAM_READABLE |
+                               G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class,
+                                   PROP_INITIAL_OFFSET,
+                                   pspec);
+
+  /**
+   * YtsOutgoingFile:stream:
+   *
+   * Internal use only.
+   */
+  pspec = g_param_spec_object ("stream", "", "",
+                               G_TYPE_INPUT_STREAM,
+                               G_PARAM_WRITABLE |
+                               G_PARAM_CONSTRUCT_ONLY |
+                               G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_STREAM, pspec);
+
+  /**
+   * YtsOutgoingFile:size:
+   *
+   * Size of the content in bytes. Taken from the file, or passed in
+   * along with the stream.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint64 ("size", "", "",
+                               0, G_MAXUINT64, 0,
+                               G_PARAM_READWRITE |
+                               G_PARAM_CONSTRUCT_ONLY |
+                               G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_SIZE, pspec);
+
+  /**
+   * YtsOutgoingFile:name:
+   *
+   * Name the content is offered under.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_string ("name", "", "",
+                               NULL,
+                               G_PARAM_READWRITE |
+                               G_PARAM_CONSTRUCT_ONLY |
+                               G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_NAME, pspec);
+
+  /**
+   * YtsOutgoingFile:content-type:
+   *
+   * MIME type of the content.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_string ("content-type", "", "",
+                               NULL,
+                               G_PARAM_READWRITE |
+                               G_PARAM_CONSTRUCT_ONLY |
+                               G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_CONTENT_TYPE, pspec);
 }
 
 static void
 yts_outgoing_file_init (YtsOutgoingFile *self)
 {
+  YtsOutgoingFilePrivate *priv = GET_PRIVATE (self);
+
+  yts_file_transfer_meter_init (&priv->meter);
 }
 
 YtsOutgoingFile *
@@ -718,6 +1271,30 @@ yts_outgoing_file_new (TpAccount  *tp_account,
                        NULL);
 }
 
+YtsOutgoingFile *
+yts_outgoing_file_new_for_stream (TpAccount     *tp_account,
+                                  GInputStream  *stream,
+                                  uint64_t       size,
+                                  char const    *name,
+                                  char const    *content_type,
+                                  char const    *sender_service_id,
+                                  char const    *recipient_contact_id,
+                                  char const    *recipient_service_id,
+                                  char const    *description)
+{
+  return g_object_new (YTS_TYPE_OUTGOING_FILE,
+                       "tp-account", tp_account,
+                       "stream", stream,
+                       "size", size,
+                       "name", name,
+                       "content-type", content_type,
+                       "sender-service-id", sender_service_id,
+                       "recipient-contact-id", recipient_contact_id,
+                       "recipient-service-id", recipient_service_id,
+                       "description", description,
+                       NULL);
+}
+
 char const *
 yts_outgoing_file_get_description (YtsOutgoingFile *self)
 {
@@ -738,3 +1315,93 @@ yts_outgoing_file_get_file (YtsOutgoingFile *self)
   return priv->file;
 }
 
+
+uint64_t
+yts_outgoing_file_get_size (YtsOutgoingFile *self)
+{
+  YtsOutgoingFilePrivate *priv = GET_PRIVATE (self);
+
+  g_return_val_if_fail (YTS_IS_OUTGOING_FILE (self), 0);
+
+  return priv->size;
+}
+
+/*
+ * Attach additional metadata to the channel request. Only possible before
+ * the transfer has been started.
+ */
+void
+yts_outgoing_file_set_metadata (YtsOutgoingFile   *self,
+                                char const        *key,
+                                char const *const *values)
+{
+  YtsOutgoingFilePrivate *priv = GET_PRIVATE (self);
+
+  g_return_if_fail (YTS_IS_OUTGOING_FILE (self));
+  g_return_if_fail (key);
+  g_return_if_fail (values);
+  g_return_if_fail (!priv->started);
+
+  if (NULL == priv->metadata) {
+    priv->metadata = g_hash_table_new_full (g_str_hash,
+                                            g_str_equal,
+                                            g_free,
+                                            (GDestroyNotify) g_strfreev);
+  }
+
+  g_hash_table_insert (priv->metadata,
+                       g_strdup (key),
+                       g_strdupv ((char **) values));
+}
+
+/*
+ * Start the transfer prepared in g_initable_init().
+ */
+void
+yts_outgoing_file_start (YtsOutgoingFile *self)
+{
+  YtsOutgoingFilePrivate  *priv = GET_PRIVATE (self);
+  GSimpleAsyncResult      *result;
+
+  g_return_if_fail (YTS_IS_OUTGOING_FILE (self));
+  g_return_if_fail (!priv->started);
+
+  priv->started = true;
+
+  if (priv->stream) {
+    /* Streams can only be read once, so there's no checksum. */
+    request_channel (self);
+    return;
+  }
+
+  /* The checksum has to go into the channel request's metadata, which can
+   * not be changed later on. So compute it up front, off the main thread.
+   * The result holds a reference to self. */
+  result = g_simple_async_result_new (G_OBJECT (self),
+                                      _compute_checksum,
+                                      NULL,
+                                      yts_outgoing_file_start);
+  g_simple_async_result_run_in_thread (result,
+                                       _compute_checksum_thread,
+                                       G_PRIORITY_LOW,
+                                       NULL);
+  g_object_unref (result);
+}
+
+/*
+ * Cancel a transfer that has not been started.
+ */
+void
+yts_outgoing_file_cancel (YtsOutgoingFile *self)
+{
+  YtsOutgoingFilePrivate *priv = GET_PRIVATE (self);
+
+  g_return_if_fail (YTS_IS_OUTGOING_FILE (self));
+  g_return_if_fail (!priv->started);
+
+  priv->started = true;
+
+  g_signal_emit_by_name (self, "cancelled");
+  priv->progress = -0.1;
+  g_object_notify (G_OBJECT (self), "progress");
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_PROBES_H
+#define YTS_PROBES_H
+
+/*
+ * Static tracepoints, SystemTap / USDT style, under the provider name
+ * "ytstenut". With --enable-probes each probe compiles to a single nop plus
+ * a note in the ELF file, which perf, bpftrace and stap attach to at run
+ * time; otherwise they compile to nothing. Compiled in, the arguments are
+ * evaluated whether a tracer is attached or not, so only pass values that
+ * are at hand already. Where arguments need computing, guard the probe
+ * with YTS_PROBE_ENABLED(), which tests the probe's SDT semaphore. Tracers
+ * increment it while attached, and it is 0 when probes are not compiled in.
+ * Every probe has a semaphore, defined in ytstenut.c.
+ *
+ * Strings are passed as pointers, IDs let a single invocation be followed
+ * across processes:
+ *
+ *  message-send (contact_id, service_id, type, capability, invocation_id)
+ *  message-receive (contact_id, service_id, size)
+ *  message-dispatch (contact_id, service_id, type, capability,
+ *                    invocation_id, dispatched)
+ *  channel-request (contact_id, service_id, error, size)
+ *  channel-reply (contact_id, service_id, error, success)
+ *  invocation-establish (invocation_id, capability, aspect, queueing_us)
+ *  invocation-conclude (invocation_id, capability, aspect, processing_us)
+ *  event-send (capability, aspect, n_recipients)
+ *  status-advertise (capability, size)
+ *  status-receive (contact_id, service_id, capability, size)
+ *  outgoing-file-state (channel_path, state, reason, transferred, size)
+ *  incoming-file-state (channel_path, state, reason, transferred, size)
+ *
+ * For example
+ *  bpftrace -e 'usdt:./libytstenut-1.so:ytstenut:invocation__conclude
+ *               { @[str(arg1), str(arg2)] = hist(arg3); }'
+ */
+
+#ifdef YTS_ENABLE_PROBES
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define YTS_PROBE_SEMAPHORE(name) \
+  unsigned short ytstenut_##name##_semaphore \
+    __attribute__ ((section (".probes"))) \
+    __attribute__ ((visibility ("hidden")))
+
+extern YTS_PROBE_SEMAPHORE (message__send);
+extern YTS_PROBE_SEMAPHORE (message__receive);
+extern YTS_PROBE_SEMAPHORE (message__dispatch);
+extern YTS_PROBE_SEMAPHORE (channel__request);
+extern YTS_PROBE_SEMAPHORE (channel__reply);
+extern YTS_PROBE_SEMAPHORE (invocation__establish);
+extern YTS_PROBE_SEMAPHORE (invocation__conclude);
+extern YTS_PROBE_SEMAPHORE (event__send);
+extern YTS_PROBE_SEMAPHORE (status__advertise);
+extern YTS_PROBE_SEMAPHORE (status__receive);
+extern YTS_PROBE_SEMAPHORE (outgoing__file__state);
+extern YTS_PROBE_SEMAPHORE (incoming__file__state);
+
+#define YTS_PROBE_ENABLED(name) \
+  __builtin_expect (ytstenut_##name##_semaphore, 0)
+
+#define YTS_PROBE(name) \
+  DTRACE_PROBE (ytstenut, name)
+#define YTS_PROBE1(name, a1) \
+  DTRACE_PROBE1 (ytstenut, name, a1)
+#define YTS_PROBE2(name, a1, a2) \
+  DTRACE_PROBE2 (ytstenut, name, a1, a2)
+#define YTS_PROBE3(name, a1, a2, a3) \
+  DTRACE_PROBE3 (ytstenut, name, a1, a2, a3)
+#define YTS_PROBE4(name, a1, a2, a3, a4) \
+  DTRACE_PROBE4 (ytstenut, name, a1, a2, a3, a4)
+#define YTS_PROBE5(name, a1, a2, a3, a4, a5) \
+  DTRACE_PROBE5 (ytstenut, name, a1, a2, a3, a4, a5)
+#define YTS_PROBE6(name, a1, a2, a3, a4, a5, a6) \
+  DTRACE_PROBE6 (ytstenut, name, a1, a2, a3, a4, a5, a6)
+
+#else /* YTS_ENABLE_PROBES */
+
+#define YTS_PROBE_ENABLED(name) 0
+
+#define YTS_PROBE(name) do {} while (0)
+#define YTS_PROBE1(name, a1) do {} while (0)
+#define YTS_PROBE2(name, a1, a2) do {} while (0)
+#define YTS_PROBE3(name, a1, a2, a3) do {} while (0)
+#define YTS_PROBE4(name, a1, a2, a3, a4) do {} while (0)
+#define YTS_PROBE5(name, a1, a2, a3, a4, a5) do {} while (0)
+#define YTS_PROBE6(name, a1, a2, a3, a4, a5, a6) do {} while (0)
+
+#endif /* YTS_ENABLE_PROBES */
+
+#endif /* YTS_PROBES_H */
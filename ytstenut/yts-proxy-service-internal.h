@@ -53,5 +53,8 @@ yts_proxy_service_dispatch_response (YtsProxyService  *self,
                                      char const       *invocation_id,
                                      GVariant         *response);
 
+void
+yts_proxy_service_dump_latency_statistics (YtsProxyService *self);
+
 #endif /* YTS_PROXY_SERVICE_INTERNAL_H */
 
@@ -23,6 +23,7 @@
 #include <stdbool.h>
 
 #include "yts-capability.h"
+#include "yts-histogram.h"
 #include "yts-invocation-message.h"
 #include "yts-marshal.h"
 #include "yts-proxy-factory.h"
@@ -47,8 +48,23 @@ G_DEFINE_ABSTRACT_TYPE (YtsProxyService, yts_proxy_service, YTS_TYPE_SERVICE)
  * @short_description: Represents a remote service with method invocation support.
  */
 
+#define PROXY_TIMEOUT_S_DEFAULT 30
+#define MAX_PENDING_PROXIES_DEFAULT 64
+
+/* Invocations still waiting for a response after this long are not timed,
+ * the service is not going to answer them. */
+#define INVOCATION_STALE_S 60
+#define MAX_TIMED_INVOCATIONS 256
+
+enum {
+  PROP_0,
+  PROP_PROXY_TIMEOUT,
+  PROP_MAX_PENDING_PROXIES
+};
+
 enum {
   SIG_PROXY_CREATED,
+  SIG_PROXY_CREATION_FAILED,
   N_SIGNALS
 };
 
@@ -56,10 +72,145 @@ typedef struct {
   YtsProfile *profile;
   GHashTable  *pending_proxies;
   GHashTable  *proxies;
+  /* Properties */
+  unsigned     proxy_timeout_s;
+  unsigned     max_pending_proxies;
+  /* Round trip of invocations, by capability and aspect */
+  GHashTable      *timed_invocations;
+  YtsLatencyTable *latency;
 } YtsProxyServicePrivate;
 
+/*
+ * Invocation sent to the remote service, for timing the response.
+ */
+typedef struct {
+  char    *capability;
+  char    *aspect;
+  int64_t  start_time;
+} TimedInvocation;
+
+/*
+ * Proxy registration waiting for the remote service to respond.
+ */
+typedef struct {
+  YtsProxyService *self;          /* free pointer */
+  char            *invocation_id; /* free pointer, owned by the hash */
+  char           **capabilities;
+  bool             batch;
+  unsigned         timeout_id;
+} PendingProxies;
+
 static unsigned _signals[N_SIGNALS] = { 0, };
 
+static void
+timed_invocation_free (TimedInvocation *timed)
+{
+  g_free (timed->capability);
+  g_free (timed->aspect);
+  g_slice_free (TimedInvocation, timed);
+}
+
+static bool
+_timed_invocation_is_stale (char const      *invocation_id,
+                            TimedInvocation *timed,
+                            int64_t const   *now)
+{
+  return *now - timed->start_time > INVOCATION_STALE_S * G_USEC_PER_SEC;
+}
+
+static void
+start_timed_invocation (YtsProxyService *self,
+                        char const      *invocation_id,
+                        char const      *capability,
+                        char const      *aspect)
+{
+  YtsProxyServicePrivate *priv = GET_PRIVATE (self);
+  TimedInvocation *timed;
+  int64_t          now = g_get_monotonic_time ();
+
+  /* Invocations that never get a response would pile up otherwise. */
+  if (g_hash_table_size (priv->timed_invocations) >= MAX_TIMED_INVOCATIONS) {
+    g_hash_table_foreach_remove (priv->timed_invocations,
+                                 (GHRFunc) _timed_invocation_is_stale,
+                                 &now);
+  }
+
+  timed = g_slice_new (TimedInvocation);
+  timed->capability = g_strdup (capability);
+  timed->aspect = g_strdup (aspect);
+  timed->start_time = now;
+
+  g_hash_table_insert (priv->timed_invocations,
+                       g_strdup (invocation_id),
+                       timed);
+}
+
+static void
+finish_timed_invocation (YtsProxyService *self,
+                         char const      *invocation_id)
+{
+  YtsProxyServicePrivate *priv = GET_PRIVATE (self);
+  TimedInvocation *timed;
+
+  timed = g_hash_table_lookup (priv->timed_invocations, invocation_id);
+  if (timed) {
+    yts_latency_table_record (priv->latency,
+                              timed->capability,
+                              timed->aspect,
+                              g_get_monotonic_time () - timed->start_time);
+    g_hash_table_remove (priv->timed_invocations, invocation_id);
+  }
+}
+
+static void
+pending_proxies_free (PendingProxies *pending)
+{
+  if (pending->timeout_id) {
+    g_source_remove (pending->timeout_id);
+  }
+  g_strfreev (pending->capabilities);
+  g_free (pending);
+}
+
+static void
+emit_proxy_creation_failed (YtsProxyService *self,
+                            char const      *capability,
+                            GError          *error)
+{
+  g_signal_emit (self, _signals[SIG_PROXY_CREATION_FAILED], 0,
+                 capability, error);
+}
+
+static bool
+_pending_proxies_timeout (PendingProxies *pending)
+{
+  YtsProxyService *self = pending->self;
+  YtsProxyServicePrivate *priv = GET_PRIVATE (self);
+  GError   *error;
+  unsigned  i;
+
+  /* Returning false removes the source. */
+  pending->timeout_id = 0;
+
+  error = g_error_new (YTS_PROXY_SERVICE_ERROR,
+                       YTS_PROXY_SERVICE_ERROR_TIMED_OUT,
+                       "No response from the service after %u seconds",
+                       priv->proxy_timeout_s);
+
+  /* Keep the data around for the signal emission. */
+  g_hash_table_steal (priv->pending_proxies, pending->invocation_id);
+  g_free (pending->invocation_id);
+
+  for (i = 0; pending->capabilities[i]; i++) {
+    emit_proxy_creation_failed (self, pending->capabilities[i], error);
+  }
+
+  g_error_free (error);
+  pending_proxies_free (pending);
+
+  return false;
+}
+
 static void
 _constructed (GObject *object)
 {
@@ -74,9 +225,15 @@ _get_property (GObject      *object,
                GValue       *value,
                GParamSpec   *pspec)
 {
-  // YtsProxyServicePrivate *priv = GET_PRIVATE (object);
+  YtsProxyServicePrivate *priv = GET_PRIVATE (object);
 
   switch (property_id) {
+    case PROP_PROXY_TIMEOUT:
+      g_value_set_uint (value, priv->proxy_timeout_s);
+      break;
+    case PROP_MAX_PENDING_PROXIES:
+      g_value_set_uint (value, priv->max_pending_proxies);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -88,9 +245,16 @@ _set_property (GObject      *object,
                const GValue *value,
                GParamSpec   *pspec)
 {
-  // YtsProxyServicePrivate *priv = GET_PRIVATE (object);
+  YtsProxyServicePrivate *priv = GET_PRIVATE (object);
 
   switch (property_id) {
+    case PROP_PROXY_TIMEOUT:
+      /* Applies to registrations started from now on. */
+      priv->proxy_timeout_s = g_value_get_uint (value);
+      break;
+    case PROP_MAX_PENDING_PROXIES:
+      priv->max_pending_proxies = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -133,13 +297,29 @@ _dispose (GObject *object)
     priv->pending_proxies = NULL;
   }
 
+  if (priv->timed_invocations) {
+    g_hash_table_destroy (priv->timed_invocations);
+    priv->timed_invocations = NULL;
+  }
+
   G_OBJECT_CLASS (yts_proxy_service_parent_class)->dispose (object);
 }
 
+static void
+_finalize (GObject *object)
+{
+  YtsProxyServicePrivate *priv = GET_PRIVATE (object);
+
+  yts_latency_table_free (priv->latency);
+
+  G_OBJECT_CLASS (yts_proxy_service_parent_class)->finalize (object);
+}
+
 static void
 yts_proxy_service_class_init (YtsProxyServiceClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GParamSpec   *pspec;
 
   g_type_class_add_private (klass, sizeof (YtsProxyServicePrivate));
 
@@ -147,6 +327,39 @@ yts_proxy_service_class_init (YtsProxyServiceClass *klass)
   object_class->get_property = _get_property;
   object_class->set_property = _set_property;
   object_class->dispose = _dispose;
+  object_class->finalize = _finalize;
+
+  /* Properties */
+
+  /**
+   * YtsProxyService:proxy-timeout:
+   *
+   * Seconds to wait for the remote service to respond to a proxy
+   * registration, before YtsProxyService::proxy-creation-failed is emitted.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint ("proxy-timeout", "", "",
+                             1, G_MAXUINT, PROXY_TIMEOUT_S_DEFAULT,
+                             G_PARAM_READWRITE |
+                             G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_PROXY_TIMEOUT, pspec);
+
+  /**
+   * YtsProxyService:max-pending-proxies:
+   *
+   * Maximum number of proxy registrations waiting for a response. Creating
+   * more proxies fails until some of them have completed or timed out.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint ("max-pending-proxies", "", "",
+                             1, G_MAXUINT, MAX_PENDING_PROXIES_DEFAULT,
+                             G_PARAM_READWRITE |
+                             G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class,
+                                   PROP_MAX_PENDING_PROXIES,
+                                   pspec);
 
   /* Signals */
 
@@ -157,7 +370,8 @@ yts_proxy_service_class_init (YtsProxyServiceClass *klass)
    *
    * The YtsProxyService::proxy-created signal is emitted asynchronously in
    * response to yts_proxy_service_create_proxy() and delivers the initialised
-   * and ready to use proxy object.
+   * and ready to use proxy object. After yts_proxy_service_create_proxies()
+   * it is emitted once for each capability.
    *
    * Since: 0.3
    */
@@ -168,6 +382,27 @@ yts_proxy_service_class_init (YtsProxyServiceClass *klass)
                                               yts_marshal_VOID__OBJECT,
                                               G_TYPE_NONE, 1,
                                               YTS_TYPE_PROXY);
+
+  /**
+   * YtsProxyService::proxy-creation-failed:
+   * @self: object which emitted the signal.
+   * @capability: capability the proxy was requested for.
+   * @error: reason, in the #YTS_PROXY_SERVICE_ERROR domain.
+   *
+   * The YtsProxyService::proxy-creation-failed signal is emitted instead of
+   * YtsProxyService::proxy-created when the remote service refused or
+   * did not respond to the registration in time.
+   *
+   * Since: 0.4
+   */
+  _signals[SIG_PROXY_CREATION_FAILED] =
+                              g_signal_new ("proxy-creation-failed",
+                                            YTS_TYPE_PROXY_SERVICE,
+                                            G_SIGNAL_RUN_LAST,
+                                            0, NULL, NULL,
+                                            yts_marshal_VOID__STRING_BOXED,
+                                            G_TYPE_NONE, 2,
+                                            G_TYPE_STRING, G_TYPE_ERROR);
 }
 
 static void
@@ -175,15 +410,27 @@ yts_proxy_service_init (YtsProxyService *self)
 {
   YtsProxyServicePrivate *priv = GET_PRIVATE (self);
 
+  priv->proxy_timeout_s = PROXY_TIMEOUT_S_DEFAULT;
+  priv->max_pending_proxies = MAX_PENDING_PROXIES_DEFAULT;
+
   priv->proxies = g_hash_table_new_full (g_str_hash,
                                          g_str_equal,
                                          g_free,
                                          NULL);
 
-  priv->pending_proxies = g_hash_table_new_full (g_str_hash,
-                                                 g_str_equal,
-                                                 g_free,
-                                                 g_free);
+  priv->pending_proxies = g_hash_table_new_full (
+                                        g_str_hash,
+                                        g_str_equal,
+                                        g_free,
+                                        (GDestroyNotify) pending_proxies_free);
+
+  priv->timed_invocations = g_hash_table_new_full (
+                                        g_str_hash,
+                                        g_str_equal,
+                                        g_free,
+                                        (GDestroyNotify) timed_invocation_free);
+
+  priv->latency = yts_latency_table_new ();
 }
 
 static void
@@ -202,6 +449,7 @@ _profile_invoke_service (YtsProfile      *profile,
                                         aspect,
                                         arguments);
 
+  start_timed_invocation (self, invocation_id, fqc_id, aspect);
   yts_service_emitter_send_message (YTS_SERVICE_EMITTER (self), message);
 
   g_object_unref (message);
@@ -224,6 +472,7 @@ _proxy_invoke_service (YtsProxy        *proxy,
                                         aspect,
                                         arguments);
 
+  start_timed_invocation (self, invocation_id, fqc_id, aspect);
   yts_service_emitter_send_message (YTS_SERVICE_EMITTER (self), message);
 
   g_object_unref (message);
@@ -248,6 +497,128 @@ _proxy_destroyed (YtsProxyService  *self,
   }
 }
 
+static void
+ensure_profile (YtsProxyService *self)
+{
+  YtsProxyServicePrivate *priv = GET_PRIVATE (self);
+
+  if (NULL == priv->profile) {
+    /* Lazily create the profile proxy. */
+    priv->profile = g_object_new (YTS_TYPE_PROFILE_PROXY, NULL);
+    g_signal_connect (priv->profile, "invoke-service",
+                      G_CALLBACK (_profile_invoke_service), self);
+  }
+}
+
+static void
+create_proxy (YtsProxyService *self,
+              char const      *capability,
+              GVariant        *properties)
+{
+  YtsProxyServicePrivate *priv = GET_PRIVATE (self);
+  YtsProxyFactory * const factory = yts_proxy_factory_get_default ();
+  YtsProxy *proxy;
+  /* Initial properties for the proxy */
+  GVariantIter iter;
+  char *name;
+  GVariant *value;
+
+  if (!g_variant_is_of_type (properties, G_VARIANT_TYPE_DICTIONARY)) {
+    GError *error = g_error_new (YTS_PROXY_SERVICE_ERROR,
+                                 YTS_PROXY_SERVICE_ERROR_REGISTRATION_FAILED,
+                                 "Registering proxy for capability %s failed",
+                                 capability);
+    emit_proxy_creation_failed (self, capability, error);
+    g_error_free (error);
+    return;
+  }
+
+  /* Create proxy object */
+  proxy = yts_proxy_factory_create_proxy (factory, capability);
+  if (!proxy) {
+    GError *error = g_error_new (YTS_PROXY_SERVICE_ERROR,
+                                 YTS_PROXY_SERVICE_ERROR_NO_PROXY_TYPE,
+                                 "Creating proxy for capability %s failed",
+                                 capability);
+    emit_proxy_creation_failed (self, capability, error);
+    g_error_free (error);
+    return;
+  }
+
+  g_hash_table_insert (priv->proxies,
+                       g_strdup (capability),
+                       proxy);
+  g_signal_connect (proxy, "invoke-service",
+                    G_CALLBACK (_proxy_invoke_service), self);
+  g_object_weak_ref (G_OBJECT (proxy),
+                     (GWeakNotify) _proxy_destroyed,
+                     self);
+
+  g_variant_iter_init (&iter, properties);
+  while (g_variant_iter_next (&iter, "{sv}", &name, &value)) {
+    /* Pass the properties to the proxy through the standard mechanism. */
+    yts_proxy_handle_service_event (proxy, name, value);
+    g_free (name);
+    g_variant_unref (value);
+  }
+
+  g_signal_emit (self, _signals[SIG_PROXY_CREATED], 0, proxy);
+  g_object_unref (proxy);
+}
+
+/*
+ * Validate @capabilities and start tracking a registration for them.
+ * Returns the invocation ID to send the registration with, or %NULL.
+ */
+static char const *
+add_pending_proxies (YtsProxyService    *self,
+                     char const *const  *capabilities,
+                     bool                batch)
+{
+  YtsProxyServicePrivate *priv = GET_PRIVATE (self);
+  PendingProxies  *pending;
+  unsigned         i;
+
+  for (i = 0; capabilities[i]; i++) {
+    if (!yts_capability_has_fqc_id (YTS_CAPABILITY (self), capabilities[i])) {
+      // FIXME GError
+      g_critical ("%s : Service does not support capability %s",
+                  G_STRLOC,
+                  capabilities[i]);
+      return NULL;
+    }
+  }
+
+  if (g_hash_table_size (priv->pending_proxies) >= priv->max_pending_proxies) {
+    g_warning ("%s : Too many proxy registrations pending (%u)",
+               G_STRLOC,
+               priv->max_pending_proxies);
+    return NULL;
+  }
+
+  ensure_profile (self);
+
+  /* Register new proxy with the service.
+   * For now just remember its type, and create it when the server responds. */
+
+  pending = g_new0 (PendingProxies, 1);
+  pending->self = self;
+  pending->invocation_id =
+                  yts_proxy_create_invocation_id (YTS_PROXY (priv->profile));
+  pending->capabilities = g_strdupv ((char **) capabilities);
+  pending->batch = batch;
+  pending->timeout_id = g_timeout_add_seconds (
+                                      priv->proxy_timeout_s,
+                                      (GSourceFunc) _pending_proxies_timeout,
+                                      pending);
+
+  g_hash_table_insert (priv->pending_proxies,
+                       pending->invocation_id,
+                       pending);
+
+  return pending->invocation_id;
+}
+
 /**
  * yts_proxy_service_create_proxy:
  * @self: object on which to invoke this method.
@@ -266,39 +637,83 @@ yts_proxy_service_create_proxy (YtsProxyService *self,
                                  char const       *capability)
 {
   YtsProxyServicePrivate *priv = GET_PRIVATE (self);
-  bool   has_fqc_id;
-  char  *invocation_id;
-
-  has_fqc_id = yts_capability_has_fqc_id (YTS_CAPABILITY (self), capability);
-  if (!has_fqc_id) {
-    // FIXME GError
-    g_critical ("%s : Service does not support capability %s",
-                G_STRLOC,
-                capability);
+  char const *capabilities[] = { capability, NULL };
+  char const *invocation_id;
+
+  invocation_id = add_pending_proxies (self, capabilities, false);
+  if (NULL == invocation_id) {
     return false;
   }
 
-  if (NULL == priv->profile) {
-    /* Lazily create the profile proxy. */
-    priv->profile = g_object_new (YTS_TYPE_PROFILE_PROXY, NULL);
-    g_signal_connect (priv->profile, "invoke-service",
-                      G_CALLBACK (_profile_invoke_service), self);
-  }
+  yts_profile_register_proxy (priv->profile, invocation_id, capability);
 
-  /* Register new proxy with the service.
-   * For now just remember its type, and create it when the server responds. */
+  return true;
+}
 
-  invocation_id = yts_proxy_create_invocation_id (YTS_PROXY (priv->profile));
-  g_hash_table_insert (priv->pending_proxies,
-                       invocation_id,
-                       g_strdup (capability));
+/**
+ * yts_proxy_service_create_proxies:
+ * @self: object on which to invoke this method.
+ * @capabilities: %NULL-terminated array of fully qualified capability IDs.
+ *
+ * Create proxies for several remote objects of service @self at once. This
+ * takes a single round trip to the remote service, rather than one for each
+ * capability as with yts_proxy_service_create_proxy(). The
+ * YtsProxyService::proxy-created signal is emitted once for each proxy.
+ *
+ * Returns: <literal>true</literal> if the YtsProxyService::proxy-created can be expected to
+ *          deliver.
+ *
+ * Since: 0.4
+ */
+bool
+yts_proxy_service_create_proxies (YtsProxyService   *self,
+                                  char const *const *capabilities)
+{
+  YtsProxyServicePrivate *priv = GET_PRIVATE (self);
+  char const *invocation_id;
 
-  // TODO timeout
-  yts_profile_register_proxy (priv->profile, invocation_id, capability);
+  g_return_val_if_fail (YTS_IS_PROXY_SERVICE (self), false);
+  g_return_val_if_fail (capabilities && capabilities[0], false);
+
+  invocation_id = add_pending_proxies (self, capabilities, true);
+  if (NULL == invocation_id) {
+    return false;
+  }
+
+  yts_profile_register_proxies (priv->profile, invocation_id, capabilities);
 
   return true;
 }
 
+static void
+dispatch_batch_response (YtsProxyService    *self,
+                         char const *const  *capabilities,
+                         GVariant           *response)
+{
+  unsigned i;
+
+  for (i = 0; capabilities[i]; i++) {
+
+    GVariant *properties = NULL;
+
+    if (g_variant_is_of_type (response, G_VARIANT_TYPE ("a{sv}"))) {
+      properties = g_variant_lookup_value (response, capabilities[i], NULL);
+    }
+
+    if (properties) {
+      create_proxy (self, capabilities[i], properties);
+      g_variant_unref (properties);
+    } else {
+      GError *error = g_error_new (YTS_PROXY_SERVICE_ERROR,
+                                   YTS_PROXY_SERVICE_ERROR_REGISTRATION_FAILED,
+                                   "No response for capability %s",
+                                   capabilities[i]);
+      emit_proxy_creation_failed (self, capabilities[i], error);
+      g_error_free (error);
+    }
+  }
+}
+
 bool
 yts_proxy_service_dispatch_event (YtsProxyService *self,
                                    char const       *capability,
@@ -334,57 +749,28 @@ yts_proxy_service_dispatch_response (YtsProxyService  *self,
                                       GVariant          *response)
 {
   YtsProxyServicePrivate *priv = GET_PRIVATE (self);
-  char const *new_proxy_fqc_id;
+  PendingProxies *pending;
+
+  finish_timed_invocation (self, invocation_id);
 
   /* PONDERING this reply should really go to the profile proxy
    * and be handled there. */
-  new_proxy_fqc_id = (char const *) g_hash_table_lookup (priv->pending_proxies,
-                                                         invocation_id);
-  if (new_proxy_fqc_id) {
-
-    YtsProxyFactory * const factory = yts_proxy_factory_get_default ();
-    YtsProxy *proxy;
-    /* Initial properties for the proxy */
-    GVariantIter iter;
-    char *name;
-    GVariant *value;
-
-    if (!g_variant_is_of_type (response, G_VARIANT_TYPE_DICTIONARY)) {
-      g_critical ("%s : Registering proxy for capability %s failed",
-                  G_STRLOC,
-                  new_proxy_fqc_id);
-      return false;
-    }
-
-    /* Create proxy object */
-    proxy = yts_proxy_factory_create_proxy (factory, new_proxy_fqc_id);
-    if (!proxy) {
-      g_critical ("%s : Creating proxy for capability %s failed",
-                  G_STRLOC,
-                  new_proxy_fqc_id);
-      return false;
-    }
-
-    g_hash_table_insert (priv->proxies,
-                         g_strdup (new_proxy_fqc_id),
-                         proxy);
-    g_signal_connect (proxy, "invoke-service",
-                      G_CALLBACK (_proxy_invoke_service), self);
-    g_object_weak_ref (G_OBJECT (proxy),
-                       (GWeakNotify) _proxy_destroyed,
-                       self);
-
-    g_variant_iter_init (&iter, response);
-    while (g_variant_iter_next (&iter, "{sv}", &name, &value)) {
-      /* Pass the properties to the proxy through the standard mechanism. */
-      yts_proxy_handle_service_event (proxy, name, value);
-      g_free (name);
-      g_variant_unref (value);
+  pending = g_hash_table_lookup (priv->pending_proxies, invocation_id);
+  if (pending) {
+
+    /* Detach from the hash first, signal handlers may create new proxies. */
+    g_hash_table_steal (priv->pending_proxies, invocation_id);
+    g_free (pending->invocation_id);
+
+    if (pending->batch) {
+      dispatch_batch_response (self,
+                               (char const *const *) pending->capabilities,
+                               response);
+    } else {
+      create_proxy (self, pending->capabilities[0], response);
     }
 
-    g_signal_emit (self, _signals[SIG_PROXY_CREATED], 0, proxy);
-    g_object_unref (proxy);
-    g_hash_table_remove (priv->pending_proxies, invocation_id);
+    pending_proxies_free (pending);
     return true;
   }
 
@@ -408,3 +794,47 @@ yts_proxy_service_dispatch_response (YtsProxyService  *self,
   return false;
 }
 
+/**
+ * yts_proxy_service_get_latency_statistics:
+ * @self: object on which to invoke this method.
+ *
+ * Get the round trip times of invocations made through this service's
+ * proxies, from sending the invocation until the response arrives. The
+ * result is of type <literal>a{sv}</literal>, with key "end-to-end" holding
+ * an <literal>a{sa{sa{sv}}}</literal> dictionary from capability to aspect
+ * to a summary of the latency histogram: "count" (<literal>t</literal>),
+ * "min", "mean", "p50", "p90", "p99", "p99.9" and "max"
+ * (<literal>x</literal>, microseconds).
+ *
+ * Returns: (transfer full): latency statistics.
+ *
+ * Since: 0.4
+ */
+GVariant *
+yts_proxy_service_get_latency_statistics (YtsProxyService *self)
+{
+  YtsProxyServicePrivate *priv = GET_PRIVATE (self);
+  GVariantBuilder builder;
+
+  g_return_val_if_fail (YTS_IS_PROXY_SERVICE (self), NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+  g_variant_builder_add (&builder, "{sv}", "end-to-end",
+                         yts_latency_table_to_variant (priv->latency));
+
+  return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+void
+yts_proxy_service_dump_latency_statistics (YtsProxyService *self)
+{
+  YtsProxyServicePrivate *priv = GET_PRIVATE (self);
+  char *name;
+
+  g_return_if_fail (YTS_IS_PROXY_SERVICE (self));
+
+  name = g_strdup_printf ("end-to-end %s",
+                          yts_service_get_id (YTS_SERVICE (self)));
+  yts_latency_table_dump (priv->latency, name);
+  g_free (name);
+}
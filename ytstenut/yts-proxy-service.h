@@ -40,10 +40,25 @@ typedef struct YtsProxyService YtsProxyService;
 GType
 yts_proxy_service_get_type (void) G_GNUC_CONST;
 
+#define YTS_PROXY_SERVICE_ERROR g_quark_from_static_string ("yts-proxy-service-error")
+
+enum {
+  YTS_PROXY_SERVICE_ERROR_TIMED_OUT,
+  YTS_PROXY_SERVICE_ERROR_REGISTRATION_FAILED,
+  YTS_PROXY_SERVICE_ERROR_NO_PROXY_TYPE
+};
+
 bool
 yts_proxy_service_create_proxy (YtsProxyService *self,
                                 char const      *capability);
 
+bool
+yts_proxy_service_create_proxies (YtsProxyService   *self,
+                                  char const *const *capabilities);
+
+GVariant *
+yts_proxy_service_get_latency_statistics (YtsProxyService *self);
+
 G_END_DECLS
 
 #endif /* YTS_PROXY_SERVICE_H */
@@ -35,6 +35,9 @@ G_DEFINE_ABSTRACT_TYPE_WITH_CODE (YtsProxy,
                                   G_IMPLEMENT_INTERFACE (YTS_TYPE_CAPABILITY,
                                                          _capability_interface_init))
 
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), YTS_TYPE_PROXY, YtsProxyPrivate))
+
 #undef G_LOG_DOMAIN
 #define G_LOG_DOMAIN PACKAGE"\0proxy\0"G_STRLOC
 
@@ -57,8 +60,124 @@ enum {
   N_SIGNALS
 };
 
+typedef struct {
+  /* Invocations made through yts_proxy_invoke_async(),
+   * maps invocation ID to Invocation. */
+  GHashTable  *invocations;
+} YtsProxyPrivate;
+
+/* Deadline for asynchronous invocations, unless specified otherwise. */
+#define INVOKE_TIMEOUT_MS_DEFAULT (30 * 1000)
+
+typedef struct {
+  YtsProxy            *self;          /* free pointer */
+  char                *invocation_id; /* also the key in the hash */
+  GSimpleAsyncResult  *result;
+  GCancellable        *cancellable;
+  unsigned long        cancelled_id;
+  unsigned             cancelled_idle_id;
+  unsigned             timeout_id;
+} Invocation;
+
 static unsigned _signals[N_SIGNALS] = { 0, };
 
+/*
+ * Invocation
+ */
+
+static void
+invocation_free (Invocation *invocation)
+{
+  if (invocation->timeout_id) {
+    g_source_remove (invocation->timeout_id);
+  }
+
+  if (invocation->cancelled_idle_id) {
+    g_source_remove (invocation->cancelled_idle_id);
+  }
+
+  if (invocation->cancellable) {
+    g_cancellable_disconnect (invocation->cancellable,
+                              invocation->cancelled_id);
+    g_object_unref (invocation->cancellable);
+  }
+
+  g_object_unref (invocation->result);
+  g_free (invocation->invocation_id);
+  g_free (invocation);
+}
+
+/*
+ * Take @invocation out of the tracker and complete it, either with
+ * @response or with @error.
+ */
+static void
+invocation_complete (Invocation *invocation,
+                     GVariant   *response,
+                     GError     *error)
+{
+  YtsProxyPrivate *priv = GET_PRIVATE (invocation->self);
+  GSimpleAsyncResult *result;
+
+  result = g_object_ref (invocation->result);
+  g_hash_table_remove (priv->invocations, invocation->invocation_id);
+
+  if (error) {
+    g_simple_async_result_set_from_error (result, error);
+  } else if (response) {
+    g_simple_async_result_set_op_res_gpointer (
+                                        result,
+                                        g_variant_ref_sink (response),
+                                        (GDestroyNotify) g_variant_unref);
+  }
+
+  g_simple_async_result_complete (result);
+  g_object_unref (result);
+}
+
+static bool
+_invocation_timeout (Invocation *invocation)
+{
+  GError *error;
+
+  /* Returning false removes the source. */
+  invocation->timeout_id = 0;
+
+  error = g_error_new (G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
+                       "No response to invocation %s",
+                       invocation->invocation_id);
+  invocation_complete (invocation, NULL, error);
+  g_error_free (error);
+
+  return false;
+}
+
+static bool
+_invocation_cancelled_idle (Invocation *invocation)
+{
+  GError *error = NULL;
+
+  invocation->cancelled_idle_id = 0;
+
+  g_cancellable_set_error_if_cancelled (invocation->cancellable, &error);
+  invocation_complete (invocation, NULL, error);
+  g_error_free (error);
+
+  return false;
+}
+
+static void
+_invocation_cancelled (GCancellable *cancellable,
+                       Invocation   *invocation)
+{
+  /* Can't disconnect from within the handler, so complete from an idle. */
+  if (0 == invocation->cancelled_idle_id) {
+    invocation->cancelled_idle_id = g_idle_add (
+                                  (GSourceFunc) _invocation_cancelled_idle,
+                                  invocation);
+  }
+}
+
 /*
  * YtsCapability implementation
  */
@@ -101,6 +220,25 @@ _set_property (GObject      *object,
 static void
 _dispose (GObject *object)
 {
+  YtsProxyPrivate *priv = GET_PRIVATE (object);
+
+  if (priv->invocations) {
+
+    GList *invocations = g_hash_table_get_values (priv->invocations);
+    GList *iter;
+
+    for (iter = invocations; iter; iter = iter->next) {
+      GError *error = g_error_new (G_IO_ERROR, G_IO_ERROR_CLOSED,
+                                   "Proxy disposed");
+      invocation_complete (iter->data, NULL, error);
+      g_error_free (error);
+    }
+    g_list_free (invocations);
+
+    g_hash_table_destroy (priv->invocations);
+    priv->invocations = NULL;
+  }
+
   G_OBJECT_CLASS (yts_proxy_parent_class)->dispose (object);
 }
 
@@ -109,6 +247,8 @@ yts_proxy_class_init (YtsProxyClass *klass)
 {
   GObjectClass  *object_class = G_OBJECT_CLASS (klass);
 
+  g_type_class_add_private (klass, sizeof (YtsProxyPrivate));
+
   object_class->get_property = _get_property;
   object_class->set_property = _set_property;
   object_class->dispose = _dispose;
@@ -180,6 +320,13 @@ yts_proxy_class_init (YtsProxyClass *klass)
 static void
 yts_proxy_init (YtsProxy *self)
 {
+  YtsProxyPrivate *priv = GET_PRIVATE (self);
+
+  priv->invocations = g_hash_table_new_full (
+                                        g_str_hash,
+                                        g_str_equal,
+                                        NULL,
+                                        (GDestroyNotify) invocation_free);
 }
 
 /**
@@ -254,7 +401,8 @@ yts_proxy_create_invocation_id (YtsProxy *self)
  *
  *
  * Invoke a method on the remote object. The response is delivered by the
- * #YtsProxy::service-response signal.
+ * #YtsProxy::service-response signal. See yts_proxy_invoke_async() for
+ * having it delivered to a callback instead.
  *
  * Since: 0.3
  */
@@ -281,6 +429,128 @@ yts_proxy_invoke (YtsProxy  *self,
   }
 }
 
+/**
+ * yts_proxy_invoke_async:
+ * @self: object on which to invoke this method.
+ * @aspect: name of the method to invoke.
+ * @arguments: arguments to pass, see yts_proxy_invoke().
+ * @timeout_ms: deadline for the response in milliseconds, -1 for the default
+ *              of 30 seconds, or %G_MAXINT for no deadline.
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @callback: callback to call when the response arrives.
+ * @data: user data to pass to @callback.
+ *
+ * Invoke a method on the remote object. When the response arrives, or the
+ * deadline passes, or @cancellable is cancelled, @callback is called and
+ * needs to call yts_proxy_invoke_finish(). The response is not delivered by
+ * the #YtsProxy::service-response signal.
+ *
+ * Since: 0.4
+ */
+void
+yts_proxy_invoke_async (YtsProxy            *self,
+                        char const          *aspect,
+                        GVariant            *arguments,
+                        int                  timeout_ms,
+                        GCancellable        *cancellable,
+                        GAsyncReadyCallback  callback,
+                        void                *data)
+{
+  YtsProxyPrivate *priv = GET_PRIVATE (self);
+  GSimpleAsyncResult  *result;
+  Invocation          *invocation;
+
+  g_return_if_fail (YTS_IS_PROXY (self));
+  g_return_if_fail (aspect);
+
+  result = g_simple_async_result_new (G_OBJECT (self),
+                                      callback,
+                                      data,
+                                      yts_proxy_invoke_async);
+
+  if (cancellable && g_cancellable_is_cancelled (cancellable)) {
+
+    GError *error = NULL;
+
+    g_cancellable_set_error_if_cancelled (cancellable, &error);
+    g_simple_async_result_take_error (result, error);
+    g_simple_async_result_complete_in_idle (result);
+    g_object_unref (result);
+
+    if (arguments &&
+        g_variant_is_floating (arguments)) {
+      g_variant_unref (arguments);
+    }
+    return;
+  }
+
+  invocation = g_new0 (Invocation, 1);
+  invocation->self = self;
+  invocation->invocation_id = yts_proxy_create_invocation_id (self);
+  invocation->result = result;
+
+  if (timeout_ms < 0) {
+    timeout_ms = INVOKE_TIMEOUT_MS_DEFAULT;
+  }
+  if (timeout_ms != G_MAXINT) {
+    invocation->timeout_id = g_timeout_add (timeout_ms,
+                                            (GSourceFunc) _invocation_timeout,
+                                            invocation);
+  }
+
+  if (cancellable) {
+    invocation->cancellable = g_object_ref (cancellable);
+    invocation->cancelled_id = g_cancellable_connect (
+                                          cancellable,
+                                          G_CALLBACK (_invocation_cancelled),
+                                          invocation,
+                                          NULL);
+  }
+
+  g_hash_table_insert (priv->invocations,
+                       invocation->invocation_id,
+                       invocation);
+
+  yts_proxy_invoke (self, invocation->invocation_id, aspect, arguments);
+}
+
+/**
+ * yts_proxy_invoke_finish:
+ * @self: object on which to invoke this method.
+ * @result: #GAsyncResult passed to the callback.
+ * @error: return location for a #GError, or %NULL.
+ *
+ * Finish an invocation started with yts_proxy_invoke_async().
+ *
+ * Returns: (transfer full): the response, or %NULL if the method did not
+ *          return anything or the invocation failed, in which case @error
+ *          is set.
+ *
+ * Since: 0.4
+ */
+GVariant *
+yts_proxy_invoke_finish (YtsProxy      *self,
+                         GAsyncResult  *result,
+                         GError       **error)
+{
+  GSimpleAsyncResult  *simple = G_SIMPLE_ASYNC_RESULT (result);
+  GVariant            *response;
+
+  g_return_val_if_fail (g_simple_async_result_is_valid (
+                                              result,
+                                              G_OBJECT (self),
+                                              yts_proxy_invoke_async),
+                        NULL);
+
+  if (g_simple_async_result_propagate_error (simple, error)) {
+    return NULL;
+  }
+
+  response = g_simple_async_result_get_op_res_gpointer (simple);
+
+  return response ? g_variant_ref (response) : NULL;
+}
+
 void
 yts_proxy_handle_service_event (YtsProxy  *self,
                                  char const *aspect,
@@ -306,11 +576,21 @@ yts_proxy_handle_service_response (YtsProxy   *self,
                                     char const  *invocation_id,
                                     GVariant    *response)
 {
+  YtsProxyPrivate *priv = GET_PRIVATE (self);
+  Invocation *invocation;
+
   g_return_if_fail (YTS_IS_PROXY (self));
 
-  g_signal_emit (self, _signals[SERVICE_RESPONSE_SIGNAL], 0,
-                 invocation_id,
-                 response);
+  invocation = invocation_id ?
+                  g_hash_table_lookup (priv->invocations, invocation_id) :
+                  NULL;
+  if (invocation) {
+    invocation_complete (invocation, response, NULL);
+  } else {
+    g_signal_emit (self, _signals[SERVICE_RESPONSE_SIGNAL], 0,
+                   invocation_id,
+                   response);
+  }
 
   /* This is a bit hackish, ok, but it allows for creating the variant
    * in the invocation of this function. */
@@ -22,6 +22,7 @@
 #define YTS_PROXY_H
 
 #include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -78,6 +79,20 @@ yts_proxy_invoke (YtsProxy  *self,
                    char const *aspect,
                    GVariant   *arguments);
 
+void
+yts_proxy_invoke_async (YtsProxy            *self,
+                        char const          *aspect,
+                        GVariant            *arguments,
+                        int                  timeout_ms,
+                        GCancellable        *cancellable,
+                        GAsyncReadyCallback  callback,
+                        void                *data);
+
+GVariant *
+yts_proxy_invoke_finish (YtsProxy      *self,
+                         GAsyncResult  *result,
+                         GError       **error);
+
 G_END_DECLS
 
 #endif /* YTS_PROXY_H */
@@ -22,6 +22,7 @@
 
 #include <stdbool.h>
 
+#include "yts-metadata-internal.h"
 #include "yts-response-message.h"
 
 G_DEFINE_TYPE (YtsResponseMessage, yts_response_message, YTS_TYPE_METADATA)
@@ -86,6 +87,7 @@ yts_response_message_new (char const *capability,
                            GVariant   *response)
 {
   RestXmlNode *node;
+  YtsMetadata *message;
 
   node = rest_xml_node_add_child (NULL, "message");
   /* PONDERING need those keywords be made reserved */
@@ -93,18 +95,13 @@ yts_response_message_new (char const *capability,
   rest_xml_node_add_attr (node, "capability", capability);
   rest_xml_node_add_attr (node, "invocation", invocation_id);
 
-  if (response) {
-    char *args = g_variant_print (response, false);
-    /* FIXME this is just a stopgap solution to lacking g_markup_unescape_text()
-     * want to move to complex message bodies anywy. */
-    char *escaped_args = g_uri_escape_string (args, NULL, true);
-    rest_xml_node_add_attr (node, "response", escaped_args);
-    g_free (escaped_args);
-    g_free (args);
-  }
+  message = g_object_new (YTS_TYPE_RESPONSE_MESSAGE,
+                          "top-level-node", node,
+                          NULL);
+
+  /* Serialised on demand only. */
+  yts_metadata_set_payload (message, "response", response);
 
-  return g_object_new (YTS_TYPE_RESPONSE_MESSAGE,
-                       "top-level-node", node,
-                       NULL);
+  return message;
 }
 
@@ -21,6 +21,7 @@
 #include "config.h"
 
 #include "yts-roster-impl.h"
+#include "yts-enum-types.h"
 #include "yts-marshal.h"
 
 G_DEFINE_TYPE (YtsRosterImpl, yts_roster_impl, YTS_TYPE_ROSTER)
@@ -31,6 +32,7 @@ G_DEFINE_TYPE (YtsRosterImpl, yts_roster_impl, YTS_TYPE_ROSTER)
 enum {
   SIG_SEND_MESSAGE,
   SIG_SEND_FILE,
+  SIG_SEND_STREAM,
 
   N_SIGNALS
 };
@@ -62,13 +64,30 @@ yts_roster_impl_class_init (YtsRosterImplClass *klass)
                                           G_TYPE_FROM_CLASS (object_class),
                                           G_SIGNAL_RUN_LAST,
                                           0, NULL, NULL,
-                                          yts_marshal_OBJECT__OBJECT_OBJECT_OBJECT_STRING_POINTER,
-                                          YTS_TYPE_OUTGOING_FILE, 5,
+                                          yts_marshal_OBJECT__OBJECT_OBJECT_OBJECT_STRING_ENUM_POINTER,
+                                          YTS_TYPE_OUTGOING_FILE, 6,
                                           YTS_TYPE_CONTACT,
                                           YTS_TYPE_SERVICE,
                                           G_TYPE_FILE,
                                           G_TYPE_STRING,
+                                          YTS_TYPE_TRANSFER_PRIORITY,
                                           G_TYPE_POINTER);
+
+  _signals[SIG_SEND_STREAM] = g_signal_new ("send-stream",
+                                            G_TYPE_FROM_CLASS (object_class),
+                                            G_SIGNAL_RUN_LAST,
+                                            0, NULL, NULL,
+                                            yts_marshal_OBJECT__OBJECT_OBJECT_OBJECT_UINT64_STRING_STRING_STRING_ENUM_POINTER,
+                                            YTS_TYPE_OUTGOING_FILE, 9,
+                                            YTS_TYPE_CONTACT,
+                                            YTS_TYPE_SERVICE,
+                                            G_TYPE_INPUT_STREAM,
+                                            G_TYPE_UINT64,
+                                            G_TYPE_STRING,
+                                            G_TYPE_STRING,
+                                            G_TYPE_STRING,
+                                            YTS_TYPE_TRANSFER_PRIORITY,
+                                            G_TYPE_POINTER);
 }
 
 static void
@@ -98,20 +117,43 @@ yts_roster_impl_send_message (YtsRosterImpl *self,
 }
 
 YtsOutgoingFile *
-yts_roster_impl_send_file (YtsRosterImpl   *self,
-                           YtsContact      *contact,
-                           YtsService      *service,
-                           GFile           *file,
-                           char const      *description,
-                           GError         **error_out)
+yts_roster_impl_send_file (YtsRosterImpl      *self,
+                           YtsContact         *contact,
+                           YtsService         *service,
+                           GFile              *file,
+                           char const         *description,
+                           YtsTransferPriority priority,
+                           GError            **error_out)
 {
   YtsOutgoingFile *transfer;
 
   transfer = NULL;
   g_signal_emit (self, _signals[SIG_SEND_FILE], 0,
-                 contact, service, file, description, error_out,
+                 contact, service, file, description, priority, error_out,
                  &transfer);
 
   return transfer;
 }
 
+YtsOutgoingFile *
+yts_roster_impl_send_stream (YtsRosterImpl      *self,
+                             YtsContact         *contact,
+                             YtsService         *service,
+                             GInputStream       *stream,
+                             uint64_t            size,
+                             char const         *name,
+                             char const         *content_type,
+                             char const         *description,
+                             YtsTransferPriority priority,
+                             GError            **error_out)
+{
+  YtsOutgoingFile *transfer;
+
+  transfer = NULL;
+  g_signal_emit (self, _signals[SIG_SEND_STREAM], 0,
+                 contact, service, stream, size, name, content_type,
+                 description, priority, error_out,
+                 &transfer);
+
+  return transfer;
+}
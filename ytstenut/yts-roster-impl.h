@@ -21,11 +21,13 @@
 #ifndef YTS_ROSTER_IMPL_H
 #define YTS_ROSTER_IMPL_H
 
+#include <stdint.h>
 #include <glib-object.h>
 #include <gio/gio.h>
 #include <ytstenut/yts-roster-internal.h>
 #include <ytstenut/yts-metadata.h>
 #include <ytstenut/yts-outgoing-file.h>
+#include <ytstenut/yts-transfer-scheduler.h>
 
 G_BEGIN_DECLS
 
@@ -67,12 +69,25 @@ yts_roster_impl_send_message (YtsRosterImpl *self,
                               YtsMetadata   *message);
 
 YtsOutgoingFile *
-yts_roster_impl_send_file (YtsRosterImpl   *self,
-                           YtsContact      *contact,
-                           YtsService      *service,
-                           GFile           *file,
-                           char const      *description,
-                           GError         **error_out);
+yts_roster_impl_send_file (YtsRosterImpl      *self,
+                           YtsContact         *contact,
+                           YtsService         *service,
+                           GFile              *file,
+                           char const         *description,
+                           YtsTransferPriority priority,
+                           GError            **error_out);
+
+YtsOutgoingFile *
+yts_roster_impl_send_stream (YtsRosterImpl      *self,
+                             YtsContact         *contact,
+                             YtsService         *service,
+                             GInputStream       *stream,
+                             uint64_t            size,
+                             char const         *name,
+                             char const         *content_type,
+                             char const         *description,
+                             YtsTransferPriority priority,
+                             GError            **error_out);
 
 G_END_DECLS
 
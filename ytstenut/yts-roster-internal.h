@@ -22,9 +22,9 @@
 #define YTS_ROSTER_INTERNAL_H
 
 #include <stdbool.h>
-#include <telepathy-glib/connection.h>
 #include <ytstenut/yts-contact.h>
 #include <ytstenut/yts-roster.h>
+#include <ytstenut/yts-transport.h>
 
 #define YTS_ROSTER_CLASS(klass) \
   (G_TYPE_CHECK_CLASS_CAST ((klass), YTS_TYPE_ROSTER, YtsRosterClass))
@@ -50,7 +50,7 @@ yts_roster_remove_contact (YtsRoster  *roster,
 
 void
 yts_roster_add_service (YtsRoster         *roster,
-                        TpConnection      *tp_connection,
+                        YtsTransport      *transport,
                         char const        *contact_id,
                         char const        *service_id,
                         char const        *type,
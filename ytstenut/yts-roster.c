@@ -22,7 +22,6 @@
 #include "config.h"
 
 #include <gio/gio.h>
-#include <telepathy-ytstenut-glib/telepathy-ytstenut-glib.h>
 
 #include "ytstenut-internal.h"
 #include "yts-contact-impl.h"
@@ -143,12 +142,13 @@ _contact_send_message (YtsContact   *contact,
 }
 
 static YtsOutgoingFile *
-_contact_send_file (YtsContact   *contact,
-                    YtsService   *service,
-                    GFile        *file,
-                    char const   *description,
-                    GError      **error_out,
-                    YtsRoster    *self)
+_contact_send_file (YtsContact         *contact,
+                    YtsService         *service,
+                    GFile              *file,
+                    char const         *description,
+                    YtsTransferPriority priority,
+                    GError            **error_out,
+                    YtsRoster          *self)
 {
   /* This is a bit of a hack, we require the non-abstract subclass to
    * implement this interface. */
@@ -157,9 +157,36 @@ _contact_send_file (YtsContact   *contact,
                                     service,
                                     file,
                                     description,
+                                    priority,
                                     error_out);
 }
 
+static YtsOutgoingFile *
+_contact_send_stream (YtsContact         *contact,
+                      YtsService         *service,
+                      GInputStream       *stream,
+                      uint64_t            size,
+                      char const         *name,
+                      char const         *content_type,
+                      char const         *description,
+                      YtsTransferPriority priority,
+                      GError            **error_out,
+                      YtsRoster          *self)
+{
+  /* This is a bit of a hack, we require the non-abstract subclass to
+   * implement this interface. */
+  return yts_roster_impl_send_stream (YTS_ROSTER_IMPL (self),
+                                      contact,
+                                      service,
+                                      stream,
+                                      size,
+                                      name,
+                                      content_type,
+                                      description,
+                                      priority,
+                                      error_out);
+}
+
 static void
 _get_property (GObject    *object,
                unsigned    property_id,
@@ -206,6 +233,9 @@ _dispose (GObject *object)
       g_signal_handlers_disconnect_by_func (contact,
                                             _contact_send_file,
                                             object);
+      g_signal_handlers_disconnect_by_func (contact,
+                                            _contact_send_stream,
+                                            object);
     }
 
     g_hash_table_destroy (priv->contacts);
@@ -370,6 +400,9 @@ yts_roster_remove_service_by_id (YtsRoster  *self,
     g_signal_handlers_disconnect_by_func (contact,
                                           _contact_send_file,
                                           self);
+    g_signal_handlers_disconnect_by_func (contact,
+                                          _contact_send_stream,
+                                          self);
     g_object_ref (contact);
     g_hash_table_remove (priv->contacts, contact_id);
     g_signal_emit (self, _signals[SIG_CONTACT_REMOVED], 0, contact);
@@ -430,6 +463,9 @@ yts_roster_clear (YtsRoster *self)
       g_signal_handlers_disconnect_by_func (contact,
                                             _contact_send_file,
                                             self);
+      g_signal_handlers_disconnect_by_func (contact,
+                                            _contact_send_stream,
+                                            self);
 
       g_object_ref (contact);
 
@@ -458,83 +494,105 @@ yts_roster_contact_service_added_cb (YtsContact *contact,
   g_signal_emit (roster, _signals[SIG_SERVICE_ADDED], 0, service);
 }
 
+typedef struct {
+  YtsRoster   *roster;
+  YtsService  *service;
+  char        *contact_id;
+} AddServiceData;
+
+static void
+add_service_data_free (AddServiceData *data)
+{
+  g_object_unref (data->roster);
+  g_object_unref (data->service);
+  g_free (data->contact_id);
+  g_slice_free (AddServiceData, data);
+}
+
 static void
-_connection_get_contacts (TpConnection        *connection,
-                            guint              n_contacts,
-                            TpContact *const  *contacts,
-                            const char *const *requested_ids,
-                            GHashTable        *failed_id_errors,
-                            const GError      *error,
-                            gpointer           self_,
-                            GObject           *service_)
+add_contact (YtsRoster  *self,
+             char const *contact_id,
+             YtsContact *contact,
+             YtsService *service)
 {
-  YtsRoster *self = YTS_ROSTER (self_);
   YtsRosterPrivate *priv = GET_PRIVATE (self);
-  YtsService *service = YTS_SERVICE (service_);
+  GHashTableIter iter;
+  gpointer k, v;
 
-  if (n_contacts == 0) {
+  YTS_NOTE (ROSTER, "Creating new contact for %s", contact_id);
 
-    GError const *error;
+  g_signal_connect (contact, "service-added",
+                    G_CALLBACK (yts_roster_contact_service_added_cb),
+                    self);
+  g_signal_connect (contact, "service-removed",
+                    G_CALLBACK (yts_roster_contact_service_removed_cb),
+                    self);
 
-    g_return_if_fail (requested_ids && requested_ids[0]);
-    g_return_if_fail (failed_id_errors);
+  g_hash_table_insert (priv->contacts, g_strdup (contact_id), contact);
 
-    error = g_hash_table_lookup (failed_id_errors, requested_ids[0]);
-    g_critical ("%s : %s", G_STRLOC, error->message);
+  YTS_NOTE (ROSTER, "Emitting contact-added for new contact %s", contact_id);
+  g_signal_emit (self, _signals[SIG_CONTACT_ADDED], 0, contact);
 
-  } else {
+  g_signal_connect (contact, "send-message",
+                    G_CALLBACK (_contact_send_message), self);
+  g_signal_connect (contact, "send-file",
+                    G_CALLBACK (_contact_send_file), self);
+  g_signal_connect (contact, "send-stream",
+                    G_CALLBACK (_contact_send_stream), self);
 
-    YtsContact *contact;
-    char const *contact_id = requested_ids[0];
-    TpContact *tp_contact = TP_CONTACT (contacts[0]);
-    GHashTableIter iter;
-    gpointer k, v;
-
-    g_message ("Creating new contact for %s", contact_id);
+  yts_contact_add_service (contact, service);
 
-    contact = yts_contact_impl_new (tp_contact);
+  /* Apply deferred status updates */
 
-    g_signal_connect (contact, "service-added",
-                      G_CALLBACK (yts_roster_contact_service_added_cb),
-                      self);
-    g_signal_connect (contact, "service-removed",
-                      G_CALLBACK (yts_roster_contact_service_removed_cb),
-                      self);
+  g_hash_table_iter_init (&iter, priv->deferred_statuses);
 
-    g_hash_table_insert (priv->contacts, g_strdup (contact_id), contact);
+  while (g_hash_table_iter_next (&iter, &k, &v))
+    {
+      StatusTuple *st = k;
+
+      if (g_str_equal (st->contact_id, contact_id))
+        {
+          yts_contact_update_service_status (contact, st->service_id,
+              st->fqc_id, v);
+          g_hash_table_iter_remove (&iter);
+        }
+    }
+}
 
-    g_message ("Emitting contact-added for new contact %s", contact_id);
-    g_signal_emit (self, _signals[SIG_CONTACT_ADDED], 0, contact);
+static void
+_transport_resolve_contact (YtsTransport    *transport,
+                            GAsyncResult    *result,
+                            AddServiceData  *data)
+{
+  YtsContact  *contact;
+  GError      *error = NULL;
 
-    g_signal_connect (contact, "send-message",
-                      G_CALLBACK (_contact_send_message), self);
-    g_signal_connect (contact, "send-file",
-                      G_CALLBACK (_contact_send_file), self);
+  contact = yts_transport_resolve_contact_finish (transport, result, &error);
+  if (NULL == contact) {
 
-    yts_contact_add_service (contact, service);
-    g_object_unref (service);
+    g_critical ("%s : %s", G_STRLOC, error->message);
+    g_clear_error (&error);
 
-    /* Apply deferred status updates */
+  } else if (yts_roster_find_contact_by_id (data->roster, data->contact_id)) {
 
-    g_hash_table_iter_init (&iter, priv->deferred_statuses);
+    /* Another service of this contact has been resolved first. */
+    yts_contact_add_service (yts_roster_find_contact_by_id (data->roster,
+                                                            data->contact_id),
+                             data->service);
+    g_object_unref (contact);
 
-    while (g_hash_table_iter_next (&iter, &k, &v))
-      {
-        StatusTuple *st = k;
+  } else {
 
-        if (g_str_equal (st->contact_id, contact_id))
-          {
-            yts_contact_update_service_status (contact, st->service_id,
-                st->fqc_id, v);
-            g_hash_table_iter_remove (&iter);
-          }
-      }
+    /* Roster takes the contact reference. */
+    add_contact (data->roster, data->contact_id, contact, data->service);
   }
+
+  add_service_data_free (data);
 }
 
 void
 yts_roster_add_service (YtsRoster         *self,
-                        TpConnection      *tp_connection,
+                        YtsTransport      *transport,
                         char const        *contact_id,
                         char const        *service_id,
                         char const        *type,
@@ -546,7 +604,8 @@ yts_roster_add_service (YtsRoster         *self,
   YtsService        *service;
   YtsServiceFactory *factory = yts_service_factory_get_default ();
 
-  DEBUG ("contact=%s, service=%s, type=%s", contact_id, service_id, type);
+  YTS_NOTE (ROSTER, "contact=%s, service=%s, type=%s",
+            contact_id, service_id, type);
 
   service = yts_service_factory_create_service (factory,
                                                 caps,
@@ -558,26 +617,27 @@ yts_roster_add_service (YtsRoster         *self,
   contact = yts_roster_find_contact_by_id (self, contact_id);
   if (contact) {
 
-    DEBUG ("we already have that contact");
+    YTS_NOTE (ROSTER, "we already have that contact");
     yts_contact_add_service (contact, service);
+    g_object_unref (service);
 
   } else {
 
-    TpContactFeature const features[] = { TP_CONTACT_FEATURE_PRESENCE,
-                                          TP_CONTACT_FEATURE_CONTACT_INFO,
-                                          TP_CONTACT_FEATURE_AVATAR_DATA,
-                                          TP_CONTACT_FEATURE_CAPABILITIES };
-
-    DEBUG ("adding that contact later, when we get a TpContact");
-    tp_connection_get_contacts_by_id (tp_connection,
-                                      1,
-                                      &contact_id,
-                                      G_N_ELEMENTS (features),
-                                      features,
-                                      _connection_get_contacts,
-                                      self,
-                                      NULL,
-                                      G_OBJECT (service));
+    AddServiceData *data;
+
+    YTS_NOTE (ROSTER, "adding that contact later, when it is resolved");
+
+    data = g_slice_new (AddServiceData);
+    data->roster = g_object_ref (self);
+    data->service = service;
+    data->contact_id = g_strdup (contact_id);
+
+    yts_transport_resolve_contact_async (
+                          transport,
+                          contact_id,
+                          NULL,
+                          (GAsyncReadyCallback) _transport_resolve_contact,
+                          data);
   }
 }
 
@@ -591,22 +651,24 @@ yts_roster_update_contact_status (YtsRoster   *self,
   YtsRosterPrivate *priv = GET_PRIVATE (self);
   YtsContact *contact;
 
-  DEBUG ("contact=%s service=%s fqc=%s", contact_id, service_id, fqc_id);
+  YTS_NOTE (ROSTER, "contact=%s service=%s fqc=%s",
+            contact_id, service_id, fqc_id);
   contact = g_hash_table_lookup (priv->contacts, contact_id);
 
   if (contact != NULL)
     {
-      DEBUG ("updating service status straight away");
+      YTS_NOTE (ROSTER, "updating service status straight away");
       yts_contact_update_service_status (contact, service_id, fqc_id,
           status_xml);
     }
   else
     {
       /* We've hit a race condition between the contact's status being
-       * discovered, and the TpContact being set up.
+       * discovered, and the contact being resolved.
        * Save the status and apply it when we get the contact.
        */
-      DEBUG ("no contact yet, will update status when we have one");
+      YTS_NOTE (ROSTER,
+                "no contact yet, will update status when we have one");
       g_hash_table_insert (priv->deferred_statuses,
           status_tuple_new (contact_id, service_id, fqc_id),
           g_strdup (status_xml));
@@ -22,6 +22,7 @@
 
 #include <stdbool.h>
 
+#include "yts-enum-types.h"
 #include "yts-marshal.h"
 #include "yts-service.h"
 #include "yts-service-emitter.h"
@@ -31,6 +32,7 @@ G_DEFINE_INTERFACE (YtsServiceEmitter, yts_service_emitter, YTS_TYPE_SERVICE)
 enum {
   SIG_SEND_MESSAGE,
   SIG_SEND_FILE,
+  SIG_SEND_STREAM,
 
   N_SIGNALS
 };
@@ -56,11 +58,26 @@ yts_service_emitter_default_init (YtsServiceEmitterInterface *interface)
                                             G_TYPE_FROM_INTERFACE (interface),
                                             G_SIGNAL_RUN_LAST,
                                             0, NULL, NULL,
-                                            yts_marshal_OBJECT__OBJECT_STRING_POINTER,
-                                            YTS_TYPE_OUTGOING_FILE, 3,
+                                            yts_marshal_OBJECT__OBJECT_STRING_ENUM_POINTER,
+                                            YTS_TYPE_OUTGOING_FILE, 4,
                                             G_TYPE_FILE,
                                             G_TYPE_STRING,
+                                            YTS_TYPE_TRANSFER_PRIORITY,
                                             G_TYPE_POINTER);
+
+    _signals[SIG_SEND_STREAM] = g_signal_new ("send-stream",
+                                              G_TYPE_FROM_INTERFACE (interface),
+                                              G_SIGNAL_RUN_LAST,
+                                              0, NULL, NULL,
+                                              yts_marshal_OBJECT__OBJECT_UINT64_STRING_STRING_STRING_ENUM_POINTER,
+                                              YTS_TYPE_OUTGOING_FILE, 7,
+                                              G_TYPE_INPUT_STREAM,
+                                              G_TYPE_UINT64,
+                                              G_TYPE_STRING,
+                                              G_TYPE_STRING,
+                                              G_TYPE_STRING,
+                                              YTS_TYPE_TRANSFER_PRIORITY,
+                                              G_TYPE_POINTER);
     _initialized = true;
   }
 }
@@ -76,15 +93,36 @@ YtsOutgoingFile *
 yts_service_emitter_send_file (YtsServiceEmitter   *self,
                                GFile               *file,
                                char const          *description,
+                               YtsTransferPriority  priority,
                                GError             **error_out)
 {
   YtsOutgoingFile *transfer;
 
   transfer = NULL;
   g_signal_emit (self, _signals[SIG_SEND_FILE], 0,
-                 file, description, error_out,
+                 file, description, priority, error_out,
                  &transfer);
 
   return transfer;
 }
 
+YtsOutgoingFile *
+yts_service_emitter_send_stream (YtsServiceEmitter   *self,
+                                 GInputStream        *stream,
+                                 uint64_t             size,
+                                 char const          *name,
+                                 char const          *content_type,
+                                 char const          *description,
+                                 YtsTransferPriority  priority,
+                                 GError             **error_out)
+{
+  YtsOutgoingFile *transfer;
+
+  transfer = NULL;
+  g_signal_emit (self, _signals[SIG_SEND_STREAM], 0,
+                 stream, size, name, content_type, description, priority,
+                 error_out,
+                 &transfer);
+
+  return transfer;
+}
@@ -21,10 +21,12 @@
 #ifndef YTS_SERVICE_EMITTER_H
 #define YTS_SERVICE_EMITTER_H
 
+#include <stdint.h>
 #include <glib-object.h>
 #include <gio/gio.h>
 #include <ytstenut/yts-metadata.h>
 #include <ytstenut/yts-outgoing-file.h>
+#include <ytstenut/yts-transfer-scheduler.h>
 
 G_BEGIN_DECLS
 
@@ -59,8 +61,19 @@ YtsOutgoingFile *
 yts_service_emitter_send_file (YtsServiceEmitter   *self,
                                GFile               *file,
                                char const          *description,
+                               YtsTransferPriority  priority,
                                GError             **error_out);
 
+YtsOutgoingFile *
+yts_service_emitter_send_stream (YtsServiceEmitter   *self,
+                                 GInputStream        *stream,
+                                 uint64_t             size,
+                                 char const          *name,
+                                 char const          *content_type,
+                                 char const          *description,
+                                 YtsTransferPriority  priority,
+                                 GError             **error_out);
+
 G_END_DECLS
 
 #endif /* YTS_SERVICE_EMITTER_H */
@@ -85,11 +85,10 @@ yts_service_factory_create_service (YtsServiceFactory *self,
 
   g_return_val_if_fail (fqc_ids, NULL);
 
+  /* Only check for the proxy types here, they are not resolved (and
+   * possibly loaded) before a proxy is actually created. */
   for (i = 0; fqc_ids[i]; i++) {
-    GType proxy_gtype = yts_factory_get_proxy_gtype_for_fqc_id (
-                            YTS_FACTORY (self),
-                            fqc_ids[i]);
-    if (proxy_gtype != G_TYPE_INVALID) {
+    if (yts_factory_has_proxy_for_fqc_id (YTS_FACTORY (self), fqc_ids[i])) {
       return yts_proxy_service_impl_new (service_id,
                                          type,
                                          fqc_ids,
@@ -25,6 +25,7 @@
 #include "yts-invocation-message.h"
 #include "yts-marshal.h"
 #include "yts-message.h"
+#include "yts-outgoing-bundle-internal.h"
 #include "yts-service-emitter.h"
 #include "yts-service-internal.h"
 
@@ -395,36 +396,6 @@ yts_service_update_status (YtsService *self,
   }
 }
 
-static YtsMetadata *
-create_message (char const  *type,
-                GVariant    *payload)
-{
-
-  RestXmlNode *node;
-  char        *payload_str;
-  char        *payload_str_escaped;;
-
-  node = rest_xml_node_add_child (NULL, "message");
-  /* PONDERING need those keywords be made reserved */
-  rest_xml_node_add_attr (node, "type", type);
-  rest_xml_node_add_attr (node, "capability", SERVICE_FQC_ID);
-
-  payload_str = g_variant_print (payload, false);
-  /* FIXME this is just a stopgap solution to lacking g_markup_unescape_text()
-   * want to move to complex message bodies anywy. */
-  payload_str_escaped = g_uri_escape_string (payload_str, NULL, true);
-  rest_xml_node_add_attr (node, "payload", payload_str_escaped);
-  g_free (payload_str_escaped);
-  g_free (payload_str);
-
-  if (g_variant_is_floating (payload))
-    g_variant_unref (payload);
-
-  return g_object_new (YTS_TYPE_MESSAGE,
-                       "top-level-node", node,
-                       NULL);
-}
-
 /**
  * yts_service_send_text:
  * @self: object on which to invoke this method.
@@ -442,7 +413,9 @@ yts_service_send_text (YtsService *self,
 
   g_return_if_fail (YTS_IS_SERVICE (self));
 
-  message = create_message ("text", g_variant_new_string (text));
+  message = yts_message_new_for_payload ("text",
+                                         SERVICE_FQC_ID,
+                                         g_variant_new_string (text));
   yts_service_emitter_send_message (YTS_SERVICE_EMITTER (self), message);
   g_object_unref (message);
 }
@@ -466,7 +439,9 @@ yts_service_send_list (YtsService         *self,
 
   g_return_if_fail (YTS_IS_SERVICE (self));
 
-  message = create_message ("list", g_variant_new_strv (texts, length));
+  message = yts_message_new_for_payload ("list",
+                                         SERVICE_FQC_ID,
+                                         g_variant_new_strv (texts, length));
   yts_service_emitter_send_message (YTS_SERVICE_EMITTER (self), message);
   g_object_unref (message);
 }
@@ -505,7 +480,9 @@ yts_service_send_dictionary (YtsService         *self,
     g_variant_builder_add (&builder, "{ss}", name, value);
   }
 
-  message = create_message ("dictionary", g_variant_builder_end (&builder));
+  message = yts_message_new_for_payload ("dictionary",
+                                         SERVICE_FQC_ID,
+                                         g_variant_builder_end (&builder));
   yts_service_emitter_send_message (YTS_SERVICE_EMITTER (self), message);
   g_object_unref (message);
 }
@@ -531,10 +508,204 @@ yts_service_send_file (YtsService  *self,
                        GFile       *file,
                        char const  *description,
                        GError     **error_out)
+{
+  return yts_service_send_file_with_priority (self,
+                                              file,
+                                              description,
+                                              YTS_TRANSFER_PRIORITY_INTERACTIVE,
+                                              error_out);
+}
+
+/**
+ * yts_service_send_file_with_priority:
+ * @self: object on which to invoke this method.
+ * @file: file to send.
+ * @description: an optional text that is meant to be presented receiving user.
+ * @priority: scheduling priority of the transfer.
+ * @error_out: error out pointer. If set the error code can be any of
+ *             YTS_OUTGOING_FILE_ERROR_.
+ *
+ * Like yts_service_send_file(), but the transfer is queued with @priority,
+ * e.g. #YTS_TRANSFER_PRIORITY_BACKGROUND for bulk transfers that should not
+ * hold up interactive ones.
+ *
+ * Returns: (transfer full): an #YtsOutgoingFile instance if the transfer
+ * could be initated, or %NULL on error, in which case @error will be set if
+ * non-null.
+ *
+ * Since: 0.4
+ */
+YtsOutgoingFile *
+yts_service_send_file_with_priority (YtsService           *self,
+                                     GFile                *file,
+                                     char const           *description,
+                                     YtsTransferPriority   priority,
+                                     GError              **error_out)
 {
   return yts_service_emitter_send_file (YTS_SERVICE_EMITTER (self),
                                         file,
                                         description,
+                                        priority,
                                         error_out);
 }
 
+/**
+ * yts_service_send_stream:
+ * @self: object on which to invoke this method.
+ * @stream: stream to read the content from.
+ * @size: number of bytes that will be read from @stream.
+ * @name: name to offer the content under, or %NULL.
+ * @content_type: MIME type of the content, or %NULL.
+ * @description: an optional text that is meant to be presented receiving user.
+ * @error_out: error out pointer. If set the error code can be any of
+ *             YTS_OUTGOING_FILE_ERROR_.
+ *
+ * Send the content of @stream to remote service @self, without having to
+ * store it in a file first. Such transfers can not be resumed.
+ *
+ * Returns: (transfer full): an #YtsOutgoingFile instance if the transfer
+ * could be initated, or %NULL on error, in which case @error will be set if
+ * non-null.
+ *
+ * Since: 0.4
+ */
+YtsOutgoingFile *
+yts_service_send_stream (YtsService    *self,
+                         GInputStream  *stream,
+                         uint64_t       size,
+                         char const    *name,
+                         char const    *content_type,
+                         char const    *description,
+                         GError       **error_out)
+{
+  return yts_service_send_stream_with_priority (self,
+                                                stream,
+                                                size,
+                                                name,
+                                                content_type,
+                                                description,
+                                                YTS_TRANSFER_PRIORITY_INTERACTIVE,
+                                                error_out);
+}
+
+/**
+ * yts_service_send_stream_with_priority:
+ * @self: object on which to invoke this method.
+ * @stream: stream to read the content from.
+ * @size: number of bytes that will be read from @stream.
+ * @name: name to offer the content under, or %NULL.
+ * @content_type: MIME type of the content, or %NULL.
+ * @description: an optional text that is meant to be presented receiving user.
+ * @priority: scheduling priority of the transfer.
+ * @error_out: error out pointer. If set the error code can be any of
+ *             YTS_OUTGOING_FILE_ERROR_.
+ *
+ * Like yts_service_send_stream(), but the transfer is queued with @priority.
+ *
+ * Returns: (transfer full): an #YtsOutgoingFile instance if the transfer
+ * could be initated, or %NULL on error, in which case @error will be set if
+ * non-null.
+ *
+ * Since: 0.4
+ */
+YtsOutgoingFile *
+yts_service_send_stream_with_priority (YtsService           *self,
+                                       GInputStream         *stream,
+                                       uint64_t              size,
+                                       char const           *name,
+                                       char const           *content_type,
+                                       char const           *description,
+                                       YtsTransferPriority   priority,
+                                       GError              **error_out)
+{
+  return yts_service_emitter_send_stream (YTS_SERVICE_EMITTER (self),
+                                          stream,
+                                          size,
+                                          name,
+                                          content_type,
+                                          description,
+                                          priority,
+                                          error_out);
+}
+
+/**
+ * yts_service_send_data:
+ * @self: object on which to invoke this method.
+ * @data: (array length=size): content to send.
+ * @size: size of @data in bytes.
+ * @name: name to offer the content under, or %NULL.
+ * @content_type: MIME type of the content, or %NULL.
+ * @description: an optional text that is meant to be presented receiving user.
+ * @error_out: error out pointer. If set the error code can be any of
+ *             YTS_OUTGOING_FILE_ERROR_.
+ *
+ * Send an in-memory buffer to remote service @self. @data is copied, so it
+ * may be freed once this function returns.
+ *
+ * Returns: (transfer full): an #YtsOutgoingFile instance if the transfer
+ * could be initated, or %NULL on error, in which case @error will be set if
+ * non-null.
+ *
+ * Since: 0.4
+ */
+YtsOutgoingFile *
+yts_service_send_data (YtsService    *self,
+                       void const    *data,
+                       size_t         size,
+                       char const    *name,
+                       char const    *content_type,
+                       char const    *description,
+                       GError       **error_out)
+{
+  GInputStream    *stream;
+  YtsOutgoingFile *transfer;
+
+  g_return_val_if_fail (data || 0 == size, NULL);
+
+  stream = g_memory_input_stream_new_from_data (g_memdup (data, size),
+                                                size,
+                                                g_free);
+  transfer = yts_service_send_stream (self,
+                                      stream,
+                                      size,
+                                      name,
+                                      content_type,
+                                      description,
+                                      error_out);
+  g_object_unref (stream);
+
+  return transfer;
+}
+
+/**
+ * yts_service_send_bundle:
+ * @self: object on which to invoke this method.
+ * @files: (array length=n_files): files to send.
+ * @n_files: number of files.
+ * @description: an optional text that is meant to be presented receiving user.
+ * @error_out: error out pointer. If set the error code can be any of
+ *             YTS_OUTGOING_FILE_ERROR_.
+ *
+ * Send @files to remote service @self through a single transfer. This
+ * avoids negotiating a channel per file, which pays off for many small
+ * files. Only the files' base names are transmitted.
+ *
+ * Returns: (transfer full): an #YtsOutgoingBundle instance if the transfer
+ * could be initated, or %NULL on error, in which case @error will be set if
+ * non-null.
+ *
+ * Since: 0.4
+ */
+YtsOutgoingBundle *
+yts_service_send_bundle (YtsService    *self,
+                         GFile *const  *files,
+                         unsigned       n_files,
+                         char const    *description,
+                         GError       **error_out)
+{
+  return yts_outgoing_bundle_new (self,
+                                  files,
+                                  n_files,
+                                  description,
+                                  error_out);
+}
@@ -22,9 +22,12 @@
 #ifndef YTS_SERVICE_H
 #define YTS_SERVICE_H
 
+#include <stdint.h>
 #include <glib-object.h>
 #include <gio/gio.h>
+#include <ytstenut/yts-outgoing-bundle.h>
 #include <ytstenut/yts-outgoing-file.h>
+#include <ytstenut/yts-transfer-scheduler.h>
 
 G_BEGIN_DECLS
 
@@ -75,6 +78,48 @@ yts_service_send_file (YtsService  *self,
                       char const   *description,
                       GError      **error_out);
 
+YtsOutgoingFile *
+yts_service_send_file_with_priority (YtsService           *self,
+                                     GFile                *file,
+                                     char const           *description,
+                                     YtsTransferPriority   priority,
+                                     GError              **error_out);
+
+YtsOutgoingFile *
+yts_service_send_stream (YtsService    *self,
+                         GInputStream  *stream,
+                         uint64_t       size,
+                         char const    *name,
+                         char const    *content_type,
+                         char const    *description,
+                         GError       **error_out);
+
+YtsOutgoingFile *
+yts_service_send_stream_with_priority (YtsService           *self,
+                                       GInputStream         *stream,
+                                       uint64_t              size,
+                                       char const           *name,
+                                       char const           *content_type,
+                                       char const           *description,
+                                       YtsTransferPriority   priority,
+                                       GError              **error_out);
+
+YtsOutgoingFile *
+yts_service_send_data (YtsService    *self,
+                       void const    *data,
+                       size_t         size,
+                       char const    *name,
+                       char const    *content_type,
+                       char const    *description,
+                       GError       **error_out);
+
+YtsOutgoingBundle *
+yts_service_send_bundle (YtsService    *self,
+                         GFile *const  *files,
+                         unsigned       n_files,
+                         char const    *description,
+                         GError       **error_out);
+
 G_END_DECLS
 
 #endif /* YTS_SERVICE_H */
@@ -0,0 +1,1441 @@
+/*
+ * Copyright © 2011 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <telepathy-glib/telepathy-glib.h>
+#include <telepathy-ytstenut-glib/telepathy-ytstenut-glib.h>
+
+#include "yts-contact-impl.h"
+#include "yts-metadata-internal.h"
+#include "yts-outgoing-file-internal.h"
+#include "yts-probes.h"
+#include "yts-telepathy-transport.h"
+#include "ytstenut-internal.h"
+
+static void
+_transport_interface_init (YtsTransportInterface *interface);
+
+G_DEFINE_TYPE_WITH_CODE (YtsTelepathyTransport,
+                         yts_telepathy_transport,
+                         G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (YTS_TYPE_TRANSPORT,
+                                                _transport_interface_init))
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN PACKAGE"\0client\0"G_STRLOC
+
+/*
+ * YtsTelepathyTransport carries messages over Ytstenut channels and
+ * discovers services through TpYtsStatus. Account and connection setup
+ * remain with #YtsClient, which creates the transport once the account is
+ * prepared, registers it when the connection is, and has it look up the
+ * status object when the connection is ready.
+ */
+
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), YTS_TYPE_TELEPATHY_TRANSPORT, YtsTelepathyTransportPrivate))
+
+typedef struct {
+  TpAccount   *tp_account;
+  TpYtsClient *tp_client;
+  TpYtsStatus *tp_status;
+  char        *service_id;
+  /* Messages waiting for their recipient's TpContact,
+   * YtsContact -> SendQueue */
+  GHashTable          *send_queues;
+  YtsSendQueueLimits   send_queue_limits;
+  unsigned             expiry_id;
+  /* Statistics */
+  uint64_t     bytes_sent;
+  unsigned     n_waiting;
+  unsigned     n_channels;
+} YtsTelepathyTransportPrivate;
+
+/*
+ * Incoming messages
+ */
+
+static void
+_tp_client_received_channels (TpYtsClient           *tp_client,
+                              YtsTelepathyTransport *self)
+{
+  TpYtsChannel  *ch;
+
+  while ((ch = tp_yts_client_accept_channel (tp_client)))
+    {
+      char const      *from;
+      GHashTable      *props;
+      GHashTableIter   iter;
+      gpointer         key, value;
+
+      from = tp_channel_get_initiator_identifier (TP_CHANNEL (ch));
+
+      g_object_get (ch, "channel-properties", &props, NULL);
+      g_assert (props);
+
+      g_hash_table_iter_init (&iter, props);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          GValue      *v = value;
+          char        *k = key;
+
+          if (!g_strcmp0 (k, "org.freedesktop.ytstenut.xpmn.Channel.RequestBody"))
+            {
+              /* The connection manager puts the sender's service into the
+               * message's "from-service" attribute. */
+              yts_transport_emit_message_received (YTS_TRANSPORT (self),
+                                                   from,
+                                                   NULL,
+                                                   g_value_get_string (v));
+            }
+        }
+    }
+}
+
+/*
+ * Discovery
+ */
+
+static void
+process_one_service (YtsTelepathyTransport  *self,
+                     char const             *contact_id,
+                     char const             *service_id,
+                     const GValueArray      *service_info)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+  char const        *type;
+  GHashTable        *names;
+  char             **caps;
+  GHashTable        *service_statuses;
+  GHashTable        *discovered_statuses;
+
+  if (service_info->n_values != 3)
+    {
+      g_warning ("Missformed service description (nvalues == %d)",
+                 service_info->n_values);
+      return;
+    }
+
+  YTS_NOTE (CLIENT, "Processing service %s:%s", contact_id, service_id);
+
+  type  = g_value_get_string (&service_info->values[0]);
+  names = g_value_get_boxed (&service_info->values[1]);
+  caps  = g_value_get_boxed (&service_info->values[2]);
+
+  service_statuses = g_hash_table_new_full (g_str_hash,
+                                            g_str_equal,
+                                            g_free,
+                                            g_free);
+
+  discovered_statuses = tp_yts_status_get_discovered_statuses (priv->tp_status);
+  if (discovered_statuses) {
+    GHashTable *contact_statuses = g_hash_table_lookup (discovered_statuses,
+                                                        contact_id);
+    if (contact_statuses) {
+      unsigned i;
+      for (i = 0; caps && caps[i]; i++) {
+        GHashTable *capability_statuses = g_hash_table_lookup (contact_statuses,
+                                                               caps[i]);
+        if (capability_statuses) {
+          char const *status_xml = g_hash_table_lookup (capability_statuses,
+                                                        service_id);
+          if (status_xml) {
+            g_hash_table_insert (service_statuses,
+                                 g_strdup (caps[i]),
+                                 g_strdup (status_xml));
+          }
+        }
+      }
+    }
+  }
+
+  yts_transport_emit_service_added (YTS_TRANSPORT (self),
+                                    contact_id,
+                                    service_id,
+                                    type,
+                                    (char const *const *) caps,
+                                    names,
+                                    service_statuses);
+
+  g_hash_table_unref (service_statuses);
+}
+
+static void
+process_status (YtsTelepathyTransport *self)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+  GHashTable        *services;
+
+  if ((services = tp_yts_status_get_discovered_services (priv->tp_status)))
+    {
+      char           *contact_id;
+      GHashTable     *service;
+      GHashTableIter  iter;
+
+      if (g_hash_table_size (services) <= 0)
+        YTS_NOTE (CLIENT, "No services discovered so far");
+
+      g_hash_table_iter_init (&iter, services);
+      while (g_hash_table_iter_next (&iter,
+                                     (void **) &contact_id,
+                                     (void **) &service))
+        {
+          char           *service_id;
+          GValueArray    *service_info;
+          GHashTableIter  iter2;
+
+          g_hash_table_iter_init (&iter2, service);
+          while (g_hash_table_iter_next (&iter2,
+                                         (void **) &service_id,
+                                         (void **) &service_info))
+            {
+              process_one_service (self,
+                                   contact_id,
+                                   service_id,
+                                   service_info);
+            }
+        }
+    }
+  else
+    YTS_NOTE (CLIENT, "No discovered services");
+}
+
+static void
+_tp_status_service_added (TpYtsStatus           *tp_status,
+                          char const            *contact_id,
+                          char const            *service_id,
+                          const GValueArray     *service_info,
+                          YtsTelepathyTransport *self)
+{
+  process_one_service (self, contact_id, service_id, service_info);
+}
+
+static void send_queues_fail_service (YtsTelepathyTransport *self,
+                                      char const *contact_id,
+                                      char const *service_id);
+
+static void
+_tp_status_service_removed (TpYtsStatus           *tp_status,
+                            char const            *contact_id,
+                            char const            *service_id,
+                            YtsTelepathyTransport *self)
+{
+  /* Nobody is going to pick these up any more. */
+  send_queues_fail_service (self, contact_id, service_id);
+
+  yts_transport_emit_service_removed (YTS_TRANSPORT (self),
+                                      contact_id,
+                                      service_id);
+}
+
+static void
+_tp_status_status_changed (TpYtsStatus            *tp_status,
+                           char const             *contact_id,
+                           char const             *fqc_id,
+                           char const             *service_id,
+                           char const             *status_xml,
+                           YtsTelepathyTransport  *self)
+{
+  yts_transport_emit_status_changed (YTS_TRANSPORT (self),
+                                     contact_id,
+                                     fqc_id,
+                                     service_id,
+                                     status_xml);
+}
+
+static void
+_tp_status_ensure (GObject                *source_object,
+                   GAsyncResult           *result,
+                   YtsTelepathyTransport  *self)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+  TpAccount   *account = TP_ACCOUNT (source_object);
+  GError      *error = NULL;
+  TpYtsStatus *tp_status;
+
+  if (!(tp_status = tp_yts_status_ensure_finish (account, result, &error)))
+    {
+      g_error ("Failed to obtain tp_status: %s", error->message);
+    }
+
+  YTS_NOTE (CLIENT, "Processing tp_status");
+
+  if (priv->tp_status)
+    g_object_unref (priv->tp_status);
+  priv->tp_status = tp_status;
+
+  tp_g_signal_connect_object (tp_status, "service-added",
+                              G_CALLBACK (_tp_status_service_added),
+                              self, 0);
+  tp_g_signal_connect_object (tp_status, "service-removed",
+                              G_CALLBACK (_tp_status_service_removed),
+                              self, 0);
+  tp_g_signal_connect_object (tp_status, "status-changed",
+                              G_CALLBACK (_tp_status_status_changed),
+                              self, 0);
+
+  process_status (self);
+
+  yts_transport_emit_ready (YTS_TRANSPORT (self));
+
+  /* Balance the reference taken by ensure_status(). */
+  g_object_unref (self);
+}
+
+static void
+_tp_status_advertise_status (GObject       *source_object,
+                             GAsyncResult  *result,
+                             gpointer       user_data)
+{
+  TpYtsStatus *status = TP_YTS_STATUS (source_object);
+  GError      *error = NULL;
+
+  if (!tp_yts_status_advertise_status_finish (status, result, &error)) {
+      g_critical ("Failed to advertise status: %s", error->message);
+  } else {
+    YTS_NOTE (CLIENT, "Advertising of status succeeded");
+  }
+
+  g_clear_error (&error);
+}
+
+/*
+ * Outgoing messages
+ */
+
+typedef struct {
+  YtsTelepathyTransport *transport;
+  YtsContact            *contact;
+  char                  *contact_id;  /* contact may be gone by reply */
+  GHashTable            *attrs;
+  char                  *xml;
+  char                  *service_id;
+  YtsError               error;
+  gboolean               status_done;
+  int                    ref_count;
+  int64_t                queued_time;
+  YtsMetadata           *message;   /* while queued, to hand it back */
+} ChannelData;
+
+static void
+channel_data_unref (ChannelData *d)
+{
+  d->ref_count--;
+
+  if (d->ref_count <= 0)
+    {
+      g_object_unref (d->transport);
+      if (d->message)
+        g_object_unref (d->message);
+      g_hash_table_unref (d->attrs);
+      g_free (d->xml);
+      g_free (d->contact_id);
+      g_free (d->service_id);
+      g_free (d);
+    }
+}
+
+static ChannelData *
+channel_data_ref (ChannelData *d)
+{
+  d->ref_count++;
+  return d;
+}
+
+static void
+_channel_replied (TpYtsChannel *proxy,
+                  GHashTable   *attributes,
+                  char const   *body,
+                  gpointer      data,
+                  GObject      *weak_object)
+{
+  ChannelData     *d = data;
+
+  if (YTS_DEBUG_ENABLED (YTS_DEBUG_CLIENT))
+    {
+      GHashTableIter   iter;
+      gpointer         key, value;
+
+      g_debug ("Got reply with attributes:");
+
+      g_hash_table_iter_init (&iter, attributes);
+
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          g_debug ("    %s = %s\n",
+                   (char const *) key, (char const  *) value);
+        }
+
+      g_debug ("    body: %s\n", body);
+    }
+
+  if (YTS_PROBE_ENABLED (channel__reply))
+    {
+      YTS_PROBE4 (channel__reply,
+                  d->contact_id, d->service_id, d->error, true);
+    }
+
+  if (!d->status_done)
+    {
+      guint32   a;
+      YtsError e;
+
+      a = yts_error_get_atom (d->error);
+      e = yts_error_make (a, YTS_ERROR_SUCCESS);
+
+      yts_transport_emit_error (YTS_TRANSPORT (d->transport), e);
+
+      d->status_done = TRUE;
+    }
+
+  channel_data_unref (d);
+}
+
+static void
+_channel_failed (TpYtsChannel *proxy,
+                 guint         error_type,
+                 char const   *stanza_error_name,
+                 char const   *ytstenut_error_name,
+                 char const   *text,
+                 gpointer      data,
+                 GObject      *weak_object)
+{
+  guint32       a;
+  YtsError      e;
+  ChannelData  *d = data;
+
+  a = yts_error_get_atom (d->error);
+
+  g_warning ("Sending of message failed: type %u, %s, %s, %s",
+             error_type, stanza_error_name, ytstenut_error_name, text);
+
+  if (YTS_PROBE_ENABLED (channel__reply))
+    {
+      YTS_PROBE4 (channel__reply,
+                  d->contact_id, d->service_id, d->error, false);
+    }
+
+  e = yts_error_make (a, YTS_ERROR_NO_MSG_CHANNEL);
+
+  yts_transport_emit_error (YTS_TRANSPORT (d->transport), e);
+
+  d->status_done = TRUE;
+
+  channel_data_unref (d);
+}
+
+static void
+_channel_closed (TpChannel *channel,
+                 gpointer   data,
+                 GObject   *weak_object)
+{
+  ChannelData *d = data;
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (d->transport);
+
+  YTS_NOTE (CLIENT, "Channel closed");
+
+  priv->n_channels--;
+
+  if (!d->status_done)
+    {
+      guint32   a;
+      YtsError e;
+
+      a = yts_error_get_atom (d->error);
+      e = yts_error_make (a, YTS_ERROR_SUCCESS);
+
+      yts_transport_emit_error (YTS_TRANSPORT (d->transport), e);
+
+      d->status_done = TRUE;
+    }
+
+  channel_data_unref (d);
+}
+
+static void
+_channel_request (GObject      *source_object,
+                  GAsyncResult *result,
+                  gpointer      data)
+{
+  GError *error = NULL;
+
+  if (!tp_yts_channel_request_finish (
+          TP_YTS_CHANNEL (source_object), result, &error))
+    {
+      g_warning ("Failed to Request on channel: %s\n", error->message);
+    }
+  else
+    {
+      YTS_NOTE (CLIENT, "Channel requested");
+    }
+
+  g_clear_error (&error);
+}
+
+static void
+_outgoing_channel (GObject      *obj,
+                   GAsyncResult *res,
+                   gpointer      data)
+{
+  TpYtsChannel  *ch;
+  TpYtsClient   *client = TP_YTS_CLIENT (obj);
+  GError        *error  = NULL;
+  ChannelData   *d      = data;
+
+  if (!(ch = tp_yts_client_request_channel_finish (client, res, &error)))
+    {
+      guint32   a;
+      YtsError e;
+
+      a = yts_error_get_atom (d->error);
+
+      g_warning ("Failed to open outgoing channel: %s", error->message);
+      g_clear_error (&error);
+
+      e = yts_error_make (a, YTS_ERROR_NO_MSG_CHANNEL);
+
+      yts_transport_emit_error (YTS_TRANSPORT (d->transport), e);
+    }
+  else
+    {
+      YtsTelepathyTransportPrivate *priv = GET_PRIVATE (d->transport);
+
+      YTS_NOTE (CLIENT, "Got message channel, sending request");
+
+      priv->n_channels++;
+
+      tp_yts_channel_connect_to_replied (ch, _channel_replied,
+                                         channel_data_ref (d),
+                                         NULL, NULL, NULL);
+      tp_yts_channel_connect_to_failed (ch, _channel_failed,
+                                        channel_data_ref (d),
+                                        NULL, NULL, NULL);
+      tp_cli_channel_connect_to_closed (TP_CHANNEL (ch),
+                                        _channel_closed,
+                                        channel_data_ref (d),
+                                        NULL, NULL, NULL);
+
+      tp_yts_channel_request_async (ch, NULL, _channel_request, NULL);
+    }
+
+  channel_data_unref (d);
+}
+
+static YtsError
+dispatch_message (ChannelData *d)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (d->transport);
+  TpContact *tp_contact;
+  size_t     size;
+
+  YTS_NOTE (CLIENT, "Dispatching delayed message to %s", d->service_id);
+
+  tp_contact = yts_contact_get_tp_contact (d->contact);
+  g_assert (tp_contact);
+
+  size = strlen (d->xml);
+  priv->bytes_sent += size;
+
+  if (YTS_PROBE_ENABLED (channel__request))
+    {
+      YTS_PROBE4 (channel__request,
+                  d->contact_id, d->service_id, d->error, size);
+    }
+
+  tp_yts_client_request_channel_async (priv->tp_client,
+                                       tp_contact,
+                                       d->service_id,
+                                       TP_YTS_REQUEST_TYPE_GET,
+                                       d->attrs,
+                                       d->xml,
+                                       NULL,
+                                       _outgoing_channel,
+                                       d);
+
+  return d->error;
+}
+
+/*
+ * Messages to a contact whose TpContact is not known yet wait here, in
+ * order, behind a single notify::tp-contact handler.
+ */
+
+typedef struct {
+  YtsTelepathyTransport *transport;  /* free pointer */
+  YtsContact            *contact;
+  GQueue                *messages;   /* of ChannelData */
+  gulong                 notify_id;
+  bool                   congested;
+} SendQueue;
+
+static void
+fail_message (ChannelData *d,
+              unsigned     code)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (d->transport);
+
+  priv->n_waiting--;
+  yts_transport_emit_error (YTS_TRANSPORT (d->transport),
+                            yts_error_make (yts_error_get_atom (d->error),
+                                            code));
+  channel_data_unref (d);
+}
+
+static void
+send_queue_update_congestion (SendQueue *queue)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (queue->transport);
+  unsigned length = g_queue_get_length (queue->messages);
+  bool     congested = queue->congested;
+
+  if (0 == priv->send_queue_limits.high_water) {
+    congested = false;
+  } else if (length >= priv->send_queue_limits.high_water) {
+    congested = true;
+  } else if (length <= priv->send_queue_limits.low_water) {
+    congested = false;
+  }
+
+  if (congested != queue->congested) {
+    queue->congested = congested;
+    yts_transport_emit_send_queue_congested (YTS_TRANSPORT (queue->transport),
+                                             yts_contact_get_id (queue->contact),
+                                             congested);
+  }
+}
+
+/* Fail messages that have been waiting for too long, oldest first. */
+static void
+send_queue_expire (SendQueue  *queue,
+                   int64_t     now)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (queue->transport);
+  int64_t      expiry;
+  ChannelData *d;
+
+  if (0 == priv->send_queue_limits.expiry_s) {
+    return;
+  }
+
+  expiry = (int64_t) priv->send_queue_limits.expiry_s * G_USEC_PER_SEC;
+  while ((d = g_queue_peek_head (queue->messages)) &&
+         now - d->queued_time > expiry) {
+    g_queue_pop_head (queue->messages);
+    fail_message (d, YTS_ERROR_EXPIRED);
+  }
+}
+
+static void
+send_queue_free (SendQueue *queue)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (queue->transport);
+  ChannelData *d;
+
+  g_signal_handler_disconnect (queue->contact, queue->notify_id);
+
+  /* Only left over on dispose, the transport is going away. */
+  while ((d = g_queue_pop_head (queue->messages))) {
+    priv->n_waiting--;
+    channel_data_unref (d);
+  }
+
+  g_queue_free (queue->messages);
+  g_object_unref (queue->contact);
+  g_slice_free (SendQueue, queue);
+}
+
+static void
+_send_queue_notify_tp_contact (YtsContact *contact,
+                               GParamSpec *pspec,
+                               SendQueue  *queue)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (queue->transport);
+  ChannelData *d;
+
+  if (NULL == yts_contact_get_tp_contact (contact)) {
+    return;
+  }
+
+  YTS_NOTE (CLIENT, "Contact ready, dispatching %u messages",
+            g_queue_get_length (queue->messages));
+
+  /* Detach first, sending may call back into the transport. */
+  g_hash_table_steal (priv->send_queues, contact);
+
+  send_queue_expire (queue, g_get_monotonic_time ());
+
+  while ((d = g_queue_pop_head (queue->messages))) {
+    priv->n_waiting--;
+    dispatch_message (d);
+  }
+
+  send_queue_update_congestion (queue);
+  send_queue_free (queue);
+}
+
+/*
+ * Expiry is checked when messages are queued, and once a second by this
+ * sweep while there are queues and an expiry is set, so messages to a
+ * contact nobody sends to any more fail in time too.
+ */
+static gboolean
+_send_queues_expire (YtsTelepathyTransport *self)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+  GList   *contacts;
+  GList   *iter;
+  int64_t  now = g_get_monotonic_time ();
+
+  /* Failing messages calls out, and senders may queue more meanwhile. */
+  contacts = g_hash_table_get_keys (priv->send_queues);
+  for (iter = contacts; iter; iter = iter->next) {
+    SendQueue *queue = g_hash_table_lookup (priv->send_queues, iter->data);
+    if (queue) {
+      send_queue_expire (queue, now);
+      send_queue_update_congestion (queue);
+    }
+    queue = g_hash_table_lookup (priv->send_queues, iter->data);
+    if (queue &&
+        g_queue_is_empty (queue->messages)) {
+      g_hash_table_remove (priv->send_queues, iter->data);
+    }
+  }
+  g_list_free (contacts);
+
+  if (0 == priv->send_queue_limits.expiry_s ||
+      0 == g_hash_table_size (priv->send_queues)) {
+    priv->expiry_id = 0;
+    return false;
+  }
+
+  return true;
+}
+
+static void
+send_queues_ensure_expiry (YtsTelepathyTransport *self)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+
+  if (0 == priv->expiry_id &&
+      priv->send_queue_limits.expiry_s &&
+      g_hash_table_size (priv->send_queues)) {
+    priv->expiry_id = g_timeout_add_seconds (1,
+                                  (GSourceFunc) _send_queues_expire,
+                                  self);
+  }
+}
+
+static void
+send_queues_fail_service (YtsTelepathyTransport *self,
+                          char const            *contact_id,
+                          char const            *service_id)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+  GHashTableIter   iter;
+  SendQueue       *queue = NULL;
+  SendQueue       *q;
+  GQueue           failed = G_QUEUE_INIT;
+  GList           *link;
+  ChannelData     *d;
+
+  g_hash_table_iter_init (&iter, priv->send_queues);
+  while (g_hash_table_iter_next (&iter, NULL, (void **) &q)) {
+    if (0 == g_strcmp0 (contact_id, yts_contact_get_id (q->contact))) {
+      queue = q;
+      break;
+    }
+  }
+
+  if (NULL == queue) {
+    return;
+  }
+
+  link = queue->messages->head;
+  while (link) {
+    GList *next = link->next;
+    d = link->data;
+    if (0 == g_strcmp0 (service_id, d->service_id)) {
+      g_queue_unlink (queue->messages, link);
+      g_queue_push_tail_link (&failed, link);
+    }
+    link = next;
+  }
+
+  send_queue_update_congestion (queue);
+  if (g_queue_is_empty (queue->messages)) {
+    g_hash_table_remove (priv->send_queues, queue->contact);
+  }
+
+  while ((d = g_queue_pop_head (&failed))) {
+    fail_message (d, YTS_ERROR_NO_ROUTE);
+  }
+}
+
+static SendQueue *
+send_queue_ensure (YtsTelepathyTransport  *self,
+                   YtsContact             *contact)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+  SendQueue *queue;
+
+  queue = g_hash_table_lookup (priv->send_queues, contact);
+  if (NULL == queue) {
+    queue = g_slice_new0 (SendQueue);
+    queue->transport = self;
+    queue->contact = g_object_ref (contact);
+    queue->messages = g_queue_new ();
+    queue->notify_id = g_signal_connect (contact, "notify::tp-contact",
+                                         G_CALLBACK (_send_queue_notify_tp_contact),
+                                         queue);
+    g_hash_table_insert (priv->send_queues, contact, queue);
+  }
+
+  return queue;
+}
+
+/*
+ * Returns %YTS_ERROR_PENDING when queued, otherwise the message was refused
+ * and @d released.
+ */
+static YtsError
+send_queue_push (YtsTelepathyTransport  *self,
+                 ChannelData            *d)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+  YtsSendQueueLimits const *limits = &priv->send_queue_limits;
+  SendQueue *queue;
+
+  queue = send_queue_ensure (self, d->contact);
+
+  d->queued_time = g_get_monotonic_time ();
+  send_queue_expire (queue, d->queued_time);
+
+  if (limits->high_water &&
+      g_queue_get_length (queue->messages) >= limits->high_water) {
+
+    if (YTS_SEND_QUEUE_POLICY_DROP_OLDEST == limits->policy) {
+
+      fail_message (g_queue_pop_head (queue->messages), YTS_ERROR_QUEUE_FULL);
+
+    } else {
+
+      YtsError e = yts_error_make (yts_error_get_atom (d->error),
+                                   YTS_ERROR_QUEUE_FULL);
+      channel_data_unref (d);
+      return e;
+    }
+  }
+
+  YTS_NOTE (CLIENT, "Contact not ready, postponing message dispatch");
+
+  g_queue_push_tail (queue->messages, d);
+  priv->n_waiting++;
+
+  send_queue_update_congestion (queue);
+  send_queues_ensure_expiry (self);
+
+  return d->error;
+}
+
+/*
+ * Contact resolution
+ */
+
+static void
+_connection_get_contacts (TpConnection        *connection,
+                          guint                n_contacts,
+                          TpContact *const    *contacts,
+                          const char *const   *requested_ids,
+                          GHashTable          *failed_id_errors,
+                          const GError        *error,
+                          gpointer             result_,
+                          GObject             *weak_object)
+{
+  GSimpleAsyncResult *result = G_SIMPLE_ASYNC_RESULT (result_);
+
+  if (error) {
+
+    g_simple_async_result_set_from_error (result, error);
+
+  } else if (n_contacts == 0) {
+
+    GError const *id_error = g_hash_table_lookup (failed_id_errors,
+                                                  requested_ids[0]);
+    g_simple_async_result_set_from_error (result, id_error);
+
+  } else {
+
+    YtsContact *contact = yts_contact_impl_new (TP_CONTACT (contacts[0]));
+    g_simple_async_result_set_op_res_gpointer (result,
+                                               contact,
+                                               g_object_unref);
+  }
+
+  g_simple_async_result_complete (result);
+  g_object_unref (result);
+}
+
+/*
+ * YtsTransport implementation
+ */
+
+static char const *
+_get_contact_id (YtsTransport *self)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+
+  return tp_account_get_normalized_name (priv->tp_account);
+}
+
+static void
+_add_capability (YtsTransport *self,
+                 char const   *fqc_id)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+
+  tp_yts_client_add_capability (priv->tp_client, fqc_id);
+}
+
+static void
+_add_interest (YtsTransport *self,
+               char const   *fqc_id)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+
+  tp_yts_client_add_interest (priv->tp_client, fqc_id);
+}
+
+static void
+_advertise_status (YtsTransport *self,
+                   char const   *fqc_id,
+                   char const   *status_xml)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+
+  /* #YtsClient advertises all statuses again when we become ready. */
+  if (NULL == priv->tp_status) {
+    return;
+  }
+
+  tp_yts_status_advertise_status_async (priv->tp_status,
+                                        fqc_id,
+                                        priv->service_id,
+                                        status_xml,
+                                        NULL,
+                                        _tp_status_advertise_status,
+                                        self);
+}
+
+/*
+ * The status interface takes one capability per call, so a batch issues
+ * them all back to back without waiting for replies in between, and
+ * completes as a whole.
+ */
+
+typedef struct {
+  unsigned  n_pending;
+  unsigned  n_failed;
+} AdvertiseBatch;
+
+static void
+_tp_status_advertise_batch (GObject         *source_object,
+                            GAsyncResult    *result,
+                            AdvertiseBatch  *batch)
+{
+  TpYtsStatus *status = TP_YTS_STATUS (source_object);
+  GError      *error = NULL;
+
+  if (!tp_yts_status_advertise_status_finish (status, result, &error)) {
+    g_critical ("Failed to advertise status: %s", error->message);
+    g_clear_error (&error);
+    batch->n_failed++;
+  }
+
+  if (--batch->n_pending) {
+    return;
+  }
+
+  YTS_NOTE (CLIENT, "Advertising of status batch done, %u failed",
+            batch->n_failed);
+  g_slice_free (AdvertiseBatch, batch);
+}
+
+static void
+_advertise_statuses (YtsTransport *self,
+                     GHashTable   *statuses)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+  AdvertiseBatch  *batch;
+  GHashTableIter   iter;
+  char const      *fqc_id;
+  char const      *status_xml;
+
+  /* #YtsClient advertises all statuses again when we become ready. */
+  if (NULL == priv->tp_status ||
+      0 == g_hash_table_size (statuses)) {
+    return;
+  }
+
+  batch = g_slice_new0 (AdvertiseBatch);
+  batch->n_pending = g_hash_table_size (statuses);
+
+  g_hash_table_iter_init (&iter, statuses);
+  while (g_hash_table_iter_next (&iter,
+                                 (void **) &fqc_id,
+                                 (void **) &status_xml)) {
+    tp_yts_status_advertise_status_async (priv->tp_status,
+                                          fqc_id,
+                                          priv->service_id,
+                                          status_xml,
+                                          NULL,
+                                          (GAsyncReadyCallback) _tp_status_advertise_batch,
+                                          batch);
+  }
+}
+
+static void
+_refresh (YtsTransport *self)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+
+  if (priv->tp_status) {
+    process_status (YTS_TELEPATHY_TRANSPORT (self));
+  }
+}
+
+static YtsError
+_send_message (YtsTransport *self,
+               YtsContact   *contact,
+               char const   *service_id,
+               YtsMetadata  *message)
+{
+  GHashTable  *attrs;
+  ChannelData *d;
+  YtsError     e;
+  char        *xml = NULL;
+
+  if (!(attrs = yts_metadata_extract (message, &xml)))
+    {
+      g_warning ("Failed to extract content from YtsMessage object");
+
+      e = yts_error_new (YTS_ERROR_INVALID_PARAMETER);
+      g_free (xml);
+      return e;
+    }
+
+  e = yts_error_new (YTS_ERROR_PENDING);
+
+  d              = g_new (ChannelData, 1);
+  d->error       = e;
+  d->transport   = g_object_ref (self);
+  d->contact     = contact;
+  d->contact_id  = g_strdup (yts_contact_get_id (contact));
+  d->status_done = FALSE;
+  d->ref_count   = 1;
+  d->attrs       = attrs;
+  d->xml         = xml;
+  d->service_id  = g_strdup (service_id);
+  d->message     = NULL;
+
+  /* Keep the order if messages are waiting already. */
+  if (yts_contact_get_tp_contact (contact) &&
+      NULL == g_hash_table_lookup (GET_PRIVATE (self)->send_queues, contact))
+    {
+      dispatch_message (d);
+    }
+  else
+    {
+      d->message = g_object_ref (message);
+      e = send_queue_push (YTS_TELEPATHY_TRANSPORT (self), d);
+    }
+
+  return e;
+}
+
+static void
+_resolve_contact_async (YtsTransport        *self,
+                        char const          *contact_id,
+                        GCancellable        *cancellable,
+                        GAsyncReadyCallback  callback,
+                        void                *user_data)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+  TpConnection        *tp_connection;
+  GSimpleAsyncResult  *result;
+  TpContactFeature const features[] = { TP_CONTACT_FEATURE_PRESENCE,
+                                        TP_CONTACT_FEATURE_CONTACT_INFO,
+                                        TP_CONTACT_FEATURE_AVATAR_DATA,
+                                        TP_CONTACT_FEATURE_CAPABILITIES };
+
+  result = g_simple_async_result_new (G_OBJECT (self),
+                                      callback,
+                                      user_data,
+                                      _resolve_contact_async);
+
+  tp_connection = tp_account_get_connection (priv->tp_account);
+  if (NULL == tp_connection) {
+    g_simple_async_result_set_error (result,
+                                     TP_ERROR, TP_ERROR_DISCONNECTED,
+                                     "Account %s is not connected",
+                                     tp_account_get_normalized_name (
+                                                            priv->tp_account));
+    g_simple_async_result_complete_in_idle (result);
+    g_object_unref (result);
+    return;
+  }
+
+  tp_connection_get_contacts_by_id (tp_connection,
+                                    1,
+                                    &contact_id,
+                                    G_N_ELEMENTS (features),
+                                    features,
+                                    _connection_get_contacts,
+                                    result,
+                                    NULL,
+                                    NULL);
+}
+
+static YtsContact *
+_resolve_contact_finish (YtsTransport  *self,
+                         GAsyncResult  *result,
+                         GError       **error)
+{
+  GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  g_return_val_if_fail (g_simple_async_result_is_valid (result,
+                                                        G_OBJECT (self),
+                                                        _resolve_contact_async),
+                        NULL);
+
+  if (g_simple_async_result_propagate_error (simple, error)) {
+    return NULL;
+  }
+
+  return g_object_ref (g_simple_async_result_get_op_res_gpointer (simple));
+}
+
+static YtsOutgoingFile *
+_send_file (YtsTransport  *self,
+            YtsContact    *contact,
+            char const    *service_id,
+            GFile         *file,
+            char const    *description,
+            GError       **error)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+  YtsOutgoingFile *outgoing;
+
+  outgoing = yts_outgoing_file_new (priv->tp_account,
+                                    file,
+                                    priv->service_id,
+                                    yts_contact_get_id (contact),
+                                    service_id,
+                                    description);
+
+  if (!g_initable_init (G_INITABLE (outgoing), NULL, error)) {
+    g_object_unref (outgoing);
+    return NULL;
+  }
+
+  return outgoing;
+}
+
+static YtsOutgoingFile *
+_send_stream (YtsTransport  *self,
+              YtsContact    *contact,
+              char const    *service_id,
+              GInputStream  *stream,
+              uint64_t       size,
+              char const    *name,
+              char const    *content_type,
+              char const    *description,
+              GError       **error)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+  YtsOutgoingFile *outgoing;
+
+  outgoing = yts_outgoing_file_new_for_stream (priv->tp_account,
+                                               stream,
+                                               size,
+                                               name,
+                                               content_type,
+                                               priv->service_id,
+                                               yts_contact_get_id (contact),
+                                               service_id,
+                                               description);
+
+  if (!g_initable_init (G_INITABLE (outgoing), NULL, error)) {
+    g_object_unref (outgoing);
+    return NULL;
+  }
+
+  return outgoing;
+}
+
+static void
+_get_statistics (YtsTransport           *self,
+                 YtsTransportStatistics *statistics)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+
+  statistics->bytes_sent = priv->bytes_sent;
+  statistics->messages_waiting = priv->n_waiting;
+  statistics->channels_open = priv->n_channels;
+}
+
+static void
+_set_send_queue_limits (YtsTransport              *self,
+                        YtsSendQueueLimits const  *limits)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+
+  /* Applies to existing queues as they change. */
+  priv->send_queue_limits = *limits;
+
+  if (0 == limits->expiry_s &&
+      priv->expiry_id) {
+    g_source_remove (priv->expiry_id);
+    priv->expiry_id = 0;
+  }
+  send_queues_ensure_expiry (YTS_TELEPATHY_TRANSPORT (self));
+}
+
+static void
+_transport_interface_init (YtsTransportInterface *interface)
+{
+  interface->get_contact_id = _get_contact_id;
+  interface->add_capability = _add_capability;
+  interface->add_interest = _add_interest;
+  interface->advertise_status = _advertise_status;
+  interface->refresh = _refresh;
+  interface->send_message = _send_message;
+  interface->resolve_contact_async = _resolve_contact_async;
+  interface->resolve_contact_finish = _resolve_contact_finish;
+  interface->send_file = _send_file;
+  interface->send_stream = _send_stream;
+  interface->get_statistics = _get_statistics;
+  interface->set_send_queue_limits = _set_send_queue_limits;
+  interface->advertise_statuses = _advertise_statuses;
+}
+
+/*
+ * YtsTelepathyTransport
+ */
+
+static void
+_dispose (GObject *object)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (object);
+
+  if (priv->expiry_id) {
+    g_source_remove (priv->expiry_id);
+    priv->expiry_id = 0;
+  }
+
+  if (priv->send_queues) {
+    g_hash_table_destroy (priv->send_queues);
+    priv->send_queues = NULL;
+  }
+
+  if (priv->tp_status) {
+    g_object_unref (priv->tp_status);
+    priv->tp_status = NULL;
+  }
+
+  if (priv->tp_client) {
+    g_object_unref (priv->tp_client);
+    priv->tp_client = NULL;
+  }
+
+  if (priv->tp_account) {
+    g_object_unref (priv->tp_account);
+    priv->tp_account = NULL;
+  }
+
+  G_OBJECT_CLASS (yts_telepathy_transport_parent_class)->dispose (object);
+}
+
+static void
+_finalize (GObject *object)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (object);
+
+  g_free (priv->service_id);
+
+  G_OBJECT_CLASS (yts_telepathy_transport_parent_class)->finalize (object);
+}
+
+static void
+yts_telepathy_transport_class_init (YtsTelepathyTransportClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  g_type_class_add_private (klass, sizeof (YtsTelepathyTransportPrivate));
+
+  object_class->dispose = _dispose;
+  object_class->finalize = _finalize;
+}
+
+static void
+yts_telepathy_transport_init (YtsTelepathyTransport *self)
+{
+  YtsTelepathyTransportPrivate *priv = GET_PRIVATE (self);
+
+  priv->send_queues = g_hash_table_new_full (g_direct_hash,
+                                             g_direct_equal,
+                                             NULL,
+                                             (GDestroyNotify) send_queue_free);
+
+  priv->send_queue_limits.high_water = YTS_SEND_QUEUE_DEFAULT_HIGH_WATER;
+  priv->send_queue_limits.low_water = YTS_SEND_QUEUE_DEFAULT_LOW_WATER;
+  priv->send_queue_limits.expiry_s = 0;
+  priv->send_queue_limits.policy = YTS_SEND_QUEUE_POLICY_REJECT_NEW;
+}
+
+YtsTelepathyTransport *
+yts_telepathy_transport_new (TpAccount  *tp_account,
+                             char const *service_id)
+{
+  YtsTelepathyTransport *self;
+  YtsTelepathyTransportPrivate *priv;
+
+  g_return_val_if_fail (TP_IS_ACCOUNT (tp_account), NULL);
+  g_return_val_if_fail (service_id, NULL);
+
+  self = g_object_new (YTS_TYPE_TELEPATHY_TRANSPORT, NULL);
+  priv = GET_PRIVATE (self);
+
+  priv->tp_account = g_object_ref (tp_account);
+  priv->service_id = g_strdup (service_id);
+  priv->tp_client = tp_yts_client_new (service_id, tp_account);
+
+  return self;
+}
+
+/*
+ * yts_telepathy_transport_register:
+ * @self: object on which to invoke this method.
+ * @error: return location for an error.
+ *
+ * Register with the connection manager to receive messages, once the
+ * connection is prepared.
+ */
+bool
+yts_telepathy_transport_register (YtsTelepathyTransport  *self,
+                                  GError                **error)
+{
+  YtsTelepathyTransportPrivate *priv;
+
+  g_return_val_if_fail (YTS_IS_TELEPATHY_TRANSPORT (self), false);
+
+  priv = GET_PRIVATE (self);
+
+  if (!tp_yts_client_register (priv->tp_client, error)) {
+    return false;
+  }
+
+  tp_g_signal_connect_object (priv->tp_client, "received-channels",
+                              G_CALLBACK (_tp_client_received_channels),
+                              self, 0);
+
+  return true;
+}
+
+/*
+ * yts_telepathy_transport_ensure_status:
+ * @self: object on which to invoke this method.
+ *
+ * Set up discovery once the connection is ready. #YtsTransport::ready is
+ * emitted when done.
+ */
+void
+yts_telepathy_transport_ensure_status (YtsTelepathyTransport *self)
+{
+  YtsTelepathyTransportPrivate *priv;
+
+  g_return_if_fail (YTS_IS_TELEPATHY_TRANSPORT (self));
+
+  priv = GET_PRIVATE (self);
+
+  tp_yts_status_ensure_async (priv->tp_account,
+                              NULL,
+                              (GAsyncReadyCallback) _tp_status_ensure,
+                              g_object_ref (self));
+}
+
+/*
+ * yts_telepathy_transport_take_send_queues:
+ * @self: object on which to invoke this method.
+ * @func: called for every message, in order per contact.
+ * @data: context to pass to @func.
+ *
+ * Hand out all messages still waiting for their recipient, and forget
+ * them. Used when the connection is lost, their contacts will not be
+ * resolved any more. @func takes over reporting completion under the
+ * @error that was returned when the message was sent.
+ */
+void
+yts_telepathy_transport_take_send_queues (YtsTelepathyTransport           *self,
+                                          YtsTelepathyTransportQueuedFunc  func,
+                                          void                            *data)
+{
+  YtsTelepathyTransportPrivate *priv;
+  GList *queues;
+  GList *iter;
+
+  g_return_if_fail (YTS_IS_TELEPATHY_TRANSPORT (self));
+  g_return_if_fail (func);
+
+  priv = GET_PRIVATE (self);
+
+  /* @func may send again, the queues are off the books already. */
+  queues = g_hash_table_get_values (priv->send_queues);
+  g_hash_table_steal_all (priv->send_queues);
+
+  for (iter = queues; iter; iter = iter->next) {
+    SendQueue   *queue = iter->data;
+    ChannelData *d;
+
+    while ((d = g_queue_pop_head (queue->messages))) {
+      priv->n_waiting--;
+      func (queue->contact, d->service_id, d->message, d->error, data);
+      channel_data_unref (d);
+    }
+
+    send_queue_update_congestion (queue);
+    send_queue_free (queue);
+  }
+
+  g_list_free (queues);
+}
+
+TpYtsStatus *const
+yts_telepathy_transport_get_tp_status (YtsTelepathyTransport *self)
+{
+  YtsTelepathyTransportPrivate *priv;
+
+  g_return_val_if_fail (YTS_IS_TELEPATHY_TRANSPORT (self), NULL);
+
+  priv = GET_PRIVATE (self);
+
+  return priv->tp_status;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright © 2011 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_TELEPATHY_TRANSPORT_H
+#define YTS_TELEPATHY_TRANSPORT_H
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include <telepathy-glib/account.h>
+#include <telepathy-ytstenut-glib/telepathy-ytstenut-glib.h>
+#include <ytstenut/yts-transport.h>
+
+G_BEGIN_DECLS
+
+#define YTS_TYPE_TELEPATHY_TRANSPORT (yts_telepathy_transport_get_type ())
+
+#define YTS_TELEPATHY_TRANSPORT(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), YTS_TYPE_TELEPATHY_TRANSPORT, YtsTelepathyTransport))
+
+#define YTS_TELEPATHY_TRANSPORT_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), YTS_TYPE_TELEPATHY_TRANSPORT, YtsTelepathyTransportClass))
+
+#define YTS_IS_TELEPATHY_TRANSPORT(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), YTS_TYPE_TELEPATHY_TRANSPORT))
+
+#define YTS_IS_TELEPATHY_TRANSPORT_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), YTS_TYPE_TELEPATHY_TRANSPORT))
+
+#define YTS_TELEPATHY_TRANSPORT_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), YTS_TYPE_TELEPATHY_TRANSPORT, YtsTelepathyTransportClass))
+
+typedef struct {
+  GObject parent;
+} YtsTelepathyTransport;
+
+typedef struct {
+  GObjectClass parent;
+} YtsTelepathyTransportClass;
+
+GType
+yts_telepathy_transport_get_type (void) G_GNUC_CONST;
+
+YtsTelepathyTransport *
+yts_telepathy_transport_new (TpAccount  *tp_account,
+                             char const *service_id);
+
+bool
+yts_telepathy_transport_register (YtsTelepathyTransport  *self,
+                                  GError                **error);
+
+void
+yts_telepathy_transport_ensure_status (YtsTelepathyTransport *self);
+
+typedef void
+(*YtsTelepathyTransportQueuedFunc) (YtsContact  *contact,
+                                    char const  *service_id,
+                                    YtsMetadata *message,
+                                    YtsError     error,
+                                    void        *data);
+
+void
+yts_telepathy_transport_take_send_queues (YtsTelepathyTransport           *self,
+                                          YtsTelepathyTransportQueuedFunc  func,
+                                          void                            *data);
+
+TpYtsStatus *const
+yts_telepathy_transport_get_tp_status (YtsTelepathyTransport *self);
+
+G_END_DECLS
+
+#endif /* YTS_TELEPATHY_TRANSPORT_H */
@@ -0,0 +1,66 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_TRANSFER_SCHEDULER_INTERNAL_H
+#define YTS_TRANSFER_SCHEDULER_INTERNAL_H
+
+#include <stdint.h>
+#include <ytstenut/yts-transfer-scheduler.h>
+
+G_BEGIN_DECLS
+
+#define YTS_TRANSFER_SCHEDULER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), YTS_TYPE_TRANSFER_SCHEDULER, YtsTransferSchedulerClass))
+
+#define YTS_IS_TRANSFER_SCHEDULER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), YTS_TYPE_TRANSFER_SCHEDULER))
+
+#define YTS_TRANSFER_SCHEDULER_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), YTS_TYPE_TRANSFER_SCHEDULER, YtsTransferSchedulerClass))
+
+struct YtsTransferScheduler {
+  GObject parent;
+};
+
+typedef struct {
+  GObjectClass parent;
+
+  /* Starts a transfer once it got a slot, overridden by the tests. */
+  void (*start) (YtsTransferScheduler *self,
+                 YtsOutgoingFile      *transfer);
+} YtsTransferSchedulerClass;
+
+YtsTransferScheduler *
+yts_transfer_scheduler_new (void);
+
+void
+yts_transfer_scheduler_enqueue (YtsTransferScheduler *self,
+                                YtsOutgoingFile      *transfer,
+                                YtsTransferPriority   priority);
+
+void
+yts_transfer_scheduler_get_statistics (YtsTransferScheduler *self,
+                                       unsigned             *n_running,
+                                       unsigned             *n_queued,
+                                       uint64_t             *bytes_per_second);
+
+G_END_DECLS
+
+#endif /* YTS_TRANSFER_SCHEDULER_INTERNAL_H */
@@ -0,0 +1,596 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "yts-file-transfer.h"
+#include "yts-outgoing-file-internal.h"
+#include "yts-transfer-scheduler-internal.h"
+#include "ytstenut-internal.h"
+
+G_DEFINE_TYPE (YtsTransferScheduler, yts_transfer_scheduler, G_TYPE_OBJECT)
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN PACKAGE"\0file-transfer\0"G_STRLOC
+
+/**
+ * SECTION: yts-transfer-scheduler
+ * @short_description: Queues outgoing file transfers.
+ *
+ * #YtsTransferScheduler makes sure that only a limited number of outgoing
+ * file transfers are running at any time, both overall and per recipient
+ * contact. Transfers created by yts_service_send_file() are queued, and
+ * started in order of their #YtsTransferPriority, which can be passed to
+ * yts_service_send_file_with_priority().
+ *
+ * All transfers queued since the scheduler was last idle form a batch, the
+ * combined progress of which is available through the
+ * #YtsTransferScheduler:progress property.
+ */
+
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), YTS_TYPE_TRANSFER_SCHEDULER, YtsTransferSchedulerPrivate))
+
+#define MAX_TRANSFERS_DEFAULT 4
+#define MAX_TRANSFERS_PER_CONTACT_DEFAULT 2
+
+enum {
+  PROP_0,
+  PROP_MAX_TRANSFERS,
+  PROP_MAX_TRANSFERS_PER_CONTACT,
+  PROP_PROGRESS
+};
+
+typedef struct {
+  YtsOutgoingFile     *transfer;
+  char                *contact_id;
+  YtsTransferPriority  priority;
+  uint64_t             size;
+  bool                 running;
+  bool                 done;
+} Entry;
+
+typedef struct {
+  /* Properties */
+  unsigned     max_transfers;
+  unsigned     max_transfers_per_contact;
+  /* Data */
+  GQueue       interactive;
+  GQueue       background;
+  GHashTable  *running_per_contact;
+  unsigned     n_running;
+  GList       *batch;
+  GHashTable  *entries;
+  unsigned     dispatch_id;
+} YtsTransferSchedulerPrivate;
+
+static void
+_transfer_notify_progress (YtsOutgoingFile      *transfer,
+                           GParamSpec           *pspec,
+                           YtsTransferScheduler *self);
+
+static void
+entry_destroy (Entry                *entry,
+               YtsTransferScheduler *self)
+{
+  g_signal_handlers_disconnect_by_func (entry->transfer,
+                                        _transfer_notify_progress,
+                                        self);
+  g_object_unref (entry->transfer);
+  g_free (entry->contact_id);
+  g_free (entry);
+}
+
+static Entry *
+find_entry (YtsTransferScheduler  *self,
+            YtsOutgoingFile       *transfer)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (self);
+
+  return g_hash_table_lookup (priv->entries, transfer);
+}
+
+static GQueue *
+get_queue (YtsTransferScheduler *self,
+           YtsTransferPriority   priority)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (self);
+
+  return priority == YTS_TRANSFER_PRIORITY_INTERACTIVE ?
+            &priv->interactive :
+            &priv->background;
+}
+
+static void
+clear_batch (YtsTransferScheduler *self)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (self);
+
+  g_hash_table_remove_all (priv->entries);
+  g_list_foreach (priv->batch, (GFunc) entry_destroy, self);
+  g_list_free (priv->batch);
+  priv->batch = NULL;
+}
+
+/*
+ * Start the first transfer in @queue whose recipient has a slot left.
+ */
+static bool
+start_next (YtsTransferScheduler  *self,
+            GQueue                *queue)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (self);
+  GList *iter;
+
+  for (iter = queue->head; iter; iter = iter->next) {
+
+    Entry     *entry = iter->data;
+    unsigned   n_running;
+
+    n_running = GPOINTER_TO_UINT (g_hash_table_lookup (
+                                                priv->running_per_contact,
+                                                entry->contact_id));
+    if (n_running < priv->max_transfers_per_contact) {
+
+      g_queue_delete_link (queue, iter);
+      g_hash_table_insert (priv->running_per_contact,
+                           g_strdup (entry->contact_id),
+                           GUINT_TO_POINTER (n_running + 1));
+      priv->n_running++;
+      entry->running = true;
+
+      YTS_NOTE (FILE_TRANSFER, "Starting transfer to %s (%u running)",
+                entry->contact_id, priv->n_running);
+      YTS_TRANSFER_SCHEDULER_GET_CLASS (self)->start (self, entry->transfer);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static gboolean
+_dispatch (YtsTransferScheduler *self)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (self);
+
+  priv->dispatch_id = 0;
+
+  while (priv->n_running < priv->max_transfers &&
+         (start_next (self, &priv->interactive) ||
+          start_next (self, &priv->background))) {
+    ;
+  }
+
+  if (0 == priv->n_running &&
+      g_queue_is_empty (&priv->interactive) &&
+      g_queue_is_empty (&priv->background) &&
+      priv->batch) {
+
+    /* Batch complete. */
+    clear_batch (self);
+    g_object_notify (G_OBJECT (self), "progress");
+  }
+
+  return false;
+}
+
+static void
+schedule_dispatch (YtsTransferScheduler *self)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (self);
+
+  /* Dispatch from idle, so priorities can still be adjusted right after
+   * queueing. */
+  if (0 == priv->dispatch_id) {
+    priv->dispatch_id = g_idle_add ((GSourceFunc) _dispatch, self);
+  }
+}
+
+static void
+_transfer_notify_progress (YtsOutgoingFile      *transfer,
+                           GParamSpec           *pspec,
+                           YtsTransferScheduler *self)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (self);
+  Entry *entry;
+  float  progress;
+
+  entry = find_entry (self, transfer);
+  g_return_if_fail (entry);
+
+  progress = yts_file_transfer_get_progress (YTS_FILE_TRANSFER (transfer));
+  if (!entry->done &&
+      (progress < 0.0 || progress > 1.0)) {
+
+    /* Completed, failed or cancelled. */
+    entry->done = true;
+
+    if (entry->running) {
+      unsigned n_running = GPOINTER_TO_UINT (g_hash_table_lookup (
+                                                priv->running_per_contact,
+                                                entry->contact_id));
+      if (n_running > 1) {
+        g_hash_table_insert (priv->running_per_contact,
+                             g_strdup (entry->contact_id),
+                             GUINT_TO_POINTER (n_running - 1));
+      } else {
+        g_hash_table_remove (priv->running_per_contact, entry->contact_id);
+      }
+      priv->n_running--;
+      entry->running = false;
+    }
+
+    schedule_dispatch (self);
+  }
+
+  g_object_notify (G_OBJECT (self), "progress");
+}
+
+static void
+_start (YtsTransferScheduler *self,
+        YtsOutgoingFile      *transfer)
+{
+  yts_outgoing_file_start (transfer);
+}
+
+static void
+_get_property (GObject    *object,
+               unsigned    property_id,
+               GValue     *value,
+               GParamSpec *pspec)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (object);
+
+  switch (property_id) {
+    case PROP_MAX_TRANSFERS:
+      g_value_set_uint (value, priv->max_transfers);
+      break;
+    case PROP_MAX_TRANSFERS_PER_CONTACT:
+      g_value_set_uint (value, priv->max_transfers_per_contact);
+      break;
+    case PROP_PROGRESS:
+      g_value_set_float (value,
+                         yts_transfer_scheduler_get_progress (
+                                          YTS_TRANSFER_SCHEDULER (object)));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+_set_property (GObject      *object,
+               unsigned      property_id,
+               const GValue *value,
+               GParamSpec   *pspec)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (object);
+
+  switch (property_id) {
+    case PROP_MAX_TRANSFERS:
+      priv->max_transfers = g_value_get_uint (value);
+      schedule_dispatch (YTS_TRANSFER_SCHEDULER (object));
+      break;
+    case PROP_MAX_TRANSFERS_PER_CONTACT:
+      priv->max_transfers_per_contact = g_value_get_uint (value);
+      schedule_dispatch (YTS_TRANSFER_SCHEDULER (object));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+_dispose (GObject *object)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (object);
+
+  if (priv->dispatch_id) {
+    g_source_remove (priv->dispatch_id);
+    priv->dispatch_id = 0;
+  }
+
+  /* Queued transfers are simply never started. */
+  g_queue_clear (&priv->interactive);
+  g_queue_clear (&priv->background);
+
+  if (priv->entries) {
+    clear_batch (YTS_TRANSFER_SCHEDULER (object));
+    g_hash_table_destroy (priv->entries);
+    priv->entries = NULL;
+  }
+
+  if (priv->running_per_contact) {
+    g_hash_table_destroy (priv->running_per_contact);
+    priv->running_per_contact = NULL;
+  }
+
+  G_OBJECT_CLASS (yts_transfer_scheduler_parent_class)->dispose (object);
+}
+
+static void
+yts_transfer_scheduler_class_init (YtsTransferSchedulerClass *klass)
+{
+  GObjectClass  *object_class = G_OBJECT_CLASS (klass);
+  GParamSpec    *pspec;
+
+  g_type_class_add_private (klass, sizeof (YtsTransferSchedulerPrivate));
+
+  object_class->get_property = _get_property;
+  object_class->set_property = _set_property;
+  object_class->dispose = _dispose;
+
+  klass->start = _start;
+
+  /**
+   * YtsTransferScheduler:max-transfers:
+   *
+   * Maximum number of outgoing transfers running at the same time.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint ("max-transfers", "", "",
+                             1, G_MAXUINT, MAX_TRANSFERS_DEFAULT,
+                             G_PARAM_READWRITE |
+                             G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_MAX_TRANSFERS, pspec);
+
+  /**
+   * YtsTransferScheduler:max-transfers-per-contact:
+   *
+   * Maximum number of outgoing transfers to the same contact running at the
+   * same time.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_uint ("max-transfers-per-contact", "", "",
+                             1, G_MAXUINT, MAX_TRANSFERS_PER_CONTACT_DEFAULT,
+                             G_PARAM_READWRITE |
+                             G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class,
+                                   PROP_MAX_TRANSFERS_PER_CONTACT,
+                                   pspec);
+
+  /**
+   * YtsTransferScheduler:progress:
+   *
+   * Combined progress of the current batch of transfers, weighted by file
+   * size. Ranges from 0.0 to 1.0, with 1.0 also meaning that the scheduler
+   * is idle.
+   *
+   * Since: 0.4
+   */
+  pspec = g_param_spec_float ("progress", "", "",
+                              0.0, 1.0, 1.0,
+                              G_PARAM_READABLE |
+                              G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_PROGRESS, pspec);
+}
+
+static void
+yts_transfer_scheduler_init (YtsTransferScheduler *self)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (self);
+
+  priv->max_transfers = MAX_TRANSFERS_DEFAULT;
+  priv->max_transfers_per_contact = MAX_TRANSFERS_PER_CONTACT_DEFAULT;
+
+  g_queue_init (&priv->interactive);
+  g_queue_init (&priv->background);
+
+  priv->running_per_contact = g_hash_table_new_full (g_str_hash,
+                                                     g_str_equal,
+                                                     g_free,
+                                                     NULL);
+
+  /* Entries are owned by the batch, looked up by transfer. */
+  priv->entries = g_hash_table_new (g_direct_hash, g_direct_equal);
+}
+
+YtsTransferScheduler *
+yts_transfer_scheduler_new (void)
+{
+  return g_object_new (YTS_TYPE_TRANSFER_SCHEDULER, NULL);
+}
+
+void
+yts_transfer_scheduler_enqueue (YtsTransferScheduler *self,
+                                YtsOutgoingFile      *transfer,
+                                YtsTransferPriority   priority)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (self);
+  Entry *entry;
+
+  g_return_if_fail (YTS_IS_TRANSFER_SCHEDULER (self));
+  g_return_if_fail (YTS_IS_OUTGOING_FILE (transfer));
+  g_return_if_fail (NULL == find_entry (self, transfer));
+
+  entry = g_new0 (Entry, 1);
+  entry->transfer = g_object_ref (transfer);
+  entry->priority = priority;
+  entry->size = yts_outgoing_file_get_size (transfer);
+  g_object_get (transfer, "recipient-contact-id", &entry->contact_id, NULL);
+
+  g_signal_connect (transfer, "notify::progress",
+                    G_CALLBACK (_transfer_notify_progress), self);
+
+  priv->batch = g_list_prepend (priv->batch, entry);
+  g_hash_table_insert (priv->entries, transfer, entry);
+  g_queue_push_tail (get_queue (self, priority), entry);
+
+  schedule_dispatch (self);
+  g_object_notify (G_OBJECT (self), "progress");
+}
+
+/**
+ * yts_transfer_scheduler_set_priority:
+ * @self: object on which to invoke this method.
+ * @transfer: queued outgoing file transfer.
+ * @priority: new priority of @transfer.
+ *
+ * Change the priority of a transfer that has not been started yet. Transfers
+ * moved to a different priority go to the end of that priority's queue.
+ *
+ * Returns: <literal>true</literal> if @transfer is queued and its priority
+ *          could be changed.
+ *
+ * Since: 0.4
+ */
+bool
+yts_transfer_scheduler_set_priority (YtsTransferScheduler *self,
+                                     YtsOutgoingFile      *transfer,
+                                     YtsTransferPriority   priority)
+{
+  Entry *entry;
+
+  g_return_val_if_fail (YTS_IS_TRANSFER_SCHEDULER (self), false);
+  g_return_val_if_fail (YTS_IS_OUTGOING_FILE (transfer), false);
+
+  entry = find_entry (self, transfer);
+  if (NULL == entry ||
+      entry->running ||
+      entry->done) {
+    return false;
+  }
+
+  if (entry->priority != priority) {
+    g_queue_remove (get_queue (self, entry->priority), entry);
+    g_queue_push_tail (get_queue (self, priority), entry);
+    entry->priority = priority;
+  }
+
+  return true;
+}
+
+/**
+ * yts_transfer_scheduler_cancel:
+ * @self: object on which to invoke this method.
+ * @transfer: queued outgoing file transfer.
+ *
+ * Remove a transfer that has not been started yet from the queue. The
+ * transfer emits #YtsFileTransfer::cancelled.
+ *
+ * Returns: <literal>true</literal> if @transfer was queued and has been
+ *          cancelled.
+ *
+ * Since: 0.4
+ */
+bool
+yts_transfer_scheduler_cancel (YtsTransferScheduler *self,
+                               YtsOutgoingFile      *transfer)
+{
+  Entry *entry;
+
+  g_return_val_if_fail (YTS_IS_TRANSFER_SCHEDULER (self), false);
+  g_return_val_if_fail (YTS_IS_OUTGOING_FILE (transfer), false);
+
+  entry = find_entry (self, transfer);
+  if (NULL == entry ||
+      entry->running ||
+      entry->done) {
+    return false;
+  }
+
+  g_queue_remove (get_queue (self, entry->priority), entry);
+
+  /* Marks the entry done through the progress notification. */
+  yts_outgoing_file_cancel (transfer);
+
+  return true;
+}
+
+/**
+ * yts_transfer_scheduler_get_progress:
+ * @self: object on which to invoke this method.
+ *
+ * See #YtsTransferScheduler:progress for details.
+ *
+ * Returns: combined progress of the current batch of transfers.
+ *
+ * Since: 0.4
+ */
+float
+yts_transfer_scheduler_get_progress (YtsTransferScheduler *self)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (self);
+  GList     *iter;
+  uint64_t   size = 0;
+  uint64_t   transferred = 0;
+
+  g_return_val_if_fail (YTS_IS_TRANSFER_SCHEDULER (self), 0.0);
+
+  if (NULL == priv->batch) {
+    return 1.0;
+  }
+
+  for (iter = priv->batch; iter; iter = iter->next) {
+    Entry *entry = iter->data;
+    size += entry->size;
+    if (entry->done) {
+      transferred += entry->size;
+    } else if (entry->running) {
+      transferred += MIN (entry->size,
+                          yts_file_transfer_get_transferred_bytes (
+                                          YTS_FILE_TRANSFER (entry->transfer)));
+    }
+  }
+
+  if (0 == size) {
+    return 0.0;
+  }
+
+  return (float) transferred / size;
+}
+
+/*
+ * yts_transfer_scheduler_get_statistics:
+ * @self: object on which to invoke this method.
+ * @n_running: number of transfers running.
+ * @n_queued: number of transfers waiting for a slot.
+ * @bytes_per_second: combined throughput of the running transfers.
+ */
+void
+yts_transfer_scheduler_get_statistics (YtsTransferScheduler *self,
+                                       unsigned             *n_running,
+                                       unsigned             *n_queued,
+                                       uint64_t             *bytes_per_second)
+{
+  YtsTransferSchedulerPrivate *priv = GET_PRIVATE (self);
+  GList *iter;
+
+  g_return_if_fail (YTS_IS_TRANSFER_SCHEDULER (self));
+
+  *n_running = priv->n_running;
+  *n_queued = g_queue_get_length (&priv->interactive) +
+              g_queue_get_length (&priv->background);
+
+  *bytes_per_second = 0;
+  for (iter = priv->batch; iter; iter = iter->next) {
+    Entry *entry = iter->data;
+    if (entry->running) {
+      *bytes_per_second += yts_file_transfer_get_bytes_per_second (
+                                          YTS_FILE_TRANSFER (entry->transfer));
+    }
+  }
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright © 2012 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_TRANSFER_SCHEDULER_H
+#define YTS_TRANSFER_SCHEDULER_H
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include <ytstenut/yts-outgoing-file.h>
+
+G_BEGIN_DECLS
+
+#define YTS_TYPE_TRANSFER_SCHEDULER yts_transfer_scheduler_get_type()
+
+#define YTS_TRANSFER_SCHEDULER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), YTS_TYPE_TRANSFER_SCHEDULER, YtsTransferScheduler))
+
+#define YTS_IS_TRANSFER_SCHEDULER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), YTS_TYPE_TRANSFER_SCHEDULER))
+
+typedef struct YtsTransferScheduler YtsTransferScheduler;
+
+GType
+yts_transfer_scheduler_get_type (void) G_GNUC_CONST;
+
+/**
+ * YtsTransferPriority:
+ * @YTS_TRANSFER_PRIORITY_BACKGROUND: bulk transfer, started after all
+ *                                    interactive ones.
+ * @YTS_TRANSFER_PRIORITY_INTERACTIVE: transfer the user is waiting for.
+ *
+ * Scheduling priority of an outgoing file transfer.
+ *
+ * Since: 0.4
+ */
+typedef enum { /*< prefix=YTS_TRANSFER_PRIORITY >*/
+  YTS_TRANSFER_PRIORITY_BACKGROUND = 0,
+  YTS_TRANSFER_PRIORITY_INTERACTIVE
+} YtsTransferPriority;
+
+bool
+yts_transfer_scheduler_set_priority (YtsTransferScheduler *self,
+                                     YtsOutgoingFile      *transfer,
+                                     YtsTransferPriority   priority);
+
+bool
+yts_transfer_scheduler_cancel (YtsTransferScheduler *self,
+                               YtsOutgoingFile      *transfer);
+
+float
+yts_transfer_scheduler_get_progress (YtsTransferScheduler *self);
+
+G_END_DECLS
+
+#endif /* YTS_TRANSFER_SCHEDULER_H */
@@ -0,0 +1,523 @@
+/*
+ * Copyright © 2011 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "yts-marshal.h"
+#include "yts-probes.h"
+#include "yts-transport.h"
+
+G_DEFINE_INTERFACE (YtsTransport, yts_transport, G_TYPE_OBJECT)
+
+/*
+ * YtsTransport is what #YtsClient uses to reach other services: sending
+ * messages, advertising and discovering services and their status, resolving
+ * contacts and transferring files. The Telepathy implementation is what
+ * clients normally use; the loopback implementation connects clients within
+ * one process, for tests and benchmarks that must not depend on D-Bus and a
+ * connection manager.
+ */
+
+enum {
+  SIG_READY,
+  SIG_DISCONNECTED,
+  SIG_MESSAGE_RECEIVED,
+  SIG_SERVICE_ADDED,
+  SIG_SERVICE_REMOVED,
+  SIG_STATUS_CHANGED,
+  SIG_ERROR,
+  SIG_SEND_QUEUE_CONGESTED,
+
+  N_SIGNALS
+};
+
+static unsigned _signals[N_SIGNALS] = { 0, };
+
+static void
+yts_transport_default_init (YtsTransportInterface *interface)
+{
+  GType type = G_TYPE_FROM_INTERFACE (interface);
+
+  /*
+   * YtsTransport::ready:
+   *
+   * Discovery is up and all currently known services have been announced.
+   */
+  _signals[SIG_READY] = g_signal_new ("ready",
+                                      type,
+                                      G_SIGNAL_RUN_LAST,
+                                      0, NULL, NULL,
+                                      yts_marshal_VOID__VOID,
+                                      G_TYPE_NONE, 0);
+
+  /*
+   * YtsTransport::disconnected:
+   *
+   * The transport went away, emitted by transports implementing
+   * yts_transport_disconnect() only.
+   */
+  _signals[SIG_DISCONNECTED] = g_signal_new ("disconnected",
+                                             type,
+                                             G_SIGNAL_RUN_LAST,
+                                             0, NULL, NULL,
+                                             yts_marshal_VOID__VOID,
+                                             G_TYPE_NONE, 0);
+
+  /*
+   * YtsTransport::message-received:
+   * @contact_id: sender contact.
+   * @service_id: sender service, or %NULL if the message carries it in its
+   *              "from-service" attribute.
+   * @xml: the message.
+   */
+  _signals[SIG_MESSAGE_RECEIVED] = g_signal_new ("message-received",
+                                           type,
+                                           G_SIGNAL_RUN_LAST,
+                                           0, NULL, NULL,
+                                           yts_marshal_VOID__STRING_STRING_STRING,
+                                           G_TYPE_NONE, 3,
+                                           G_TYPE_STRING,
+                                           G_TYPE_STRING,
+                                           G_TYPE_STRING);
+
+  /*
+   * YtsTransport::service-added:
+   * @contact_id: contact the service is running as.
+   * @service_id: the service.
+   * @type: service type.
+   * @caps: capabilities the service provides.
+   * @names: localised service names, language => name.
+   * @statuses: current status per capability, fqc-id => status xml.
+   */
+  _signals[SIG_SERVICE_ADDED] = g_signal_new ("service-added",
+                          type,
+                          G_SIGNAL_RUN_LAST,
+                          0, NULL, NULL,
+                          yts_marshal_VOID__STRING_STRING_STRING_BOXED_BOXED_BOXED,
+                          G_TYPE_NONE, 6,
+                          G_TYPE_STRING,
+                          G_TYPE_STRING,
+                          G_TYPE_STRING,
+                          G_TYPE_STRV,
+                          G_TYPE_HASH_TABLE,
+                          G_TYPE_HASH_TABLE);
+
+  /*
+   * YtsTransport::service-removed:
+   * @contact_id: contact the service was running as.
+   * @service_id: the service.
+   */
+  _signals[SIG_SERVICE_REMOVED] = g_signal_new ("service-removed",
+                                                type,
+                                                G_SIGNAL_RUN_LAST,
+                                                0, NULL, NULL,
+                                                yts_marshal_VOID__STRING_STRING,
+                                                G_TYPE_NONE, 2,
+                                                G_TYPE_STRING,
+                                                G_TYPE_STRING);
+
+  /*
+   * YtsTransport::status-changed:
+   * @contact_id: contact the service is running as.
+   * @fqc_id: capability the status is for.
+   * @service_id: the service.
+   * @status_xml: new status.
+   */
+  _signals[SIG_STATUS_CHANGED] = g_signal_new ("status-changed",
+                                   type,
+                                   G_SIGNAL_RUN_LAST,
+                                   0, NULL, NULL,
+                                   yts_marshal_VOID__STRING_STRING_STRING_STRING,
+                                   G_TYPE_NONE, 4,
+                                   G_TYPE_STRING,
+                                   G_TYPE_STRING,
+                                   G_TYPE_STRING,
+                                   G_TYPE_STRING);
+
+  /*
+   * YtsTransport::error:
+   * @error: #YtsError concluding a pending yts_transport_send_message().
+   */
+  _signals[SIG_ERROR] = g_signal_new ("error",
+                                      type,
+                                      G_SIGNAL_RUN_LAST,
+                                      0, NULL, NULL,
+                                      yts_marshal_VOID__UINT,
+                                      G_TYPE_NONE, 1,
+                                      G_TYPE_UINT);
+
+  /*
+   * YtsTransport::send-queue-congested:
+   * @contact_id: contact the messages are waiting for.
+   * @congested: whether the high water mark was reached, or the queue
+   *             drained below the low water mark again.
+   */
+  _signals[SIG_SEND_QUEUE_CONGESTED] = g_signal_new ("send-queue-congested",
+                                           type,
+                                           G_SIGNAL_RUN_LAST,
+                                           0, NULL, NULL,
+                                           yts_marshal_VOID__STRING_BOOLEAN,
+                                           G_TYPE_NONE, 2,
+                                           G_TYPE_STRING,
+                                           G_TYPE_BOOLEAN);
+}
+
+char const *
+yts_transport_get_contact_id (YtsTransport *self)
+{
+  g_return_val_if_fail (YTS_IS_TRANSPORT (self), NULL);
+
+  return YTS_TRANSPORT_GET_INTERFACE (self)->get_contact_id (self);
+}
+
+void
+yts_transport_connect (YtsTransport *self)
+{
+  YtsTransportInterface *iface;
+
+  g_return_if_fail (YTS_IS_TRANSPORT (self));
+
+  iface = YTS_TRANSPORT_GET_INTERFACE (self);
+  if (iface->connect) {
+    iface->connect (self);
+  }
+}
+
+void
+yts_transport_disconnect (YtsTransport *self)
+{
+  YtsTransportInterface *iface;
+
+  g_return_if_fail (YTS_IS_TRANSPORT (self));
+
+  iface = YTS_TRANSPORT_GET_INTERFACE (self);
+  if (iface->disconnect) {
+    iface->disconnect (self);
+  }
+}
+
+void
+yts_transport_add_capability (YtsTransport *self,
+                              char const   *fqc_id)
+{
+  g_return_if_fail (YTS_IS_TRANSPORT (self));
+  g_return_if_fail (fqc_id);
+
+  YTS_TRANSPORT_GET_INTERFACE (self)->add_capability (self, fqc_id);
+}
+
+void
+yts_transport_add_interest (YtsTransport *self,
+                            char const   *fqc_id)
+{
+  g_return_if_fail (YTS_IS_TRANSPORT (self));
+  g_return_if_fail (fqc_id);
+
+  YTS_TRANSPORT_GET_INTERFACE (self)->add_interest (self, fqc_id);
+}
+
+void
+yts_transport_advertise_status (YtsTransport *self,
+                                char const   *fqc_id,
+                                char const   *status_xml)
+{
+  g_return_if_fail (YTS_IS_TRANSPORT (self));
+  g_return_if_fail (fqc_id);
+
+  if (YTS_PROBE_ENABLED (status__advertise)) {
+    YTS_PROBE2 (status__advertise,
+                fqc_id, status_xml ? strlen (status_xml) : 0);
+  }
+
+  YTS_TRANSPORT_GET_INTERFACE (self)->advertise_status (self,
+                                                         fqc_id,
+                                                         status_xml);
+}
+
+/*
+ * yts_transport_advertise_statuses:
+ * @self: object on which to invoke this method.
+ * @statuses: status XML by fully qualified capability id.
+ *
+ * Advertise a set of statuses at once, typically all of them again after
+ * (re)connecting.
+ */
+void
+yts_transport_advertise_statuses (YtsTransport *self,
+                                  GHashTable   *statuses)
+{
+  YtsTransportInterface *iface;
+  GHashTableIter         iter;
+  char const            *fqc_id;
+  char const            *status_xml;
+
+  g_return_if_fail (YTS_IS_TRANSPORT (self));
+  g_return_if_fail (statuses);
+
+  iface = YTS_TRANSPORT_GET_INTERFACE (self);
+
+  g_hash_table_iter_init (&iter, statuses);
+  while (g_hash_table_iter_next (&iter,
+                                 (void **) &fqc_id,
+                                 (void **) &status_xml)) {
+    if (YTS_PROBE_ENABLED (status__advertise)) {
+      YTS_PROBE2 (status__advertise,
+                  fqc_id, status_xml ? strlen (status_xml) : 0);
+    }
+    if (NULL == iface->advertise_statuses) {
+      iface->advertise_status (self, fqc_id, status_xml);
+    }
+  }
+
+  if (iface->advertise_statuses) {
+    iface->advertise_statuses (self, statuses);
+  }
+}
+
+/*
+ * yts_transport_refresh:
+ * @self: object on which to invoke this method.
+ *
+ * Announce all known services again through #YtsTransport::service-added.
+ */
+void
+yts_transport_refresh (YtsTransport *self)
+{
+  g_return_if_fail (YTS_IS_TRANSPORT (self));
+
+  YTS_TRANSPORT_GET_INTERFACE (self)->refresh (self);
+}
+
+/*
+ * yts_transport_send_message:
+ * @self: object on which to invoke this method.
+ * @contact: recipient contact.
+ * @service_id: recipient service.
+ * @message: message to send.
+ *
+ * Returns: #YtsError; when %YTS_ERROR_PENDING the outcome is reported
+ *          through #YtsTransport::error later.
+ */
+YtsError
+yts_transport_send_message (YtsTransport *self,
+                            YtsContact   *contact,
+                            char const   *service_id,
+                            YtsMetadata  *message)
+{
+  g_return_val_if_fail (YTS_IS_TRANSPORT (self),
+                        yts_error_new (YTS_ERROR_INVALID_PARAMETER));
+  g_return_val_if_fail (YTS_IS_CONTACT (contact),
+                        yts_error_new (YTS_ERROR_INVALID_PARAMETER));
+  g_return_val_if_fail (YTS_IS_METADATA (message),
+                        yts_error_new (YTS_ERROR_INVALID_PARAMETER));
+
+  return YTS_TRANSPORT_GET_INTERFACE (self)->send_message (self,
+                                                            contact,
+                                                            service_id,
+                                                            message);
+}
+
+void
+yts_transport_resolve_contact_async (YtsTransport        *self,
+                                     char const          *contact_id,
+                                     GCancellable        *cancellable,
+                                     GAsyncReadyCallback  callback,
+                                     void                *user_data)
+{
+  g_return_if_fail (YTS_IS_TRANSPORT (self));
+  g_return_if_fail (contact_id);
+
+  YTS_TRANSPORT_GET_INTERFACE (self)->resolve_contact_async (self,
+                                                              contact_id,
+                                                              cancellable,
+                                                              callback,
+                                                              user_data);
+}
+
+/*
+ * yts_transport_resolve_contact_finish:
+ *
+ * Returns: (transfer full): new #YtsContact, or %NULL on error.
+ */
+YtsContact *
+yts_transport_resolve_contact_finish (YtsTransport  *self,
+                                      GAsyncResult  *result,
+                                      GError       **error)
+{
+  g_return_val_if_fail (YTS_IS_TRANSPORT (self), NULL);
+
+  return YTS_TRANSPORT_GET_INTERFACE (self)->resolve_contact_finish (self,
+                                                                     result,
+                                                                     error);
+}
+
+YtsOutgoingFile *
+yts_transport_send_file (YtsTransport  *self,
+                         YtsContact    *contact,
+                         char const    *service_id,
+                         GFile         *file,
+                         char const    *description,
+                         GError       **error)
+{
+  g_return_val_if_fail (YTS_IS_TRANSPORT (self), NULL);
+
+  return YTS_TRANSPORT_GET_INTERFACE (self)->send_file (self,
+                                                         contact,
+                                                         service_id,
+                                                         file,
+                                                         description,
+                                                         error);
+}
+
+YtsOutgoingFile *
+yts_transport_send_stream (YtsTransport  *self,
+                           YtsContact    *contact,
+                           char const    *service_id,
+                           GInputStream  *stream,
+                           uint64_t       size,
+                           char const    *name,
+                           char const    *content_type,
+                           char const    *description,
+                           GError       **error)
+{
+  g_return_val_if_fail (YTS_IS_TRANSPORT (self), NULL);
+
+  return YTS_TRANSPORT_GET_INTERFACE (self)->send_stream (self,
+                                                           contact,
+                                                           service_id,
+                                                           stream,
+                                                           size,
+                                                           name,
+                                                           content_type,
+                                                           description,
+                                                           error);
+}
+
+void
+yts_transport_get_statistics (YtsTransport            *self,
+                              YtsTransportStatistics  *statistics)
+{
+  YtsTransportInterface *iface;
+
+  g_return_if_fail (YTS_IS_TRANSPORT (self));
+  g_return_if_fail (statistics);
+
+  memset (statistics, 0, sizeof (*statistics));
+
+  iface = YTS_TRANSPORT_GET_INTERFACE (self);
+  if (iface->get_statistics) {
+    iface->get_statistics (self, statistics);
+  }
+}
+
+void
+yts_transport_set_send_queue_limits (YtsTransport              *self,
+                                     YtsSendQueueLimits const  *limits)
+{
+  YtsTransportInterface *iface;
+
+  g_return_if_fail (YTS_IS_TRANSPORT (self));
+  g_return_if_fail (limits);
+  g_return_if_fail (YTS_SEND_QUEUE_LIMITS_VALID (limits));
+
+  iface = YTS_TRANSPORT_GET_INTERFACE (self);
+  if (iface->set_send_queue_limits) {
+    iface->set_send_queue_limits (self, limits);
+  }
+}
+
+void
+yts_transport_emit_ready (YtsTransport *self)
+{
+  g_signal_emit (self, _signals[SIG_READY], 0);
+}
+
+void
+yts_transport_emit_disconnected (YtsTransport *self)
+{
+  g_signal_emit (self, _signals[SIG_DISCONNECTED], 0);
+}
+
+void
+yts_transport_emit_message_received (YtsTransport *self,
+                                     char const   *contact_id,
+                                     char const   *service_id,
+                                     char const   *xml)
+{
+  g_signal_emit (self, _signals[SIG_MESSAGE_RECEIVED], 0,
+                 contact_id, service_id, xml);
+}
+
+void
+yts_transport_emit_service_added (YtsTransport      *self,
+                                  char const        *contact_id,
+                                  char const        *service_id,
+                                  char const        *type,
+                                  char const *const *caps,
+                                  GHashTable        *names,
+                                  GHashTable        *statuses)
+{
+  g_signal_emit (self, _signals[SIG_SERVICE_ADDED], 0,
+                 contact_id, service_id, type, caps, names, statuses);
+}
+
+void
+yts_transport_emit_service_removed (YtsTransport *self,
+                                    char const   *contact_id,
+                                    char const   *service_id)
+{
+  g_signal_emit (self, _signals[SIG_SERVICE_REMOVED], 0,
+                 contact_id, service_id);
+}
+
+void
+yts_transport_emit_status_changed (YtsTransport *self,
+                                   char const   *contact_id,
+                                   char const   *fqc_id,
+                                   char const   *service_id,
+                                   char const   *status_xml)
+{
+  if (YTS_PROBE_ENABLED (status__receive)) {
+    YTS_PROBE4 (status__receive,
+                contact_id, service_id, fqc_id,
+                status_xml ? strlen (status_xml) : 0);
+  }
+
+  g_signal_emit (self, _signals[SIG_STATUS_CHANGED], 0,
+                 contact_id, fqc_id, service_id, status_xml);
+}
+
+void
+yts_transport_emit_error (YtsTransport *self,
+                          YtsError      error)
+{
+  g_signal_emit (self, _signals[SIG_ERROR], 0, error);
+}
+
+void
+yts_transport_emit_send_queue_congested (YtsTransport *self,
+                                         char const   *contact_id,
+                                         bool          congested)
+{
+  g_signal_emit (self, _signals[SIG_SEND_QUEUE_CONGESTED], 0,
+                 contact_id, congested);
+}
@@ -0,0 +1,289 @@
+/*
+ * Copyright © 2011 Intel Corp.
+ *
+ * This  library is free  software; you can  redistribute it and/or
+ * modify it  under  the terms  of the  GNU Lesser  General  Public
+ * License  as published  by the Free  Software  Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed  in the hope that it will be useful,
+ * but  WITHOUT ANY WARRANTY; without even  the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Rob Staudinger <robsta@linux.intel.com>
+ */
+
+#ifndef YTS_TRANSPORT_H
+#define YTS_TRANSPORT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <ytstenut/yts-client.h>
+#include <ytstenut/yts-contact.h>
+#include <ytstenut/yts-error.h>
+#include <ytstenut/yts-metadata.h>
+#include <ytstenut/yts-outgoing-file.h>
+
+G_BEGIN_DECLS
+
+#define YTS_TYPE_TRANSPORT \
+  (yts_transport_get_type ())
+
+#define YTS_TRANSPORT(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), YTS_TYPE_TRANSPORT, YtsTransport))
+
+#define YTS_IS_TRANSPORT(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), YTS_TYPE_TRANSPORT))
+
+#define YTS_TRANSPORT_GET_INTERFACE(obj) \
+  (G_TYPE_INSTANCE_GET_INTERFACE ((obj), YTS_TYPE_TRANSPORT, YtsTransportInterface))
+
+typedef struct YtsTransport YtsTransport;
+
+/*
+ * Counters and gauges a transport keeps about itself, for
+ * yts_client_get_statistics().
+ */
+typedef struct {
+  uint64_t  bytes_sent;
+  unsigned  messages_waiting;   /* for the recipient to be resolved */
+  unsigned  channels_open;
+} YtsTransportStatistics;
+
+/*
+ * Bounds for messages waiting for their recipient to become reachable, per
+ * contact. A @high_water of 0 means unbounded, an @expiry_s of 0 never.
+ */
+typedef struct {
+  unsigned            high_water;
+  unsigned            low_water;
+  unsigned            expiry_s;
+  YtsSendQueuePolicy  policy;
+} YtsSendQueueLimits;
+
+#define YTS_SEND_QUEUE_DEFAULT_HIGH_WATER 256
+#define YTS_SEND_QUEUE_DEFAULT_LOW_WATER 64
+
+/* Congestion could never clear with @low_water above @high_water. */
+#define YTS_SEND_QUEUE_LIMITS_VALID(limits) \
+  (0 == (limits)->high_water || (limits)->low_water <= (limits)->high_water)
+
+/*
+ * The @connect and @disconnect methods are optional, the Telepathy transport
+ * leaves them to #YtsClient, which drives the account itself. So is
+ * @get_statistics, transports that don't implement it report zeroes, and
+ * @set_send_queue_limits, for transports that never hold messages back.
+ * Without @advertise_statuses each status is passed to @advertise_status.
+ */
+typedef struct {
+
+  /*< private >*/
+  GTypeInterface parent;
+
+  char const *
+  (*get_contact_id) (YtsTransport *self);
+
+  void
+  (*connect) (YtsTransport *self);
+
+  void
+  (*disconnect) (YtsTransport *self);
+
+  void
+  (*add_capability) (YtsTransport *self,
+                     char const   *fqc_id);
+
+  void
+  (*add_interest) (YtsTransport *self,
+                   char const   *fqc_id);
+
+  void
+  (*advertise_status) (YtsTransport *self,
+                       char const   *fqc_id,
+                       char const   *status_xml);
+
+  void
+  (*refresh) (YtsTransport *self);
+
+  YtsError
+  (*send_message) (YtsTransport *self,
+                   YtsContact   *contact,
+                   char const   *service_id,
+                   YtsMetadata  *message);
+
+  void
+  (*resolve_contact_async) (YtsTransport        *self,
+                            char const          *contact_id,
+                            GCancellable        *cancellable,
+                            GAsyncReadyCallback  callback,
+                            void                *user_data);
+
+  YtsContact *
+  (*resolve_contact_finish) (YtsTransport  *self,
+                             GAsyncResult  *result,
+                             GError       **error);
+
+  YtsOutgoingFile *
+  (*send_file) (YtsTransport  *self,
+                YtsContact    *contact,
+                char const    *service_id,
+                GFile         *file,
+                char const    *description,
+                GError       **error);
+
+  YtsOutgoingFile *
+  (*send_stream) (YtsTransport  *self,
+                  YtsContact    *contact,
+                  char const    *service_id,
+                  GInputStream  *stream,
+                  uint64_t       size,
+                  char const    *name,
+                  char const    *content_type,
+                  char const    *description,
+                  GError       **error);
+
+  void
+  (*get_statistics) (YtsTransport           *self,
+                     YtsTransportStatistics *statistics);
+
+  void
+  (*set_send_queue_limits) (YtsTransport              *self,
+                            YtsSendQueueLimits const  *limits);
+
+  void
+  (*advertise_statuses) (YtsTransport *self,
+                         GHashTable   *statuses);
+
+} YtsTransportInterface;
+
+GType
+yts_transport_get_type (void) G_GNUC_CONST;
+
+char const *
+yts_transport_get_contact_id (YtsTransport *self);
+
+void
+yts_transport_connect (YtsTransport *self);
+
+void
+yts_transport_disconnect (YtsTransport *self);
+
+void
+yts_transport_add_capability (YtsTransport *self,
+                              char const   *fqc_id);
+
+void
+yts_transport_add_interest (YtsTransport *self,
+                            char const   *fqc_id);
+
+void
+yts_transport_advertise_status (YtsTransport *self,
+                                char const   *fqc_id,
+                                char const   *status_xml);
+
+void
+yts_transport_advertise_statuses (YtsTransport *self,
+                                  GHashTable   *statuses);
+
+void
+yts_transport_refresh (YtsTransport *self);
+
+YtsError
+yts_transport_send_message (YtsTransport *self,
+                            YtsContact   *contact,
+                            char const   *service_id,
+                            YtsMetadata  *message);
+
+void
+yts_transport_resolve_contact_async (YtsTransport        *self,
+                                     char const          *contact_id,
+                                     GCancellable        *cancellable,
+                                     GAsyncReadyCallback  callback,
+                                     void                *user_data);
+
+YtsContact *
+yts_transport_resolve_contact_finish (YtsTransport  *self,
+                                      GAsyncResult  *result,
+                                      GError       **error);
+
+YtsOutgoingFile *
+yts_transport_send_file (YtsTransport  *self,
+                         YtsContact    *contact,
+                         char const    *service_id,
+                         GFile         *file,
+                         char const    *description,
+                         GError       **error);
+
+YtsOutgoingFile *
+yts_transport_send_stream (YtsTransport  *self,
+                           YtsContact    *contact,
+                           char const    *service_id,
+                           GInputStream  *stream,
+                           uint64_t       size,
+                           char const    *name,
+                           char const    *content_type,
+                           char const    *description,
+                           GError       **error);
+
+void
+yts_transport_get_statistics (YtsTransport            *self,
+                              YtsTransportStatistics  *statistics);
+
+void
+yts_transport_set_send_queue_limits (YtsTransport              *self,
+                                     YtsSendQueueLimits const  *limits);
+
+/* For implementations. */
+
+void
+yts_transport_emit_ready (YtsTransport *self);
+
+void
+yts_transport_emit_disconnected (YtsTransport *self);
+
+void
+yts_transport_emit_message_received (YtsTransport *self,
+                                     char const   *contact_id,
+                                     char const   *service_id,
+                                     char const   *xml);
+
+void
+yts_transport_emit_service_added (YtsTransport      *self,
+                                  char const        *contact_id,
+                                  char const        *service_id,
+                                  char const        *type,
+                                  char const *const *caps,
+                                  GHashTable        *names,
+                                  GHashTable        *statuses);
+
+void
+yts_transport_emit_service_removed (YtsTransport *self,
+                                    char const   *contact_id,
+                                    char const   *service_id);
+
+void
+yts_transport_emit_status_changed (YtsTransport *self,
+                                   char const   *contact_id,
+                                   char const   *fqc_id,
+                                   char const   *service_id,
+                                   char const   *status_xml);
+
+void
+yts_transport_emit_error (YtsTransport *self,
+                          YtsError      error);
+
+void
+yts_transport_emit_send_queue_congested (YtsTransport *self,
+                                         char const   *contact_id,
+                                         bool          congested);
+
+G_END_DECLS
+
+#endif /* YTS_TRANSPORT_H */
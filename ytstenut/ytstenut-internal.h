@@ -44,6 +44,21 @@ ytstenut_init (void);
 YtsDebugFlags
 ytstenut_get_debug_flags (void);
 
+/* Parsed from YTS_DEBUG once by ytstenut_init(), so the macros below can
+ * test a topic before anything gets formatted. */
+extern YtsDebugFlags ytstenut_debug_flags;
+
+#define YTS_DEBUG_ENABLED(topic) \
+  G_UNLIKELY (ytstenut_debug_flags & (topic))
+
+/* Debug output for hot paths, costs a single branch unless YTS_DEBUG
+ * enables @topic, e.g. YTS_NOTE (CLIENT, "Sending to %s", id). */
+#define YTS_NOTE(topic, format, ...) \
+  G_STMT_START { \
+    if (YTS_DEBUG_ENABLED (YTS_DEBUG_##topic)) \
+      g_log (G_LOG_DOMAIN, G_LOG_LEVEL_DEBUG, format, ##__VA_ARGS__); \
+  } G_STMT_END
+
 #define ERROR(format, ...) \
   do \
     { \
@@ -25,6 +25,7 @@
 #include <glib.h>
 
 #include "ytstenut-internal.h"
+#include "yts-probes.h"
 
 #undef G_LOG_DOMAIN
 #define G_LOG_DOMAIN PACKAGE"\0main\0"G_STRLOC
@@ -44,7 +45,22 @@ static const GDebugKey _debug_keys[] = {
   { "unspecified",      YTS_DEBUG_UNSPECIFIED }
 };
 
-static YtsDebugFlags _debug_flags = 0;
+YtsDebugFlags ytstenut_debug_flags = 0;
+
+#ifdef YTS_ENABLE_PROBES
+YTS_PROBE_SEMAPHORE (message__send);
+YTS_PROBE_SEMAPHORE (message__receive);
+YTS_PROBE_SEMAPHORE (message__dispatch);
+YTS_PROBE_SEMAPHORE (channel__request);
+YTS_PROBE_SEMAPHORE (channel__reply);
+YTS_PROBE_SEMAPHORE (invocation__establish);
+YTS_PROBE_SEMAPHORE (invocation__conclude);
+YTS_PROBE_SEMAPHORE (event__send);
+YTS_PROBE_SEMAPHORE (status__advertise);
+YTS_PROBE_SEMAPHORE (status__receive);
+YTS_PROBE_SEMAPHORE (outgoing__file__state);
+YTS_PROBE_SEMAPHORE (incoming__file__state);
+#endif
 
 static void
 log_brief (GLogLevelFlags  log_level,
@@ -101,6 +117,17 @@ _log_handler (char const      *log_domain,
   char const  *location = NULL;
   unsigned     topic_flag = 0;
 
+  /* Not in debug mode only debug messages (there should not be any in a
+   * tarball release) and exceptions are printed, bail out before doing any
+   * work on the rest. */
+  if (!ytstenut_debug_flags &&
+      !(log_level & (G_LOG_LEVEL_ERROR |
+                     G_LOG_LEVEL_CRITICAL |
+                     G_LOG_LEVEL_WARNING |
+                     G_LOG_LEVEL_DEBUG))) {
+    return;
+  }
+
   /* A bit of a hack, the domain has the format "ytstenut\0topic",
    * so look what's past the \0 for the topic. */
   topic = &log_domain[strlen (log_domain) + 1];
@@ -111,7 +138,7 @@ _log_handler (char const      *log_domain,
       location += 2;
   }
 
-  if (_debug_flags) {
+  if (ytstenut_debug_flags) {
 
     /* == We are in debug mode. == */
 
@@ -122,9 +149,9 @@ _log_handler (char const      *log_domain,
       }
     }
 
-    if (_debug_flags & topic_flag) {
+    if (ytstenut_debug_flags & topic_flag) {
 
-      if (YTS_DEBUG_BRIEF & _debug_flags) {
+      if (YTS_DEBUG_BRIEF & ytstenut_debug_flags) {
 
         log_brief (log_level,
                    location ? location : topic,
@@ -139,16 +166,8 @@ _log_handler (char const      *log_domain,
   } else {
 
     /* == Not in debug mode ==
-     * Only print debug messages (there should not be any in a tarball release),
-     * and exceptions. */
-    GLogLevelFlags log_mask = G_LOG_LEVEL_ERROR |
-                              G_LOG_LEVEL_CRITICAL |
-                              G_LOG_LEVEL_WARNING |
-                              G_LOG_LEVEL_DEBUG;
-
-    if (log_level & log_mask) {
-      log_default (log_domain, log_level, topic, location, message);
-    }
+     * Filtered above already. */
+    log_default (log_domain, log_level, topic, location, message);
   }
 }
 
@@ -166,9 +185,9 @@ ytstenut_init (void)
 
   yts_debug = g_getenv ("YTS_DEBUG");
   if (yts_debug) {
-    _debug_flags = g_parse_debug_string (yts_debug,
-                                         _debug_keys,
-                                         G_N_ELEMENTS (_debug_keys));
+    ytstenut_debug_flags = g_parse_debug_string (yts_debug,
+                                                 _debug_keys,
+                                                 G_N_ELEMENTS (_debug_keys));
   }
 
   g_log_set_handler (PACKAGE, G_LOG_LEVEL_MASK, _log_handler, NULL);
@@ -180,7 +199,7 @@ ytstenut_init (void)
 YtsDebugFlags
 ytstenut_get_debug_flags (void)
 {
-  return _debug_flags;
+  return ytstenut_debug_flags;
 }
 
 #if 0
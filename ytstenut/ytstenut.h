@@ -23,13 +23,18 @@
 #define YTSTENUT_H
 
 #include <ytstenut/yts-capability.h>
+#include <ytstenut/yts-capability-registry.h>
 #include <ytstenut/yts-client.h>
 #include <ytstenut/yts-contact.h>
+#include <ytstenut/yts-incoming-bundle.h>
 #include <ytstenut/yts-incoming-file.h>
+#include <ytstenut/yts-incoming-file-policy.h>
+#include <ytstenut/yts-outgoing-bundle.h>
 #include <ytstenut/yts-outgoing-file.h>
 #include <ytstenut/yts-file-transfer.h>
 #include <ytstenut/yts-roster.h>
 #include <ytstenut/yts-service.h>
+#include <ytstenut/yts-transfer-scheduler.h>
 #include <ytstenut/yts-version.h>
 
 #include <ytstenut/yts-enum-types.h>